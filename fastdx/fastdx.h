@@ -4,15 +4,47 @@
 #define WIN32_LEAN_AND_MEAN
 #endif
 
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
 #include <d3d12.h>
 #include <dxgi1_6.h>
 #include <dxgidebug.h>
+#include <assert.h>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
 #include <functional>
+#include <list>
+#include <map>
+#include <math.h>
 #include <memory>
+#include <mutex>
 #include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+#if !defined(_WIN32)
+#include <errno.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
 
 ///
 /// fastdx Header - D3D12 Lightweight Wrapper for Quick Prototyping
@@ -20,17 +52,58 @@
 namespace fastdx {
     class D3D12DeviceWrapper;
     typedef std::shared_ptr<D3D12DeviceWrapper> D3D12DeviceWrapperPtr;
+    class ConstantBufferAllocator;
+    typedef std::shared_ptr<ConstantBufferAllocator> ConstantBufferAllocatorPtr;
+    class FrameContext;
+    typedef std::shared_ptr<FrameContext> FrameContextPtr;
+    class FrameStatistics;
+    typedef std::shared_ptr<FrameStatistics> FrameStatisticsPtr;
+    class GpuProfiler;
+    typedef std::shared_ptr<GpuProfiler> GpuProfilerPtr;
+    class ResidencyManager;
+    typedef std::shared_ptr<ResidencyManager> ResidencyManagerPtr;
+    class ShaderVisibleDescriptorHeap;
+    typedef std::shared_ptr<ShaderVisibleDescriptorHeap> ShaderVisibleDescriptorHeapPtr;
+    class StagingDescriptorHeap;
+    typedef std::shared_ptr<StagingDescriptorHeap> StagingDescriptorHeapPtr;
+    class BindlessResourceTable;
+    typedef std::shared_ptr<BindlessResourceTable> BindlessResourceTablePtr;
+    class SamplerCache;
+    typedef std::shared_ptr<SamplerCache> SamplerCachePtr;
+    class CommandContextPool;
+    typedef std::shared_ptr<CommandContextPool> CommandContextPoolPtr;
+    class WorkerPool;
+    typedef std::shared_ptr<WorkerPool> WorkerPoolPtr;
+    class RenderGraph;
+    typedef std::shared_ptr<RenderGraph> RenderGraphPtr;
+    class IndirectArgumentLayout;
+    class PipelineStateCache;
+    typedef std::shared_ptr<PipelineStateCache> PipelineStateCachePtr;
+    class AsyncPipelineState;
+    typedef std::shared_ptr<AsyncPipelineState> AsyncPipelineStatePtr;
+    class AsyncPipelineCompiler;
+    typedef std::shared_ptr<AsyncPipelineCompiler> AsyncPipelineCompilerPtr;
+    class ReloadablePipelineState;
+    typedef std::shared_ptr<ReloadablePipelineState> ReloadablePipelineStatePtr;
+    class ShaderHotReloader;
+    typedef std::shared_ptr<ShaderHotReloader> ShaderHotReloaderPtr;
+    typedef std::shared_ptr<IUnknown> IUnknownPtr;
 
     typedef std::shared_ptr<ID3D12CommandAllocator> ID3D12CommandAllocatorPtr;
     typedef std::shared_ptr<ID3D12CommandQueue> ID3D12CommandQueuePtr;
+    typedef std::shared_ptr<ID3D12CommandSignature> ID3D12CommandSignaturePtr;
     typedef std::shared_ptr<ID3D12DescriptorHeap> ID3D12DescriptorHeapPtr;
     typedef std::shared_ptr<ID3D12Device2> ID3D12DevicePtr;
     typedef std::shared_ptr<ID3D12Fence> ID3D12FencePtr;
     typedef std::shared_ptr<ID3D12GraphicsCommandList6> ID3D12GraphicsCommandListPtr;
+    typedef std::shared_ptr<ID3D12Heap> ID3D12HeapPtr;
+    typedef std::shared_ptr<ID3D12PipelineLibrary> ID3D12PipelineLibraryPtr;
     typedef std::shared_ptr<ID3D12PipelineState> ID3D12PipelineStatePtr;
+    typedef std::shared_ptr<ID3D12QueryHeap> ID3D12QueryHeapPtr;
     typedef std::shared_ptr<ID3D12Resource> ID3D12ResourcePtr;
     typedef std::shared_ptr<ID3D12RootSignature> ID3D12RootSignaturePtr;
     typedef std::shared_ptr<ID3DBlob> ID3DBlobPtr;
+    typedef std::shared_ptr<IDXGIAdapter3> IDXGIAdapterPtr;
     typedef std::shared_ptr<IDXGISwapChain3> IDXGISwapChainPtr;
 
     struct WindowProperties {
@@ -45,14 +118,100 @@ namespace fastdx {
         }
     };
     inline std::function<void()> onWindowDestroy = nullptr;
+    inline std::function<void(uint32_t virtualKey)> onKeyDown = nullptr;
+
+
+    ///
+    /// Frame Scheduler
+    ///
+
+    /// Fixed timestep simulation. advance() accumulates the time since its last call and returns how many fixed
+    /// steps to simulate, at most maxSteps(); time past the cap is dropped instead of piling up. alpha() is the
+    /// fraction of a step left over, to interpolate draws between the last two simulated states.
+    class FrameScheduler {
+    public:
+        typedef std::function<double()> ClockFunction;          // Monotonic time in seconds
+
+        FrameScheduler(double fixedStepSec = 1.0 / 60.0, uint32_t maxSteps = 8, ClockFunction clock = nullptr)
+            : _clock(clock ? clock : steadyClock) {
+            setFixedStep(fixedStepSec);
+            setMaxSteps(maxSteps);
+        }
+
+        // Reads the clock, the first call only starts timing
+        inline uint32_t advance() {
+            double time = _clock();
+            double elapsedSec = _isStarted ? time - _lastTime : 0.0;
+            _lastTime = time;
+            _isStarted = true;
+            return advance(elapsedSec);
+        }
+
+        inline uint32_t advance(double elapsedSec) {
+            _accumulatedTime += std::max(elapsedSec, 0.0);
+
+            // Clock deltas measured a hair under one step still count as a step, avoiding 0/2 steps judder
+            double stepThreshold = _fixedStep * (1.0 - 1e-4);
+            uint32_t steps = 0;
+            while (_accumulatedTime >= stepThreshold && steps < _maxSteps) {
+                _accumulatedTime = std::max(_accumulatedTime - _fixedStep, 0.0);
+                ++steps;
+            }
+            if (_accumulatedTime >= stepThreshold) {
+                double remainingTime = fmod(_accumulatedTime, _fixedStep);
+                _droppedTime += _accumulatedTime - remainingTime;
+                _accumulatedTime = remainingTime;
+            }
+
+            _stepCount += steps;
+            ++_frameCount;
+            return steps;
+        }
+
+        // Restarts timing on the next advance(), e.g. after a long stall that should not be simulated
+        inline void reset() {
+            _isStarted = false;
+            _accumulatedTime = 0.0;
+        }
+
+        inline void setFixedStep(double fixedStepSec) { _fixedStep = std::max(fixedStepSec, 1e-6); }
+        inline void setMaxSteps(uint32_t maxSteps) { _maxSteps = std::max(maxSteps, 1u); }
+
+        inline double fixedStep() const { return _fixedStep; }
+        inline uint32_t maxSteps() const { return _maxSteps; }
+        inline float alpha() const { return static_cast<float>(_accumulatedTime / _fixedStep); }
+        inline uint64_t stepCount() const { return _stepCount; }
+        inline uint64_t frameCount() const { return _frameCount; }
+        inline double droppedTime() const { return _droppedTime; }
+
+        static double steadyClock() {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+    private:
+        ClockFunction _clock;
+        double _fixedStep = 1.0 / 60.0;
+        uint32_t _maxSteps = 8;
+
+        bool _isStarted = false;
+        double _lastTime = 0.0;
+        double _accumulatedTime = 0.0;
+        double _droppedTime = 0.0;
+        uint64_t _stepCount = 0;
+        uint64_t _frameCount = 0;
+    };
 
 
     ///
     /// Window helpers
     ///
     HWND createWindow(const WindowProperties& properties, HRESULT* outResult = nullptr);
+
+    // Calls update with the fixed step in seconds as many times as the scheduler asks, then draw once with the
+    // interpolation alpha, until the window closes. Frame, update and draw times go to statistics if set
     int runMainLoop(std::function<void(float)> updateFunction = nullptr,
-        std::function<void()> drawFunction = nullptr);
+        std::function<void(float)> drawFunction = nullptr, FrameScheduler scheduler = FrameScheduler(),
+        FrameStatisticsPtr statistics = nullptr);
 
 
     ///
@@ -63,9 +222,12 @@ namespace fastdx {
 
     class D3D12DeviceWrapper {
     public:
-        D3D12DeviceWrapper(ID3D12DevicePtr device) : _device(device) {}
+        D3D12DeviceWrapper(ID3D12DevicePtr device, IDXGIAdapterPtr adapter = nullptr);
 
         inline ID3D12DevicePtr d3dDevice() const { return _device; }
+        inline IDXGIAdapterPtr dxgiAdapter() const { return _adapter; }
+        inline ResidencyManagerPtr residencyManager() const { return _residencyManager; }
+        inline PipelineStateCachePtr pipelineStateCache() const { return _pipelineStateCache; }
 
         ID3D12CommandAllocatorPtr createCommandAllocator(D3D12_COMMAND_LIST_TYPE commandType,
             HRESULT* outResult = nullptr);
@@ -75,21 +237,58 @@ namespace fastdx {
 
         ID3D12CommandQueuePtr createCommandQueue(D3D12_COMMAND_LIST_TYPE type, HRESULT* outResult = nullptr);
 
+        // Root signature is required when the layout changes root arguments
+        ID3D12CommandSignaturePtr createCommandSignature(const IndirectArgumentLayout& layout,
+            ID3D12RootSignaturePtr rootSignature = nullptr, HRESULT* outResult = nullptr);
+
+        CommandContextPoolPtr createCommandContextPool(D3D12_COMMAND_LIST_TYPE commandType);
+
+        RenderGraphPtr createRenderGraph(int32_t frameCount);
+
+        ConstantBufferAllocatorPtr createConstantBufferAllocator(int32_t frameCount, uint32_t frameSizeInBytes,
+            HRESULT* outResult = nullptr);
+
         ID3D12ResourcePtr createCommittedResource(const D3D12_HEAP_PROPERTIES& heapProperties,
             D3D12_HEAP_FLAGS heapFlags, const D3D12_RESOURCE_DESC& desc, D3D12_RESOURCE_STATES initialState,
             const D3D12_CLEAR_VALUE* optOptimalClearValue, HRESULT* outResult = nullptr);
 
         ID3D12FencePtr createFence(uint64_t initialValue, D3D12_FENCE_FLAGS flags, HRESULT* outResult = nullptr);
 
+        // Frame pacing on commandQueue with latency frames in flight, see FrameContext
+        FrameContextPtr createFrameContext(ID3D12CommandQueuePtr commandQueue, D3D12_COMMAND_LIST_TYPE commandType,
+            uint32_t latency = 2, HRESULT* outResult = nullptr);
+
+        // Timestamp queries for up to maxScopesPerFrame scopes per frame on commandQueue, see GpuProfiler
+        GpuProfilerPtr createGpuProfiler(ID3D12CommandQueuePtr commandQueue, uint32_t maxScopesPerFrame = 256,
+            HRESULT* outResult = nullptr);
+
+        // Returns the cached pipeline for an equivalent desc, see PipelineStateCache
         ID3D12PipelineStatePtr createGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc,
             HRESULT* outResult = nullptr);
 
+        // Compiles through the pipeline state cache on threadCount workers
+        AsyncPipelineCompilerPtr createAsyncPipelineCompiler(uint32_t threadCount = 2);
+
         ID3D12DescriptorHeapPtr createDescriptorHeap(int32_t count, D3D12_DESCRIPTOR_HEAP_TYPE heapType,
             HRESULT* outResult = nullptr);
 
+        ID3D12DescriptorHeapPtr createDescriptorHeap(int32_t count, D3D12_DESCRIPTOR_HEAP_TYPE heapType,
+            D3D12_DESCRIPTOR_HEAP_FLAGS heapFlags, HRESULT* outResult = nullptr);
+
+        StagingDescriptorHeapPtr createStagingDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE heapType,
+            uint32_t descriptorsPerPage = 256);
+
+        ShaderVisibleDescriptorHeapPtr createShaderVisibleDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE heapType,
+            uint32_t staticCount, uint32_t transientCountPerFrame, int32_t frameCount, HRESULT* outResult = nullptr);
+
+        BindlessResourceTablePtr createBindlessResourceTable(ShaderVisibleDescriptorHeapPtr heap);
+
+        SamplerCachePtr createSamplerCache(ShaderVisibleDescriptorHeapPtr heap);
+
         std::vector<ID3D12ResourcePtr> createRenderTargetViews(IDXGISwapChainPtr swapChain,
             ID3D12DescriptorHeapPtr heap, HRESULT* outResult = nullptr);
 
+        // Cached by the root signature part, shaders embedding the same root signature share one object
         ID3D12RootSignaturePtr createRootSignature(uint32_t nodeMask, const void* data, size_t dataSizeInBytes,
             HRESULT* outResult = nullptr);
 
@@ -112,458 +311,6483 @@ namespace fastdx {
 
     private:
         ID3D12DevicePtr _device;
+        IDXGIAdapterPtr _adapter;
+        ResidencyManagerPtr _residencyManager;
+        PipelineStateCachePtr _pipelineStateCache;
+
+        struct RootSignatureEntry {
+            uint32_t nodeMask;
+            std::vector<uint8_t> data;                  // RTS0 part, compared on hash hits
+            ID3D12RootSignaturePtr rootSignature;
+        };
+
+        std::mutex _rootSignatureMutex;
+        std::unordered_multimap<uint64_t, RootSignatureEntry> _rootSignatures;
     };
-}
 
-///
-/// fastdxu Header - D3D12 Utilities
-///
-namespace fastdxu {
-    D3D12_BLEND_DESC defaultBlendDesc();
 
-    D3D12_DEPTH_STENCIL_DESC defaultDepthStencilDesc();
+    ///
+    /// Per-Frame Constant Buffer Allocator
+    ///
+    struct ConstantBufferAllocation {
+        uint8_t* cpuPtr = nullptr;
+        D3D12_GPU_VIRTUAL_ADDRESS gpuAddress = 0;
+        uint32_t sizeInBytes = 0;
+    };
 
-    D3D12_INDEX_BUFFER_VIEW indexBufferView(D3D12_GPU_VIRTUAL_ADDRESS BufferLocation, UINT SizeInBytes,
-        DXGI_FORMAT Format = DXGI_FORMAT_R16_UINT);
+    /// Upload buffer mapped once, split into one region per frame in flight. Each region is linearly
+    /// sub-allocated in 256B aligned slices and rewinds on beginFrame(), after the GPU is done with it.
+    class ConstantBufferAllocator {
+    public:
+        ConstantBufferAllocator(ID3D12ResourcePtr buffer, uint8_t* cpuBasePtr, int32_t frameCount,
+            uint32_t frameSizeInBytes);
+        ~ConstantBufferAllocator();
 
-    D3D12_RASTERIZER_DESC defaultRasterizerDesc();
+        void beginFrame(int32_t frameIndex);
 
-    D3D12_RESOURCE_BARRIER resourceBarrierTransition(fastdx::ID3D12ResourcePtr resource, D3D12_RESOURCE_STATES beforeState, D3D12_RESOURCE_STATES afterState);
+        inline ConstantBufferAllocation allocate(uint32_t sizeInBytes) {
+            uint32_t alignedSizeInBytes = (sizeInBytes + kAlignmentMask) & ~kAlignmentMask;
+            if (_frameOffset + alignedSizeInBytes > _frameSizeInBytes) {
+                ++_failedAllocationCount;
+                return ConstantBufferAllocation();
+            }
 
-    D3D12_RESOURCE_DESC resourceBufferDesc(uint32_t width,
-        D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE);
+            uint64_t offset = _frameBaseOffset + _frameOffset;
+            _frameOffset += alignedSizeInBytes;
+            return ConstantBufferAllocation{ _cpuBasePtr + offset, _gpuBaseAddress + offset, alignedSizeInBytes };
+        }
 
-    D3D12_RESOURCE_DESC resourceTexDesc(D3D12_RESOURCE_DIMENSION dimension, uint32_t width,
-        uint32_t height, uint16_t depth, DXGI_FORMAT format, D3D12_RESOURCE_FLAGS flags);
+        template <typename T>
+        inline ConstantBufferAllocation push(const T& data) {
+            ConstantBufferAllocation allocation = allocate(sizeof(T));
+            if (allocation.cpuPtr != nullptr) {
+                memcpy(allocation.cpuPtr, &data, sizeof(T));
+            }
+            return allocation;
+        }
 
-    D3D12_SHADER_RESOURCE_VIEW_DESC shaderResourceViewDesc(D3D12_SRV_DIMENSION dimension);
+        inline ID3D12ResourcePtr buffer() const { return _buffer; }
+        inline uint32_t frameSizeInBytes() const { return _frameSizeInBytes; }
+        inline uint32_t frameUsedSizeInBytes() const { return _frameOffset; }
 
-    DXGI_SWAP_CHAIN_DESC1 swapChainDesc(const HWND hwnd, uint32_t bufferCount = 2,
-        DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM);
+        // Allocations that did not fit their frame region, since construction
+        inline uint64_t failedAllocationCount() const { return _failedAllocationCount; }
 
-    D3D12_GRAPHICS_PIPELINE_STATE_DESC defaultGraphicsPipelineDesc(DXGI_FORMAT renderTargetFormat);
-};
+    private:
+        static const uint32_t kAlignmentMask = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1;
+
+        ID3D12ResourcePtr _buffer;
+        uint8_t* _cpuBasePtr;
+        D3D12_GPU_VIRTUAL_ADDRESS _gpuBaseAddress;
+        int32_t _frameCount;
+        uint32_t _frameSizeInBytes;
+        uint64_t _frameBaseOffset = 0;
+        uint32_t _frameOffset = 0;
+        uint64_t _failedAllocationCount = 0;
+    };
 
 
-///
-/// Implementation
-///
-#if defined(FASTDX_IMPLEMENTATION)
+    ///
+    /// Fence-Deferred Release Queue
+    ///
+    /// Holds the last reference to objects until the GPU passes the fence value they were released at.
+    /// release() is lock-free and may be called from any thread, retire() never waits on the GPU.
+    class DeferredReleaseQueue {
+    public:
+        DeferredReleaseQueue() = default;
+        DeferredReleaseQueue(const DeferredReleaseQueue&) = delete;
+        DeferredReleaseQueue& operator=(const DeferredReleaseQueue&) = delete;
+        ~DeferredReleaseQueue();
 
-#ifndef SAFE_FREE
-#define SAFE_FREE(p) { if (p) { free(p); (p)=nullptr; } }
-#endif
+        void release(IUnknownPtr object, uint64_t fenceValue);
 
-#ifndef SAFE_RELEASE
-#define SAFE_RELEASE(p) { if (p) { (p)->Release(); (p)=nullptr; } }
-#endif
+        // Drops every object whose fence value is <= completedFenceValue, returns how many were dropped
+        size_t retire(uint64_t completedFenceValue);
+        size_t flush() { return retire(UINT64_MAX); }
 
-#ifndef CHECK_ASSIGN_RETURN_IF_FAILED_
-#define CHECK_ASSIGN_RETURN_IF_FAILED_(HRESULTVAR, OUTVAR, ...) { if (_checkFailedAndAssign(HRESULTVAR, OUTVAR)) { return __VA_ARGS__; } }
-#endif
+        inline size_t pendingCount() const { return _pendingCount.load(std::memory_order_relaxed); }
 
-#ifndef CHECK_ASSIGN_RETURN_IF_FAILED
-#define CHECK_ASSIGN_RETURN_IF_FAILED(HRESULTVAR, OUTVAR) { if (_checkFailedAndAssign(HRESULTVAR, OUTVAR)) { return nullptr; } }
-#endif
+    private:
+        struct Node {
+            IUnknownPtr object;
+            uint64_t fenceValue;
+            Node* next;
+        };
 
-///
-/// Common
-///
-namespace fastdx {
-    struct PtrDeleter {
-        void operator() (IUnknown* ptr) {
-            SAFE_RELEASE(ptr);
-        }
+        std::atomic<Node*> _incoming = nullptr;
+        std::atomic<size_t> _pendingCount = 0;
+        std::mutex _retireMutex;
+        Node* _retiring = nullptr;
     };
 
-    inline bool _checkFailedAndAssign(HRESULT hr, HRESULT* outResult = nullptr) {
-        if (outResult != nullptr) {
-            *outResult = hr;
-        }
-        return FAILED(hr);
-    }
-};
 
+    ///
+    /// Frame Pacing
+    ///
+    /// Fence values of the frames in flight, no D3D12 calls. Frame n may be recorded once the GPU completed
+    /// frame n - latency, its per-frame resources in slot n % kMaxLatency are then free for any latency. Lowering
+    /// the latency makes the next beginFrame() wait for more frames, raising it lets the CPU run further ahead.
+    class FramePacer {
+    public:
+        static constexpr uint32_t kMaxLatency = 4;
 
-///
-/// Window Implementation
-///
-namespace fastdx {
-    using namespace std::chrono;
+        FramePacer(uint32_t latency = 2) { setLatency(latency); }
 
-    LRESULT CALLBACK _WindowProcKeyDown(HWND hWnd, WPARAM wParam, LPARAM lParam) {
-        switch (wParam) {
-        case VK_ESCAPE:
-            SendMessage(hWnd, WM_CLOSE, 0, 0);
-            break;
+        // Clamped to [1, kMaxLatency]
+        inline void setLatency(uint32_t latency) { _latency = std::min(std::max(latency, 1u), kMaxLatency); }
+        inline uint32_t latency() const { return _latency; }
+
+        // Fence value the GPU must reach before recording the frame, 0 if none
+        inline uint64_t beginFrame() const {
+            return (_frameNumber >= _latency) ? _signalValues[(_frameNumber - _latency) % kMaxLatency] : 0;
         }
 
-        return S_OK;
-    }
+        // Fence value to signal after the frame's commands
+        inline uint64_t endFrame() {
+            uint64_t value = signal();
+            _signalValues[_frameNumber++ % kMaxLatency] = value;
+            return value;
+        }
 
+        // Fence value to signal outside of a frame, e.g. after uploads
+        inline uint64_t signal() { return ++_signaledValue; }
 
-    LRESULT CALLBACK _WindowProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
-        switch (msg) {
-        case WM_PAINT:
-            break;
+        inline uint32_t frameSlot() const { return static_cast<uint32_t>(_frameNumber % kMaxLatency); }
+        inline uint64_t frameNumber() const { return _frameNumber; }
+        inline uint64_t signaledValue() const { return _signaledValue; }
+        inline uint64_t nextSignalValue() const { return _signaledValue + 1; }
 
-        case WM_SIZE:
-            break;
+    private:
+        uint32_t _latency = 2;
+        uint64_t _frameNumber = 0;
+        uint64_t _signaledValue = 0;
+        uint64_t _signalValues[kMaxLatency] = {};        // Of the last frames, by slot
+    };
 
-        case WM_KEYDOWN:
-            _WindowProcKeyDown(hWnd, wParam, lParam);
-            break;
+    /// Paces frames on a queue with its own fence and one command allocator per frame slot, created on first
+    /// use. beginFrame() stalls only when the GPU has not finished the frame latency() frames back, endFrame()
+    /// signals and never waits.
+    class FrameContext {
+    public:
+        FrameContext(ID3D12DevicePtr device, ID3D12CommandQueuePtr commandQueue, D3D12_COMMAND_LIST_TYPE commandType,
+            ID3D12FencePtr fence, uint32_t latency);
+        FrameContext(const FrameContext&) = delete;
+        FrameContext& operator=(const FrameContext&) = delete;
+        ~FrameContext();
 
-        case WM_DESTROY:
-            PostQuitMessage(0);
-            break;
-        }
+        // Waits for the frame slot, then resets its allocator. Returns the frame slot
+        uint32_t beginFrame();
+        uint64_t endFrame();
 
-        return DefWindowProc(hWnd, msg, wParam, lParam);
-    }
+        // Signals and waits for every submitted command, e.g. before releasing resources or on exit
+        void waitIdle();
 
+        // Allocator of the current frame slot
+        ID3D12CommandAllocatorPtr commandAllocator(HRESULT* outResult = nullptr);
 
-    HWND createWindow(const WindowProperties& properties, HRESULT* outResult) {
-        HINSTANCE hInstance = (HINSTANCE)GetModuleHandle(nullptr);
+        inline void setLatency(uint32_t latency) { _pacer.setLatency(latency); }
+        inline uint32_t latency() const { return _pacer.latency(); }
+        inline uint32_t frameSlot() const { return _pacer.frameSlot(); }
+        inline uint64_t frameNumber() const { return _pacer.frameNumber(); }
 
-        WNDCLASSEX wc = { 0 };
-        wc.cbSize = sizeof(WNDCLASSEX);
-        wc.style = properties.isFullScreen ? 0 : CS_HREDRAW | CS_VREDRAW;
-        wc.lpfnWndProc = (WNDPROC)_WindowProc;
-        wc.hInstance = hInstance;
-        wc.hIcon = LoadIcon(nullptr, IDI_APPLICATION);
-        wc.hCursor = LoadCursor(nullptr, IDC_ARROW);
-        wc.lpszClassName = L"fastdx";
-        RegisterClassEx(&wc);
+        // Signaled after the commands of the frame being recorded, for DeferredReleaseQueue::release()
+        inline uint64_t frameFenceValue() const { return _pacer.nextSignalValue(); }
+        inline uint64_t completedFenceValue() const { return _fence->GetCompletedValue(); }
+        inline ID3D12FencePtr fence() const { return _fence; }
+        inline uint64_t stallCount() const { return _stallCount; }
 
-        HWND hwnd = CreateWindow(
-            wc.lpszClassName,
-            properties.title,
-            properties.isFullScreen ? WS_POPUP : WS_OVERLAPPEDWINDOW,
-            CW_USEDEFAULT,
-            CW_USEDEFAULT,
-            properties.width,
-            properties.height,
-            nullptr,
-            nullptr,
-            hInstance,
-            0);
+        // Time the last beginFrame() stalled for the GPU, 0 if it did not
+        inline double lastWaitTimeMs() const { return _lastWaitTimeMs; }
 
-        if (!hwnd) {
-            HRESULT result = HRESULT_FROM_WIN32(GetLastError());
-            UnregisterClass(wc.lpszClassName, nullptr);
-            CHECK_ASSIGN_RETURN_IF_FAILED(result, outResult);
-        }
+    private:
+        void _waitForFenceValue(uint64_t fenceValue);
 
-        ShowWindow(hwnd, properties.showMode);
+        ID3D12DevicePtr _device;
+        ID3D12CommandQueuePtr _commandQueue;
+        D3D12_COMMAND_LIST_TYPE _commandType;
+        ID3D12FencePtr _fence;
+        HANDLE _fenceEvent;
+        FramePacer _pacer;
+        ID3D12CommandAllocatorPtr _commandAllocators[FramePacer::kMaxLatency];
+        uint64_t _stallCount = 0;
+        double _lastWaitTimeMs = 0.0;
+    };
 
-        return hwnd;
-    }
 
+    ///
+    /// Frame Statistics
+    ///
+    enum class FrameTiming : uint8_t {
+        Frame,          // CPU time between frame starts
+        Update,
+        Draw,           // Includes the GPU wait
+        GpuWait,
+        Count
+    };
 
-    int runMainLoop(std::function<void(float)> updateFunction, std::function<void()> drawFunction) {
-        MSG msg = {};
-        const float kDesiredUpdateTimeMs = 1.0f / 60.0f;
-        float remainingElapsedTimeMs = 0.0;
+    struct FrameTimes {
+        uint64_t frameNumber = 0;
+        float timesMs[static_cast<size_t>(FrameTiming::Count)] = {};
 
-        while (msg.message != WM_QUIT) {
-            if (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
-                TranslateMessage(&msg);
-                DispatchMessage(&msg);
-            }
+        inline float& operator[](FrameTiming timing) { return timesMs[static_cast<size_t>(timing)]; }
+        inline float operator[](FrameTiming timing) const { return timesMs[static_cast<size_t>(timing)]; }
+    };
 
-            static high_resolution_clock::time_point lastClockTime = high_resolution_clock::now();
-            high_resolution_clock::time_point currentClockTime = high_resolution_clock::now();
+    struct FrameTimingSummary {
+        uint32_t frameCount = 0;
+        double minMs = 0.0;
+        double meanMs = 0.0;
+        double p50Ms = 0.0;
+        double p95Ms = 0.0;
+        double p99Ms = 0.0;
+        double maxMs = 0.0;
+    };
 
-            float elapsedTimeMs = duration<float, std::milli>(currentClockTime - lastClockTime).count();
-            elapsedTimeMs += remainingElapsedTimeMs;
-            lastClockTime = currentClockTime;
+    /// Ring of the last capacity() frame times. One thread records, e.g. the main loop, and never blocks;
+    /// any thread may read. Each slot carries a sequence number, readers drop slots overwritten while copied.
+    class FrameStatistics {
+    public:
+        static const uint32_t kDefaultCapacity = 1024;
 
-            if (updateFunction) {
-                int updateCycles = (int)(elapsedTimeMs / kDesiredUpdateTimeMs);
-                remainingElapsedTimeMs = max(0.0f, elapsedTimeMs - updateCycles * kDesiredUpdateTimeMs);
+        // Rounded up to a power of two
+        FrameStatistics(uint32_t capacity = kDefaultCapacity);
+        FrameStatistics(const FrameStatistics&) = delete;
+        FrameStatistics& operator=(const FrameStatistics&) = delete;
 
-                for (int32_t i = 0; i < updateCycles; ++i) {
-                    updateFunction(kDesiredUpdateTimeMs);
-                }
-            }
+        // Recording thread only: accumulates into the current frame, endFrame() publishes it
+        inline void addTime(FrameTiming timing, double timeMs) { _current[timing] += static_cast<float>(timeMs); }
+        void endFrame();
+        void record(const FrameTimes& times);
 
-            if (drawFunction) {
-                drawFunction();
-            }
-        }
+        // Last frameCount frames, oldest first
+        std::vector<FrameTimes> snapshot(uint32_t frameCount = UINT32_MAX) const;
 
-        fastdx::onWindowDestroy();
+        // Nearest-rank percentiles over the last frameCount frames
+        FrameTimingSummary summary(FrameTiming timing, uint32_t frameCount = UINT32_MAX) const;
+        static FrameTimingSummary summarize(const std::vector<FrameTimes>& frames, FrameTiming timing);
 
-        return static_cast<int>(msg.wParam);
-    }
-};
+        // bucketCount buckets of bucketMs, the last one also counts longer frames
+        std::vector<uint32_t> histogram(FrameTiming timing, double bucketMs = 1.0, uint32_t bucketCount = 50,
+            uint32_t frameCount = UINT32_MAX) const;
 
+        std::string toCsv(uint32_t frameCount = UINT32_MAX) const;
+        std::string toJson(uint32_t frameCount = UINT32_MAX, double histogramBucketMs = 1.0,
+            uint32_t histogramBucketCount = 50) const;
 
-///
-/// D3D12DeviceWrapper Implementation
-///
-namespace fastdx {
-    std::shared_ptr<IDXGIFactory4> _getOrCreateDXIG(HRESULT* outResult) {
-        static std::shared_ptr<IDXGIFactory4> _dxgiFactory = nullptr;
-        if (_dxgiFactory) {
-            if (outResult) {
-                *outResult = S_OK;
-            }
-            return _dxgiFactory;
-        }
+        inline uint32_t capacity() const { return static_cast<uint32_t>(_slots.size()); }
+        inline uint64_t frameCount() const { return _frameCount.load(std::memory_order_acquire); }
 
-        uint32_t dxgiFactoryFlags = 0;
+    private:
+        struct Slot {
+            std::atomic<uint64_t> sequence{ 0 };          // 2 * frame + 1 while written, 2 * frame + 2 once done
+            std::atomic<float> timesMs[static_cast<size_t>(FrameTiming::Count)];
+        };
 
-#if defined(_DEBUG)
-        dxgiFactoryFlags |= DXGI_CREATE_FACTORY_DEBUG;
+        static std::vector<uint32_t> _histogram(const std::vector<FrameTimes>& frames, FrameTiming timing,
+            double bucketMs, uint32_t bucketCount);
 
-        ID3D12Debug1* debugController = nullptr;
-        if (SUCCEEDED(D3D12GetDebugInterface(IID_PPV_ARGS(&debugController)))) {
-            debugController->EnableDebugLayer();
-            debugController->SetEnableGPUBasedValidation(true);
-            debugController->SetEnableSynchronizedCommandQueueValidation(true);
-        }
-        SAFE_RELEASE(debugController);
+        std::vector<Slot> _slots;
+        std::atomic<uint64_t> _frameCount{ 0 };
+        FrameTimes _current;
+    };
 
-        IDXGIInfoQueue* dxgiInfoQueue = nullptr;
-        if (SUCCEEDED(DXGIGetDebugInterface1(0, IID_PPV_ARGS(&dxgiInfoQueue)))) {
-            dxgiInfoQueue->SetBreakOnSeverity(DXGI_DEBUG_ALL, DXGI_INFO_QUEUE_MESSAGE_SEVERITY_ERROR, true);
-            dxgiInfoQueue->SetBreakOnSeverity(DXGI_DEBUG_ALL, DXGI_INFO_QUEUE_MESSAGE_SEVERITY_CORRUPTION, true);
-        }
-        SAFE_RELEASE(dxgiInfoQueue);
-#endif
 
-        HRESULT hr;
-        IDXGIFactory4* dxgiFactory = nullptr;
-        hr = CreateDXGIFactory2(dxgiFactoryFlags, IID_PPV_ARGS(&dxgiFactory));
-        if (SUCCEEDED(hr)) {
-            _dxgiFactory = std::shared_ptr<IDXGIFactory4>(dxgiFactory, PtrDeleter());
-        }
+    ///
+    /// GPU Profiler
+    ///
+    struct GpuTimingNode {
+        static const uint32_t kInvalidParent = UINT32_MAX;
+
+        std::string name;
+        uint32_t parent = kInvalidParent;
+        uint32_t depth = 0;
+        double beginMs = 0.0;                   // From the first timestamp of the frame
+        double durationMs = 0.0;
+    };
 
-        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
-        return _dxgiFactory;
-    }
+    struct GpuFrameTimings {
+        uint64_t frameNumber = 0;
+        std::vector<GpuTimingNode> nodes;      // Depth first, in the order scopes began
 
+        // Indented tree, one scope per line
+        std::string toString() const;
+        std::string toJson() const;
+    };
 
-    D3D12DeviceWrapperPtr createDevice(D3D_FEATURE_LEVEL featureLevel, HRESULT* outResult) {
-        HRESULT hr = E_FAIL;
-        std::shared_ptr<IDXGIFactory4> dxgiFactory = _getOrCreateDXIG(&hr);
+    /// Hierarchical GPU timings from timestamp queries. Every frame in flight owns a range of queries; endFrame()
+    /// resolves the range into a readback buffer and beginFrame() reads back frames the GPU completed since,
+    /// without waiting. A frame whose range is still in flight is not profiled. Scopes are recorded from one
+    /// thread, command lists must execute in recording order on one queue.
+    class GpuProfiler {
+    public:
+        typedef std::function<void(ID3D12GraphicsCommandList* commandList, uint32_t query)> TimestampFunction;
+        typedef std::function<void(ID3D12GraphicsCommandList* commandList, uint32_t firstQuery,
+            uint32_t queryCount)> ResolveFunction;
+        typedef std::function<void(uint32_t firstQuery, uint32_t queryCount, uint64_t* outTimestamps)>
+            ReadbackFunction;
 
-        ID3D12Device2* device = nullptr;
+        static const uint32_t kFrameCount = FramePacer::kMaxLatency + 1;
+
+        GpuProfiler(uint64_t timestampFrequency, uint32_t maxScopesPerFrame, TimestampFunction timestampFunction,
+            ResolveFunction resolveFunction, ReadbackFunction readbackFunction);
+
+        // Reads back frames signaled with a fence value <= completedFenceValue, then starts profiling a frame
+        void beginFrame(uint64_t completedFenceValue);
+        void endFrame(ID3D12GraphicsCommandList* commandList, uint64_t fenceValue);
+
+        // Scopes nest, scopes past maxScopesPerFrame() are dropped with their children
+        void beginScope(ID3D12GraphicsCommandList* commandList, const char* name);
+        void endScope(ID3D12GraphicsCommandList* commandList);
+
+        // Latest frame read back
+        inline const GpuFrameTimings& lastFrameTimings() const { return _lastFrameTimings; }
+        inline uint64_t resolvedFrameCount() const { return _resolvedFrameCount; }
+        inline uint64_t droppedFrameCount() const { return _droppedFrameCount; }
+        inline uint64_t droppedScopeCount() const { return _droppedScopeCount; }
+        inline uint32_t maxScopesPerFrame() const { return _maxQueriesPerFrame / 2; }
+        inline uint32_t queryCount() const { return _maxQueriesPerFrame * kFrameCount; }
+
+    private:
+        static constexpr uint32_t kInvalidQuery = UINT32_MAX;
+
+        struct Scope {
+            std::string name;
+            uint32_t parent;
+            uint32_t depth;
+            uint32_t beginQuery;
+            uint32_t endQuery;
+        };
+
+        struct Frame {
+            uint64_t frameNumber = 0;
+            uint64_t fenceValue = 0;
+            bool isPending = false;
+            uint32_t queryCount = 0;
+            std::vector<Scope> scopes;
+        };
+
+        void _readback(Frame& frame);
+
+        uint64_t _timestampFrequency;
+        uint32_t _maxQueriesPerFrame;
+        TimestampFunction _timestampFunction;
+        ResolveFunction _resolveFunction;
+        ReadbackFunction _readbackFunction;
+
+        Frame _frames[kFrameCount];
+        Frame* _currentFrame = nullptr;             // Null when the frame is not profiled
+        std::vector<uint32_t> _scopeStack;          // Open scope indices, kInvalidQuery for dropped ones
+        std::deque<Frame*> _pendingFrames;          // In submission order
+        std::vector<uint64_t> _timestamps;
+        uint64_t _frameNumber = 0;
+
+        GpuFrameTimings _lastFrameTimings;
+        uint64_t _resolvedFrameCount = 0;
+        uint64_t _droppedFrameCount = 0;
+        uint64_t _droppedScopeCount = 0;
+    };
+
+    /// Profiles the enclosing block on commandList, profiler may be null
+    class GpuProfilerScope {
+    public:
+        GpuProfilerScope(GpuProfiler* profiler, ID3D12GraphicsCommandList* commandList, const char* name) :
+            _profiler(profiler), _commandList(commandList) {
+            if (_profiler) {
+                _profiler->beginScope(_commandList, name);
+            }
+        }
+        GpuProfilerScope(const GpuProfilerScope&) = delete;
+        GpuProfilerScope& operator=(const GpuProfilerScope&) = delete;
+        ~GpuProfilerScope() {
+            if (_profiler) {
+                _profiler->endScope(_commandList);
+            }
+        }
+
+    private:
+        GpuProfiler* _profiler;
+        ID3D12GraphicsCommandList* _commandList;
+    };
+
+
+    ///
+    /// CPU Profiler
+    ///
+
+    /// Scoped CPU timings saved as Chrome trace events, for chrome://tracing or ui.perfetto.dev. Each thread
+    /// writes completed scopes to its own ring of kEventsPerThread events without locks, a thread that exits
+    /// hands its ring to the next new thread. Timestamps are TSC ticks on x64, converted to time when saved.
+    /// Scope names are not copied, e.g. string literals.
+    class CpuProfiler {
+    public:
+        static const uint32_t kEventsPerThread = 1 << 15;
+
+        static inline uint64_t ticks() {
+#if defined(_M_X64) || defined(__x86_64__)
+            return __rdtsc();
+#else
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+        }
+
+        static inline void record(const char* name, uint64_t beginTicks, uint64_t endTicks) {
+            ThreadBuffer* buffer = (_threadBuffer != nullptr) ? _threadBuffer : _registerThread();
+            uint64_t index = buffer->writeIndex.load(std::memory_order_relaxed);
+            Event& event = buffer->events[index & (kEventsPerThread - 1)];
+            event.name.store(name, std::memory_order_relaxed);
+            event.beginTicks.store(beginTicks, std::memory_order_relaxed);
+            event.endTicks.store(endTicks, std::memory_order_relaxed);
+            buffer->writeIndex.store(index + 1, std::memory_order_release);
+        }
+
+        static inline void setEnabled(bool isEnabled) { _isEnabled.store(isEnabled, std::memory_order_relaxed); }
+        static inline bool isEnabled() { return _isEnabled.load(std::memory_order_relaxed); }
+
+        // Shown as the track name of the calling thread
+        static void setThreadName(const char* name);
+
+        // Drops every event recorded so far, threads keep recording
+        static void clear();
+
+        static std::string toChromeTraceJson();
+        static HRESULT save(const std::filesystem::path& filePath);
+
+    private:
+        struct Event {
+            std::atomic<const char*> name{ nullptr };
+            std::atomic<uint64_t> beginTicks{ 0 };
+            std::atomic<uint64_t> endTicks{ 0 };
+        };
+
+        struct ThreadBuffer {
+            std::unique_ptr<Event[]> events{ new Event[kEventsPerThread] };
+            std::atomic<uint64_t> writeIndex{ 0 };
+            std::atomic<uint64_t> clearIndex{ 0 };      // Events before it are dropped
+            uint32_t threadId = 0;
+            std::string threadName;
+            bool isOwned = false;
+        };
+
+        struct ThreadRelease {
+            ~ThreadRelease();
+        };
+
+        static ThreadBuffer* _registerThread();
+
+        inline static std::atomic<bool> _isEnabled{ true };
+        inline static thread_local ThreadBuffer* _threadBuffer = nullptr;
+        inline static std::mutex _mutex;
+        inline static std::vector<std::unique_ptr<ThreadBuffer>> _threadBuffers;
+
+        // Time of tick 0 of the trace, ticks are converted against the time elapsed since
+        inline static const uint64_t _originTicks = ticks();
+        inline static const std::chrono::steady_clock::time_point _originTime = std::chrono::steady_clock::now();
+    };
+
+    /// Profiles the enclosing block while the profiler is enabled, see FASTDX_PROFILE_SCOPE
+    class CpuProfilerScope {
+    public:
+        explicit CpuProfilerScope(const char* name) :
+            _name(CpuProfiler::isEnabled() ? name : nullptr), _beginTicks(_name ? CpuProfiler::ticks() : 0) {
+        }
+        CpuProfilerScope(const CpuProfilerScope&) = delete;
+        CpuProfilerScope& operator=(const CpuProfilerScope&) = delete;
+        ~CpuProfilerScope() {
+            if (_name) {
+                CpuProfiler::record(_name, _beginTicks, CpuProfiler::ticks());
+            }
+        }
+
+    private:
+        const char* _name;
+        uint64_t _beginTicks;
+    };
+
+#if defined(FASTDX_DISABLE_PROFILING)
+#define FASTDX_PROFILE_SCOPE(name)
+#else
+#define FASTDX_PROFILE_CONCAT_(a, b) a##b
+#define FASTDX_PROFILE_CONCAT(a, b) FASTDX_PROFILE_CONCAT_(a, b)
+#define FASTDX_PROFILE_SCOPE(name) fastdx::CpuProfilerScope FASTDX_PROFILE_CONCAT(_profileScope, __LINE__)(name)
+#endif
+#define FASTDX_PROFILE_FUNCTION() FASTDX_PROFILE_SCOPE(__FUNCTION__)
+
+
+    ///
+    /// Video Memory Residency Manager
+    ///
+    enum class ResourceCategory : uint8_t {
+        Buffer,
+        Texture,
+        RenderTarget,
+        DepthStencil,
+        Upload,
+        Readback,
+        Count
+    };
+
+    struct VideoMemoryBudget {
+        uint64_t budgetInBytes = UINT64_MAX;
+        uint64_t usageInBytes = 0;
+    };
+
+    /// Tracks every pageable allocation by category and keeps video memory usage under the OS budget by
+    /// evicting least-recently-used objects. An object is only evicted once the fence value of its last use
+    /// completed, whatever the number of frames in flight. Evicted objects are made resident again by markUsed().
+    class ResidencyManager {
+    public:
+        typedef std::function<VideoMemoryBudget()> BudgetSource;
+        typedef std::function<HRESULT(uint32_t count, ID3D12Pageable* const* objects)> ResidencyFunction;
+
+        ResidencyManager(BudgetSource budgetSource, ResidencyFunction evictFunction,
+            ResidencyFunction makeResidentFunction);
+
+        // Evictable objects are only evicted once marked used, objects never marked stay resident
+        void track(ID3D12Pageable* object, uint64_t sizeInBytes, ResourceCategory category, bool isEvictable);
+        void untrack(ID3D12Pageable* object);
+
+        // Moves object to the most-recently-used end, making it resident first if it was evicted. fenceValue is
+        // signaled once the GPU is done with the commands using object, e.g. FrameContext::frameFenceValue()
+        HRESULT markUsed(ID3D12Pageable* object, uint64_t fenceValue);
+
+        // Marks a frame's objects under one lock, evicted ones are made resident with a single call
+        HRESULT markUsed(uint32_t count, ID3D12Pageable* const* objects, uint64_t fenceValue);
+
+        // Polls the budget and evicts objects whose last use is <= completedFenceValue, on the same fence
+        HRESULT update(uint64_t completedFenceValue);
+
+        uint64_t allocatedSizeInBytes(ResourceCategory category) const;
+        uint64_t residentSizeInBytes() const;
+        uint64_t evictedSizeInBytes() const;
+        inline VideoMemoryBudget lastBudget() const { return _lastBudget; }
+
+    private:
+        struct Entry {
+            uint64_t sizeInBytes;
+            uint64_t lastUsedFenceValue;
+            ResourceCategory category;
+            bool isEvictable;
+            bool isResident;
+            std::list<ID3D12Pageable*>::iterator lruIterator;
+        };
+
+        BudgetSource _budgetSource;
+        ResidencyFunction _evictFunction;
+        ResidencyFunction _makeResidentFunction;
+
+        mutable std::mutex _mutex;
+        std::unordered_map<ID3D12Pageable*, Entry> _entries;
+        std::list<ID3D12Pageable*> _residentLru;   // Evictable and resident only, front is least recently used
+        uint64_t _allocatedSizeInBytes[static_cast<size_t>(ResourceCategory::Count)] = {};
+        uint64_t _evictedSizeInBytes = 0;
+        VideoMemoryBudget _lastBudget;
+    };
+
+
+    ///
+    /// Descriptor Heap Allocators
+    ///
+    struct DescriptorRange {
+        D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle = {};
+        D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle = {};
+        uint32_t index = UINT32_MAX;                // First descriptor index in heap
+        uint32_t count = 0;
+        uint32_t descriptorSize = 0;
+
+        inline bool isValid() const { return count > 0; }
+        inline D3D12_CPU_DESCRIPTOR_HANDLE cpu(uint32_t offset) const { return { cpuHandle.ptr + offset * descriptorSize }; }
+        inline D3D12_GPU_DESCRIPTOR_HANDLE gpu(uint32_t offset) const { return { gpuHandle.ptr + offset * descriptorSize }; }
+    };
+
+    /// First-fit allocator of [offset, offset + size) ranges, adjacent ranges are merged on free
+    class RangeAllocator {
+    public:
+        static const uint32_t kInvalidOffset = UINT32_MAX;
+
+        RangeAllocator(uint32_t size = 0);
+
+        uint32_t allocate(uint32_t size);
+        void free(uint32_t offset, uint32_t size);
+
+        inline uint32_t size() const { return _size; }
+        inline uint32_t freeSize() const { return _freeSize; }
+
+    private:
+        std::map<uint32_t, uint32_t> _freeRanges;   // Offset to size
+        uint32_t _size;
+        uint32_t _freeSize;
+    };
+
+    /// CPU-only descriptors for view creation, one at a time. Freed descriptors are reused and the heap
+    /// grows by whole pages. Copy into a ShaderVisibleDescriptorHeap to use them in shaders.
+    class StagingDescriptorHeap {
+    public:
+        StagingDescriptorHeap(ID3D12DevicePtr device, D3D12_DESCRIPTOR_HEAP_TYPE heapType, uint32_t descriptorsPerPage);
+
+        D3D12_CPU_DESCRIPTOR_HANDLE allocate(HRESULT* outResult = nullptr);
+        void free(D3D12_CPU_DESCRIPTOR_HANDLE handle);
+
+        inline uint32_t allocatedCount() const { return _allocatedCount; }
+
+    private:
+        ID3D12DevicePtr _device;
+        D3D12_DESCRIPTOR_HEAP_TYPE _heapType;
+        uint32_t _descriptorsPerPage;
+        uint32_t _descriptorSize;
+
+        std::vector<ID3D12DescriptorHeapPtr> _pages;
+        std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> _freeHandles;
+        uint32_t _pageOffset = 0;
+        uint32_t _allocatedCount = 0;
+    };
+
+    /// Single shader-visible heap split in two: static ranges for long-lived tables at the start, then a
+    /// ring partitioned per frame in flight for transient tables, rewound on beginFrame().
+    class ShaderVisibleDescriptorHeap {
+    public:
+        ShaderVisibleDescriptorHeap(ID3D12DevicePtr device, ID3D12DescriptorHeapPtr heap, uint32_t staticCount,
+            uint32_t transientCountPerFrame, int32_t frameCount);
+
+        DescriptorRange allocateStatic(uint32_t count);
+        void freeStatic(const DescriptorRange& range);
+
+        void beginFrame(int32_t frameIndex);
+        DescriptorRange allocateTransient(uint32_t count);
+
+        // Gathers scattered staging descriptors into one contiguous transient table, with a single copy call
+        DescriptorRange copyToTransient(uint32_t count, const D3D12_CPU_DESCRIPTOR_HANDLE* srcHandles);
+
+        inline ID3D12DescriptorHeapPtr heap() const { return _heap; }
+        inline uint32_t descriptorSize() const { return _descriptorSize; }
+
+    private:
+        DescriptorRange _makeRange(uint32_t index, uint32_t count) const;
+
+        ID3D12DevicePtr _device;
+        ID3D12DescriptorHeapPtr _heap;
+        D3D12_DESCRIPTOR_HEAP_TYPE _heapType;
+        D3D12_CPU_DESCRIPTOR_HANDLE _cpuStart;
+        D3D12_GPU_DESCRIPTOR_HANDLE _gpuStart;
+        uint32_t _descriptorSize;
+
+        RangeAllocator _staticAllocator;
+        uint32_t _transientCountPerFrame;
+        int32_t _frameCount;
+        uint32_t _transientFrameStart;
+        uint32_t _transientOffset = 0;
+    };
+
+
+    ///
+    /// Bindless Resource Table
+    ///
+    /// Views with stable indices in a shader-visible heap, for shaders indexing ResourceDescriptorHeap[].
+    /// Views added together are contiguous, range.index is the bindless index of the first one.
+    /// Keeps the viewed resources alive until removed, remove only once the GPU is done with them.
+    class BindlessResourceTable {
+    public:
+        BindlessResourceTable(ID3D12DevicePtr device, ShaderVisibleDescriptorHeapPtr heap);
+
+        DescriptorRange addShaderResourceViews(uint32_t count, const ID3D12ResourcePtr* resources,
+            const D3D12_SHADER_RESOURCE_VIEW_DESC* descs);
+
+        inline DescriptorRange addShaderResourceView(ID3D12ResourcePtr resource,
+            const D3D12_SHADER_RESOURCE_VIEW_DESC& desc) {
+            return addShaderResourceViews(1, &resource, &desc);
+        }
+
+        void remove(uint32_t index);
+
+        inline ShaderVisibleDescriptorHeapPtr heap() const { return _heap; }
+        inline uint32_t viewCount() const { return _viewCount; }
+
+    private:
+        struct Entry {
+            DescriptorRange range;
+            std::vector<ID3D12ResourcePtr> resources;
+        };
+
+        ID3D12DevicePtr _device;
+        ShaderVisibleDescriptorHeapPtr _heap;
+        std::unordered_map<uint32_t, Entry> _entries;
+        uint32_t _viewCount = 0;
+    };
+
+
+    ///
+    /// Sampler Cache
+    ///
+    /// Deduplicates samplers in a shader-visible sampler heap, equal descs share one descriptor. Released
+    /// samplers stay cached and are only recycled once the heap is full, as the heap is capped at 2048.
+    class SamplerCache {
+    public:
+        SamplerCache(ID3D12DevicePtr device, ShaderVisibleDescriptorHeapPtr heap);
+
+        // Returns a single descriptor range, invalid when every sampler in the heap is referenced
+        DescriptorRange acquire(const D3D12_SAMPLER_DESC& desc);
+
+        // The descriptor may be recycled afterwards, release only once the GPU is done with it
+        void release(const DescriptorRange& range);
+
+        inline ShaderVisibleDescriptorHeapPtr heap() const { return _heap; }
+        inline uint32_t samplerCount() const { return static_cast<uint32_t>(_entries.size()); }
+        inline uint64_t hitCount() const { return _hitCount; }
+        inline uint64_t missCount() const { return _missCount; }
+
+    private:
+        struct Entry {
+            D3D12_SAMPLER_DESC desc;    // Canonical
+            uint64_t hash;
+            DescriptorRange range;
+            uint32_t refCount;
+            std::list<uint32_t>::iterator unreferencedIterator;
+        };
+
+        ID3D12DevicePtr _device;
+        ShaderVisibleDescriptorHeapPtr _heap;
+        std::unordered_map<uint32_t, Entry> _entries;               // Heap index to entry
+        std::unordered_multimap<uint64_t, uint32_t> _hashToIndex;
+        std::list<uint32_t> _unreferenced;                          // Front is least recently released
+        uint64_t _hitCount = 0;
+        uint64_t _missCount = 0;
+    };
+
+
+    ///
+    /// Command Context Pool
+    ///
+    struct CommandContext {
+        ID3D12GraphicsCommandListPtr commandList;
+        ID3D12CommandAllocatorPtr commandAllocator;
+    };
+
+    /// One command list per slot for recording on several threads, each thread records into its own slot.
+    /// Lists are reused right after submit, allocators once the GPU passes the fence value of their submit.
+    class CommandContextPool {
+    public:
+        CommandContextPool(ID3D12DevicePtr device, D3D12_COMMAND_LIST_TYPE commandType);
+
+        // Recycles allocators submitted with a fence value <= completedFenceValue
+        void beginFrame(uint64_t completedFenceValue);
+
+        // Thread-safe, returns the slot context open for recording. Acquiring an open slot returns it again
+        CommandContext acquire(uint32_t slot, HRESULT* outResult = nullptr);
+
+        // Closes and executes the open contexts in slot order with a single call, whichever thread recorded
+        // them. The caller signals fenceValue on the queue afterwards
+        void submit(ID3D12CommandQueuePtr commandQueue, uint64_t fenceValue);
+
+        inline uint32_t allocatorCount() const { return _allocatorCount; }
+        inline uint32_t freeAllocatorCount() const { return static_cast<uint32_t>(_freeAllocators.size()); }
+
+    private:
+        struct InFlightAllocator {
+            uint64_t fenceValue;
+            ID3D12CommandAllocatorPtr commandAllocator;
+        };
+
+        ID3D12DevicePtr _device;
+        D3D12_COMMAND_LIST_TYPE _commandType;
+
+        std::mutex _mutex;
+        std::vector<CommandContext> _slots;                 // Null allocator when closed
+        std::vector<ID3D12CommandAllocatorPtr> _freeAllocators;
+        std::list<InFlightAllocator> _inFlightAllocators;   // Increasing fence values
+        uint32_t _allocatorCount = 0;
+    };
+
+    /// Persistent threads for per-frame fork/join work such as recording draws into one stream per part.
+    /// run() splits the job in parts picked up by the workers and the calling thread, and returns once all
+    /// parts are done. Not reentrant, run() is called from one thread at a time.
+    class WorkerPool {
+    public:
+        typedef std::function<void(uint32_t partIndex)> PartFunction;
+
+        // threadCount includes the calling thread, workers are named threadName in CPU profiles
+        WorkerPool(uint32_t threadCount, const char* threadName = nullptr);
+        ~WorkerPool();
+
+        void run(uint32_t partCount, const PartFunction& function);
+
+        inline uint32_t threadCount() const { return static_cast<uint32_t>(_workers.size()) + 1; }
+
+    private:
+        void _workerMain(const char* threadName);
+        void _runParts(std::unique_lock<std::mutex>& lock);
+
+        std::vector<std::thread> _workers;
+
+        std::mutex _mutex;
+        std::condition_variable _partsAvailable;
+        std::condition_variable _partsDone;
+        const PartFunction* _function = nullptr;
+        uint32_t _partCount = 0;
+        uint32_t _nextPart = 0;
+        uint32_t _runningPartCount = 0;     // Parts of the current run not done yet
+        bool _isStopping = false;
+    };
+
+
+    ///
+    /// Resource State Tracker
+    ///
+    /// Knows the current state of each tracked resource and subresource. Transitions are queued as needed,
+    /// transitions back and forth before a flush cancel out, and flush() issues them all in one call.
+    /// Not thread-safe, use one tracker per recording thread or record barriers on a single thread.
+    class ResourceStateTracker {
+    public:
+        void track(ID3D12Resource* resource, D3D12_RESOURCE_STATES state, uint32_t subresourceCount = 1);
+        void untrack(ID3D12Resource* resource);
+
+        // Skipped when already in state, or when state only adds no read bits to a read-only state
+        inline void transition(ID3D12Resource* resource, D3D12_RESOURCE_STATES state,
+            uint32_t subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES) {
+            _transition(resource, state, subresource, D3D12_RESOURCE_BARRIER_FLAG_NONE);
+        }
+
+        // Split barrier, the GPU may overlap the transition with the work recorded until endTransition()
+        inline void beginTransition(ID3D12Resource* resource, D3D12_RESOURCE_STATES state,
+            uint32_t subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES) {
+            _transition(resource, state, subresource, D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY);
+        }
+        void endTransition(ID3D12Resource* resource);
+
+        void uavBarrier(ID3D12Resource* resource);
+
+        // Issues all queued barriers with a single ResourceBarrier call, returns the number of barriers
+        uint32_t flush(ID3D12GraphicsCommandListPtr commandList);
+
+        D3D12_RESOURCE_STATES state(ID3D12Resource* resource, uint32_t subresource = 0) const;
+
+        inline const std::vector<D3D12_RESOURCE_BARRIER>& pendingBarriers() const { return _pendingBarriers; }
+        inline uint64_t requestedCount() const { return _requestedCount; }
+        inline uint64_t barrierCount() const { return _barrierCount; }
+        inline uint64_t flushCount() const { return _flushCount; }
+
+    private:
+        struct TrackedResource {
+            std::vector<D3D12_RESOURCE_STATES> subresourceStates;   // Single entry while uniform
+            uint32_t subresourceCount;
+        };
+
+        void _transition(ID3D12Resource* resource, D3D12_RESOURCE_STATES state, uint32_t subresource,
+            D3D12_RESOURCE_BARRIER_FLAGS flags);
+        void _queueTransition(ID3D12Resource* resource, uint32_t subresource, D3D12_RESOURCE_STATES stateBefore,
+            D3D12_RESOURCE_STATES stateAfter, D3D12_RESOURCE_BARRIER_FLAGS flags);
+
+        std::unordered_map<ID3D12Resource*, TrackedResource> _resources;
+        std::vector<D3D12_RESOURCE_BARRIER> _pendingBarriers;
+        std::vector<D3D12_RESOURCE_BARRIER> _splitBarriers;     // Begun, waiting for endTransition()
+        uint64_t _requestedCount = 0;
+        uint64_t _barrierCount = 0;
+        uint64_t _flushCount = 0;
+    };
+
+
+    ///
+    /// Render Graph
+    ///
+    /// Frame graph rebuilt every frame: declare resources and passes with their reads and writes, compile,
+    /// then execute. compile() is CPU-only, it culls passes whose outputs are never used, computes the
+    /// barriers before each pass and packs transient textures with disjoint lifetimes at shared offsets of
+    /// one heap per frame in flight. On resource heap tier 1 devices, render target and depth textures, other
+    /// textures and buffers are packed in separate heaps. Aliased transients start with undefined content,
+    /// their first writer must fully clear or overwrite them. The heaps are tracked as non-evictable by the
+    /// residency manager, placed textures are not tracked: their memory is the heap's and only pages with it.
+    class RenderGraph {
+    public:
+        static const uint32_t kInvalidId = UINT32_MAX;
+
+        typedef std::function<D3D12_RESOURCE_ALLOCATION_INFO(const D3D12_RESOURCE_DESC& desc)> AllocationInfoFunction;
+        typedef std::function<void(ID3D12GraphicsCommandListPtr commandList)> ExecuteFunction;
+        typedef std::function<ID3D12GraphicsCommandListPtr()> CommandListFunction;
+
+        RenderGraph(ID3D12DevicePtr device, int32_t frameCount, AllocationInfoFunction allocationInfoFunction,
+            ResidencyManagerPtr residencyManager = nullptr);
+
+        // Drops the passes and resources declared last frame, keeps the transient heaps and textures
+        void reset();
+
+        uint32_t createTexture(const char* name, const D3D12_RESOURCE_DESC& desc,
+            const D3D12_CLEAR_VALUE* clearValue = nullptr);
+
+        // Resource owned outside the graph, in state before the graph executes and transitioned back after
+        uint32_t importResource(const char* name, ID3D12Resource* resource, D3D12_RESOURCE_STATES state);
+
+        // Passes execute in the order they are added, side effect passes are never culled
+        uint32_t addPass(const char* name, ExecuteFunction execute, bool hasSideEffects = false);
+        void read(uint32_t pass, uint32_t resource, D3D12_RESOURCE_STATES state);
+        void write(uint32_t pass, uint32_t resource, D3D12_RESOURCE_STATES state);
+
+        void compile();
+
+        // Places transient textures in the frameIndex heap, which the GPU must be done with, then records each
+        // pass after its barriers. nextCommandList is called before each pass and once for the final barriers
+        HRESULT execute(int32_t frameIndex, const CommandListFunction& nextCommandList);
+
+        // Valid from execute() on
+        ID3D12Resource* resource(uint32_t resource) const;
+
+        inline bool isPassCulled(uint32_t pass) const { return _passes[pass].isCulled; }
+        inline uint32_t culledPassCount() const { return _culledPassCount; }
+        inline uint64_t heapOffset(uint32_t resource) const { return _resources[resource].heapOffset; }
+        inline uint64_t transientSizeInBytes() const { return _transientSizeInBytes; }
+        inline uint64_t heapSizeInBytes() const { return _heapSizeInBytes; }
+        inline uint64_t aliasingSavedSizeInBytes() const { return _transientSizeInBytes - _heapSizeInBytes; }
+
+    private:
+        struct Access {
+            uint32_t resource;
+            D3D12_RESOURCE_STATES state;
+            bool isWrite;
+        };
+
+        struct Transition {
+            uint32_t resource;
+            D3D12_RESOURCE_STATES stateBefore;
+            D3D12_RESOURCE_STATES stateAfter;
+            bool isFirstUse;                    // Transient, before state is the placed texture state
+        };
+
+        struct Pass {
+            std::string name;
+            ExecuteFunction execute;
+            bool hasSideEffects;
+            std::vector<Access> accesses;
+            uint32_t refCount = 0;
+            bool isCulled = false;
+            std::vector<Transition> transitions;
+        };
+
+        // Tier 2 places every transient in the first heap
+        enum HeapIndex : uint32_t {
+            RenderTargetHeap,
+            TextureHeap,
+            BufferHeap,
+            HeapCount
+        };
+
+        struct Resource {
+            std::string name;
+            D3D12_RESOURCE_DESC desc = {};
+            bool hasClearValue = false;
+            D3D12_CLEAR_VALUE clearValue = {};
+            ID3D12Resource* imported = nullptr;
+            D3D12_RESOURCE_STATES importedState = D3D12_RESOURCE_STATE_COMMON;
+            uint32_t refCount = 0;
+            uint32_t firstPass = kInvalidId;
+            uint32_t lastPass = kInvalidId;
+            D3D12_RESOURCE_STATES firstState = D3D12_RESOURCE_STATE_COMMON;
+            D3D12_RESOURCE_STATES lastState = D3D12_RESOURCE_STATE_COMMON;
+            D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = {};
+            uint32_t heapIndex = RenderTargetHeap;
+            uint64_t heapOffset = UINT64_MAX;
+            bool isAliased = false;
+            ID3D12Resource* placed = nullptr;
+        };
+
+        struct PlacedTexture {
+            D3D12_RESOURCE_DESC desc;
+            uint32_t heapIndex;
+            uint64_t heapOffset;
+            ID3D12ResourcePtr resource;
+            D3D12_RESOURCE_STATES state;
+            bool isUsed;
+        };
+
+        struct FrameHeap {
+            ID3D12HeapPtr heaps[HeapCount];
+            uint64_t sizesInBytes[HeapCount] = {};
+            std::vector<PlacedTexture> placedTextures;
+        };
+
+        uint32_t _heapIndex(const D3D12_RESOURCE_DESC& desc) const;
+        void _cullPasses();
+        void _computeTransitions();
+        void _placeTransients();
+
+        ID3D12DevicePtr _device;
+        AllocationInfoFunction _allocationInfoFunction;
+        ResidencyManagerPtr _residencyManager;
+        D3D12_RESOURCE_HEAP_TIER _resourceHeapTier = D3D12_RESOURCE_HEAP_TIER_1;
+        std::vector<FrameHeap> _frameHeaps;
+
+        std::vector<Pass> _passes;
+        std::vector<Resource> _resources;
+        std::vector<Transition> _finalTransitions;
+        uint32_t _culledPassCount = 0;
+        uint64_t _transientSizeInBytes = 0;
+        uint64_t _heapSizeInBytes = 0;                  // All heaps
+        uint64_t _heapSizesInBytes[HeapCount] = {};
+        uint64_t _heapAlignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    };
+
+
+    ///
+    /// Draw Packet Queue
+    ///
+    struct DrawPacket {
+        uint64_t sortKey;
+        uint32_t drawIndex;     // Application draw data
+    };
+
+    /// Draws sorted by a 64-bit key, most significant first: pass (8 bits), pipeline (16), material (16) and
+    /// depth (24). Executing in key order groups draws by state, so consecutive draws skip rebinding it.
+    class DrawPacketQueue {
+    public:
+        enum StateChange : uint32_t {
+            kPipelineChanged = 0x1,
+            kMaterialChanged = 0x2,
+            kPassChanged = 0x4,
+            kAllChanged = 0x7
+        };
+        typedef std::function<void(const DrawPacket& packet, uint32_t stateChanges)> ExecuteFunction;
+
+        // Depth in [0, 1], pass 1 - depth for back to front order
+        static inline uint64_t sortKey(uint8_t pass, uint16_t pipeline, uint16_t material, float depth) {
+            uint64_t depthBits = static_cast<uint64_t>(std::min(std::max(depth, 0.0f), 1.0f) * 0xFFFFFF);
+            return (uint64_t(pass) << 56) | (uint64_t(pipeline) << 40) | (uint64_t(material) << 24) | depthBits;
+        }
+        static inline uint8_t sortKeyPass(uint64_t sortKey) { return static_cast<uint8_t>(sortKey >> 56); }
+        static inline uint16_t sortKeyPipeline(uint64_t sortKey) { return static_cast<uint16_t>(sortKey >> 40); }
+        static inline uint16_t sortKeyMaterial(uint64_t sortKey) { return static_cast<uint16_t>(sortKey >> 24); }
+
+        inline void clear() { _packets.clear(); }
+        inline void push(uint64_t sortKey, uint32_t drawIndex) { _packets.push_back({ sortKey, drawIndex }); }
+
+        // Stable LSD radix sort on 8 bit digits, digits equal in every key are skipped
+        void sort();
+
+        // Thread-safe, calls execute on sorted packets [begin, end). The first packet reports every state changed
+        void execute(uint32_t begin, uint32_t end, const ExecuteFunction& execute);
+
+        inline const std::vector<DrawPacket>& packets() const { return _packets; }
+        inline uint32_t size() const { return static_cast<uint32_t>(_packets.size()); }
+
+        // Pipeline and material binds issued and skipped since construction
+        inline uint64_t stateChangeCount() const { return _stateChangeCount.load(std::memory_order_relaxed); }
+        inline uint64_t avoidedStateChangeCount() const { return _avoidedStateChangeCount.load(std::memory_order_relaxed); }
+
+    private:
+        std::vector<DrawPacket> _packets;
+        std::vector<DrawPacket> _sortBuffer;
+        std::atomic<uint64_t> _stateChangeCount = 0;
+        std::atomic<uint64_t> _avoidedStateChangeCount = 0;
+    };
+
+
+    ///
+    /// State Filtering Command List
+    ///
+    /// Shadows the state bound on a command list and drops calls that would not change it. Setting a root
+    /// signature clears the root arguments, as D3D12 does, and setting descriptor heaps clears the descriptor
+    /// tables. Call invalidate() after resetting the list or recording through get(). Not thread-safe, like
+    /// the list itself.
+    class CommandList {
+    public:
+        static const uint32_t kMaxRootParameters = 64;
+        static const uint32_t kMaxRootSignatureDwords = 64;
+        static const uint32_t kMaxViewports = D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE;
+
+        CommandList(ID3D12GraphicsCommandListPtr commandList = nullptr);
+
+        void invalidate();
+
+        void setPipelineState(ID3D12PipelineState* pipelineState);
+        void setGraphicsRootSignature(ID3D12RootSignature* rootSignature);
+        void setPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY topology);
+        void setViewports(uint32_t count, const D3D12_VIEWPORT* viewports);
+        void setScissorRects(uint32_t count, const D3D12_RECT* rects);
+        void setRenderTargets(uint32_t count, const D3D12_CPU_DESCRIPTOR_HANDLE* rtvHandles,
+            const D3D12_CPU_DESCRIPTOR_HANDLE* dsvHandle);
+        void setDescriptorHeaps(uint32_t count, ID3D12DescriptorHeap* const* heaps);
+        void setIndexBuffer(const D3D12_INDEX_BUFFER_VIEW& view);
+
+        void setGraphicsRootConstantBufferView(uint32_t index, D3D12_GPU_VIRTUAL_ADDRESS address);
+        void setGraphicsRootShaderResourceView(uint32_t index, D3D12_GPU_VIRTUAL_ADDRESS address);
+        void setGraphicsRootDescriptorTable(uint32_t index, D3D12_GPU_DESCRIPTOR_HANDLE handle);
+        void setGraphicsRoot32BitConstants(uint32_t index, uint32_t count, const void* data, uint32_t offset);
+        inline void setGraphicsRoot32BitConstant(uint32_t index, uint32_t value, uint32_t offset) {
+            setGraphicsRoot32BitConstants(index, 1, &value, offset);
+        }
+
+        // Not shadowed, always forwarded
+        inline void setComputeRootSignature(ID3D12RootSignature* rootSignature) {
+            _commandList->SetComputeRootSignature(rootSignature);
+        }
+        inline void setComputeRootDescriptorTable(uint32_t index, D3D12_GPU_DESCRIPTOR_HANDLE handle) {
+            _commandList->SetComputeRootDescriptorTable(index, handle);
+        }
+        inline void setComputeRoot32BitConstants(uint32_t index, uint32_t count, const void* data, uint32_t offset) {
+            _commandList->SetComputeRoot32BitConstants(index, count, data, offset);
+        }
+        inline void setVertexBuffers(uint32_t startSlot, uint32_t count, const D3D12_VERTEX_BUFFER_VIEW* views) {
+            _commandList->IASetVertexBuffers(startSlot, count, views);
+        }
+
+        inline void clearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE handle, const float color[4]) {
+            _commandList->ClearRenderTargetView(handle, color, 0, nullptr);
+        }
+        inline void clearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE handle, D3D12_CLEAR_FLAGS flags, float depth,
+            uint8_t stencil) {
+            _commandList->ClearDepthStencilView(handle, flags, depth, stencil, 0, nullptr);
+        }
+        inline void resourceBarrier(uint32_t count, const D3D12_RESOURCE_BARRIER* barriers) {
+            _commandList->ResourceBarrier(count, barriers);
+        }
+
+        inline void drawInstanced(uint32_t vertexCount, uint32_t instanceCount, uint32_t startVertex,
+            uint32_t startInstance) {
+            _commandList->DrawInstanced(vertexCount, instanceCount, startVertex, startInstance);
+        }
+        inline void drawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex,
+            int32_t baseVertex, uint32_t startInstance) {
+            _commandList->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+        }
+        inline void dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) {
+            _commandList->Dispatch(groupCountX, groupCountY, groupCountZ);
+        }
+
+        // Bindings set by the command signature are undefined afterwards, index buffer and root arguments
+        // are forgotten
+        void executeIndirect(ID3D12CommandSignature* commandSignature, uint32_t maxCommandCount,
+            ID3D12Resource* argumentBuffer, uint64_t argumentBufferOffset, ID3D12Resource* countBuffer = nullptr,
+            uint64_t countBufferOffset = 0);
+
+        inline ID3D12GraphicsCommandListPtr get() const { return _commandList; }
+        inline ID3D12GraphicsCommandList6* operator->() const { return _commandList.get(); }
+
+        // State setting calls forwarded to and dropped before the list
+        inline uint64_t issuedCount() const { return _issuedCount; }
+        inline uint64_t filteredCount() const { return _filteredCount; }
+
+    private:
+        enum class RootArgumentType : uint8_t {
+            None,
+            ConstantBufferView,
+            ShaderResourceView,
+            DescriptorTable,
+            Constants
+        };
+
+        struct RootArgument {
+            RootArgumentType type;
+            uint8_t constantsOffset;            // Range reserved in _rootConstants
+            uint8_t constantsCount;
+            uint64_t value;
+            uint64_t constantsMask;             // Valid constant values
+        };
+
+        inline bool _filter(bool isRedundant) {
+            isRedundant ? ++_filteredCount : ++_issuedCount;
+            return isRedundant;
+        }
+        bool _filterRootArgument(uint32_t index, RootArgumentType type, uint64_t value);
+        bool _reserveRootConstants(uint32_t index, uint32_t count);
+        void _clearRootArguments();
+
+        ID3D12GraphicsCommandListPtr _commandList;
+
+        ID3D12PipelineState* _pipelineState;
+        ID3D12RootSignature* _rootSignature;
+        D3D12_PRIMITIVE_TOPOLOGY _topology;
+        uint32_t _viewportCount;
+        D3D12_VIEWPORT _viewports[kMaxViewports];
+        uint32_t _scissorRectCount;
+        D3D12_RECT _scissorRects[kMaxViewports];
+        uint32_t _renderTargetCount;
+        D3D12_CPU_DESCRIPTOR_HANDLE _renderTargets[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT];
+        D3D12_CPU_DESCRIPTOR_HANDLE _depthStencil;
+        ID3D12DescriptorHeap* _descriptorHeaps[2];
+        D3D12_INDEX_BUFFER_VIEW _indexBuffer;
+        RootArgument _rootArguments[kMaxRootParameters];
+        uint32_t _rootConstants[kMaxRootSignatureDwords];   // Shared by the root constants of the bound signature
+        uint32_t _rootConstantCount;
+
+        uint64_t _issuedCount = 0;
+        uint64_t _filteredCount = 0;
+    };
+
+
+    ///
+    /// Indirect Arguments
+    ///
+    /// Per-command layout of an ExecuteIndirect argument buffer. Arguments are packed in the order they are
+    /// added, the draw or dispatch argument must be added last.
+    class IndirectArgumentLayout {
+    public:
+        // Each returns the argument index used to write it
+        uint32_t addVertexBufferView(uint32_t slot);
+        uint32_t addIndexBufferView();
+        uint32_t addConstants(uint32_t rootParameterIndex, uint32_t count, uint32_t destOffset = 0);
+        uint32_t addConstantBufferView(uint32_t rootParameterIndex);
+        uint32_t addShaderResourceView(uint32_t rootParameterIndex);
+        uint32_t addDraw();
+        uint32_t addDrawIndexed();
+        uint32_t addDispatch();
+
+        bool changesRootArguments() const;
+        D3D12_COMMAND_SIGNATURE_DESC commandSignatureDesc(uint32_t nodeMask = 0) const;
+
+        inline uint32_t argumentCount() const { return static_cast<uint32_t>(_argumentDescs.size()); }
+        inline uint32_t offset(uint32_t argument) const { return _offsets[argument]; }
+        inline uint32_t sizeInBytes(uint32_t argument) const { return _sizesInBytes[argument]; }
+        inline uint32_t strideInBytes() const { return _strideInBytes; }
+        inline const std::vector<D3D12_INDIRECT_ARGUMENT_DESC>& argumentDescs() const { return _argumentDescs; }
+
+    private:
+        uint32_t _add(const D3D12_INDIRECT_ARGUMENT_DESC& desc, uint32_t sizeInBytes);
+
+        std::vector<D3D12_INDIRECT_ARGUMENT_DESC> _argumentDescs;
+        std::vector<uint32_t> _offsets;
+        std::vector<uint32_t> _sizesInBytes;
+        uint32_t _strideInBytes = 0;
+        bool _isClosed = false;
+    };
+
+    /// Packs commands of a layout into caller memory, usually a mapped upload buffer region. Every argument
+    /// of a command must be written, nothing is cleared between commands.
+    class IndirectArgumentWriter {
+    public:
+        IndirectArgumentWriter(const IndirectArgumentLayout& layout, void* data, size_t capacityInBytes);
+
+        // Starts the next command, returns false when it does not fit
+        bool beginCommand();
+
+        inline void writeData(uint32_t argument, const void* data) {
+            assert(_command != nullptr && argument < _layout.argumentCount());
+            memcpy(_command + _layout.offset(argument), data, _layout.sizeInBytes(argument));
+        }
+
+        template <typename T>
+        inline void write(uint32_t argument, const T& value) {
+            assert(sizeof(T) == _layout.sizeInBytes(argument));
+            writeData(argument, &value);
+        }
+
+        inline uint32_t commandCount() const { return _commandCount; }
+        inline size_t sizeInBytes() const { return static_cast<size_t>(_commandCount) * _layout.strideInBytes(); }
+
+    private:
+        const IndirectArgumentLayout& _layout;
+        uint8_t* _data;
+        size_t _capacityInBytes;
+        uint8_t* _command = nullptr;
+        uint32_t _commandCount = 0;
+    };
+
+
+    ///
+    /// Command Stream
+    ///
+    /// Compact recording of command list calls into arena pages, without touching D3D12. Recording uses the
+    /// CommandList method names and replay() calls them back on any type that has them: a CommandList for the
+    /// GPU, a NullCommandList to measure recording cost, or another stream. Objects and views are stored by
+    /// pointer or value and must stay alive until replayed. reset() keeps the pages for the next frame.
+    class CommandStream {
+    public:
+        static constexpr uint32_t kPageSizeInBytes = 64 * 1024;
+
+        enum class Opcode : uint16_t {
+            SetPipelineState,
+            SetGraphicsRootSignature,
+            SetComputeRootSignature,
+            SetPrimitiveTopology,
+            SetViewports,
+            SetScissorRects,
+            SetRenderTargets,
+            SetDescriptorHeaps,
+            SetIndexBuffer,
+            SetVertexBuffers,
+            SetGraphicsRootConstantBufferView,
+            SetGraphicsRootShaderResourceView,
+            SetGraphicsRootDescriptorTable,
+            SetGraphicsRoot32BitConstants,
+            SetComputeRootDescriptorTable,
+            SetComputeRoot32BitConstants,
+            ClearRenderTargetView,
+            ClearDepthStencilView,
+            ResourceBarrier,
+            DrawInstanced,
+            DrawIndexedInstanced,
+            Dispatch,
+            ExecuteIndirect,
+            Count
+        };
+
+        CommandStream() = default;
+        CommandStream(const CommandStream&) = delete;
+        CommandStream& operator=(const CommandStream&) = delete;
+        CommandStream(CommandStream&&) = default;
+        CommandStream& operator=(CommandStream&&) = default;
+
+        void reset();
+
+        void setPipelineState(ID3D12PipelineState* pipelineState);
+        void setGraphicsRootSignature(ID3D12RootSignature* rootSignature);
+        void setComputeRootSignature(ID3D12RootSignature* rootSignature);
+        void setPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY topology);
+        void setViewports(uint32_t count, const D3D12_VIEWPORT* viewports);
+        void setScissorRects(uint32_t count, const D3D12_RECT* rects);
+        void setRenderTargets(uint32_t count, const D3D12_CPU_DESCRIPTOR_HANDLE* rtvHandles,
+            const D3D12_CPU_DESCRIPTOR_HANDLE* dsvHandle);
+        void setDescriptorHeaps(uint32_t count, ID3D12DescriptorHeap* const* heaps);
+        void setIndexBuffer(const D3D12_INDEX_BUFFER_VIEW& view);
+        void setVertexBuffers(uint32_t startSlot, uint32_t count, const D3D12_VERTEX_BUFFER_VIEW* views);
+
+        void setGraphicsRootConstantBufferView(uint32_t index, D3D12_GPU_VIRTUAL_ADDRESS address);
+        void setGraphicsRootShaderResourceView(uint32_t index, D3D12_GPU_VIRTUAL_ADDRESS address);
+        void setGraphicsRootDescriptorTable(uint32_t index, D3D12_GPU_DESCRIPTOR_HANDLE handle);
+        void setGraphicsRoot32BitConstants(uint32_t index, uint32_t count, const void* data, uint32_t offset);
+        inline void setGraphicsRoot32BitConstant(uint32_t index, uint32_t value, uint32_t offset) {
+            setGraphicsRoot32BitConstants(index, 1, &value, offset);
+        }
+        void setComputeRootDescriptorTable(uint32_t index, D3D12_GPU_DESCRIPTOR_HANDLE handle);
+        void setComputeRoot32BitConstants(uint32_t index, uint32_t count, const void* data, uint32_t offset);
+
+        void clearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE handle, const float color[4]);
+        void clearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE handle, D3D12_CLEAR_FLAGS flags, float depth,
+            uint8_t stencil);
+        void resourceBarrier(uint32_t count, const D3D12_RESOURCE_BARRIER* barriers);
+
+        void drawInstanced(uint32_t vertexCount, uint32_t instanceCount, uint32_t startVertex,
+            uint32_t startInstance);
+        void drawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex,
+            int32_t baseVertex, uint32_t startInstance);
+        void dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ);
+        void executeIndirect(ID3D12CommandSignature* commandSignature, uint32_t maxCommandCount,
+            ID3D12Resource* argumentBuffer, uint64_t argumentBufferOffset, ID3D12Resource* countBuffer = nullptr,
+            uint64_t countBufferOffset = 0);
+
+        template <typename CommandListType>
+        void replay(CommandListType& commandList) const;
+
+        inline uint32_t commandCount() const { return _commandCount; }
+        inline size_t sizeInBytes() const { return _sizeInBytes; }
+        size_t capacityInBytes() const;
+
+        // Appends the recorded commands to outData, object pointers are written as opaque values
+        void serialize(std::vector<uint8_t>& outData) const;
+
+        // Replaces the recorded commands, returns false on malformed data
+        bool deserialize(const void* data, size_t sizeInBytes);
+
+    private:
+        struct CommandHeader {
+            Opcode opcode;
+            uint16_t reserved;
+            uint32_t sizeInBytes;               // Header, arguments and trailing data
+        };
+
+        // Shared by every command, trailing data follows the arguments
+        struct CommandArguments {
+            uint64_t value;
+            uint32_t index;
+            uint32_t count;
+        };
+
+        struct ExecuteIndirectArguments {
+            ID3D12CommandSignature* commandSignature;
+            ID3D12Resource* argumentBuffer;
+            uint64_t argumentBufferOffset;
+            ID3D12Resource* countBuffer;
+            uint64_t countBufferOffset;
+            uint32_t maxCommandCount;
+        };
+
+        struct Page {
+            std::unique_ptr<uint8_t[]> data;
+            uint32_t capacityInBytes;
+            uint32_t usedSizeInBytes;
+        };
+
+        static const uint32_t kAlignmentMask = 7;
+
+        // Trailing data replay() reads after the arguments, UINT64_MAX when a count is out of range
+        static uint64_t _dataSizeInBytes(Opcode opcode, const CommandArguments& args);
+
+        uint8_t* _allocate(uint32_t sizeInBytes);
+        void* _push(Opcode opcode, uint32_t argumentsSizeInBytes, const void* data = nullptr,
+            uint32_t dataSizeInBytes = 0);
+        void _pushArguments(Opcode opcode, uint64_t value, uint32_t index = 0, uint32_t count = 0,
+            const void* data = nullptr, uint32_t dataSizeInBytes = 0);
+
+        std::vector<Page> _pages;
+        size_t _pageIndex = 0;
+        uint32_t _commandCount = 0;
+        size_t _sizeInBytes = 0;
+    };
+
+
+    template <typename CommandListType>
+    void CommandStream::replay(CommandListType& commandList) const {
+        for (const Page& page : _pages) {
+            for (uint32_t offset = 0; offset < page.usedSizeInBytes;) {
+                const CommandHeader* header = reinterpret_cast<const CommandHeader*>(page.data.get() + offset);
+                const CommandArguments* args = reinterpret_cast<const CommandArguments*>(header + 1);
+                const void* data = args + 1;
+                offset += header->sizeInBytes;
+
+                switch (header->opcode) {
+                case Opcode::SetPipelineState:
+                    commandList.setPipelineState(reinterpret_cast<ID3D12PipelineState*>(args->value));
+                    break;
+                case Opcode::SetGraphicsRootSignature:
+                    commandList.setGraphicsRootSignature(reinterpret_cast<ID3D12RootSignature*>(args->value));
+                    break;
+                case Opcode::SetComputeRootSignature:
+                    commandList.setComputeRootSignature(reinterpret_cast<ID3D12RootSignature*>(args->value));
+                    break;
+                case Opcode::SetPrimitiveTopology:
+                    commandList.setPrimitiveTopology(static_cast<D3D12_PRIMITIVE_TOPOLOGY>(args->value));
+                    break;
+                case Opcode::SetViewports:
+                    commandList.setViewports(args->count, static_cast<const D3D12_VIEWPORT*>(data));
+                    break;
+                case Opcode::SetScissorRects:
+                    commandList.setScissorRects(args->count, static_cast<const D3D12_RECT*>(data));
+                    break;
+                case Opcode::SetRenderTargets: {
+                    D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = { static_cast<SIZE_T>(args->value) };
+                    commandList.setRenderTargets(args->count, static_cast<const D3D12_CPU_DESCRIPTOR_HANDLE*>(data),
+                        dsvHandle.ptr != 0 ? &dsvHandle : nullptr);
+                    break;
+                }
+                case Opcode::SetDescriptorHeaps:
+                    commandList.setDescriptorHeaps(args->count, static_cast<ID3D12DescriptorHeap* const*>(data));
+                    break;
+                case Opcode::SetIndexBuffer:
+                    commandList.setIndexBuffer(*static_cast<const D3D12_INDEX_BUFFER_VIEW*>(data));
+                    break;
+                case Opcode::SetVertexBuffers:
+                    commandList.setVertexBuffers(args->index, args->count,
+                        static_cast<const D3D12_VERTEX_BUFFER_VIEW*>(data));
+                    break;
+                case Opcode::SetGraphicsRootConstantBufferView:
+                    commandList.setGraphicsRootConstantBufferView(args->index, args->value);
+                    break;
+                case Opcode::SetGraphicsRootShaderResourceView:
+                    commandList.setGraphicsRootShaderResourceView(args->index, args->value);
+                    break;
+                case Opcode::SetGraphicsRootDescriptorTable:
+                    commandList.setGraphicsRootDescriptorTable(args->index, D3D12_GPU_DESCRIPTOR_HANDLE{ args->value });
+                    break;
+                case Opcode::SetGraphicsRoot32BitConstants:
+                    commandList.setGraphicsRoot32BitConstants(args->index, args->count, data,
+                        static_cast<uint32_t>(args->value));
+                    break;
+                case Opcode::SetComputeRootDescriptorTable:
+                    commandList.setComputeRootDescriptorTable(args->index, D3D12_GPU_DESCRIPTOR_HANDLE{ args->value });
+                    break;
+                case Opcode::SetComputeRoot32BitConstants:
+                    commandList.setComputeRoot32BitConstants(args->index, args->count, data,
+                        static_cast<uint32_t>(args->value));
+                    break;
+                case Opcode::ClearRenderTargetView:
+                    commandList.clearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE{ static_cast<SIZE_T>(args->value) },
+                        static_cast<const float*>(data));
+                    break;
+                case Opcode::ClearDepthStencilView:
+                    commandList.clearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE{ static_cast<SIZE_T>(args->value) },
+                        static_cast<D3D12_CLEAR_FLAGS>(args->index), *static_cast<const float*>(data),
+                        static_cast<uint8_t>(args->count));
+                    break;
+                case Opcode::ResourceBarrier:
+                    commandList.resourceBarrier(args->count, static_cast<const D3D12_RESOURCE_BARRIER*>(data));
+                    break;
+                case Opcode::DrawInstanced: {
+                    const uint32_t* values = static_cast<const uint32_t*>(data);
+                    commandList.drawInstanced(values[0], values[1], values[2], values[3]);
+                    break;
+                }
+                case Opcode::DrawIndexedInstanced: {
+                    const uint32_t* values = static_cast<const uint32_t*>(data);
+                    commandList.drawIndexedInstanced(values[0], values[1], values[2], static_cast<int32_t>(values[3]),
+                        values[4]);
+                    break;
+                }
+                case Opcode::Dispatch: {
+                    const uint32_t* values = static_cast<const uint32_t*>(data);
+                    commandList.dispatch(values[0], values[1], values[2]);
+                    break;
+                }
+                case Opcode::ExecuteIndirect: {
+                    const ExecuteIndirectArguments* indirect = reinterpret_cast<const ExecuteIndirectArguments*>(header + 1);
+                    commandList.executeIndirect(indirect->commandSignature, indirect->maxCommandCount,
+                        indirect->argumentBuffer, indirect->argumentBufferOffset, indirect->countBuffer,
+                        indirect->countBufferOffset);
+                    break;
+                }
+                default:
+                    assert(false && "Unknown command");
+                    return;
+                }
+            }
+        }
+    }
+
+
+    /// Replay target that only counts commands, to measure recording and replay cost without a GPU.
+    class NullCommandList {
+    public:
+        inline void setPipelineState(ID3D12PipelineState*) { ++_stateCount; }
+        inline void setGraphicsRootSignature(ID3D12RootSignature*) { ++_stateCount; }
+        inline void setComputeRootSignature(ID3D12RootSignature*) { ++_stateCount; }
+        inline void setPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY) { ++_stateCount; }
+        inline void setViewports(uint32_t, const D3D12_VIEWPORT*) { ++_stateCount; }
+        inline void setScissorRects(uint32_t, const D3D12_RECT*) { ++_stateCount; }
+        inline void setRenderTargets(uint32_t, const D3D12_CPU_DESCRIPTOR_HANDLE*, const D3D12_CPU_DESCRIPTOR_HANDLE*) {
+            ++_stateCount;
+        }
+        inline void setDescriptorHeaps(uint32_t, ID3D12DescriptorHeap* const*) { ++_stateCount; }
+        inline void setIndexBuffer(const D3D12_INDEX_BUFFER_VIEW&) { ++_stateCount; }
+        inline void setVertexBuffers(uint32_t, uint32_t, const D3D12_VERTEX_BUFFER_VIEW*) { ++_stateCount; }
+        inline void setGraphicsRootConstantBufferView(uint32_t, D3D12_GPU_VIRTUAL_ADDRESS) { ++_stateCount; }
+        inline void setGraphicsRootShaderResourceView(uint32_t, D3D12_GPU_VIRTUAL_ADDRESS) { ++_stateCount; }
+        inline void setGraphicsRootDescriptorTable(uint32_t, D3D12_GPU_DESCRIPTOR_HANDLE) { ++_stateCount; }
+        inline void setGraphicsRoot32BitConstants(uint32_t, uint32_t, const void*, uint32_t) { ++_stateCount; }
+        inline void setGraphicsRoot32BitConstant(uint32_t, uint32_t, uint32_t) { ++_stateCount; }
+        inline void setComputeRootDescriptorTable(uint32_t, D3D12_GPU_DESCRIPTOR_HANDLE) { ++_stateCount; }
+        inline void setComputeRoot32BitConstants(uint32_t, uint32_t, const void*, uint32_t) { ++_stateCount; }
+        inline void clearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE, const float[4]) { ++_clearCount; }
+        inline void clearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_CLEAR_FLAGS, float, uint8_t) {
+            ++_clearCount;
+        }
+        inline void resourceBarrier(uint32_t count, const D3D12_RESOURCE_BARRIER*) { _barrierCount += count; }
+        inline void drawInstanced(uint32_t, uint32_t, uint32_t, uint32_t) { ++_drawCount; }
+        inline void drawIndexedInstanced(uint32_t, uint32_t, uint32_t, int32_t, uint32_t) { ++_drawCount; }
+        inline void dispatch(uint32_t, uint32_t, uint32_t) { ++_dispatchCount; }
+        inline void executeIndirect(ID3D12CommandSignature*, uint32_t, ID3D12Resource*, uint64_t,
+            ID3D12Resource* = nullptr, uint64_t = 0) {
+            ++_executeIndirectCount;
+        }
+
+        inline uint64_t stateCount() const { return _stateCount; }
+        inline uint64_t clearCount() const { return _clearCount; }
+        inline uint64_t barrierCount() const { return _barrierCount; }
+        inline uint64_t drawCount() const { return _drawCount; }
+        inline uint64_t dispatchCount() const { return _dispatchCount; }
+        inline uint64_t executeIndirectCount() const { return _executeIndirectCount; }
+
+    private:
+        uint64_t _stateCount = 0;
+        uint64_t _clearCount = 0;
+        uint64_t _barrierCount = 0;
+        uint64_t _drawCount = 0;
+        uint64_t _dispatchCount = 0;
+        uint64_t _executeIndirectCount = 0;
+    };
+
+
+    ///
+    /// Frame Capture
+    ///
+    struct ReplayStatistics {
+        uint32_t iterationCount = 0;
+        uint32_t streamCount = 0;
+        uint64_t commandCount = 0;
+        uint64_t drawCount = 0;
+        double minMs = 0.0;
+        double medianMs = 0.0;
+        double meanMs = 0.0;
+        double p95Ms = 0.0;
+        double maxMs = 0.0;
+        double stddevMs = 0.0;
+
+        std::string toJson() const;
+    };
+
+    /// One frame of command streams plus the contents of buffers they reference, e.g. constants and indirect
+    /// arguments. Saved as a compact binary file and replayed offline: object pointers in the streams are opaque
+    /// values, so a loaded capture replays into a NullCommandList only.
+    class FrameCapture {
+    public:
+        struct Buffer {
+            D3D12_GPU_VIRTUAL_ADDRESS gpuAddress;
+            std::vector<uint8_t> data;
+        };
+
+        void reset();
+
+        // Streams replay in the order they were added
+        CommandStream& addStream();
+        void addBuffer(D3D12_GPU_VIRTUAL_ADDRESS gpuAddress, const void* data, size_t sizeInBytes);
+
+        HRESULT save(const std::filesystem::path& filePath) const;
+        HRESULT load(const std::filesystem::path& filePath);
+
+        template <typename CommandListType>
+        void replay(CommandListType& commandList) const {
+            for (const CommandStream& stream : _streams) {
+                stream.replay(commandList);
+            }
+        }
+
+        // Replays into a NullCommandList, timing each iteration after warmupCount untimed ones
+        ReplayStatistics benchmark(uint32_t iterationCount, uint32_t warmupCount = 16) const;
+
+        inline const std::list<CommandStream>& streams() const { return _streams; }
+        inline const std::vector<Buffer>& buffers() const { return _buffers; }
+
+    private:
+        static const uint32_t kMagic = 0x43584446;     // "FDXC"
+        static const uint32_t kVersion = 1;
+
+        std::list<CommandStream> _streams;             // Stable references for addStream()
+        std::vector<Buffer> _buffers;
+    };
+
+
+    ///
+    /// Pipeline State Cache
+    ///
+    /// Pipelines keyed by a canonical hash of their desc, see fastdxu::hashGraphicsPipelineDesc(). Misses are
+    /// loaded from an ID3D12PipelineLibrary when one is loaded, else compiled and stored into it. Root
+    /// signatures are identified by their serialized blob so keys are stable across runs. Thread-safe,
+    /// compilation runs outside the lock.
+    class PipelineStateCache {
+    public:
+        PipelineStateCache(ID3D12DevicePtr device);
+
+        ID3D12PipelineStatePtr graphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc,
+            HRESULT* outResult = nullptr);
+
+        // blobHash identifies the serialized root signature, see D3D12DeviceWrapper::createRootSignature()
+        void registerRootSignature(ID3D12RootSignature* rootSignature, uint64_t blobHash);
+        uint64_t hash(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) const;
+
+        ID3D12PipelineStatePtr find(uint64_t hash) const;
+        void insert(uint64_t hash, ID3D12PipelineStatePtr pipelineState);
+
+        // Starts an empty library when the file is missing or was written by another driver or adapter
+        HRESULT load(const std::filesystem::path& filePath);
+
+        // Writes the library if pipelines were stored since load()
+        HRESULT save(const std::filesystem::path& filePath);
+
+        size_t size() const;
+        inline uint64_t hitCount() const { return _hitCount; }
+        inline uint64_t libraryHitCount() const { return _libraryHitCount; }
+        inline uint64_t compileCount() const { return _compileCount; }
+
+    private:
+        ID3D12DevicePtr _device;
+
+        mutable std::mutex _mutex;
+        std::unordered_map<uint64_t, ID3D12PipelineStatePtr> _pipelineStates;
+        std::unordered_map<ID3D12RootSignature*, uint64_t> _rootSignatureHashes;
+        ID3D12PipelineLibraryPtr _library;              // Owns the serialized data it references
+        bool _isLibraryDirty = false;
+
+        std::atomic<uint64_t> _hitCount = 0;
+        std::atomic<uint64_t> _libraryHitCount = 0;
+        std::atomic<uint64_t> _compileCount = 0;
+    };
+
+
+    ///
+    /// Asynchronous Pipeline Compiler
+    ///
+    /// Pipeline compiled in the background. current() is a single atomic load, it returns the fallback until the
+    /// compiled pipeline is published, and keeps returning the fallback if compilation failed.
+    class AsyncPipelineState {
+    public:
+        AsyncPipelineState(ID3D12PipelineStatePtr fallback) : _fallback(fallback) {}
+
+        inline ID3D12PipelineState* current() const {
+            ID3D12PipelineState* pipelineState = _published.load(std::memory_order_acquire);
+            return pipelineState ? pipelineState : _fallback.get();
+        }
+
+        inline bool isReady() const { return _published.load(std::memory_order_acquire) != nullptr; }
+        inline bool isDone() const { return _isDone.load(std::memory_order_acquire); }
+
+        // Valid once isDone()
+        inline HRESULT result() const { return _result; }
+        inline ID3D12PipelineStatePtr pipelineState() const { return _pipelineState; }
+        inline ID3D12PipelineStatePtr fallback() const { return _fallback; }
+
+    private:
+        friend class AsyncPipelineCompiler;
+
+        ID3D12PipelineStatePtr _fallback;
+        ID3D12PipelineStatePtr _pipelineState;          // Written by the worker before publishing
+        HRESULT _result = S_OK;
+        std::atomic<ID3D12PipelineState*> _published = nullptr;
+        std::atomic<bool> _isDone = false;
+    };
+
+    /// Worker pool compiling queued pipeline descs in submission order. compile() deep copies the desc and holds a
+    /// reference to its root signature until compiled. The destructor drops queued requests and joins the workers.
+    class AsyncPipelineCompiler {
+    public:
+        typedef std::function<ID3D12PipelineStatePtr(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc,
+            HRESULT* outResult)> CompileFunction;
+
+        AsyncPipelineCompiler(CompileFunction compileFunction, uint32_t threadCount);
+        ~AsyncPipelineCompiler();
+
+        AsyncPipelineStatePtr compile(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc,
+            ID3D12PipelineStatePtr fallback = nullptr);
+
+        // Blocks until every queued request is done, for loading screens and shutdown
+        void waitIdle();
+
+        inline uint32_t pendingCount() const { return _pendingCount.load(std::memory_order_relaxed); }
+        inline uint64_t compiledCount() const { return _compiledCount.load(std::memory_order_relaxed); }
+        inline uint64_t failedCount() const { return _failedCount.load(std::memory_order_relaxed); }
+
+    private:
+        // Owns everything the desc points to
+        struct Request {
+            D3D12_GRAPHICS_PIPELINE_STATE_DESC desc;
+            std::vector<uint8_t> shaderData[5];
+            std::vector<D3D12_INPUT_ELEMENT_DESC> inputElements;
+            std::vector<D3D12_SO_DECLARATION_ENTRY> streamOutputEntries;
+            std::vector<uint32_t> streamOutputStrides;
+            std::list<std::string> semanticNames;       // Stable c_str() pointers
+            ID3D12RootSignaturePtr rootSignature;
+            AsyncPipelineStatePtr target;
+        };
+
+        void _workerMain();
+
+        CompileFunction _compileFunction;
+        std::vector<std::thread> _workers;
+
+        std::mutex _mutex;
+        std::condition_variable _requestAvailable;
+        std::condition_variable _idle;
+        std::deque<std::unique_ptr<Request>> _requests;
+        bool _isStopping = false;
+
+        std::atomic<uint32_t> _pendingCount = 0;        // Queued and compiling
+        std::atomic<uint64_t> _compiledCount = 0;
+        std::atomic<uint64_t> _failedCount = 0;
+    };
+
+    ///
+    /// Shader Library
+    ///
+    /// Packed shader archive mapped read-only. Identical blobs are stored once and found by name or by content
+    /// hash, returned bytecode points into the mapping and stays valid until close(). Lookups are binary searches
+    /// over tables in the mapping, nothing is copied or allocated.
+    class ShaderLibrary {
+    public:
+        ShaderLibrary() = default;
+        ShaderLibrary(const ShaderLibrary&) = delete;
+        ShaderLibrary& operator=(const ShaderLibrary&) = delete;
+        ~ShaderLibrary();
+
+        HRESULT open(const std::filesystem::path& filePath);
+        void close();
+
+        // Empty bytecode if missing
+        D3D12_SHADER_BYTECODE shader(const std::string& name) const;
+        D3D12_SHADER_BYTECODE shaderByHash(uint64_t contentHash) const;
+
+        inline bool isOpen() const { return _view != nullptr; }
+        inline uint32_t shaderCount() const { return _header ? _header->entryCount : 0; }
+        inline uint32_t blobCount() const { return _header ? _header->blobCount : 0; }
+
+    private:
+        friend class ShaderLibraryWriter;
+
+        static const uint32_t kMagic = 0x53584446;     // "FDXS"
+        static const uint32_t kVersion = 1;
+        static const uint32_t kBlobAlignment = 16;
+
+        // File layout: header, entries sorted by name hash, blobs sorted by content hash, names, blob data
+        struct Header {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t entryCount;
+            uint32_t blobCount;
+        };
+
+        struct Entry {
+            uint64_t nameHash;
+            uint32_t nameOffset;                        // From the start of the file
+            uint32_t nameLength;
+            uint32_t blobIndex;
+            uint32_t reserved;
+        };
+
+        struct Blob {
+            uint64_t contentHash;
+            uint64_t dataOffset;                        // From the start of the file
+            uint64_t sizeInBytes;
+        };
+
+        bool _validate() const;
+
+        const uint8_t* _view = nullptr;
+        uint64_t _sizeInBytes = 0;
+        const Header* _header = nullptr;
+        const Entry* _entries = nullptr;
+        const Blob* _blobs = nullptr;
+    };
+
+    /// Packs named shader blobs into a ShaderLibrary archive, blobs with equal contents are stored once.
+    /// Adding a name twice keeps the last blob.
+    class ShaderLibraryWriter {
+    public:
+        void add(const std::string& name, const void* data, size_t sizeInBytes);
+        HRESULT addFile(const std::string& name, const std::filesystem::path& filePath);
+
+        HRESULT save(const std::filesystem::path& filePath) const;
+
+        // Empty bytecode if missing, valid until the writer changes
+        D3D12_SHADER_BYTECODE shader(const std::string& name) const;
+
+        inline size_t shaderCount() const { return _names.size(); }
+        inline size_t blobCount() const { return _blobs.size(); }
+
+    private:
+        std::map<std::string, uint64_t> _names;                     // Name to content hash
+        std::unordered_map<uint64_t, std::vector<uint8_t>> _blobs;  // Content hash to data
+    };
+
+    ///
+    /// Shader Permutation Builder
+    ///
+    struct ShaderBuildStatistics {
+        uint32_t permutationCount = 0;
+        uint32_t compiledCount = 0;
+        uint32_t upToDateCount = 0;
+        uint32_t failedCount = 0;
+        double elapsedMs = 0.0;
+
+        std::string toJson() const;
+    };
+
+    /// Compiles every combination of define options of HLSL sources by running DXC processes in parallel. Outputs
+    /// are cached by a hash of the source, the files it includes, defines, entry point, target and arguments,
+    /// unchanged permutations are not recompiled. Includes are found by scanning #include lines, conditional
+    /// ones included, so the dependencies are a superset of what DXC reads.
+    class ShaderPermutationBuilder {
+    public:
+        ShaderPermutationBuilder(const std::filesystem::path& compilerPath, const std::filesystem::path& cacheDirectory,
+            uint32_t threadCount = std::thread::hardware_concurrency());
+
+        void addIncludeDirectory(const std::filesystem::path& directory);
+        void addArgument(const std::string& argument);
+
+        // Each axis lists alternative defines, "NAME" or "NAME=VALUE", an empty one leaves the axis undefined.
+        // Permutations are named after the source file stem followed by their defines, e.g. "textured_vs+SKINNED"
+        void addSource(const std::filesystem::path& sourcePath, const std::string& entryPoint, const std::string& target,
+            const std::vector<std::vector<std::string>>& axes = {});
+
+        // Compiles out of date permutations and adds every compiled one to libraryWriter
+        HRESULT build(ShaderLibraryWriter& libraryWriter, ShaderBuildStatistics* outStatistics = nullptr);
+
+        // Sources and includes read by the last build, and compiler output of its failed permutations
+        inline const std::vector<std::filesystem::path>& dependencies() const { return _dependencies; }
+        inline const std::vector<std::string>& errors() const { return _errors; }
+
+    private:
+        struct Source {
+            std::filesystem::path path;
+            std::string entryPoint;
+            std::string target;
+            std::vector<std::vector<std::string>> axes;
+        };
+
+        struct Permutation {
+            std::string name;
+            const Source* source;
+            std::vector<std::string> defines;
+            std::filesystem::path outputPath;
+        };
+
+        uint64_t _hashSourceTree(const std::filesystem::path& filePath, uint64_t hash,
+            std::vector<std::filesystem::path>& visited);
+        HRESULT _compile(const Permutation& permutation, std::string* outErrors) const;
+
+        std::filesystem::path _compilerPath;
+        std::filesystem::path _cacheDirectory;
+        uint32_t _threadCount;
+        std::vector<std::filesystem::path> _includeDirectories;
+        std::vector<std::string> _arguments;
+        std::list<Source> _sources;                    // Stable pointers for Permutation::source
+
+        std::vector<std::filesystem::path> _dependencies;
+        std::vector<std::string> _errors;
+    };
+
+    ///
+    /// Shader Hot Reload
+    ///
+    /// Watches a directory tree on a background thread, with ReadDirectoryChangesW on Windows and inotify elsewhere.
+    /// Reports written, created and renamed files, or the directory itself when changes were lost to an overflow.
+    /// result() holds the error that stopped the watch, from opening the directory or from a later read.
+    class FileWatcher {
+    public:
+        FileWatcher(const std::filesystem::path& directory);
+        FileWatcher(const FileWatcher&) = delete;
+        FileWatcher& operator=(const FileWatcher&) = delete;
+        ~FileWatcher();
+
+        inline bool isWatching() const { return _thread.joinable() && SUCCEEDED(result()); }
+        inline HRESULT result() const { return _result.load(std::memory_order_acquire); }
+        inline const std::filesystem::path& directory() const { return _directoryPath; }
+
+        // Paths changed since the last call, each once. The waiting one returns early on a change
+        std::vector<std::filesystem::path> changes();
+        std::vector<std::filesystem::path> waitForChanges(std::chrono::milliseconds timeout);
+
+    private:
+        void _watchMain();
+
+        std::filesystem::path _directoryPath;
+#if defined(_WIN32)
+        HANDLE _directory = INVALID_HANDLE_VALUE;
+        HANDLE _stopEvent = nullptr;
+#else
+        // inotify watches a single directory, new subdirectories are watched as they appear
+        void _addWatches(const std::filesystem::path& relativePath, std::vector<std::filesystem::path>* outFiles);
+
+        int _inotify = -1;
+        int _stopPipe[2] = { -1, -1 };
+        std::map<int, std::filesystem::path> _watches;  // Relative directory by watch descriptor
+#endif
+        std::thread _thread;
+        std::atomic<HRESULT> _result = S_OK;
+
+        std::mutex _mutex;
+        std::condition_variable _changed;
+        std::vector<std::filesystem::path> _changes;
+    };
+
+    /// Pipeline ShaderHotReloader can replace, current() is stable between two ShaderHotReloader::update() calls.
+    class ReloadablePipelineState {
+    public:
+        ReloadablePipelineState(AsyncPipelineStatePtr pipelineState) : _active(pipelineState) {}
+
+        inline ID3D12PipelineState* current() const { return _active->current(); }
+        inline bool isReady() const { return _active->isReady(); }
+
+    private:
+        friend class ShaderHotReloader;
+
+        AsyncPipelineStatePtr _active;
+    };
+
+    /// Rebuilds shaders on a background thread when a file they depend on changes, then recompiles the pipelines
+    /// using the shaders that changed. update() swaps finished pipelines at a frame boundary, the replaced ones
+    /// are released once the GPU is done with them, no queue flush. The builder must have built once so its
+    /// dependencies are known. Root signatures and the other desc pointers are kept, they must outlive the
+    /// reloader. A directory that cannot be watched is reported by watchResult() and lastBuildErrors().
+    class ShaderHotReloader {
+    public:
+        ShaderHotReloader(ShaderPermutationBuilder builder, const std::filesystem::path& watchDirectory,
+            AsyncPipelineCompilerPtr pipelineCompiler);
+        ~ShaderHotReloader();
+
+        // Shader names index the builder permutations, desc.VS and desc.PS are the shaders currently used
+        void addPipeline(ReloadablePipelineStatePtr pipelineState, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc,
+            const std::string& vertexShaderName, const std::string& pixelShaderName);
+
+        // Call once per frame before recording, never blocks. fenceValue is signaled after this frame's commands
+        uint32_t update(DeferredReleaseQueue& releaseQueue, uint64_t fenceValue);
+
+        ShaderBuildStatistics lastBuildStatistics() const;
+        std::vector<std::string> lastBuildErrors() const;
+        inline uint64_t buildCount() const { return _buildCount.load(std::memory_order_relaxed); }
+        inline uint64_t swapCount() const { return _swapCount.load(std::memory_order_relaxed); }
+        inline HRESULT watchResult() const { return _watcher.result(); }
+
+    private:
+        struct Registration {
+            ReloadablePipelineStatePtr pipelineState;
+            D3D12_GRAPHICS_PIPELINE_STATE_DESC desc;
+            std::string vertexShaderName;
+            std::string pixelShaderName;
+            uint64_t vertexShaderHash;
+            uint64_t pixelShaderHash;
+            AsyncPipelineStatePtr pending;
+        };
+
+        bool _isAffected(const std::vector<std::filesystem::path>& changes) const;
+        void _rebuild();
+        void _reloadMain();
+
+        ShaderPermutationBuilder _builder;              // Used by the reload thread only
+        FileWatcher _watcher;
+        AsyncPipelineCompilerPtr _pipelineCompiler;
+        std::thread _thread;
+        std::atomic<bool> _isStopping = false;
+
+        mutable std::mutex _mutex;
+        std::vector<Registration> _registrations;
+        ShaderBuildStatistics _lastBuildStatistics;
+        std::vector<std::string> _lastBuildErrors;
+
+        std::atomic<uint64_t> _buildCount = 0;
+        std::atomic<uint64_t> _swapCount = 0;
+    };
+}
+
+///
+/// fastdxu Header - D3D12 Utilities
+///
+namespace fastdxu {
+    D3D12_BLEND_DESC defaultBlendDesc();
+
+    D3D12_DEPTH_STENCIL_DESC defaultDepthStencilDesc();
+
+    D3D12_INDEX_BUFFER_VIEW indexBufferView(D3D12_GPU_VIRTUAL_ADDRESS BufferLocation, UINT SizeInBytes,
+        DXGI_FORMAT Format = DXGI_FORMAT_R16_UINT);
+
+    D3D12_RASTERIZER_DESC defaultRasterizerDesc();
+
+    D3D12_RESOURCE_BARRIER resourceBarrierTransition(fastdx::ID3D12ResourcePtr resource, D3D12_RESOURCE_STATES beforeState, D3D12_RESOURCE_STATES afterState);
+
+    D3D12_RESOURCE_DESC resourceBufferDesc(uint32_t width,
+        D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE);
+
+    D3D12_RESOURCE_DESC resourceTexDesc(D3D12_RESOURCE_DIMENSION dimension, uint32_t width,
+        uint32_t height, uint16_t depth, DXGI_FORMAT format, D3D12_RESOURCE_FLAGS flags);
+
+    D3D12_SHADER_RESOURCE_VIEW_DESC shaderResourceViewDesc(D3D12_SRV_DIMENSION dimension);
+
+    DXGI_SWAP_CHAIN_DESC1 swapChainDesc(const HWND hwnd, uint32_t bufferCount = 2,
+        DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM);
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC defaultGraphicsPipelineDesc(DXGI_FORMAT renderTargetFormat);
+
+    // Splits [0, count) into partCount balanced ranges, returns [begin, end) of range partIndex
+    std::pair<uint32_t, uint32_t> partitionRange(uint32_t count, uint32_t partCount, uint32_t partIndex);
+
+    D3D12_SAMPLER_DESC samplerDesc(D3D12_FILTER filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR,
+        D3D12_TEXTURE_ADDRESS_MODE addressMode = D3D12_TEXTURE_ADDRESS_MODE_WRAP);
+
+    // Zeroes the fields a sampler ignores for its filter and address modes, equal samplers compare equal
+    D3D12_SAMPLER_DESC canonicalSamplerDesc(const D3D12_SAMPLER_DESC& desc);
+
+    uint64_t hashBytes(const void* data, size_t sizeInBytes, uint64_t seed = 14695981039346656037ull);
+
+    uint64_t hashSamplerDesc(const D3D12_SAMPLER_DESC& desc);
+
+    // DXIL container (DXBC) part four character codes
+    const uint32_t kDxilPartRootSignature = 0x30535452;    // "RTS0"
+    const uint32_t kDxilPartShader = 0x4C495844;           // "DXIL"
+
+    // Locates a part in shader bytecode or a serialized root signature, returns false if missing or malformed
+    bool findDxilContainerPart(const void* container, size_t containerSizeInBytes, uint32_t fourCC,
+        const void** outPartData, size_t* outPartSizeInBytes);
+
+    // Resets the fields the enabled states ignore to their defaults and drops the cached blob, so descs hashing
+    // equal compare equal when a pipeline library loads them. Pointers still reference the desc's data
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC canonicalGraphicsPipelineDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
+
+    // Hashes shader bytecode, states and formats, skipping fields the enabled states ignore. The root signature
+    // is identified by rootSignatureHash, the cached blob is ignored
+    uint64_t hashGraphicsPipelineDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash);
+
+    // Quoted and escaped JSON string
+    std::string jsonString(const std::string& text);
+};
+
+
+///
+/// Implementation
+///
+#if defined(FASTDX_IMPLEMENTATION)
+
+#ifndef SAFE_FREE
+#define SAFE_FREE(p) { if (p) { free(p); (p)=nullptr; } }
+#endif
+
+#ifndef SAFE_RELEASE
+#define SAFE_RELEASE(p) { if (p) { (p)->Release(); (p)=nullptr; } }
+#endif
+
+#ifndef CHECK_ASSIGN_RETURN_IF_FAILED_
+#define CHECK_ASSIGN_RETURN_IF_FAILED_(HRESULTVAR, OUTVAR, ...) { if (_checkFailedAndAssign(HRESULTVAR, OUTVAR)) { return __VA_ARGS__; } }
+#endif
+
+#ifndef CHECK_ASSIGN_RETURN_IF_FAILED
+#define CHECK_ASSIGN_RETURN_IF_FAILED(HRESULTVAR, OUTVAR) { if (_checkFailedAndAssign(HRESULTVAR, OUTVAR)) { return nullptr; } }
+#endif
+
+///
+/// Common
+///
+namespace fastdx {
+    struct PtrDeleter {
+        void operator() (IUnknown* ptr) {
+            SAFE_RELEASE(ptr);
+        }
+    };
+
+    inline bool _checkFailedAndAssign(HRESULT hr, HRESULT* outResult = nullptr) {
+        if (outResult != nullptr) {
+            *outResult = hr;
+        }
+        return FAILED(hr);
+    }
+};
+
+
+///
+/// Window Implementation
+///
+namespace fastdx {
+    using namespace std::chrono;
+
+    LRESULT CALLBACK _WindowProcKeyDown(HWND hWnd, WPARAM wParam, LPARAM lParam) {
+        switch (wParam) {
+        case VK_ESCAPE:
+            SendMessage(hWnd, WM_CLOSE, 0, 0);
+            break;
+        }
+
+        if (onKeyDown) {
+            onKeyDown(static_cast<uint32_t>(wParam));
+        }
+
+        return S_OK;
+    }
+
+
+    LRESULT CALLBACK _WindowProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+        switch (msg) {
+        case WM_PAINT:
+            break;
+
+        case WM_SIZE:
+            break;
+
+        case WM_KEYDOWN:
+            _WindowProcKeyDown(hWnd, wParam, lParam);
+            break;
+
+        case WM_DESTROY:
+            PostQuitMessage(0);
+            break;
+        }
+
+        return DefWindowProc(hWnd, msg, wParam, lParam);
+    }
+
+
+    HWND createWindow(const WindowProperties& properties, HRESULT* outResult) {
+        HINSTANCE hInstance = (HINSTANCE)GetModuleHandle(nullptr);
+
+        WNDCLASSEX wc = { 0 };
+        wc.cbSize = sizeof(WNDCLASSEX);
+        wc.style = properties.isFullScreen ? 0 : CS_HREDRAW | CS_VREDRAW;
+        wc.lpfnWndProc = (WNDPROC)_WindowProc;
+        wc.hInstance = hInstance;
+        wc.hIcon = LoadIcon(nullptr, IDI_APPLICATION);
+        wc.hCursor = LoadCursor(nullptr, IDC_ARROW);
+        wc.lpszClassName = L"fastdx";
+        RegisterClassEx(&wc);
+
+        HWND hwnd = CreateWindow(
+            wc.lpszClassName,
+            properties.title,
+            properties.isFullScreen ? WS_POPUP : WS_OVERLAPPEDWINDOW,
+            CW_USEDEFAULT,
+            CW_USEDEFAULT,
+            properties.width,
+            properties.height,
+            nullptr,
+            nullptr,
+            hInstance,
+            0);
+
+        if (!hwnd) {
+            HRESULT result = HRESULT_FROM_WIN32(GetLastError());
+            UnregisterClass(wc.lpszClassName, nullptr);
+            CHECK_ASSIGN_RETURN_IF_FAILED(result, outResult);
+        }
+
+        ShowWindow(hwnd, properties.showMode);
+
+        return hwnd;
+    }
+
+
+    int runMainLoop(std::function<void(float)> updateFunction, std::function<void(float)> drawFunction,
+        FrameScheduler scheduler, FrameStatisticsPtr statistics) {
+        MSG msg = {};
+        steady_clock::time_point lastFrameEnd = steady_clock::now();
+
+        while (msg.message != WM_QUIT) {
+            // Drain all pending messages before simulating and drawing one frame
+            if (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+                TranslateMessage(&msg);
+                DispatchMessage(&msg);
+                continue;
+            }
+
+            steady_clock::time_point updateStart = steady_clock::now();
+            uint32_t steps = scheduler.advance();
+            if (updateFunction) {
+                FASTDX_PROFILE_SCOPE("update");
+                for (uint32_t i = 0; i < steps; ++i) {
+                    updateFunction(static_cast<float>(scheduler.fixedStep()));
+                }
+            }
+
+            steady_clock::time_point drawStart = steady_clock::now();
+            if (drawFunction) {
+                FASTDX_PROFILE_SCOPE("draw");
+                drawFunction(scheduler.alpha());
+            }
+
+            steady_clock::time_point frameEnd = steady_clock::now();
+            if (statistics) {
+                statistics->addTime(FrameTiming::Frame, duration<double, std::milli>(frameEnd - lastFrameEnd).count());
+                statistics->addTime(FrameTiming::Update, duration<double, std::milli>(drawStart - updateStart).count());
+                statistics->addTime(FrameTiming::Draw, duration<double, std::milli>(frameEnd - drawStart).count());
+                statistics->endFrame();
+            }
+            lastFrameEnd = frameEnd;
+        }
+
+        fastdx::onWindowDestroy();
+
+        return static_cast<int>(msg.wParam);
+    }
+};
+
+
+///
+/// D3D12DeviceWrapper Implementation
+///
+namespace fastdx {
+    std::shared_ptr<IDXGIFactory4> _getOrCreateDXIG(HRESULT* outResult) {
+        static std::shared_ptr<IDXGIFactory4> _dxgiFactory = nullptr;
+        if (_dxgiFactory) {
+            if (outResult) {
+                *outResult = S_OK;
+            }
+            return _dxgiFactory;
+        }
+
+        uint32_t dxgiFactoryFlags = 0;
+
+#if defined(_DEBUG)
+        dxgiFactoryFlags |= DXGI_CREATE_FACTORY_DEBUG;
+
+        ID3D12Debug1* debugController = nullptr;
+        if (SUCCEEDED(D3D12GetDebugInterface(IID_PPV_ARGS(&debugController)))) {
+            debugController->EnableDebugLayer();
+            debugController->SetEnableGPUBasedValidation(true);
+            debugController->SetEnableSynchronizedCommandQueueValidation(true);
+        }
+        SAFE_RELEASE(debugController);
+
+        IDXGIInfoQueue* dxgiInfoQueue = nullptr;
+        if (SUCCEEDED(DXGIGetDebugInterface1(0, IID_PPV_ARGS(&dxgiInfoQueue)))) {
+            dxgiInfoQueue->SetBreakOnSeverity(DXGI_DEBUG_ALL, DXGI_INFO_QUEUE_MESSAGE_SEVERITY_ERROR, true);
+            dxgiInfoQueue->SetBreakOnSeverity(DXGI_DEBUG_ALL, DXGI_INFO_QUEUE_MESSAGE_SEVERITY_CORRUPTION, true);
+        }
+        SAFE_RELEASE(dxgiInfoQueue);
+#endif
+
+        HRESULT hr;
+        IDXGIFactory4* dxgiFactory = nullptr;
+        hr = CreateDXGIFactory2(dxgiFactoryFlags, IID_PPV_ARGS(&dxgiFactory));
+        if (SUCCEEDED(hr)) {
+            _dxgiFactory = std::shared_ptr<IDXGIFactory4>(dxgiFactory, PtrDeleter());
+        }
+
+        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
+        return _dxgiFactory;
+    }
+
+
+    D3D12DeviceWrapperPtr createDevice(D3D_FEATURE_LEVEL featureLevel, HRESULT* outResult) {
+        HRESULT hr = E_FAIL;
+        std::shared_ptr<IDXGIFactory4> dxgiFactory = _getOrCreateDXIG(&hr);
+
+        ID3D12Device2* device = nullptr;
         IDXGIAdapter1* hardwareAdapter = nullptr;
         std::vector <IDXGIAdapter1*> hardwareAdapters;
 
-        for (int32_t i = 0; dxgiFactory->EnumAdapters1(i, &hardwareAdapter) != DXGI_ERROR_NOT_FOUND; ++i) {
-            hardwareAdapters.push_back(hardwareAdapter);
+        for (int32_t i = 0; dxgiFactory->EnumAdapters1(i, &hardwareAdapter) != DXGI_ERROR_NOT_FOUND; ++i) {
+            hardwareAdapters.push_back(hardwareAdapter);
+
+            DXGI_ADAPTER_DESC1 desc;
+            hardwareAdapter->GetDesc1(&desc);
+            if (desc.Flags & DXGI_ADAPTER_FLAG_SOFTWARE) {
+                continue;
+            }
+
+            hr = D3D12CreateDevice(hardwareAdapter, featureLevel, IID_PPV_ARGS(&device));
+            if (SUCCEEDED(hr)) {
+                break;
+            }
+        }
+
+        // Keep the device adapter around to query its video memory budget
+        IDXGIAdapter3* deviceAdapter = nullptr;
+        if (SUCCEEDED(hr)) {
+            hardwareAdapter->QueryInterface(IID_PPV_ARGS(&deviceAdapter));
+        }
+
+        for (IDXGIAdapter1* adapter : hardwareAdapters) {
+            SAFE_RELEASE(adapter);
+        }
+
+        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
+
+        auto devicePtr = std::shared_ptr<ID3D12Device2>(device, PtrDeleter());
+        auto adapterPtr = deviceAdapter ? IDXGIAdapterPtr(deviceAdapter, PtrDeleter()) : nullptr;
+        return D3D12DeviceWrapperPtr(new D3D12DeviceWrapper(devicePtr, adapterPtr));
+    }
+
+
+    D3D12DeviceWrapper::D3D12DeviceWrapper(ID3D12DevicePtr device, IDXGIAdapterPtr adapter) :
+        _device(device), _adapter(adapter) {
+
+        ResidencyManager::BudgetSource budgetSource = nullptr;
+        if (_adapter) {
+            budgetSource = [adapter = _adapter]() {
+                VideoMemoryBudget budget;
+                DXGI_QUERY_VIDEO_MEMORY_INFO memoryInfo = {};
+                if (SUCCEEDED(adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &memoryInfo))) {
+                    budget.budgetInBytes = memoryInfo.Budget;
+                    budget.usageInBytes = memoryInfo.CurrentUsage;
+                }
+                return budget;
+            };
+        }
+
+        // Capture the raw device, the manager must not keep the device alive
+        ID3D12Device2* d3dDevice = _device.get();
+        _residencyManager = std::make_shared<ResidencyManager>(budgetSource,
+            [d3dDevice](uint32_t count, ID3D12Pageable* const* objects) { return d3dDevice->Evict(count, objects); },
+            [d3dDevice](uint32_t count, ID3D12Pageable* const* objects) { return d3dDevice->MakeResident(count, objects); });
+        _pipelineStateCache = std::make_shared<PipelineStateCache>(_device);
+    }
+
+
+    ID3D12CommandAllocatorPtr D3D12DeviceWrapper::createCommandAllocator(D3D12_COMMAND_LIST_TYPE commandType, HRESULT* outResult) {
+
+        HRESULT hr;
+        ID3D12CommandAllocator* commandAllocator = nullptr;
+        hr = _device->CreateCommandAllocator(commandType, IID_PPV_ARGS(&commandAllocator));
+
+        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
+        return ID3D12CommandAllocatorPtr(commandAllocator, PtrDeleter());
+    }
+
+
+    ID3D12GraphicsCommandListPtr D3D12DeviceWrapper::createCommandList(uint32_t nodeMask, D3D12_COMMAND_LIST_TYPE commandType,
+        ID3D12CommandAllocatorPtr allocator, HRESULT* outResult) {
+
+        HRESULT hr;
+        ID3D12GraphicsCommandList6* commandList = nullptr;
+        hr = _device->CreateCommandList(nodeMask, commandType, allocator.get(), nullptr, IID_PPV_ARGS(&commandList));
+
+        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
+        return ID3D12GraphicsCommandListPtr(commandList, PtrDeleter());
+    }
+
+
+    ID3D12CommandQueuePtr D3D12DeviceWrapper::createCommandQueue(D3D12_COMMAND_LIST_TYPE type, HRESULT* outResult) {
+        D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+        queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+        queueDesc.Type = type;
+
+        ID3D12CommandQueue* commandQueue = nullptr;
+        HRESULT hr = _device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&commandQueue));
+
+        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
+        return ID3D12CommandQueuePtr(commandQueue, PtrDeleter());
+    }
+
+
+    ID3D12CommandSignaturePtr D3D12DeviceWrapper::createCommandSignature(const IndirectArgumentLayout& layout,
+        ID3D12RootSignaturePtr rootSignature, HRESULT* outResult) {
+        assert((rootSignature != nullptr || !layout.changesRootArguments()) && "Layout requires a root signature");
+        D3D12_COMMAND_SIGNATURE_DESC desc = layout.commandSignatureDesc();
+
+        ID3D12CommandSignature* commandSignature = nullptr;
+        HRESULT hr = _device->CreateCommandSignature(&desc, layout.changesRootArguments() ? rootSignature.get() : nullptr,
+            IID_PPV_ARGS(&commandSignature));
+
+        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
+        return ID3D12CommandSignaturePtr(commandSignature, PtrDeleter());
+    }
+
+
+    CommandContextPoolPtr D3D12DeviceWrapper::createCommandContextPool(D3D12_COMMAND_LIST_TYPE commandType) {
+        return CommandContextPoolPtr(new CommandContextPool(_device, commandType));
+    }
+
+
+    RenderGraphPtr D3D12DeviceWrapper::createRenderGraph(int32_t frameCount) {
+        ID3D12DevicePtr device = _device;
+        return RenderGraphPtr(new RenderGraph(_device, frameCount, [device](const D3D12_RESOURCE_DESC& desc) {
+            return device->GetResourceAllocationInfo(0, 1, &desc);
+        }, _residencyManager));
+    }
+
+
+    ConstantBufferAllocatorPtr D3D12DeviceWrapper::createConstantBufferAllocator(int32_t frameCount,
+        uint32_t frameSizeInBytes, HRESULT* outResult) {
+        const uint32_t kAlignmentMask = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1;
+        frameSizeInBytes = (frameSizeInBytes + kAlignmentMask) & ~kAlignmentMask;
+
+        HRESULT hr;
+        D3D12_HEAP_PROPERTIES uploadHeapProps = { D3D12_HEAP_TYPE_UPLOAD };
+        ID3D12ResourcePtr buffer = createCommittedResource(uploadHeapProps, D3D12_HEAP_FLAG_NONE,
+            fastdxu::resourceBufferDesc(frameCount * frameSizeInBytes), D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, &hr);
+        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
+
+        // Upload heaps can stay mapped for the resource lifetime, CPU never reads it back
+        uint8_t* cpuBasePtr = nullptr;
+        D3D12_RANGE readRange = { 0, 0 };
+        hr = buffer->Map(0, &readRange, reinterpret_cast<void**>(&cpuBasePtr));
+        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
+
+        return ConstantBufferAllocatorPtr(new ConstantBufferAllocator(buffer, cpuBasePtr, frameCount, frameSizeInBytes));
+    }
+
+
+    ID3D12ResourcePtr D3D12DeviceWrapper::createCommittedResource(const D3D12_HEAP_PROPERTIES& heapProperties,
+        D3D12_HEAP_FLAGS heapFlags, const D3D12_RESOURCE_DESC& desc, D3D12_RESOURCE_STATES initialState,
+        const D3D12_CLEAR_VALUE* optOptimalClearValue, HRESULT* outResult) {
+
+        HRESULT hr;
+        ID3D12Resource* resource;
+        hr = _device->CreateCommittedResource(&heapProperties, heapFlags, &desc, initialState, optOptimalClearValue,
+            IID_PPV_ARGS(&resource));
+
+        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
+
+        // Record allocation by category. CPU visible heaps are never evicted, buffers and textures only once
+        // marked used
+        ResourceCategory category = ResourceCategory::Texture;
+        if (heapProperties.Type == D3D12_HEAP_TYPE_UPLOAD) {
+            category = ResourceCategory::Upload;
+        } else if (heapProperties.Type == D3D12_HEAP_TYPE_READBACK) {
+            category = ResourceCategory::Readback;
+        } else if (desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL) {
+            category = ResourceCategory::DepthStencil;
+        } else if (desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET) {
+            category = ResourceCategory::RenderTarget;
+        } else if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER) {
+            category = ResourceCategory::Buffer;
+        }
+        bool isEvictable = category == ResourceCategory::Buffer || category == ResourceCategory::Texture;
+
+        D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = _device->GetResourceAllocationInfo(0, 1, &desc);
+        _residencyManager->track(resource, allocationInfo.SizeInBytes, category, isEvictable);
+
+        return ID3D12ResourcePtr(resource, [residencyManager = _residencyManager](ID3D12Resource* ptr) {
+            residencyManager->untrack(ptr);
+            SAFE_RELEASE(ptr);
+        });
+    }
+
+
+    ID3D12FencePtr D3D12DeviceWrapper::createFence(uint64_t initialValue, D3D12_FENCE_FLAGS flags, HRESULT* outResult) {
+
+        ID3D12Fence1* fence = nullptr;
+        HRESULT hr = _device->CreateFence(initialValue, flags, IID_PPV_ARGS(&fence));
+
+        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
+        return ID3D12FencePtr(fence, PtrDeleter());
+    }
+
+
+    FrameContextPtr D3D12DeviceWrapper::createFrameContext(ID3D12CommandQueuePtr commandQueue,
+        D3D12_COMMAND_LIST_TYPE commandType, uint32_t latency, HRESULT* outResult) {
+        HRESULT hr;
+        ID3D12FencePtr fence = createFence(0, D3D12_FENCE_FLAG_NONE, &hr);
+        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
+        return FrameContextPtr(new FrameContext(_device, commandQueue, commandType, fence, latency));
+    }
+
+
+    GpuProfilerPtr D3D12DeviceWrapper::createGpuProfiler(ID3D12CommandQueuePtr commandQueue,
+        uint32_t maxScopesPerFrame, HRESULT* outResult) {
+        HRESULT hr;
+        uint64_t timestampFrequency = 0;
+        hr = commandQueue->GetTimestampFrequency(&timestampFrequency);
+        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
+
+        // Two queries per scope for every frame in flight
+        uint32_t queryCount = 2 * std::max(maxScopesPerFrame, 1u) * GpuProfiler::kFrameCount;
+        D3D12_QUERY_HEAP_DESC queryHeapDesc = { D3D12_QUERY_HEAP_TYPE_TIMESTAMP, queryCount, 0 };
+        ID3D12QueryHeap* newQueryHeap = nullptr;
+        hr = _device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&newQueryHeap));
+        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
+        ID3D12QueryHeapPtr queryHeap(newQueryHeap, PtrDeleter());
+
+        D3D12_HEAP_PROPERTIES readbackHeapProps = { D3D12_HEAP_TYPE_READBACK };
+        ID3D12ResourcePtr readbackBuffer = createCommittedResource(readbackHeapProps, D3D12_HEAP_FLAG_NONE,
+            fastdxu::resourceBufferDesc(queryCount * sizeof(uint64_t)), D3D12_RESOURCE_STATE_COPY_DEST, nullptr, &hr);
+        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
+
+        return GpuProfilerPtr(new GpuProfiler(timestampFrequency, maxScopesPerFrame,
+            [queryHeap](ID3D12GraphicsCommandList* commandList, uint32_t query) {
+                commandList->EndQuery(queryHeap.get(), D3D12_QUERY_TYPE_TIMESTAMP, query);
+            },
+            [queryHeap, readbackBuffer](ID3D12GraphicsCommandList* commandList, uint32_t firstQuery,
+                uint32_t queryCount) {
+                commandList->ResolveQueryData(queryHeap.get(), D3D12_QUERY_TYPE_TIMESTAMP, firstQuery, queryCount,
+                    readbackBuffer.get(), firstQuery * sizeof(uint64_t));
+            },
+            [readbackBuffer](uint32_t firstQuery, uint32_t queryCount, uint64_t* outTimestamps) {
+                // Map only the frame's range, the GPU may be resolving other frames into the rest
+                D3D12_RANGE readRange = { firstQuery * sizeof(uint64_t), (firstQuery + queryCount) * sizeof(uint64_t) };
+                D3D12_RANGE writtenRange = { 0, 0 };
+                uint8_t* mappedData = nullptr;
+                if (SUCCEEDED(readbackBuffer->Map(0, &readRange, reinterpret_cast<void**>(&mappedData)))) {
+                    memcpy(outTimestamps, mappedData + readRange.Begin, queryCount * sizeof(uint64_t));
+                    readbackBuffer->Unmap(0, &writtenRange);
+                } else {
+                    memset(outTimestamps, 0, queryCount * sizeof(uint64_t));
+                }
+            }));
+    }
+
+
+    ID3D12PipelineStatePtr D3D12DeviceWrapper::createGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc,
+        HRESULT* outResult) {
+        return _pipelineStateCache->graphicsPipelineState(desc, outResult);
+    }
+
+
+    AsyncPipelineCompilerPtr D3D12DeviceWrapper::createAsyncPipelineCompiler(uint32_t threadCount) {
+        PipelineStateCachePtr pipelineStateCache = _pipelineStateCache;
+        return AsyncPipelineCompilerPtr(new AsyncPipelineCompiler(
+            [pipelineStateCache](const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, HRESULT* outResult) {
+                return pipelineStateCache->graphicsPipelineState(desc, outResult);
+            }, threadCount));
+    }
+
+
+    ID3D12DescriptorHeapPtr D3D12DeviceWrapper::createDescriptorHeap(int32_t count, D3D12_DESCRIPTOR_HEAP_TYPE heapType,
+        HRESULT* outResult) {
+
+        D3D12_DESCRIPTOR_HEAP_FLAGS heapFlags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+        if (heapType == D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV || heapType == D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER) {
+            heapFlags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+        }
+        return createDescriptorHeap(count, heapType, heapFlags, outResult);
+    }
+
+
+    ID3D12DescriptorHeapPtr D3D12DeviceWrapper::createDescriptorHeap(int32_t count, D3D12_DESCRIPTOR_HEAP_TYPE heapType,
+        D3D12_DESCRIPTOR_HEAP_FLAGS heapFlags, HRESULT* outResult) {
+
+        D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc = {};
+        rtvHeapDesc.NumDescriptors = count;
+        rtvHeapDesc.Type = heapType;
+        rtvHeapDesc.Flags = heapFlags;
+
+        HRESULT hr;
+        ID3D12DescriptorHeap* heapDescriptor = nullptr;
+        hr = _device->CreateDescriptorHeap(&rtvHeapDesc, IID_PPV_ARGS(&heapDescriptor));
+
+        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
+        return ID3D12DescriptorHeapPtr(heapDescriptor, PtrDeleter());
+    }
+
+
+    StagingDescriptorHeapPtr D3D12DeviceWrapper::createStagingDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE heapType,
+        uint32_t descriptorsPerPage) {
+        return StagingDescriptorHeapPtr(new StagingDescriptorHeap(_device, heapType, descriptorsPerPage));
+    }
+
+
+    ShaderVisibleDescriptorHeapPtr D3D12DeviceWrapper::createShaderVisibleDescriptorHeap(
+        D3D12_DESCRIPTOR_HEAP_TYPE heapType, uint32_t staticCount, uint32_t transientCountPerFrame, int32_t frameCount,
+        HRESULT* outResult) {
+
+        HRESULT hr;
+        uint32_t descriptorsCount = staticCount + transientCountPerFrame * frameCount;
+        ID3D12DescriptorHeapPtr heap = createDescriptorHeap(descriptorsCount, heapType,
+            D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE, &hr);
+        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
+
+        return ShaderVisibleDescriptorHeapPtr(new ShaderVisibleDescriptorHeap(_device, heap, staticCount,
+            transientCountPerFrame, frameCount));
+    }
+
+
+    BindlessResourceTablePtr D3D12DeviceWrapper::createBindlessResourceTable(ShaderVisibleDescriptorHeapPtr heap) {
+        return BindlessResourceTablePtr(new BindlessResourceTable(_device, heap));
+    }
+
+
+    SamplerCachePtr D3D12DeviceWrapper::createSamplerCache(ShaderVisibleDescriptorHeapPtr heap) {
+        return SamplerCachePtr(new SamplerCache(_device, heap));
+    }
+
+
+    std::vector<ID3D12ResourcePtr> D3D12DeviceWrapper::createRenderTargetViews(
+        IDXGISwapChainPtr swapChain, ID3D12DescriptorHeapPtr heap, HRESULT* outResult) {
+
+        HRESULT hr;
+        DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
+        hr = swapChain->GetDesc1(&swapChainDesc);
+        CHECK_ASSIGN_RETURN_IF_FAILED_(hr, outResult, std::vector<ID3D12ResourcePtr>());
+
+        D3D12_CPU_DESCRIPTOR_HANDLE heapHandle = heap->GetCPUDescriptorHandleForHeapStart();
+        size_t heapDescriptorSize = _device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+
+        std::vector<ID3D12ResourcePtr> resources;
+        for (uint32_t i = 0; i < swapChainDesc.BufferCount; ++i) {
+            ID3D12Resource* renderTarget = nullptr;
+            hr = swapChain->GetBuffer(i, IID_PPV_ARGS(&renderTarget));
+            CHECK_ASSIGN_RETURN_IF_FAILED_(hr, outResult, std::vector<ID3D12ResourcePtr>());
+            resources.push_back(ID3D12ResourcePtr(renderTarget, PtrDeleter()));
+
+            _device->CreateRenderTargetView(renderTarget, nullptr, heapHandle);
+            heapHandle.ptr += heapDescriptorSize;
+        }
+
+        return resources;
+    }
+
+
+    ID3D12RootSignaturePtr D3D12DeviceWrapper::createRootSignature(uint32_t nodeMask, const void* data, size_t dataSizeInBytes,
+        HRESULT* outResult) {
+        // Shader bytecode and serialized root signatures are both DXIL containers, key on their RTS0 part
+        const void* rootSignatureData = data;
+        size_t rootSignatureSizeInBytes = dataSizeInBytes;
+        fastdxu::findDxilContainerPart(data, dataSizeInBytes, fastdxu::kDxilPartRootSignature, &rootSignatureData,
+            &rootSignatureSizeInBytes);
+        uint64_t hash = fastdxu::hashBytes(rootSignatureData, rootSignatureSizeInBytes,
+            fastdxu::hashBytes(&nodeMask, sizeof(nodeMask)));
+        const uint8_t* rootSignatureBytes = static_cast<const uint8_t*>(rootSignatureData);
+        auto find = [&]() -> ID3D12RootSignaturePtr {
+            auto range = _rootSignatures.equal_range(hash);
+            for (auto it = range.first; it != range.second; ++it) {
+                const RootSignatureEntry& entry = it->second;
+                if (entry.nodeMask == nodeMask && entry.data.size() == rootSignatureSizeInBytes &&
+                    std::equal(entry.data.begin(), entry.data.end(), rootSignatureBytes)) {
+                    return entry.rootSignature;
+                }
+            }
+            return nullptr;
+        };
+        {
+            std::lock_guard<std::mutex> lock(_rootSignatureMutex);
+            if (ID3D12RootSignaturePtr rootSignature = find()) {
+                _checkFailedAndAssign(S_OK, outResult);
+                return rootSignature;
+            }
+        }
+
+        ID3D12RootSignature* rootSignature = nullptr;
+        HRESULT hr = _device->CreateRootSignature(nodeMask, data, dataSizeInBytes, IID_PPV_ARGS(&rootSignature));
+
+        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
+        ID3D12RootSignaturePtr rootSignaturePtr(rootSignature, PtrDeleter());
+        std::lock_guard<std::mutex> lock(_rootSignatureMutex);
+        // Another thread may have created the same root signature meanwhile, keep the first one
+        if (ID3D12RootSignaturePtr existing = find()) {
+            _checkFailedAndAssign(S_OK, outResult);
+            return existing;
+        }
+
+        // Colliding root signatures get distinct pipeline hashes, in creation order
+        uint64_t collisionIndex = _rootSignatures.count(hash);
+        uint64_t blobHash = (collisionIndex == 0) ? hash : fastdxu::hashBytes(&collisionIndex,
+            sizeof(collisionIndex), hash);
+        std::vector<uint8_t> rootSignatureCopy(rootSignatureBytes, rootSignatureBytes + rootSignatureSizeInBytes);
+        _rootSignatures.emplace(hash, RootSignatureEntry{ nodeMask, std::move(rootSignatureCopy), rootSignaturePtr });
+        _pipelineStateCache->registerRootSignature(rootSignature, blobHash);
+        return rootSignaturePtr;
+    }
+
+
+    IDXGISwapChainPtr D3D12DeviceWrapper::createSwapChainForHwnd(ID3D12CommandQueuePtr commandQueue,
+        const DXGI_SWAP_CHAIN_DESC1& swapChainDesc, HWND hwnd, HRESULT* outResult) {
+
+        HRESULT hr;
+        std::shared_ptr<IDXGIFactory4> dxgiFactory = _getOrCreateDXIG(&hr);
+        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
+
+        IDXGISwapChain1* swapChain1 = nullptr;
+        hr = dxgiFactory->CreateSwapChainForHwnd(
+            commandQueue.get(),     // Link to Command Queue
+            hwnd,                   // Link to Window
+            &swapChainDesc,
+            nullptr,
+            nullptr,
+            &swapChain1
+        );
+        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
+
+        IDXGISwapChain3* swapChain3 = nullptr;
+        hr = swapChain1->QueryInterface(__uuidof(IDXGISwapChain3), reinterpret_cast<void**>(&swapChain3));
+        SAFE_RELEASE(swapChain1);
+        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
+
+        hr = dxgiFactory->MakeWindowAssociation(hwnd, 0);
+        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
+
+        return IDXGISwapChainPtr(swapChain3, PtrDeleter());
+    }
+
+
+    void D3D12DeviceWrapper::createConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC& desc,
+        D3D12_CPU_DESCRIPTOR_HANDLE handle) {
+        _device->CreateConstantBufferView(&desc, handle);
+    }
+
+
+    void D3D12DeviceWrapper::createDepthStencilView(ID3D12ResourcePtr resource, const D3D12_DEPTH_STENCIL_VIEW_DESC& desc,
+        D3D12_CPU_DESCRIPTOR_HANDLE handle) {
+        _device->CreateDepthStencilView(resource.get(), &desc, handle);
+    }
+
+
+    void D3D12DeviceWrapper::createRenderTargetView(ID3D12ResourcePtr resource, const D3D12_RENDER_TARGET_VIEW_DESC& desc,
+        D3D12_CPU_DESCRIPTOR_HANDLE handle) {
+        _device->CreateRenderTargetView(resource.get(), &desc, handle);
+    }
+
+
+    void D3D12DeviceWrapper::createShaderResourceView(ID3D12ResourcePtr resource, const D3D12_SHADER_RESOURCE_VIEW_DESC& desc,
+        D3D12_CPU_DESCRIPTOR_HANDLE handle) {
+        _device->CreateShaderResourceView(resource.get(), &desc, handle);
+    }
+
+    inline uint32_t D3D12DeviceWrapper::getDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE descriptorHeapType) {
+        return _device->GetDescriptorHandleIncrementSize(descriptorHeapType);
+    }
+
+
+    ///
+    /// ConstantBufferAllocator Implementation
+    ///
+    ConstantBufferAllocator::ConstantBufferAllocator(ID3D12ResourcePtr buffer, uint8_t* cpuBasePtr, int32_t frameCount,
+        uint32_t frameSizeInBytes) : _buffer(buffer), _cpuBasePtr(cpuBasePtr), _frameCount(frameCount),
+        _frameSizeInBytes(frameSizeInBytes) {
+        _gpuBaseAddress = _buffer->GetGPUVirtualAddress();
+    }
+
+
+    ConstantBufferAllocator::~ConstantBufferAllocator() {
+        _buffer->Unmap(0, nullptr);
+    }
+
+
+    void ConstantBufferAllocator::beginFrame(int32_t frameIndex) {
+        assert(frameIndex >= 0 && frameIndex < _frameCount);
+        _frameBaseOffset = static_cast<uint64_t>(frameIndex) * _frameSizeInBytes;
+        _frameOffset = 0;
+    }
+
+
+    ///
+    /// DeferredReleaseQueue Implementation
+    ///
+    DeferredReleaseQueue::~DeferredReleaseQueue() {
+        flush();
+    }
+
+
+    void DeferredReleaseQueue::release(IUnknownPtr object, uint64_t fenceValue) {
+        if (!object) {
+            return;
+        }
+
+        // Lock-free push to the incoming stack, retire() takes the whole stack at once
+        Node* node = new Node{ std::move(object), fenceValue, _incoming.load(std::memory_order_relaxed) };
+        while (!_incoming.compare_exchange_weak(node->next, node, std::memory_order_release,
+            std::memory_order_relaxed)) {
+        }
+        _pendingCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+
+    size_t DeferredReleaseQueue::retire(uint64_t completedFenceValue) {
+        std::lock_guard<std::mutex> lock(_retireMutex);
+
+        Node* incoming = _incoming.exchange(nullptr, std::memory_order_acquire);
+        while (incoming != nullptr) {
+            Node* next = incoming->next;
+            incoming->next = _retiring;
+            _retiring = incoming;
+            incoming = next;
+        }
+
+        size_t retiredCount = 0;
+        Node** link = &_retiring;
+        while (*link != nullptr) {
+            Node* node = *link;
+            if (node->fenceValue <= completedFenceValue) {
+                *link = node->next;
+                delete node;
+                ++retiredCount;
+            } else {
+                link = &node->next;
+            }
+        }
+
+        _pendingCount.fetch_sub(retiredCount, std::memory_order_relaxed);
+        return retiredCount;
+    }
+
+
+    ///
+    /// FrameContext Implementation
+    ///
+    FrameContext::FrameContext(ID3D12DevicePtr device, ID3D12CommandQueuePtr commandQueue,
+        D3D12_COMMAND_LIST_TYPE commandType, ID3D12FencePtr fence, uint32_t latency) :
+        _device(device), _commandQueue(commandQueue), _commandType(commandType), _fence(fence), _pacer(latency) {
+        _fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    }
+
+
+    FrameContext::~FrameContext() {
+        CloseHandle(_fenceEvent);
+    }
+
+
+    uint32_t FrameContext::beginFrame() {
+        // Stall only when the CPU is latency() frames ahead of the GPU
+        uint64_t waitValue = _pacer.beginFrame();
+        _lastWaitTimeMs = 0.0;
+        if (_fence->GetCompletedValue() < waitValue) {
+            FASTDX_PROFILE_SCOPE("FrameContext::waitGpu");
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            ++_stallCount;
+            _waitForFenceValue(waitValue);
+            _lastWaitTimeMs = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
+        }
+
+        uint32_t frameSlot = _pacer.frameSlot();
+        if (_commandAllocators[frameSlot] != nullptr) {
+            _commandAllocators[frameSlot]->Reset();
+        }
+        return frameSlot;
+    }
+
+
+    uint64_t FrameContext::endFrame() {
+        uint64_t fenceValue = _pacer.endFrame();
+        _commandQueue->Signal(_fence.get(), fenceValue);
+        return fenceValue;
+    }
+
+
+    void FrameContext::waitIdle() {
+        uint64_t fenceValue = _pacer.signal();
+        _commandQueue->Signal(_fence.get(), fenceValue);
+        _waitForFenceValue(fenceValue);
+    }
+
+
+    ID3D12CommandAllocatorPtr FrameContext::commandAllocator(HRESULT* outResult) {
+        ID3D12CommandAllocatorPtr& commandAllocator = _commandAllocators[_pacer.frameSlot()];
+        if (commandAllocator == nullptr) {
+            ID3D12CommandAllocator* newAllocator = nullptr;
+            HRESULT hr = _device->CreateCommandAllocator(_commandType, IID_PPV_ARGS(&newAllocator));
+            CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
+            commandAllocator = ID3D12CommandAllocatorPtr(newAllocator, PtrDeleter());
+        }
+        _checkFailedAndAssign(S_OK, outResult);
+        return commandAllocator;
+    }
+
+
+    void FrameContext::_waitForFenceValue(uint64_t fenceValue) {
+        if (_fence->GetCompletedValue() < fenceValue) {
+            _fence->SetEventOnCompletion(fenceValue, _fenceEvent);
+            WaitForSingleObjectEx(_fenceEvent, INFINITE, FALSE);
+        }
+    }
+
+
+    ///
+    /// FrameStatistics Implementation
+    ///
+    FrameStatistics::FrameStatistics(uint32_t capacity) {
+        uint32_t slotCount = 1;
+        while (slotCount < capacity && slotCount < (1u << 31)) {
+            slotCount <<= 1;
+        }
+        _slots = std::vector<Slot>(slotCount);
+    }
+
+
+    void FrameStatistics::endFrame() {
+        record(_current);
+        _current = FrameTimes();
+    }
+
+
+    void FrameStatistics::record(const FrameTimes& times) {
+        // Odd sequence marks the slot as being written, readers copying it concurrently discard their copy
+        uint64_t frame = _frameCount.load(std::memory_order_relaxed);
+        Slot& slot = _slots[frame & (_slots.size() - 1)];
+        slot.sequence.store(2 * frame + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < static_cast<size_t>(FrameTiming::Count); ++i) {
+            slot.timesMs[i].store(times.timesMs[i], std::memory_order_relaxed);
+        }
+        slot.sequence.store(2 * frame + 2, std::memory_order_release);
+        _frameCount.store(frame + 1, std::memory_order_release);
+    }
+
+
+    std::vector<FrameTimes> FrameStatistics::snapshot(uint32_t frameCount) const {
+        uint64_t end = _frameCount.load(std::memory_order_acquire);
+        uint64_t count = std::min<uint64_t>(std::min<uint64_t>(frameCount, _slots.size()), end);
+
+        std::vector<FrameTimes> frames;
+        frames.reserve(static_cast<size_t>(count));
+        for (uint64_t frame = end - count; frame < end; ++frame) {
+            const Slot& slot = _slots[frame & (_slots.size() - 1)];
+            uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence != 2 * frame + 2) {
+                continue;
+            }
+
+            FrameTimes times;
+            times.frameNumber = frame;
+            for (size_t i = 0; i < static_cast<size_t>(FrameTiming::Count); ++i) {
+                times.timesMs[i] = slot.timesMs[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) == sequence) {
+                frames.push_back(times);
+            }
+        }
+        return frames;
+    }
+
+
+    FrameTimingSummary FrameStatistics::summary(FrameTiming timing, uint32_t frameCount) const {
+        return summarize(snapshot(frameCount), timing);
+    }
+
+
+    FrameTimingSummary FrameStatistics::summarize(const std::vector<FrameTimes>& frames, FrameTiming timing) {
+        FrameTimingSummary summary;
+        if (frames.empty()) {
+            return summary;
+        }
+
+        std::vector<float> timesMs(frames.size());
+        double sumMs = 0.0;
+        for (size_t i = 0; i < frames.size(); ++i) {
+            timesMs[i] = frames[i][timing];
+            sumMs += timesMs[i];
+        }
+        std::sort(timesMs.begin(), timesMs.end());
+
+        // Nearest rank: smallest time with at least percentile% of frames at or below it
+        size_t count = timesMs.size();
+        auto percentile = [&](size_t percent) {
+            return timesMs[std::max<size_t>((count * percent + 99) / 100, 1) - 1];
+        };
+        summary.frameCount = static_cast<uint32_t>(count);
+        summary.minMs = timesMs.front();
+        summary.meanMs = sumMs / count;
+        summary.p50Ms = percentile(50);
+        summary.p95Ms = percentile(95);
+        summary.p99Ms = percentile(99);
+        summary.maxMs = timesMs.back();
+        return summary;
+    }
+
+
+    std::vector<uint32_t> FrameStatistics::histogram(FrameTiming timing, double bucketMs, uint32_t bucketCount,
+        uint32_t frameCount) const {
+        return _histogram(snapshot(frameCount), timing, bucketMs, bucketCount);
+    }
+
+
+    std::vector<uint32_t> FrameStatistics::_histogram(const std::vector<FrameTimes>& frames, FrameTiming timing,
+        double bucketMs, uint32_t bucketCount) {
+        std::vector<uint32_t> buckets(bucketCount, 0);
+        if (bucketCount == 0 || bucketMs <= 0.0) {
+            return buckets;
+        }
+
+        for (const FrameTimes& times : frames) {
+            double bucket = std::max(times[timing] / bucketMs, 0.0);
+            ++buckets[(bucket < bucketCount - 1) ? static_cast<uint32_t>(bucket) : bucketCount - 1];
+        }
+        return buckets;
+    }
+
+
+    std::string FrameStatistics::toCsv(uint32_t frameCount) const {
+        std::string csv = "frame,frame_ms,update_ms,draw_ms,gpu_wait_ms\n";
+        char row[160];
+        for (const FrameTimes& times : snapshot(frameCount)) {
+            snprintf(row, sizeof(row), "%llu,%.4f,%.4f,%.4f,%.4f\n", static_cast<unsigned long long>(times.frameNumber),
+                times[FrameTiming::Frame], times[FrameTiming::Update], times[FrameTiming::Draw],
+                times[FrameTiming::GpuWait]);
+            csv += row;
+        }
+        return csv;
+    }
+
+
+    std::string FrameStatistics::toJson(uint32_t frameCount, double histogramBucketMs,
+        uint32_t histogramBucketCount) const {
+        const char* kTimingNames[] = { "frame_ms", "update_ms", "draw_ms", "gpu_wait_ms" };
+        static_assert(_countof(kTimingNames) == static_cast<size_t>(FrameTiming::Count), "Missing timing name");
+
+        // One snapshot so every timing covers the same frames
+        std::vector<FrameTimes> frames = snapshot(frameCount);
+        char text[512];
+        snprintf(text, sizeof(text), "{\"frames\": %zu, \"histogram_bucket_ms\": %.4f", frames.size(),
+            histogramBucketMs);
+        std::string json = text;
+
+        for (size_t i = 0; i < static_cast<size_t>(FrameTiming::Count); ++i) {
+            FrameTiming timing = static_cast<FrameTiming>(i);
+            FrameTimingSummary summary = summarize(frames, timing);
+            snprintf(text, sizeof(text), ", \"%s\": {\"min\": %.4f, \"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, "
+                "\"p99\": %.4f, \"max\": %.4f, \"histogram\": [", kTimingNames[i], summary.minMs, summary.meanMs,
+                summary.p50Ms, summary.p95Ms, summary.p99Ms, summary.maxMs);
+            json += text;
+
+            std::vector<uint32_t> buckets = _histogram(frames, timing, histogramBucketMs, histogramBucketCount);
+            for (size_t j = 0; j < buckets.size(); ++j) {
+                json += (j > 0) ? ", " : "";
+                json += std::to_string(buckets[j]);
+            }
+            json += "]}";
+        }
+        return json + "}";
+    }
+
+
+    ///
+    /// GpuProfiler Implementation
+    ///
+    std::string GpuFrameTimings::toString() const {
+        std::string text;
+        char line[64];
+        for (const GpuTimingNode& node : nodes) {
+            snprintf(line, sizeof(line), " %.3f ms\n", node.durationMs);
+            text += std::string(2 * node.depth, ' ') + node.name + line;
+        }
+        return text;
+    }
+
+
+    std::string GpuFrameTimings::toJson() const {
+        // Nodes are depth first, children of a node follow it until the next node at its depth or above
+        std::function<std::string(uint32_t, uint32_t&)> nodeJson = [&](uint32_t parent, uint32_t& index) {
+            std::string json = "[";
+            while (index < nodes.size() && nodes[index].parent == parent) {
+                const GpuTimingNode& node = nodes[index++];
+                char times[96];
+                snprintf(times, sizeof(times), ", \"begin_ms\": %.4f, \"duration_ms\": %.4f, \"children\": ",
+                    node.beginMs, node.durationMs);
+                json += (json.size() > 1) ? ", " : "";
+                json += "{\"name\": " + fastdxu::jsonString(node.name) + times + nodeJson(index - 1, index) + "}";
+            }
+            return json + "]";
+        };
+
+        uint32_t index = 0;
+        return "{\"frame\": " + std::to_string(frameNumber) + ", \"scopes\": " +
+            nodeJson(GpuTimingNode::kInvalidParent, index) + "}";
+    }
+
+
+    GpuProfiler::GpuProfiler(uint64_t timestampFrequency, uint32_t maxScopesPerFrame,
+        TimestampFunction timestampFunction, ResolveFunction resolveFunction, ReadbackFunction readbackFunction) :
+        _timestampFrequency(std::max<uint64_t>(timestampFrequency, 1)),
+        _maxQueriesPerFrame(2 * std::max(maxScopesPerFrame, 1u)), _timestampFunction(timestampFunction),
+        _resolveFunction(resolveFunction), _readbackFunction(readbackFunction), _timestamps(_maxQueriesPerFrame) {
+    }
+
+
+    void GpuProfiler::beginFrame(uint64_t completedFenceValue) {
+        // Fence values increase in submission order
+        while (!_pendingFrames.empty() && _pendingFrames.front()->fenceValue <= completedFenceValue) {
+            _readback(*_pendingFrames.front());
+            _pendingFrames.pop_front();
+        }
+
+        // Skip the frame rather than wait when its queries are still in flight
+        Frame& frame = _frames[_frameNumber % kFrameCount];
+        _scopeStack.clear();
+        if (frame.isPending) {
+            _currentFrame = nullptr;
+            ++_droppedFrameCount;
+            return;
+        }
+
+        frame.frameNumber = _frameNumber;
+        frame.queryCount = 0;
+        frame.scopes.clear();
+        _currentFrame = &frame;
+    }
+
+
+    void GpuProfiler::endFrame(ID3D12GraphicsCommandList* commandList, uint64_t fenceValue) {
+        if (_currentFrame != nullptr) {
+            while (!_scopeStack.empty()) {
+                endScope(commandList);
+            }
+
+            if (_currentFrame->queryCount > 0) {
+                uint32_t firstQuery = static_cast<uint32_t>(_currentFrame - _frames) * _maxQueriesPerFrame;
+                _resolveFunction(commandList, firstQuery, _currentFrame->queryCount);
+                _currentFrame->fenceValue = fenceValue;
+                _currentFrame->isPending = true;
+                _pendingFrames.push_back(_currentFrame);
+            }
+            _currentFrame = nullptr;
+        }
+        ++_frameNumber;
+    }
+
+
+    void GpuProfiler::beginScope(ID3D12GraphicsCommandList* commandList, const char* name) {
+        if (_currentFrame == nullptr) {
+            return;
+        }
+
+        // Both queries are reserved now so every scope that began is closed, children of dropped scopes drop
+        bool isParentDropped = !_scopeStack.empty() && _scopeStack.back() == kInvalidQuery;
+        if (isParentDropped || _currentFrame->queryCount + 2 > _maxQueriesPerFrame) {
+            _scopeStack.push_back(kInvalidQuery);
+            ++_droppedScopeCount;
+            return;
+        }
+
+        uint32_t firstQuery = static_cast<uint32_t>(_currentFrame - _frames) * _maxQueriesPerFrame;
+        Scope scope = { name, _scopeStack.empty() ? GpuTimingNode::kInvalidParent : _scopeStack.back(),
+            static_cast<uint32_t>(_scopeStack.size()), _currentFrame->queryCount, _currentFrame->queryCount + 1 };
+        _currentFrame->queryCount += 2;
+        _timestampFunction(commandList, firstQuery + scope.beginQuery);
+
+        _scopeStack.push_back(static_cast<uint32_t>(_currentFrame->scopes.size()));
+        _currentFrame->scopes.push_back(std::move(scope));
+    }
+
+
+    void GpuProfiler::endScope(ID3D12GraphicsCommandList* commandList) {
+        if (_currentFrame == nullptr || _scopeStack.empty()) {
+            return;
+        }
+
+        uint32_t scopeIndex = _scopeStack.back();
+        _scopeStack.pop_back();
+        if (scopeIndex != kInvalidQuery) {
+            uint32_t firstQuery = static_cast<uint32_t>(_currentFrame - _frames) * _maxQueriesPerFrame;
+            _timestampFunction(commandList, firstQuery + _currentFrame->scopes[scopeIndex].endQuery);
+        }
+    }
+
+
+    void GpuProfiler::_readback(Frame& frame) {
+        uint32_t firstQuery = static_cast<uint32_t>(&frame - _frames) * _maxQueriesPerFrame;
+        _readbackFunction(firstQuery, frame.queryCount, _timestamps.data());
+
+        uint64_t frameBegin = UINT64_MAX;
+        for (const Scope& scope : frame.scopes) {
+            frameBegin = std::min(frameBegin, _timestamps[scope.beginQuery]);
+        }
+
+        // Ticks to milliseconds, a scope ending before it begins (e.g. a bad readback) lasts 0 ms
+        double msPerTick = 1000.0 / _timestampFrequency;
+        GpuFrameTimings timings;
+        timings.frameNumber = frame.frameNumber;
+        timings.nodes.reserve(frame.scopes.size());
+        for (const Scope& scope : frame.scopes) {
+            uint64_t begin = _timestamps[scope.beginQuery];
+            uint64_t end = std::max(_timestamps[scope.endQuery], begin);
+            timings.nodes.push_back({ scope.name, scope.parent, scope.depth, (begin - frameBegin) * msPerTick,
+                (end - begin) * msPerTick });
+        }
+
+        _lastFrameTimings = std::move(timings);
+        ++_resolvedFrameCount;
+        frame.isPending = false;
+    }
+
+
+    ///
+    /// CpuProfiler Implementation
+    ///
+    CpuProfiler::ThreadRelease::~ThreadRelease() {
+        // Events stay in the ring until the next thread owning it overwrites them
+        std::lock_guard<std::mutex> lock(_mutex);
+        _threadBuffer->isOwned = false;
+        _threadBuffer = nullptr;
+    }
+
+
+    CpuProfiler::ThreadBuffer* CpuProfiler::_registerThread() {
+        ThreadBuffer* buffer = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (std::unique_ptr<ThreadBuffer>& threadBuffer : _threadBuffers) {
+                if (!threadBuffer->isOwned) {
+                    buffer = threadBuffer.get();
+                    break;
+                }
+            }
+            if (buffer == nullptr) {
+                _threadBuffers.emplace_back(new ThreadBuffer());
+                buffer = _threadBuffers.back().get();
+                buffer->threadId = static_cast<uint32_t>(_threadBuffers.size());
+            }
+            buffer->isOwned = true;
+            buffer->threadName = "Thread " + std::to_string(buffer->threadId);
+        }
+
+        // Returns the ring when the thread exits
+        static thread_local ThreadRelease threadRelease;
+        (void)threadRelease;
+        _threadBuffer = buffer;
+        return buffer;
+    }
+
+
+    void CpuProfiler::setThreadName(const char* name) {
+        ThreadBuffer* buffer = (_threadBuffer != nullptr) ? _threadBuffer : _registerThread();
+        std::lock_guard<std::mutex> lock(_mutex);
+        buffer->threadName = name;
+    }
+
+
+    void CpuProfiler::clear() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (std::unique_ptr<ThreadBuffer>& threadBuffer : _threadBuffers) {
+            threadBuffer->clearIndex.store(threadBuffer->writeIndex.load(std::memory_order_acquire),
+                std::memory_order_relaxed);
+        }
+    }
+
+
+    std::string CpuProfiler::toChromeTraceJson() {
+        // Tick rate measured over the whole trace, TSC ticks are not guaranteed to be any fixed frequency
+        uint64_t nowTicks = ticks();
+        double elapsedUs = std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - _originTime).count();
+        double usPerTick = (nowTicks > _originTicks) ? elapsedUs / (nowTicks - _originTicks) : 0.0;
+
+        std::string json = "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+        bool isFirstEvent = true;
+        char text[128];
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (std::unique_ptr<ThreadBuffer>& threadBuffer : _threadBuffers) {
+            snprintf(text, sizeof(text), "%s\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, "
+                "\"args\": {\"name\": ", isFirstEvent ? "" : ",", threadBuffer->threadId);
+            json += text + fastdxu::jsonString(threadBuffer->threadName) + "}}";
+            isFirstEvent = false;
+
+            // The owning thread keeps writing, events overwritten during the copy are dropped
+            uint64_t endIndex = threadBuffer->writeIndex.load(std::memory_order_acquire);
+            uint64_t beginIndex = std::max(threadBuffer->clearIndex.load(std::memory_order_relaxed),
+                (endIndex > kEventsPerThread) ? endIndex - kEventsPerThread : 0);
+            struct EventCopy {
+                uint64_t index;
+                const char* name;
+                uint64_t beginTicks;
+                uint64_t endTicks;
+            };
+            std::vector<EventCopy> events;
+            events.reserve(static_cast<size_t>(endIndex - beginIndex));
+            for (uint64_t index = beginIndex; index < endIndex; ++index) {
+                const Event& event = threadBuffer->events[index & (kEventsPerThread - 1)];
+                events.push_back({ index, event.name.load(std::memory_order_relaxed),
+                    event.beginTicks.load(std::memory_order_relaxed), event.endTicks.load(std::memory_order_relaxed) });
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint64_t overwrittenIndex = threadBuffer->writeIndex.load(std::memory_order_relaxed) + 1;
+            overwrittenIndex = (overwrittenIndex > kEventsPerThread) ? overwrittenIndex - kEventsPerThread : 0;
+
+            for (const EventCopy& event : events) {
+                if (event.index < overwrittenIndex || event.name == nullptr) {
+                    continue;
+                }
+                double beginUs = static_cast<int64_t>(event.beginTicks - _originTicks) * usPerTick;
+                double durationUs = static_cast<int64_t>(event.endTicks - event.beginTicks) * usPerTick;
+                json += ",\n{\"name\": " + fastdxu::jsonString(event.name);
+                snprintf(text, sizeof(text), ", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f}",
+                    threadBuffer->threadId, beginUs, durationUs);
+                json += text;
+            }
+        }
+        return json + "\n]}";
+    }
+
+
+    HRESULT CpuProfiler::save(const std::filesystem::path& filePath) {
+        std::ofstream file(filePath);
+        if (!file) {
+            return E_FAIL;
+        }
+        file << toChromeTraceJson();
+        return file ? S_OK : E_FAIL;
+    }
+
+
+    ///
+    /// ResidencyManager Implementation
+    ///
+    ResidencyManager::ResidencyManager(BudgetSource budgetSource, ResidencyFunction evictFunction,
+        ResidencyFunction makeResidentFunction) :
+        _budgetSource(budgetSource), _evictFunction(evictFunction), _makeResidentFunction(makeResidentFunction) {
+    }
+
+
+    void ResidencyManager::track(ID3D12Pageable* object, uint64_t sizeInBytes, ResourceCategory category,
+        bool isEvictable) {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        // Out of the LRU until marked, the GPU may use objects the caller never marks
+        _entries[object] = { sizeInBytes, 0, category, isEvictable, true, _residentLru.end() };
+        _allocatedSizeInBytes[static_cast<size_t>(category)] += sizeInBytes;
+    }
+
+
+    void ResidencyManager::untrack(ID3D12Pageable* object) {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        auto it = _entries.find(object);
+        if (it == _entries.end()) {
+            return;
+        }
+
+        Entry& entry = it->second;
+        if (entry.lruIterator != _residentLru.end()) {
+            _residentLru.erase(entry.lruIterator);
+        }
+        if (!entry.isResident) {
+            _evictedSizeInBytes -= entry.sizeInBytes;
+        }
+        _allocatedSizeInBytes[static_cast<size_t>(entry.category)] -= entry.sizeInBytes;
+        _entries.erase(it);
+    }
+
+
+    HRESULT ResidencyManager::markUsed(ID3D12Pageable* object, uint64_t fenceValue) {
+        return markUsed(1, &object, fenceValue);
+    }
+
+
+    HRESULT ResidencyManager::markUsed(uint32_t count, ID3D12Pageable* const* objects, uint64_t fenceValue) {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        HRESULT hr = S_OK;
+        std::vector<ID3D12Pageable*> residentList;
+        for (uint32_t i = 0; i < count; ++i) {
+            auto it = _entries.find(objects[i]);
+            if (it == _entries.end()) {
+                hr = E_INVALIDARG;
+                continue;
+            }
+
+            Entry& entry = it->second;
+            entry.lastUsedFenceValue = std::max(entry.lastUsedFenceValue, fenceValue);
+            if (!entry.isEvictable) {
+                continue;
+            }
+
+            if (!entry.isResident) {
+                residentList.push_back(objects[i]);
+                entry.isResident = true;
+                _evictedSizeInBytes -= entry.sizeInBytes;
+                entry.lruIterator = _residentLru.insert(_residentLru.end(), objects[i]);
+            } else if (entry.lruIterator == _residentLru.end()) {
+                entry.lruIterator = _residentLru.insert(_residentLru.end(), objects[i]);
+            } else {
+                _residentLru.splice(_residentLru.end(), _residentLru, entry.lruIterator);
+            }
+        }
+
+        if (!residentList.empty() && _makeResidentFunction) {
+            HRESULT residentResult = _makeResidentFunction(static_cast<uint32_t>(residentList.size()),
+                residentList.data());
+            if (FAILED(residentResult)) {
+                // Still evicted
+                for (ID3D12Pageable* object : residentList) {
+                    Entry& entry = _entries[object];
+                    _residentLru.erase(entry.lruIterator);
+                    entry.lruIterator = _residentLru.end();
+                    entry.isResident = false;
+                    _evictedSizeInBytes += entry.sizeInBytes;
+                }
+                return residentResult;
+            }
+        }
+        return hr;
+    }
+
+
+    HRESULT ResidencyManager::update(uint64_t completedFenceValue) {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if (_budgetSource) {
+            _lastBudget = _budgetSource();
+        } else {
+            _lastBudget.usageInBytes = 0;
+            for (uint64_t sizeInBytes : _allocatedSizeInBytes) {
+                _lastBudget.usageInBytes += sizeInBytes;
+            }
+            _lastBudget.usageInBytes -= _evictedSizeInBytes;
+        }
+
+        if (_lastBudget.usageInBytes <= _lastBudget.budgetInBytes) {
+            return S_OK;
+        }
+
+        // Collect LRU objects until enough memory is freed, skip objects the GPU may still be using
+        uint64_t bytesToFree = _lastBudget.usageInBytes - _lastBudget.budgetInBytes;
+        std::vector<ID3D12Pageable*> evictList;
+        for (auto lruIt = _residentLru.begin(); lruIt != _residentLru.end() && bytesToFree > 0; ++lruIt) {
+            const Entry& entry = _entries[*lruIt];
+            if (entry.lastUsedFenceValue > completedFenceValue) {
+                continue;
+            }
+            evictList.push_back(*lruIt);
+            bytesToFree -= std::min(bytesToFree, entry.sizeInBytes);
+        }
+
+        if (evictList.empty()) {
+            return S_OK;
+        }
+
+        HRESULT hr = _evictFunction ? _evictFunction(static_cast<uint32_t>(evictList.size()), evictList.data()) : S_OK;
+        if (FAILED(hr)) {
+            return hr;
+        }
+
+        uint64_t freedSizeInBytes = 0;
+        for (ID3D12Pageable* object : evictList) {
+            Entry& entry = _entries[object];
+            _residentLru.erase(entry.lruIterator);
+            entry.lruIterator = _residentLru.end();
+            entry.isResident = false;
+            freedSizeInBytes += entry.sizeInBytes;
+        }
+        _evictedSizeInBytes += freedSizeInBytes;
+        _lastBudget.usageInBytes -= std::min(_lastBudget.usageInBytes, freedSizeInBytes);
+        return S_OK;
+    }
+
+
+    uint64_t ResidencyManager::allocatedSizeInBytes(ResourceCategory category) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _allocatedSizeInBytes[static_cast<size_t>(category)];
+    }
+
+
+    uint64_t ResidencyManager::residentSizeInBytes() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        uint64_t residentSizeInBytes = 0;
+        for (uint64_t sizeInBytes : _allocatedSizeInBytes) {
+            residentSizeInBytes += sizeInBytes;
+        }
+        return residentSizeInBytes - _evictedSizeInBytes;
+    }
+
+
+    uint64_t ResidencyManager::evictedSizeInBytes() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _evictedSizeInBytes;
+    }
+
+
+    ///
+    /// Descriptor Heap Allocators Implementation
+    ///
+    RangeAllocator::RangeAllocator(uint32_t size) : _size(size), _freeSize(size) {
+        if (size > 0) {
+            _freeRanges[0] = size;
+        }
+    }
+
+
+    uint32_t RangeAllocator::allocate(uint32_t size) {
+        for (auto it = _freeRanges.begin(); it != _freeRanges.end(); ++it) {
+            if (it->second < size) {
+                continue;
+            }
+
+            uint32_t offset = it->first;
+            uint32_t remainingSize = it->second - size;
+            _freeRanges.erase(it);
+            if (remainingSize > 0) {
+                _freeRanges[offset + size] = remainingSize;
+            }
+            _freeSize -= size;
+            return offset;
+        }
+        return kInvalidOffset;
+    }
+
+
+    void RangeAllocator::free(uint32_t offset, uint32_t size) {
+        _freeSize += size;
+
+        auto next = _freeRanges.lower_bound(offset);
+        assert(next == _freeRanges.end() || offset + size <= next->first);
+
+        // Merge with following range
+        if (next != _freeRanges.end() && offset + size == next->first) {
+            size += next->second;
+            next = _freeRanges.erase(next);
+        }
+
+        // Merge with preceding range
+        if (next != _freeRanges.begin()) {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == offset) {
+                prev->second += size;
+                return;
+            }
+        }
+        _freeRanges[offset] = size;
+    }
+
+
+    StagingDescriptorHeap::StagingDescriptorHeap(ID3D12DevicePtr device, D3D12_DESCRIPTOR_HEAP_TYPE heapType,
+        uint32_t descriptorsPerPage) : _device(device), _heapType(heapType), _descriptorsPerPage(descriptorsPerPage) {
+        _descriptorSize = _device->GetDescriptorHandleIncrementSize(heapType);
+        _pageOffset = descriptorsPerPage;
+    }
+
+
+    D3D12_CPU_DESCRIPTOR_HANDLE StagingDescriptorHeap::allocate(HRESULT* outResult) {
+        if (!_freeHandles.empty()) {
+            D3D12_CPU_DESCRIPTOR_HANDLE handle = _freeHandles.back();
+            _freeHandles.pop_back();
+            ++_allocatedCount;
+            _checkFailedAndAssign(S_OK, outResult);
+            return handle;
+        }
+
+        // Grow by one page of CPU-only descriptors
+        if (_pageOffset == _descriptorsPerPage) {
+            D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+            heapDesc.NumDescriptors = _descriptorsPerPage;
+            heapDesc.Type = _heapType;
+            heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+
+            ID3D12DescriptorHeap* heap = nullptr;
+            HRESULT hr = _device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&heap));
+            CHECK_ASSIGN_RETURN_IF_FAILED_(hr, outResult, D3D12_CPU_DESCRIPTOR_HANDLE{});
+
+            _pages.push_back(ID3D12DescriptorHeapPtr(heap, PtrDeleter()));
+            _pageOffset = 0;
+        }
+
+        D3D12_CPU_DESCRIPTOR_HANDLE handle = _pages.back()->GetCPUDescriptorHandleForHeapStart();
+        handle.ptr += _pageOffset * _descriptorSize;
+        ++_pageOffset;
+        ++_allocatedCount;
+        _checkFailedAndAssign(S_OK, outResult);
+        return handle;
+    }
+
+
+    void StagingDescriptorHeap::free(D3D12_CPU_DESCRIPTOR_HANDLE handle) {
+        if (handle.ptr == 0) {
+            return;
+        }
+        _freeHandles.push_back(handle);
+        --_allocatedCount;
+    }
+
+
+    ShaderVisibleDescriptorHeap::ShaderVisibleDescriptorHeap(ID3D12DevicePtr device, ID3D12DescriptorHeapPtr heap,
+        uint32_t staticCount, uint32_t transientCountPerFrame, int32_t frameCount) : _device(device), _heap(heap),
+        _staticAllocator(staticCount), _transientCountPerFrame(transientCountPerFrame), _frameCount(frameCount),
+        _transientFrameStart(staticCount) {
+
+        _heapType = _heap->GetDesc().Type;
+        _cpuStart = _heap->GetCPUDescriptorHandleForHeapStart();
+        _gpuStart = _heap->GetGPUDescriptorHandleForHeapStart();
+        _descriptorSize = _device->GetDescriptorHandleIncrementSize(_heapType);
+    }
+
+
+    DescriptorRange ShaderVisibleDescriptorHeap::_makeRange(uint32_t index, uint32_t count) const {
+        DescriptorRange range;
+        range.cpuHandle = { _cpuStart.ptr + index * _descriptorSize };
+        range.gpuHandle = { _gpuStart.ptr + index * _descriptorSize };
+        range.index = index;
+        range.count = count;
+        range.descriptorSize = _descriptorSize;
+        return range;
+    }
+
+
+    DescriptorRange ShaderVisibleDescriptorHeap::allocateStatic(uint32_t count) {
+        uint32_t index = _staticAllocator.allocate(count);
+        if (index == RangeAllocator::kInvalidOffset) {
+            return DescriptorRange();
+        }
+        return _makeRange(index, count);
+    }
+
+
+    void ShaderVisibleDescriptorHeap::freeStatic(const DescriptorRange& range) {
+        if (range.isValid()) {
+            _staticAllocator.free(range.index, range.count);
+        }
+    }
+
+
+    void ShaderVisibleDescriptorHeap::beginFrame(int32_t frameIndex) {
+        assert(frameIndex >= 0 && frameIndex < _frameCount);
+        _transientFrameStart = _staticAllocator.size() + frameIndex * _transientCountPerFrame;
+        _transientOffset = 0;
+    }
+
+
+    DescriptorRange ShaderVisibleDescriptorHeap::allocateTransient(uint32_t count) {
+        if (_transientOffset + count > _transientCountPerFrame) {
+            return DescriptorRange();
+        }
+
+        uint32_t index = _transientFrameStart + _transientOffset;
+        _transientOffset += count;
+        return _makeRange(index, count);
+    }
+
+
+    DescriptorRange ShaderVisibleDescriptorHeap::copyToTransient(uint32_t count,
+        const D3D12_CPU_DESCRIPTOR_HANDLE* srcHandles) {
+        DescriptorRange range = allocateTransient(count);
+        if (!range.isValid()) {
+            return range;
+        }
+
+        // One destination range, count source ranges of one descriptor each
+        const uint32_t kMaxSrcRanges = 64;
+        uint32_t srcRangeSizes[kMaxSrcRanges];
+        for (uint32_t i = 0; i < std::min(count, kMaxSrcRanges); ++i) {
+            srcRangeSizes[i] = 1;
+        }
+
+        for (uint32_t copied = 0; copied < count; copied += kMaxSrcRanges) {
+            uint32_t batchCount = std::min(count - copied, kMaxSrcRanges);
+            D3D12_CPU_DESCRIPTOR_HANDLE dstHandle = range.cpu(copied);
+            _device->CopyDescriptors(1, &dstHandle, &batchCount, batchCount, srcHandles + copied, srcRangeSizes,
+                _heapType);
+        }
+        return range;
+    }
+
+
+    ///
+    /// BindlessResourceTable Implementation
+    ///
+    BindlessResourceTable::BindlessResourceTable(ID3D12DevicePtr device, ShaderVisibleDescriptorHeapPtr heap) :
+        _device(device), _heap(heap) {
+    }
+
+
+    DescriptorRange BindlessResourceTable::addShaderResourceViews(uint32_t count, const ID3D12ResourcePtr* resources,
+        const D3D12_SHADER_RESOURCE_VIEW_DESC* descs) {
+        DescriptorRange range = _heap->allocateStatic(count);
+        if (!range.isValid()) {
+            return range;
+        }
+
+        Entry entry = { range, std::vector<ID3D12ResourcePtr>(resources, resources + count) };
+        for (uint32_t i = 0; i < count; ++i) {
+            _device->CreateShaderResourceView(resources[i].get(), &descs[i], range.cpu(i));
+        }
+
+        _entries[range.index] = std::move(entry);
+        _viewCount += count;
+        return range;
+    }
+
+
+    void BindlessResourceTable::remove(uint32_t index) {
+        auto it = _entries.find(index);
+        if (it == _entries.end()) {
+            return;
+        }
+
+        _heap->freeStatic(it->second.range);
+        _viewCount -= it->second.range.count;
+        _entries.erase(it);
+    }
+
+
+    ///
+    /// SamplerCache Implementation
+    ///
+    SamplerCache::SamplerCache(ID3D12DevicePtr device, ShaderVisibleDescriptorHeapPtr heap) :
+        _device(device), _heap(heap) {
+    }
+
+
+    DescriptorRange SamplerCache::acquire(const D3D12_SAMPLER_DESC& desc) {
+        D3D12_SAMPLER_DESC canonicalDesc = fastdxu::canonicalSamplerDesc(desc);
+        uint64_t hash = fastdxu::hashBytes(&canonicalDesc, sizeof(canonicalDesc));
+
+        auto matches = _hashToIndex.equal_range(hash);
+        for (auto it = matches.first; it != matches.second; ++it) {
+            Entry& entry = _entries[it->second];
+            if (memcmp(&entry.desc, &canonicalDesc, sizeof(canonicalDesc)) == 0) {
+                if (entry.refCount++ == 0) {
+                    _unreferenced.erase(entry.unreferencedIterator);
+                }
+                ++_hitCount;
+                return entry.range;
+            }
+        }
+
+        // Miss, recycle the least recently released sampler if the heap is full
+        DescriptorRange range = _heap->allocateStatic(1);
+        if (!range.isValid()) {
+            if (_unreferenced.empty()) {
+                return range;
+            }
+
+            auto recycled = _entries.find(_unreferenced.front());
+            _unreferenced.pop_front();
+            range = recycled->second.range;
+
+            auto recycledMatches = _hashToIndex.equal_range(recycled->second.hash);
+            for (auto it = recycledMatches.first; it != recycledMatches.second; ++it) {
+                if (it->second == range.index) {
+                    _hashToIndex.erase(it);
+                    break;
+                }
+            }
+            _entries.erase(recycled);
+        }
+
+        _device->CreateSampler(&canonicalDesc, range.cpuHandle);
+        _entries[range.index] = Entry{ canonicalDesc, hash, range, 1, _unreferenced.end() };
+        _hashToIndex.emplace(hash, range.index);
+        ++_missCount;
+        return range;
+    }
+
+
+    void SamplerCache::release(const DescriptorRange& range) {
+        auto it = _entries.find(range.index);
+        if (it == _entries.end() || it->second.refCount == 0) {
+            return;
+        }
+
+        Entry& entry = it->second;
+        if (--entry.refCount == 0) {
+            entry.unreferencedIterator = _unreferenced.insert(_unreferenced.end(), range.index);
+        }
+    }
+
+
+    ///
+    /// ResourceStateTracker Implementation
+    ///
+    void ResourceStateTracker::track(ID3D12Resource* resource, D3D12_RESOURCE_STATES state,
+        uint32_t subresourceCount) {
+        _resources[resource] = TrackedResource{ { state }, subresourceCount };
+    }
+
+
+    void ResourceStateTracker::untrack(ID3D12Resource* resource) {
+        _resources.erase(resource);
+    }
+
+
+    void ResourceStateTracker::_transition(ID3D12Resource* resource, D3D12_RESOURCE_STATES state,
+        uint32_t subresource, D3D12_RESOURCE_BARRIER_FLAGS flags) {
+        auto it = _resources.find(resource);
+        assert(it != _resources.end() || !"Resource is not tracked!");
+        if (it == _resources.end()) {
+            return;
+        }
+        ++_requestedCount;
+
+        const uint32_t kReadOnlyStates = D3D12_RESOURCE_STATE_GENERIC_READ | D3D12_RESOURCE_STATE_DEPTH_READ;
+        auto isTransitionNeeded = [kReadOnlyStates](D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after) {
+            bool isReadOnly = (before & ~kReadOnlyStates) == 0 && before != D3D12_RESOURCE_STATE_COMMON;
+            return before != after && !(isReadOnly && (after & ~before) == 0 && after != D3D12_RESOURCE_STATE_COMMON);
+        };
+
+        // Uniform state, one barrier covers every subresource
+        TrackedResource& tracked = it->second;
+        std::vector<D3D12_RESOURCE_STATES>& states = tracked.subresourceStates;
+        if (states.size() == 1 && (subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES ||
+            tracked.subresourceCount == 1)) {
+            if (isTransitionNeeded(states[0], state)) {
+                _queueTransition(resource, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, states[0], state, flags);
+                states[0] = state;
+            }
+            return;
+        }
+
+        // One barrier per subresource that differs
+        if (states.size() == 1) {
+            states.assign(tracked.subresourceCount, states[0]);
+        }
+
+        bool isAll = (subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES);
+        uint32_t first = isAll ? 0 : subresource;
+        uint32_t last = isAll ? tracked.subresourceCount : subresource + 1;
+        for (uint32_t i = first; i < last; ++i) {
+            if (isTransitionNeeded(states[i], state)) {
+                _queueTransition(resource, i, states[i], state, flags);
+                states[i] = state;
+            }
+        }
+
+        bool isUniform = true;
+        for (uint32_t i = 1; i < tracked.subresourceCount && isUniform; ++i) {
+            isUniform = (states[i] == states[0]);
+        }
+        if (isUniform) {
+            states.resize(1);
+        }
+    }
+
+
+    void ResourceStateTracker::_queueTransition(ID3D12Resource* resource, uint32_t subresource,
+        D3D12_RESOURCE_STATES stateBefore, D3D12_RESOURCE_STATES stateAfter, D3D12_RESOURCE_BARRIER_FLAGS flags) {
+        D3D12_RESOURCE_BARRIER barrier = {};
+        barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+        barrier.Flags = flags;
+        barrier.Transition = { resource, subresource, stateBefore, stateAfter };
+
+        if (flags == D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY) {
+            barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+            _splitBarriers.push_back(barrier);
+            barrier.Flags = flags;
+        }
+
+        // Merge A->B then B->C into A->C when it is the last queued barrier on this resource
+        if (flags == D3D12_RESOURCE_BARRIER_FLAG_NONE) {
+            for (auto it = _pendingBarriers.rbegin(); it != _pendingBarriers.rend(); ++it) {
+                if (it->Type != D3D12_RESOURCE_BARRIER_TYPE_TRANSITION || it->Transition.pResource != resource) {
+                    continue;
+                }
+
+                if (it->Flags == D3D12_RESOURCE_BARRIER_FLAG_NONE && it->Transition.Subresource == subresource &&
+                    it->Transition.StateAfter == stateBefore) {
+                    it->Transition.StateAfter = stateAfter;
+                    if (it->Transition.StateBefore == stateAfter) {
+                        _pendingBarriers.erase(std::next(it).base());
+                    }
+                    return;
+                }
+                break;
+            }
+        }
+
+        _pendingBarriers.push_back(barrier);
+    }
+
+
+    void ResourceStateTracker::endTransition(ID3D12Resource* resource) {
+        for (size_t i = 0; i < _splitBarriers.size();) {
+            if (_splitBarriers[i].Transition.pResource == resource) {
+                _pendingBarriers.push_back(_splitBarriers[i]);
+                _splitBarriers.erase(_splitBarriers.begin() + i);
+            } else {
+                ++i;
+            }
+        }
+    }
+
+
+    void ResourceStateTracker::uavBarrier(ID3D12Resource* resource) {
+        D3D12_RESOURCE_BARRIER barrier = {};
+        barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+        barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+        barrier.UAV.pResource = resource;
+        _pendingBarriers.push_back(barrier);
+        ++_requestedCount;
+    }
+
+
+    uint32_t ResourceStateTracker::flush(ID3D12GraphicsCommandListPtr commandList) {
+        uint32_t barrierCount = static_cast<uint32_t>(_pendingBarriers.size());
+        if (barrierCount == 0) {
+            return 0;
+        }
+
+        commandList->ResourceBarrier(barrierCount, _pendingBarriers.data());
+        _pendingBarriers.clear();
+        _barrierCount += barrierCount;
+        ++_flushCount;
+        return barrierCount;
+    }
+
+
+    D3D12_RESOURCE_STATES ResourceStateTracker::state(ID3D12Resource* resource, uint32_t subresource) const {
+        auto it = _resources.find(resource);
+        if (it == _resources.end()) {
+            return D3D12_RESOURCE_STATE_COMMON;
+        }
+
+        const std::vector<D3D12_RESOURCE_STATES>& states = it->second.subresourceStates;
+        return (states.size() == 1) ? states[0] : states[subresource];
+    }
+
+
+    ///
+    /// RenderGraph Implementation
+    ///
+    RenderGraph::RenderGraph(ID3D12DevicePtr device, int32_t frameCount, AllocationInfoFunction allocationInfoFunction,
+        ResidencyManagerPtr residencyManager) :
+        _device(device), _allocationInfoFunction(allocationInfoFunction), _residencyManager(residencyManager),
+        _frameHeaps(frameCount) {
+        // Heaps mixing resource categories need tier 2, assume tier 1 if the query fails
+        D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+        if (SUCCEEDED(_device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options)))) {
+            _resourceHeapTier = options.ResourceHeapTier;
+        }
+    }
+
+
+    void RenderGraph::reset() {
+        _passes.clear();
+        _resources.clear();
+        _finalTransitions.clear();
+        _culledPassCount = 0;
+        _transientSizeInBytes = 0;
+        _heapSizeInBytes = 0;
+        std::fill(std::begin(_heapSizesInBytes), std::end(_heapSizesInBytes), 0);
+        _heapAlignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    }
+
+
+    uint32_t RenderGraph::_heapIndex(const D3D12_RESOURCE_DESC& desc) const {
+        if (_resourceHeapTier != D3D12_RESOURCE_HEAP_TIER_1) {
+            return RenderTargetHeap;
+        }
+        if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER) {
+            return BufferHeap;
+        }
+        const uint32_t kRenderTargetFlags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET |
+            D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+        return (desc.Flags & kRenderTargetFlags) ? RenderTargetHeap : TextureHeap;
+    }
+
+
+    uint32_t RenderGraph::createTexture(const char* name, const D3D12_RESOURCE_DESC& desc,
+        const D3D12_CLEAR_VALUE* clearValue) {
+        Resource resource;
+        resource.name = name;
+        resource.desc = desc;
+        resource.hasClearValue = (clearValue != nullptr);
+        resource.clearValue = clearValue ? *clearValue : D3D12_CLEAR_VALUE{};
+        _resources.push_back(resource);
+        return static_cast<uint32_t>(_resources.size() - 1);
+    }
+
+
+    uint32_t RenderGraph::importResource(const char* name, ID3D12Resource* imported, D3D12_RESOURCE_STATES state) {
+        Resource resource;
+        resource.name = name;
+        resource.imported = imported;
+        resource.importedState = state;
+        _resources.push_back(resource);
+        return static_cast<uint32_t>(_resources.size() - 1);
+    }
+
+
+    uint32_t RenderGraph::addPass(const char* name, ExecuteFunction execute, bool hasSideEffects) {
+        Pass pass;
+        pass.name = name;
+        pass.execute = execute;
+        pass.hasSideEffects = hasSideEffects;
+        _passes.push_back(std::move(pass));
+        return static_cast<uint32_t>(_passes.size() - 1);
+    }
+
+
+    void RenderGraph::read(uint32_t pass, uint32_t resource, D3D12_RESOURCE_STATES state) {
+        _passes[pass].accesses.push_back({ resource, state, false });
+    }
+
+
+    void RenderGraph::write(uint32_t pass, uint32_t resource, D3D12_RESOURCE_STATES state) {
+        _passes[pass].accesses.push_back({ resource, state, true });
+    }
+
+
+    void RenderGraph::compile() {
+        _cullPasses();
+        _computeTransitions();
+        _placeTransients();
+    }
+
+
+    void RenderGraph::_cullPasses() {
+        // Passes are referenced by their outputs, resources by their readers. Imported resources are outputs
+        for (Pass& pass : _passes) {
+            for (const Access& access : pass.accesses) {
+                if (access.isWrite) {
+                    ++pass.refCount;
+                } else {
+                    ++_resources[access.resource].refCount;
+                }
+            }
+        }
+
+        std::vector<uint32_t> unreferencedResources;
+        for (uint32_t i = 0; i < _resources.size(); ++i) {
+            if (_resources[i].imported != nullptr) {
+                ++_resources[i].refCount;
+            } else if (_resources[i].refCount == 0) {
+                unreferencedResources.push_back(i);
+            }
+        }
+
+        // Culled passes release what they read
+        auto cullPass = [&](Pass& pass) {
+            pass.isCulled = true;
+            ++_culledPassCount;
+            for (const Access& access : pass.accesses) {
+                if (!access.isWrite && --_resources[access.resource].refCount == 0) {
+                    unreferencedResources.push_back(access.resource);
+                }
+            }
+        };
+
+        for (Pass& pass : _passes) {
+            if (pass.refCount == 0 && !pass.hasSideEffects) {
+                cullPass(pass);
+            }
+        }
+
+        // Unreferenced resources release their writers
+        while (!unreferencedResources.empty()) {
+            uint32_t resource = unreferencedResources.back();
+            unreferencedResources.pop_back();
+
+            for (Pass& pass : _passes) {
+                bool writesResource = false;
+                for (const Access& access : pass.accesses) {
+                    writesResource |= (access.isWrite && access.resource == resource);
+                }
+                if (writesResource && !pass.isCulled && --pass.refCount == 0 && !pass.hasSideEffects) {
+                    cullPass(pass);
+                }
+            }
+        }
+    }
+
+
+    void RenderGraph::_computeTransitions() {
+        std::vector<D3D12_RESOURCE_STATES> states(_resources.size());
+        for (uint32_t i = 0; i < _resources.size(); ++i) {
+            states[i] = _resources[i].importedState;
+        }
+
+        for (uint32_t passIndex = 0; passIndex < _passes.size(); ++passIndex) {
+            Pass& pass = _passes[passIndex];
+            if (pass.isCulled) {
+                continue;
+            }
+
+            for (const Access& access : pass.accesses) {
+                Resource& resource = _resources[access.resource];
+                bool isFirstUse = (resource.firstPass == kInvalidId);
+                if (isFirstUse) {
+                    resource.firstPass = passIndex;
+                    resource.firstState = access.state;
+                }
+                resource.lastPass = passIndex;
+
+                // Transients are placed in their first state whenever possible, execute() fixes up the rest
+                if (isFirstUse && resource.imported == nullptr) {
+                    pass.transitions.push_back({ access.resource, access.state, access.state, true });
+                } else if (states[access.resource] != access.state) {
+                    pass.transitions.push_back({ access.resource, states[access.resource], access.state, false });
+                }
+                states[access.resource] = access.state;
+                resource.lastState = access.state;
+            }
+        }
+
+        for (uint32_t i = 0; i < _resources.size(); ++i) {
+            const Resource& resource = _resources[i];
+            if (resource.imported != nullptr && states[i] != resource.importedState) {
+                _finalTransitions.push_back({ i, states[i], resource.importedState, false });
+            }
+        }
+    }
+
+
+    void RenderGraph::_placeTransients() {
+        std::vector<uint32_t> transients;
+        for (uint32_t i = 0; i < _resources.size(); ++i) {
+            Resource& resource = _resources[i];
+            if (resource.imported == nullptr && resource.firstPass != kInvalidId) {
+                resource.allocationInfo = _allocationInfoFunction(resource.desc);
+                resource.heapIndex = _heapIndex(resource.desc);
+                _transientSizeInBytes += resource.allocationInfo.SizeInBytes;
+                _heapAlignment = std::max(_heapAlignment, resource.allocationInfo.Alignment);
+                transients.push_back(i);
+            }
+        }
+
+        // Largest first, each at the lowest offset not overlapping a placed transient alive at the same time
+        std::sort(transients.begin(), transients.end(), [this](uint32_t a, uint32_t b) {
+            return _resources[a].allocationInfo.SizeInBytes > _resources[b].allocationInfo.SizeInBytes;
+        });
+
+        auto isAliveTogether = [](const Resource& a, const Resource& b) {
+            return a.heapIndex == b.heapIndex && a.firstPass <= b.lastPass && b.firstPass <= a.lastPass;
+        };
+        auto isOverlapping = [](const Resource& a, const Resource& b) {
+            return a.heapIndex == b.heapIndex && a.heapOffset < b.heapOffset + b.allocationInfo.SizeInBytes &&
+                b.heapOffset < a.heapOffset + a.allocationInfo.SizeInBytes;
+        };
+
+        for (uint32_t i = 0; i < transients.size(); ++i) {
+            Resource& resource = _resources[transients[i]];
+            uint64_t alignmentMask = std::max(resource.allocationInfo.Alignment, uint64_t(1)) - 1;
+
+            std::vector<uint64_t> candidateOffsets = { 0 };
+            for (uint32_t j = 0; j < i; ++j) {
+                const Resource& placed = _resources[transients[j]];
+                if (isAliveTogether(resource, placed)) {
+                    uint64_t endOffset = placed.heapOffset + placed.allocationInfo.SizeInBytes;
+                    candidateOffsets.push_back((endOffset + alignmentMask) & ~alignmentMask);
+                }
+            }
+            std::sort(candidateOffsets.begin(), candidateOffsets.end());
+
+            for (uint64_t offset : candidateOffsets) {
+                resource.heapOffset = offset;
+                bool isFree = true;
+                for (uint32_t j = 0; j < i && isFree; ++j) {
+                    const Resource& placed = _resources[transients[j]];
+                    isFree = !isAliveTogether(resource, placed) || !isOverlapping(resource, placed);
+                }
+                if (isFree) {
+                    break;
+                }
+            }
+            uint64_t& heapSizeInBytes = _heapSizesInBytes[resource.heapIndex];
+            heapSizeInBytes = std::max(heapSizeInBytes, resource.heapOffset + resource.allocationInfo.SizeInBytes);
+        }
+        for (uint64_t heapSizeInBytes : _heapSizesInBytes) {
+            _heapSizeInBytes += heapSizeInBytes;
+        }
+
+        // Transients sharing memory must be activated with an aliasing barrier on first use
+        for (uint32_t i = 0; i < transients.size(); ++i) {
+            for (uint32_t j = i + 1; j < transients.size(); ++j) {
+                Resource& a = _resources[transients[i]];
+                Resource& b = _resources[transients[j]];
+                if (isOverlapping(a, b)) {
+                    a.isAliased = b.isAliased = true;
+                }
+            }
+        }
+    }
+
+
+    HRESULT RenderGraph::execute(int32_t frameIndex, const CommandListFunction& nextCommandList) {
+        FASTDX_PROFILE_FUNCTION();
+        HRESULT hr = S_OK;
+        FrameHeap& frameHeap = _frameHeaps[frameIndex];
+
+        // Grow this frame's heaps, textures placed in a previous one are dropped with it
+        const D3D12_HEAP_FLAGS kTier1HeapFlags[HeapCount] = { D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES,
+            D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES, D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS };
+        const ResourceCategory kHeapCategories[HeapCount] = { ResourceCategory::RenderTarget,
+            ResourceCategory::Texture, ResourceCategory::Buffer };
+        for (uint32_t heapIndex = 0; heapIndex < HeapCount; ++heapIndex) {
+            uint64_t heapSizeInBytes = _heapSizesInBytes[heapIndex];
+            if (heapSizeInBytes <= frameHeap.sizesInBytes[heapIndex]) {
+                continue;
+            }
+
+            D3D12_HEAP_DESC heapDesc = {};
+            heapDesc.SizeInBytes = heapSizeInBytes;
+            heapDesc.Properties = { D3D12_HEAP_TYPE_DEFAULT };
+            heapDesc.Alignment = _heapAlignment;
+            heapDesc.Flags = (_resourceHeapTier == D3D12_RESOURCE_HEAP_TIER_1) ? kTier1HeapFlags[heapIndex] :
+                D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES;
+
+            ID3D12Heap* heap = nullptr;
+            hr = _device->CreateHeap(&heapDesc, IID_PPV_ARGS(&heap));
+            if (FAILED(hr)) {
+                return hr;
+            }
+            if (_residencyManager) {
+                // Used by every frame on this index, never worth evicting
+                _residencyManager->track(heap, heapSizeInBytes, kHeapCategories[heapIndex], false);
+                frameHeap.heaps[heapIndex] = ID3D12HeapPtr(heap,
+                    [residencyManager = _residencyManager](ID3D12Heap* ptr) {
+                        residencyManager->untrack(ptr);
+                        SAFE_RELEASE(ptr);
+                    });
+            } else {
+                frameHeap.heaps[heapIndex] = ID3D12HeapPtr(heap, PtrDeleter());
+            }
+            frameHeap.sizesInBytes[heapIndex] = heapSizeInBytes;
+            frameHeap.placedTextures.erase(std::remove_if(frameHeap.placedTextures.begin(),
+                frameHeap.placedTextures.end(), [heapIndex](const PlacedTexture& placedTexture) {
+                    return placedTexture.heapIndex == heapIndex;
+                }), frameHeap.placedTextures.end());
+        }
+
+        // Reuse textures placed with the same desc at the same offset on previous frames
+        for (PlacedTexture& placedTexture : frameHeap.placedTextures) {
+            placedTexture.isUsed = false;
+        }
+        for (Resource& resource : _resources) {
+            if (resource.imported != nullptr || resource.firstPass == kInvalidId) {
+                continue;
+            }
+
+            for (PlacedTexture& placedTexture : frameHeap.placedTextures) {
+                if (!placedTexture.isUsed && placedTexture.heapIndex == resource.heapIndex &&
+                    placedTexture.heapOffset == resource.heapOffset &&
+                    memcmp(&placedTexture.desc, &resource.desc, sizeof(resource.desc)) == 0) {
+                    placedTexture.isUsed = true;
+                    resource.placed = placedTexture.resource.get();
+                    break;
+                }
+            }
+        }
+
+        // Drop the others, the GPU is done with this frame's heap
+        frameHeap.placedTextures.erase(std::remove_if(frameHeap.placedTextures.begin(),
+            frameHeap.placedTextures.end(), [](const PlacedTexture& placedTexture) { return !placedTexture.isUsed; }),
+            frameHeap.placedTextures.end());
+
+        for (Resource& resource : _resources) {
+            if (resource.imported != nullptr || resource.firstPass == kInvalidId || resource.placed != nullptr) {
+                continue;
+            }
+
+            ID3D12Resource* placed = nullptr;
+            hr = _device->CreatePlacedResource(frameHeap.heaps[resource.heapIndex].get(), resource.heapOffset,
+                &resource.desc, resource.firstState, resource.hasClearValue ? &resource.clearValue : nullptr,
+                IID_PPV_ARGS(&placed));
+            if (FAILED(hr)) {
+                return hr;
+            }
+
+            frameHeap.placedTextures.push_back({ resource.desc, resource.heapIndex, resource.heapOffset,
+                ID3D12ResourcePtr(placed, PtrDeleter()), resource.firstState, true });
+            resource.placed = placed;
+        }
+
+        auto placedTexture = [&frameHeap](ID3D12Resource* placed) -> PlacedTexture& {
+            return *std::find_if(frameHeap.placedTextures.begin(), frameHeap.placedTextures.end(),
+                [placed](const PlacedTexture& placedTexture) { return placedTexture.resource.get() == placed; });
+        };
+
+        auto recordBarriers = [&](ID3D12GraphicsCommandListPtr commandList, const std::vector<Transition>& transitions) {
+            std::vector<D3D12_RESOURCE_BARRIER> barriers;
+            for (const Transition& transition : transitions) {
+                D3D12_RESOURCE_BARRIER barrier = {};
+                ID3D12Resource* d3dResource = resource(transition.resource);
+                D3D12_RESOURCE_STATES stateBefore = transition.stateBefore;
+                if (transition.isFirstUse) {
+                    if (_resources[transition.resource].isAliased) {
+                        barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+                        barrier.Aliasing = { nullptr, d3dResource };
+                        barriers.push_back(barrier);
+                    }
+                    stateBefore = placedTexture(d3dResource).state;
+                }
+                if (stateBefore != transition.stateAfter) {
+                    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+                    barrier.Transition = { d3dResource, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, stateBefore,
+                        transition.stateAfter };
+                    barriers.push_back(barrier);
+                }
+            }
+            if (!barriers.empty()) {
+                commandList->ResourceBarrier(static_cast<uint32_t>(barriers.size()), barriers.data());
+            }
+        };
+
+        for (Pass& pass : _passes) {
+            if (pass.isCulled) {
+                continue;
+            }
+            ID3D12GraphicsCommandListPtr commandList = nextCommandList();
+            recordBarriers(commandList, pass.transitions);
+            pass.execute(commandList);
+        }
+        recordBarriers(nextCommandList(), _finalTransitions);
+
+        for (const Resource& resource : _resources) {
+            if (resource.placed != nullptr) {
+                placedTexture(resource.placed).state = resource.lastState;
+            }
+        }
+        return hr;
+    }
+
+
+    ID3D12Resource* RenderGraph::resource(uint32_t resource) const {
+        const Resource& graphResource = _resources[resource];
+        return graphResource.imported ? graphResource.imported : graphResource.placed;
+    }
+
+
+    ///
+    /// DrawPacketQueue Implementation
+    ///
+    void DrawPacketQueue::sort() {
+        const uint32_t kDigitCount = sizeof(uint64_t);
+        const uint32_t kBucketCount = 256;
+
+        // All digit histograms in a single pass
+        std::vector<uint32_t> histograms(kDigitCount * kBucketCount, 0);
+        for (const DrawPacket& packet : _packets) {
+            for (uint32_t digit = 0; digit < kDigitCount; ++digit) {
+                ++histograms[digit * kBucketCount + ((packet.sortKey >> (digit * 8)) & 0xFF)];
+            }
+        }
+
+        _sortBuffer.resize(_packets.size());
+        for (uint32_t digit = 0; digit < kDigitCount; ++digit) {
+            uint32_t* histogram = &histograms[digit * kBucketCount];
+            uint32_t firstKeyBucket = _packets.empty() ? 0 : ((_packets[0].sortKey >> (digit * 8)) & 0xFF);
+            if (histogram[firstKeyBucket] == _packets.size()) {
+                continue;
+            }
+
+            uint32_t offset = 0;
+            for (uint32_t bucket = 0; bucket < kBucketCount; ++bucket) {
+                uint32_t count = histogram[bucket];
+                histogram[bucket] = offset;
+                offset += count;
+            }
+
+            for (const DrawPacket& packet : _packets) {
+                _sortBuffer[histogram[(packet.sortKey >> (digit * 8)) & 0xFF]++] = packet;
+            }
+            _packets.swap(_sortBuffer);
+        }
+    }
+
+
+    void DrawPacketQueue::execute(uint32_t begin, uint32_t end, const ExecuteFunction& execute) {
+        uint64_t stateChangeCount = 0;
+        for (uint32_t i = begin; i < end; ++i) {
+            const DrawPacket& packet = _packets[i];
+            uint32_t stateChanges = kAllChanged;
+            if (i > begin) {
+                uint64_t previousKey = _packets[i - 1].sortKey;
+                stateChanges = 0;
+                stateChanges |= (sortKeyPass(packet.sortKey) != sortKeyPass(previousKey)) ? kAllChanged : 0;
+                stateChanges |= (sortKeyPipeline(packet.sortKey) != sortKeyPipeline(previousKey)) ? kPipelineChanged : 0;
+                stateChanges |= (sortKeyMaterial(packet.sortKey) != sortKeyMaterial(previousKey)) ? kMaterialChanged : 0;
+            }
+
+            stateChangeCount += ((stateChanges & kPipelineChanged) ? 1 : 0) + ((stateChanges & kMaterialChanged) ? 1 : 0);
+            execute(packet, stateChanges);
+        }
+
+        uint64_t drawCount = (end > begin) ? (end - begin) : 0;
+        _stateChangeCount.fetch_add(stateChangeCount, std::memory_order_relaxed);
+        _avoidedStateChangeCount.fetch_add(2 * drawCount - stateChangeCount, std::memory_order_relaxed);
+    }
+
+
+    ///
+    /// CommandList Implementation
+    ///
+    CommandList::CommandList(ID3D12GraphicsCommandListPtr commandList) : _commandList(commandList) {
+        invalidate();
+    }
+
+
+    void CommandList::invalidate() {
+        _pipelineState = nullptr;
+        _rootSignature = nullptr;
+        _topology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+        _viewportCount = 0;
+        _scissorRectCount = 0;
+        _renderTargetCount = UINT32_MAX;
+        _descriptorHeaps[0] = _descriptorHeaps[1] = nullptr;
+        _indexBuffer = {};
+        _clearRootArguments();
+    }
+
+
+    void CommandList::setPipelineState(ID3D12PipelineState* pipelineState) {
+        if (!_filter(pipelineState == _pipelineState)) {
+            _pipelineState = pipelineState;
+            _commandList->SetPipelineState(pipelineState);
+        }
+    }
+
+
+    void CommandList::setGraphicsRootSignature(ID3D12RootSignature* rootSignature) {
+        if (!_filter(rootSignature == _rootSignature)) {
+            _rootSignature = rootSignature;
+            _clearRootArguments();
+            _commandList->SetGraphicsRootSignature(rootSignature);
+        }
+    }
+
+
+    void CommandList::setPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY topology) {
+        if (!_filter(topology == _topology)) {
+            _topology = topology;
+            _commandList->IASetPrimitiveTopology(topology);
+        }
+    }
+
+
+    void CommandList::setViewports(uint32_t count, const D3D12_VIEWPORT* viewports) {
+        assert(count <= kMaxViewports);
+        bool isRedundant = (count == _viewportCount && memcmp(viewports, _viewports, count * sizeof(*viewports)) == 0);
+        if (!_filter(isRedundant)) {
+            _viewportCount = count;
+            memcpy(_viewports, viewports, count * sizeof(*viewports));
+            _commandList->RSSetViewports(count, viewports);
+        }
+    }
+
+
+    void CommandList::setScissorRects(uint32_t count, const D3D12_RECT* rects) {
+        assert(count <= kMaxViewports);
+        bool isRedundant = (count == _scissorRectCount && memcmp(rects, _scissorRects, count * sizeof(*rects)) == 0);
+        if (!_filter(isRedundant)) {
+            _scissorRectCount = count;
+            memcpy(_scissorRects, rects, count * sizeof(*rects));
+            _commandList->RSSetScissorRects(count, rects);
+        }
+    }
+
+
+    void CommandList::setRenderTargets(uint32_t count, const D3D12_CPU_DESCRIPTOR_HANDLE* rtvHandles,
+        const D3D12_CPU_DESCRIPTOR_HANDLE* dsvHandle) {
+        assert(count <= D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT);
+        D3D12_CPU_DESCRIPTOR_HANDLE depthStencil = dsvHandle ? *dsvHandle : D3D12_CPU_DESCRIPTOR_HANDLE{};
+        bool isRedundant = (count == _renderTargetCount && depthStencil.ptr == _depthStencil.ptr &&
+            memcmp(rtvHandles, _renderTargets, count * sizeof(*rtvHandles)) == 0);
+        if (!_filter(isRedundant)) {
+            _renderTargetCount = count;
+            memcpy(_renderTargets, rtvHandles, count * sizeof(*rtvHandles));
+            _depthStencil = depthStencil;
+            _commandList->OMSetRenderTargets(count, rtvHandles, FALSE, dsvHandle);
+        }
+    }
+
+
+    void CommandList::setDescriptorHeaps(uint32_t count, ID3D12DescriptorHeap* const* heaps) {
+        assert(count <= _countof(_descriptorHeaps));
+        ID3D12DescriptorHeap* descriptorHeaps[2] = { count > 0 ? heaps[0] : nullptr, count > 1 ? heaps[1] : nullptr };
+        bool isRedundant = (descriptorHeaps[0] == _descriptorHeaps[0] && descriptorHeaps[1] == _descriptorHeaps[1]);
+        if (!_filter(isRedundant)) {
+            _descriptorHeaps[0] = descriptorHeaps[0];
+            _descriptorHeaps[1] = descriptorHeaps[1];
+            _commandList->SetDescriptorHeaps(count, heaps);
+
+            // Tables point into the previous heaps, they must be set again
+            for (RootArgument& rootArgument : _rootArguments) {
+                if (rootArgument.type == RootArgumentType::DescriptorTable) {
+                    rootArgument.type = RootArgumentType::None;
+                }
+            }
+        }
+    }
+
+
+    void CommandList::setIndexBuffer(const D3D12_INDEX_BUFFER_VIEW& view) {
+        if (!_filter(memcmp(&view, &_indexBuffer, sizeof(view)) == 0)) {
+            _indexBuffer = view;
+            _commandList->IASetIndexBuffer(&view);
+        }
+    }
+
+
+    bool CommandList::_filterRootArgument(uint32_t index, RootArgumentType type, uint64_t value) {
+        assert(index < kMaxRootParameters);
+        RootArgument& rootArgument = _rootArguments[index];
+        if (_filter(rootArgument.type == type && rootArgument.value == value)) {
+            return true;
+        }
+
+        rootArgument.type = type;
+        rootArgument.value = value;
+        return false;
+    }
+
+
+    void CommandList::setGraphicsRootConstantBufferView(uint32_t index, D3D12_GPU_VIRTUAL_ADDRESS address) {
+        if (!_filterRootArgument(index, RootArgumentType::ConstantBufferView, address)) {
+            _commandList->SetGraphicsRootConstantBufferView(index, address);
+        }
+    }
+
+
+    void CommandList::setGraphicsRootShaderResourceView(uint32_t index, D3D12_GPU_VIRTUAL_ADDRESS address) {
+        if (!_filterRootArgument(index, RootArgumentType::ShaderResourceView, address)) {
+            _commandList->SetGraphicsRootShaderResourceView(index, address);
+        }
+    }
+
+
+    void CommandList::setGraphicsRootDescriptorTable(uint32_t index, D3D12_GPU_DESCRIPTOR_HANDLE handle) {
+        if (!_filterRootArgument(index, RootArgumentType::DescriptorTable, handle.ptr)) {
+            _commandList->SetGraphicsRootDescriptorTable(index, handle);
+        }
+    }
+
+
+    bool CommandList::_reserveRootConstants(uint32_t index, uint32_t count) {
+        RootArgument& rootArgument = _rootArguments[index];
+        if (_rootConstantCount + count > kMaxRootSignatureDwords) {
+            // Grown ranges left holes, pack the live ones. They fit unless the calls exceed the root signature size
+            uint32_t constants[kMaxRootSignatureDwords];
+            uint32_t constantCount = 0;
+            for (RootArgument& other : _rootArguments) {
+                if (other.type == RootArgumentType::Constants && &other != &rootArgument) {
+                    memcpy(&constants[constantCount], &_rootConstants[other.constantsOffset],
+                        other.constantsCount * sizeof(uint32_t));
+                    other.constantsOffset = static_cast<uint8_t>(constantCount);
+                    constantCount += other.constantsCount;
+                }
+            }
+            if (constantCount + count > kMaxRootSignatureDwords) {
+                return false;
+            }
+            memcpy(&constants[constantCount], &_rootConstants[rootArgument.constantsOffset],
+                rootArgument.constantsCount * sizeof(uint32_t));
+            memcpy(_rootConstants, constants, (constantCount + rootArgument.constantsCount) * sizeof(uint32_t));
+            rootArgument.constantsOffset = static_cast<uint8_t>(constantCount);
+            _rootConstantCount = constantCount;
+        } else {
+            memmove(&_rootConstants[_rootConstantCount], &_rootConstants[rootArgument.constantsOffset],
+                rootArgument.constantsCount * sizeof(uint32_t));
+            rootArgument.constantsOffset = static_cast<uint8_t>(_rootConstantCount);
+        }
+        rootArgument.constantsCount = static_cast<uint8_t>(count);
+        _rootConstantCount += count;
+        return true;
+    }
+
+
+    void CommandList::_clearRootArguments() {
+        for (RootArgument& rootArgument : _rootArguments) {
+            rootArgument.type = RootArgumentType::None;
+            rootArgument.constantsMask = 0;
+        }
+        _rootConstantCount = 0;
+    }
+
+
+    void CommandList::setGraphicsRoot32BitConstants(uint32_t index, uint32_t count, const void* data,
+        uint32_t offset) {
+        assert(index < kMaxRootParameters && offset + count <= kMaxRootSignatureDwords);
+        RootArgument& rootArgument = _rootArguments[index];
+        if (rootArgument.type != RootArgumentType::Constants) {
+            rootArgument.type = RootArgumentType::Constants;
+            rootArgument.constantsOffset = 0;
+            rootArgument.constantsCount = 0;
+            rootArgument.constantsMask = 0;
+        }
+        if (offset + count > rootArgument.constantsCount && !_reserveRootConstants(index, offset + count)) {
+            assert(!"Root constants exceed the root signature size");
+            rootArgument.constantsMask = 0;
+            _filter(false);
+            _commandList->SetGraphicsRoot32BitConstants(index, count, data, offset);
+            return;
+        }
+
+        uint32_t* constants = &_rootConstants[rootArgument.constantsOffset];
+        uint64_t rangeMask = ((count < 64) ? ((uint64_t(1) << count) - 1) : UINT64_MAX) << offset;
+        bool isRedundant = (rootArgument.constantsMask & rangeMask) == rangeMask &&
+            memcmp(&constants[offset], data, count * sizeof(uint32_t)) == 0;
+        if (!_filter(isRedundant)) {
+            rootArgument.constantsMask |= rangeMask;
+            memcpy(&constants[offset], data, count * sizeof(uint32_t));
+            _commandList->SetGraphicsRoot32BitConstants(index, count, data, offset);
+        }
+    }
+
+
+    void CommandList::executeIndirect(ID3D12CommandSignature* commandSignature, uint32_t maxCommandCount,
+        ID3D12Resource* argumentBuffer, uint64_t argumentBufferOffset, ID3D12Resource* countBuffer,
+        uint64_t countBufferOffset) {
+        _commandList->ExecuteIndirect(commandSignature, maxCommandCount, argumentBuffer, argumentBufferOffset,
+            countBuffer, countBufferOffset);
+
+        _indexBuffer = {};
+        _clearRootArguments();
+    }
+
+
+    ///
+    /// Indirect Arguments Implementation
+    ///
+    uint32_t IndirectArgumentLayout::_add(const D3D12_INDIRECT_ARGUMENT_DESC& desc, uint32_t sizeInBytes) {
+        assert(!_isClosed && "Draw or dispatch argument must be the last one");
+        _isClosed = (desc.Type == D3D12_INDIRECT_ARGUMENT_TYPE_DRAW ||
+            desc.Type == D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED || desc.Type == D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH);
+
+        _argumentDescs.push_back(desc);
+        _offsets.push_back(_strideInBytes);
+        _sizesInBytes.push_back(sizeInBytes);
+        _strideInBytes += sizeInBytes;
+        return static_cast<uint32_t>(_argumentDescs.size() - 1);
+    }
+
+
+    uint32_t IndirectArgumentLayout::addVertexBufferView(uint32_t slot) {
+        D3D12_INDIRECT_ARGUMENT_DESC desc = {};
+        desc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_VERTEX_BUFFER_VIEW;
+        desc.VertexBuffer.Slot = slot;
+        return _add(desc, sizeof(D3D12_VERTEX_BUFFER_VIEW));
+    }
+
+
+    uint32_t IndirectArgumentLayout::addIndexBufferView() {
+        D3D12_INDIRECT_ARGUMENT_DESC desc = {};
+        desc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_INDEX_BUFFER_VIEW;
+        return _add(desc, sizeof(D3D12_INDEX_BUFFER_VIEW));
+    }
+
+
+    uint32_t IndirectArgumentLayout::addConstants(uint32_t rootParameterIndex, uint32_t count, uint32_t destOffset) {
+        D3D12_INDIRECT_ARGUMENT_DESC desc = {};
+        desc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+        desc.Constant.RootParameterIndex = rootParameterIndex;
+        desc.Constant.DestOffsetIn32BitValues = destOffset;
+        desc.Constant.Num32BitValuesToSet = count;
+        return _add(desc, count * sizeof(uint32_t));
+    }
+
+
+    uint32_t IndirectArgumentLayout::addConstantBufferView(uint32_t rootParameterIndex) {
+        D3D12_INDIRECT_ARGUMENT_DESC desc = {};
+        desc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT_BUFFER_VIEW;
+        desc.ConstantBufferView.RootParameterIndex = rootParameterIndex;
+        return _add(desc, sizeof(D3D12_GPU_VIRTUAL_ADDRESS));
+    }
+
+
+    uint32_t IndirectArgumentLayout::addShaderResourceView(uint32_t rootParameterIndex) {
+        D3D12_INDIRECT_ARGUMENT_DESC desc = {};
+        desc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_SHADER_RESOURCE_VIEW;
+        desc.ShaderResourceView.RootParameterIndex = rootParameterIndex;
+        return _add(desc, sizeof(D3D12_GPU_VIRTUAL_ADDRESS));
+    }
+
+
+    uint32_t IndirectArgumentLayout::addDraw() {
+        D3D12_INDIRECT_ARGUMENT_DESC desc = {};
+        desc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW;
+        return _add(desc, sizeof(D3D12_DRAW_ARGUMENTS));
+    }
+
+
+    uint32_t IndirectArgumentLayout::addDrawIndexed() {
+        D3D12_INDIRECT_ARGUMENT_DESC desc = {};
+        desc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+        return _add(desc, sizeof(D3D12_DRAW_INDEXED_ARGUMENTS));
+    }
+
+
+    uint32_t IndirectArgumentLayout::addDispatch() {
+        D3D12_INDIRECT_ARGUMENT_DESC desc = {};
+        desc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH;
+        return _add(desc, sizeof(D3D12_DISPATCH_ARGUMENTS));
+    }
+
+
+    bool IndirectArgumentLayout::changesRootArguments() const {
+        return std::any_of(_argumentDescs.begin(), _argumentDescs.end(), [](const D3D12_INDIRECT_ARGUMENT_DESC& desc) {
+            return desc.Type == D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT ||
+                desc.Type == D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT_BUFFER_VIEW ||
+                desc.Type == D3D12_INDIRECT_ARGUMENT_TYPE_SHADER_RESOURCE_VIEW ||
+                desc.Type == D3D12_INDIRECT_ARGUMENT_TYPE_UNORDERED_ACCESS_VIEW;
+        });
+    }
+
+
+    D3D12_COMMAND_SIGNATURE_DESC IndirectArgumentLayout::commandSignatureDesc(uint32_t nodeMask) const {
+        assert(_isClosed && "Layout has no draw or dispatch argument");
+        D3D12_COMMAND_SIGNATURE_DESC desc = {};
+        desc.ByteStride = _strideInBytes;
+        desc.NumArgumentDescs = static_cast<uint32_t>(_argumentDescs.size());
+        desc.pArgumentDescs = _argumentDescs.data();
+        desc.NodeMask = nodeMask;
+        return desc;
+    }
+
+
+    IndirectArgumentWriter::IndirectArgumentWriter(const IndirectArgumentLayout& layout, void* data,
+        size_t capacityInBytes) : _layout(layout), _data(static_cast<uint8_t*>(data)),
+        _capacityInBytes(capacityInBytes) {
+        assert(layout.strideInBytes() > 0);
+    }
+
+
+    bool IndirectArgumentWriter::beginCommand() {
+        size_t offset = static_cast<size_t>(_commandCount) * _layout.strideInBytes();
+        if (offset + _layout.strideInBytes() > _capacityInBytes) {
+            _command = nullptr;
+            return false;
+        }
+
+        _command = _data + offset;
+        ++_commandCount;
+        return true;
+    }
+
+
+    ///
+    /// CommandStream Implementation
+    ///
+    void CommandStream::reset() {
+        for (Page& page : _pages) {
+            page.usedSizeInBytes = 0;
+        }
+        _pageIndex = 0;
+        _commandCount = 0;
+        _sizeInBytes = 0;
+    }
+
+
+    size_t CommandStream::capacityInBytes() const {
+        size_t capacityInBytes = 0;
+        for (const Page& page : _pages) {
+            capacityInBytes += page.capacityInBytes;
+        }
+        return capacityInBytes;
+    }
+
+
+    uint8_t* CommandStream::_allocate(uint32_t sizeInBytes) {
+        // Pages only move forward until reset(), a page skipped because too small stays empty this frame
+        while (_pageIndex < _pages.size() &&
+            _pages[_pageIndex].usedSizeInBytes + sizeInBytes > _pages[_pageIndex].capacityInBytes) {
+            ++_pageIndex;
+        }
+        if (_pageIndex == _pages.size()) {
+            uint32_t capacityInBytes = std::max(kPageSizeInBytes, sizeInBytes);
+            _pages.push_back({ std::unique_ptr<uint8_t[]>(new uint8_t[capacityInBytes]), capacityInBytes, 0 });
+        }
+
+        Page& page = _pages[_pageIndex];
+        uint8_t* data = page.data.get() + page.usedSizeInBytes;
+        page.usedSizeInBytes += sizeInBytes;
+        _sizeInBytes += sizeInBytes;
+        return data;
+    }
+
+
+    void* CommandStream::_push(Opcode opcode, uint32_t argumentsSizeInBytes, const void* data,
+        uint32_t dataSizeInBytes) {
+        uint32_t sizeInBytes = (sizeof(CommandHeader) + argumentsSizeInBytes + dataSizeInBytes + kAlignmentMask) &
+            ~kAlignmentMask;
+
+        CommandHeader* header = reinterpret_cast<CommandHeader*>(_allocate(sizeInBytes));
+        header->opcode = opcode;
+        header->reserved = 0;
+        header->sizeInBytes = sizeInBytes;
+        if (dataSizeInBytes > 0) {
+            memcpy(reinterpret_cast<uint8_t*>(header + 1) + argumentsSizeInBytes, data, dataSizeInBytes);
+        }
+
+        ++_commandCount;
+        return header + 1;
+    }
+
+
+    void CommandStream::serialize(std::vector<uint8_t>& outData) const {
+        outData.reserve(outData.size() + _sizeInBytes);
+        for (const Page& page : _pages) {
+            outData.insert(outData.end(), page.data.get(), page.data.get() + page.usedSizeInBytes);
+        }
+    }
+
+
+    bool CommandStream::deserialize(const void* data, size_t sizeInBytes) {
+        reset();
+        if (sizeInBytes > UINT32_MAX || (sizeInBytes & kAlignmentMask) != 0) {
+            return false;
+        }
+
+        // Walk the commands first, replay trusts opcodes, counts and command sizes
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        uint32_t commandCount = 0;
+        for (size_t offset = 0; offset < sizeInBytes; ++commandCount) {
+            const CommandHeader* header = reinterpret_cast<const CommandHeader*>(bytes + offset);
+            if (sizeInBytes - offset < sizeof(CommandHeader) || header->opcode >= Opcode::Count) {
+                return false;
+            }
+            bool isExecuteIndirect = (header->opcode == Opcode::ExecuteIndirect);
+            uint64_t argumentsSizeInBytes = isExecuteIndirect ? sizeof(ExecuteIndirectArguments) :
+                sizeof(CommandArguments);
+            if (header->sizeInBytes < sizeof(CommandHeader) + argumentsSizeInBytes ||
+                header->sizeInBytes > sizeInBytes - offset) {
+                return false;
+            }
+
+            // Exactly what the recording call pushed
+            uint64_t dataSizeInBytes = isExecuteIndirect ? 0 :
+                _dataSizeInBytes(header->opcode, *reinterpret_cast<const CommandArguments*>(header + 1));
+            if (dataSizeInBytes == UINT64_MAX || header->sizeInBytes !=
+                ((sizeof(CommandHeader) + argumentsSizeInBytes + dataSizeInBytes + kAlignmentMask) & ~kAlignmentMask)) {
+                return false;
+            }
+            offset += header->sizeInBytes;
+        }
+
+        if (sizeInBytes > 0) {
+            memcpy(_allocate(static_cast<uint32_t>(sizeInBytes)), data, sizeInBytes);
+        }
+        _commandCount = commandCount;
+        return true;
+    }
+
+
+    uint64_t CommandStream::_dataSizeInBytes(Opcode opcode, const CommandArguments& args) {
+        auto countedSize = [&args](uint32_t maxCount, size_t elementSizeInBytes) {
+            return (args.count <= maxCount) ? args.count * elementSizeInBytes : UINT64_MAX;
+        };
+        bool isRootIndexValid = (args.index < CommandList::kMaxRootParameters);
+
+        switch (opcode) {
+        case Opcode::SetViewports:
+            return countedSize(CommandList::kMaxViewports, sizeof(D3D12_VIEWPORT));
+        case Opcode::SetScissorRects:
+            return countedSize(CommandList::kMaxViewports, sizeof(D3D12_RECT));
+        case Opcode::SetRenderTargets:
+            return countedSize(D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT, sizeof(D3D12_CPU_DESCRIPTOR_HANDLE));
+        case Opcode::SetDescriptorHeaps:
+            return countedSize(2, sizeof(ID3D12DescriptorHeap*));
+        case Opcode::SetIndexBuffer:
+            return sizeof(D3D12_INDEX_BUFFER_VIEW);
+        case Opcode::SetVertexBuffers:
+            return (args.index <= D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT) ?
+                countedSize(D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT - args.index, sizeof(D3D12_VERTEX_BUFFER_VIEW)) :
+                UINT64_MAX;
+        case Opcode::SetGraphicsRootConstantBufferView:
+        case Opcode::SetGraphicsRootShaderResourceView:
+        case Opcode::SetGraphicsRootDescriptorTable:
+        case Opcode::SetComputeRootDescriptorTable:
+            return isRootIndexValid ? 0 : UINT64_MAX;
+        case Opcode::SetGraphicsRoot32BitConstants:
+        case Opcode::SetComputeRoot32BitConstants:
+            // The offset is stored in value
+            return (isRootIndexValid && args.value <= CommandList::kMaxRootSignatureDwords &&
+                args.count <= CommandList::kMaxRootSignatureDwords - args.value) ?
+                args.count * sizeof(uint32_t) : UINT64_MAX;
+        case Opcode::ClearRenderTargetView:
+            return 4 * sizeof(float);
+        case Opcode::ClearDepthStencilView:
+            return sizeof(float);
+        case Opcode::ResourceBarrier:
+            return countedSize(UINT32_MAX, sizeof(D3D12_RESOURCE_BARRIER));
+        case Opcode::DrawInstanced:
+            return 4 * sizeof(uint32_t);
+        case Opcode::DrawIndexedInstanced:
+            return 5 * sizeof(uint32_t);
+        case Opcode::Dispatch:
+            return 3 * sizeof(uint32_t);
+        default:
+            return 0;
+        }
+    }
+
+
+    void CommandStream::_pushArguments(Opcode opcode, uint64_t value, uint32_t index, uint32_t count,
+        const void* data, uint32_t dataSizeInBytes) {
+        CommandArguments* args = static_cast<CommandArguments*>(_push(opcode, sizeof(CommandArguments), data,
+            dataSizeInBytes));
+        args->value = value;
+        args->index = index;
+        args->count = count;
+    }
+
+
+    void CommandStream::setPipelineState(ID3D12PipelineState* pipelineState) {
+        _pushArguments(Opcode::SetPipelineState, reinterpret_cast<uint64_t>(pipelineState));
+    }
+
+
+    void CommandStream::setGraphicsRootSignature(ID3D12RootSignature* rootSignature) {
+        _pushArguments(Opcode::SetGraphicsRootSignature, reinterpret_cast<uint64_t>(rootSignature));
+    }
+
+
+    void CommandStream::setComputeRootSignature(ID3D12RootSignature* rootSignature) {
+        _pushArguments(Opcode::SetComputeRootSignature, reinterpret_cast<uint64_t>(rootSignature));
+    }
+
+
+    void CommandStream::setPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY topology) {
+        _pushArguments(Opcode::SetPrimitiveTopology, static_cast<uint64_t>(topology));
+    }
+
+
+    void CommandStream::setViewports(uint32_t count, const D3D12_VIEWPORT* viewports) {
+        _pushArguments(Opcode::SetViewports, 0, 0, count, viewports, count * sizeof(*viewports));
+    }
+
+
+    void CommandStream::setScissorRects(uint32_t count, const D3D12_RECT* rects) {
+        _pushArguments(Opcode::SetScissorRects, 0, 0, count, rects, count * sizeof(*rects));
+    }
+
+
+    void CommandStream::setRenderTargets(uint32_t count, const D3D12_CPU_DESCRIPTOR_HANDLE* rtvHandles,
+        const D3D12_CPU_DESCRIPTOR_HANDLE* dsvHandle) {
+        _pushArguments(Opcode::SetRenderTargets, dsvHandle ? dsvHandle->ptr : 0, 0, count, rtvHandles,
+            count * sizeof(*rtvHandles));
+    }
+
+
+    void CommandStream::setDescriptorHeaps(uint32_t count, ID3D12DescriptorHeap* const* heaps) {
+        _pushArguments(Opcode::SetDescriptorHeaps, 0, 0, count, heaps, count * sizeof(*heaps));
+    }
+
+
+    void CommandStream::setIndexBuffer(const D3D12_INDEX_BUFFER_VIEW& view) {
+        _pushArguments(Opcode::SetIndexBuffer, 0, 0, 1, &view, sizeof(view));
+    }
+
+
+    void CommandStream::setVertexBuffers(uint32_t startSlot, uint32_t count, const D3D12_VERTEX_BUFFER_VIEW* views) {
+        _pushArguments(Opcode::SetVertexBuffers, 0, startSlot, count, views, count * sizeof(*views));
+    }
+
+
+    void CommandStream::setGraphicsRootConstantBufferView(uint32_t index, D3D12_GPU_VIRTUAL_ADDRESS address) {
+        _pushArguments(Opcode::SetGraphicsRootConstantBufferView, address, index);
+    }
+
+
+    void CommandStream::setGraphicsRootShaderResourceView(uint32_t index, D3D12_GPU_VIRTUAL_ADDRESS address) {
+        _pushArguments(Opcode::SetGraphicsRootShaderResourceView, address, index);
+    }
+
+
+    void CommandStream::setGraphicsRootDescriptorTable(uint32_t index, D3D12_GPU_DESCRIPTOR_HANDLE handle) {
+        _pushArguments(Opcode::SetGraphicsRootDescriptorTable, handle.ptr, index);
+    }
+
+
+    void CommandStream::setGraphicsRoot32BitConstants(uint32_t index, uint32_t count, const void* data,
+        uint32_t offset) {
+        _pushArguments(Opcode::SetGraphicsRoot32BitConstants, offset, index, count, data, count * sizeof(uint32_t));
+    }
+
+
+    void CommandStream::setComputeRootDescriptorTable(uint32_t index, D3D12_GPU_DESCRIPTOR_HANDLE handle) {
+        _pushArguments(Opcode::SetComputeRootDescriptorTable, handle.ptr, index);
+    }
+
+
+    void CommandStream::setComputeRoot32BitConstants(uint32_t index, uint32_t count, const void* data,
+        uint32_t offset) {
+        _pushArguments(Opcode::SetComputeRoot32BitConstants, offset, index, count, data, count * sizeof(uint32_t));
+    }
+
+
+    void CommandStream::clearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE handle, const float color[4]) {
+        _pushArguments(Opcode::ClearRenderTargetView, handle.ptr, 0, 0, color, 4 * sizeof(float));
+    }
+
+
+    void CommandStream::clearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE handle, D3D12_CLEAR_FLAGS flags,
+        float depth, uint8_t stencil) {
+        _pushArguments(Opcode::ClearDepthStencilView, handle.ptr, static_cast<uint32_t>(flags), stencil, &depth,
+            sizeof(depth));
+    }
+
+
+    void CommandStream::resourceBarrier(uint32_t count, const D3D12_RESOURCE_BARRIER* barriers) {
+        _pushArguments(Opcode::ResourceBarrier, 0, 0, count, barriers, count * sizeof(*barriers));
+    }
+
+
+    void CommandStream::drawInstanced(uint32_t vertexCount, uint32_t instanceCount, uint32_t startVertex,
+        uint32_t startInstance) {
+        uint32_t values[] = { vertexCount, instanceCount, startVertex, startInstance };
+        _pushArguments(Opcode::DrawInstanced, 0, 0, 0, values, sizeof(values));
+    }
+
+
+    void CommandStream::drawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex,
+        int32_t baseVertex, uint32_t startInstance) {
+        uint32_t values[] = { indexCount, instanceCount, startIndex, static_cast<uint32_t>(baseVertex), startInstance };
+        _pushArguments(Opcode::DrawIndexedInstanced, 0, 0, 0, values, sizeof(values));
+    }
+
+
+    void CommandStream::dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) {
+        uint32_t values[] = { groupCountX, groupCountY, groupCountZ };
+        _pushArguments(Opcode::Dispatch, 0, 0, 0, values, sizeof(values));
+    }
+
+
+    void CommandStream::executeIndirect(ID3D12CommandSignature* commandSignature, uint32_t maxCommandCount,
+        ID3D12Resource* argumentBuffer, uint64_t argumentBufferOffset, ID3D12Resource* countBuffer,
+        uint64_t countBufferOffset) {
+        ExecuteIndirectArguments* args = static_cast<ExecuteIndirectArguments*>(_push(Opcode::ExecuteIndirect,
+            sizeof(ExecuteIndirectArguments)));
+        args->commandSignature = commandSignature;
+        args->argumentBuffer = argumentBuffer;
+        args->argumentBufferOffset = argumentBufferOffset;
+        args->countBuffer = countBuffer;
+        args->countBufferOffset = countBufferOffset;
+        args->maxCommandCount = maxCommandCount;
+    }
+
+
+    ///
+    /// FrameCapture Implementation
+    ///
+    std::string ReplayStatistics::toJson() const {
+        char json[512];
+        snprintf(json, sizeof(json), "{\"iterations\": %u, \"streams\": %u, \"commands\": %llu, \"draws\": %llu, "
+            "\"min_ms\": %.6f, \"median_ms\": %.6f, \"mean_ms\": %.6f, \"p95_ms\": %.6f, \"max_ms\": %.6f, "
+            "\"stddev_ms\": %.6f}", iterationCount, streamCount, static_cast<unsigned long long>(commandCount),
+            static_cast<unsigned long long>(drawCount), minMs, medianMs, meanMs, p95Ms, maxMs, stddevMs);
+        return json;
+    }
+
+
+    void FrameCapture::reset() {
+        _streams.clear();
+        _buffers.clear();
+    }
+
+
+    CommandStream& FrameCapture::addStream() {
+        _streams.emplace_back();
+        return _streams.back();
+    }
+
+
+    void FrameCapture::addBuffer(D3D12_GPU_VIRTUAL_ADDRESS gpuAddress, const void* data, size_t sizeInBytes) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        _buffers.push_back({ gpuAddress, std::vector<uint8_t>(bytes, bytes + sizeInBytes) });
+    }
+
+
+    HRESULT FrameCapture::save(const std::filesystem::path& filePath) const {
+        std::ofstream file(filePath, std::ios::binary);
+        if (!file) {
+            return E_FAIL;
+        }
+
+        // Header, then each stream and each buffer prefixed by its size
+        uint32_t header[] = { kMagic, kVersion, static_cast<uint32_t>(_streams.size()),
+            static_cast<uint32_t>(_buffers.size()) };
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+        std::vector<uint8_t> streamData;
+        for (const CommandStream& stream : _streams) {
+            streamData.clear();
+            stream.serialize(streamData);
+            uint64_t sizeInBytes = streamData.size();
+            file.write(reinterpret_cast<const char*>(&sizeInBytes), sizeof(sizeInBytes));
+            file.write(reinterpret_cast<const char*>(streamData.data()), streamData.size());
+        }
+        for (const Buffer& buffer : _buffers) {
+            uint64_t bufferHeader[] = { buffer.gpuAddress, buffer.data.size() };
+            file.write(reinterpret_cast<const char*>(bufferHeader), sizeof(bufferHeader));
+            file.write(reinterpret_cast<const char*>(buffer.data.data()), buffer.data.size());
+        }
+        return file ? S_OK : E_FAIL;
+    }
+
+
+    HRESULT FrameCapture::load(const std::filesystem::path& filePath) {
+        reset();
+        std::ifstream file(filePath, std::ios::binary);
+        uint32_t header[4] = {};
+        if (!file.read(reinterpret_cast<char*>(header), sizeof(header))) {
+            return E_FAIL;
+        }
+        if (header[0] != kMagic || header[1] != kVersion) {
+            return E_INVALIDARG;
+        }
+
+        std::vector<uint8_t> streamData;
+        for (uint32_t i = 0; i < header[2]; ++i) {
+            uint64_t sizeInBytes = 0;
+            file.read(reinterpret_cast<char*>(&sizeInBytes), sizeof(sizeInBytes));
+            if (!file || sizeInBytes > UINT32_MAX) {
+                reset();
+                return E_FAIL;
+            }
+            streamData.resize(static_cast<size_t>(sizeInBytes));
+            file.read(reinterpret_cast<char*>(streamData.data()), streamData.size());
+            if (!file || !addStream().deserialize(streamData.data(), streamData.size())) {
+                reset();
+                return E_FAIL;
+            }
+        }
+        for (uint32_t i = 0; i < header[3]; ++i) {
+            uint64_t bufferHeader[2] = {};
+            file.read(reinterpret_cast<char*>(bufferHeader), sizeof(bufferHeader));
+            if (!file || bufferHeader[1] > UINT32_MAX) {
+                reset();
+                return E_FAIL;
+            }
+            Buffer buffer = { bufferHeader[0], std::vector<uint8_t>(static_cast<size_t>(bufferHeader[1])) };
+            file.read(reinterpret_cast<char*>(buffer.data.data()), buffer.data.size());
+            if (!file) {
+                reset();
+                return E_FAIL;
+            }
+            _buffers.push_back(std::move(buffer));
+        }
+        return S_OK;
+    }
+
+
+    ReplayStatistics FrameCapture::benchmark(uint32_t iterationCount, uint32_t warmupCount) const {
+        ReplayStatistics statistics;
+        statistics.iterationCount = iterationCount;
+        statistics.streamCount = static_cast<uint32_t>(_streams.size());
+        for (const CommandStream& stream : _streams) {
+            statistics.commandCount += stream.commandCount();
+        }
+        if (iterationCount == 0) {
+            return statistics;
+        }
+
+        // Warm caches and branch predictors first, the draw count comes from the last replay
+        std::vector<double> timesMs(iterationCount);
+        for (uint32_t i = 0; i < warmupCount + iterationCount; ++i) {
+            NullCommandList nullCommandList;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            replay(nullCommandList);
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+            if (i >= warmupCount) {
+                timesMs[i - warmupCount] = std::chrono::duration<double, std::milli>(end - start).count();
+            }
+            statistics.drawCount = nullCommandList.drawCount();
+        }
+
+        std::sort(timesMs.begin(), timesMs.end());
+        double sumMs = 0.0;
+        for (double timeMs : timesMs) {
+            sumMs += timeMs;
+        }
+        statistics.minMs = timesMs.front();
+        statistics.maxMs = timesMs.back();
+        statistics.medianMs = (iterationCount % 2) ? timesMs[iterationCount / 2] :
+            0.5 * (timesMs[iterationCount / 2 - 1] + timesMs[iterationCount / 2]);
+        statistics.p95Ms = timesMs[std::min<size_t>(iterationCount - 1, (iterationCount * 95) / 100)];
+        statistics.meanMs = sumMs / iterationCount;
+
+        double varianceSum = 0.0;
+        for (double timeMs : timesMs) {
+            varianceSum += (timeMs - statistics.meanMs) * (timeMs - statistics.meanMs);
+        }
+        statistics.stddevMs = sqrt(varianceSum / iterationCount);
+        return statistics;
+    }
+
+
+    ///
+    /// PipelineStateCache Implementation
+    ///
+    void _pipelineLibraryName(uint64_t hash, wchar_t outName[17]) {
+        for (int32_t i = 15; i >= 0; --i, hash >>= 4) {
+            outName[i] = L"0123456789abcdef"[hash & 0xf];
+        }
+        outName[16] = L'\0';
+    }
+
+
+    PipelineStateCache::PipelineStateCache(ID3D12DevicePtr device) : _device(device) {
+    }
+
+
+    void PipelineStateCache::registerRootSignature(ID3D12RootSignature* rootSignature, uint64_t blobHash) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _rootSignatureHashes[rootSignature] = blobHash;
+    }
+
+
+    uint64_t PipelineStateCache::hash(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) const {
+        // Unregistered root signatures fall back to their address, valid for this run only
+        uint64_t rootSignatureHash = reinterpret_cast<uint64_t>(desc.pRootSignature);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto it = _rootSignatureHashes.find(desc.pRootSignature);
+            if (it != _rootSignatureHashes.end()) {
+                rootSignatureHash = it->second;
+            }
+        }
+        return fastdxu::hashGraphicsPipelineDesc(fastdxu::canonicalGraphicsPipelineDesc(desc), rootSignatureHash);
+    }
+
+
+    ID3D12PipelineStatePtr PipelineStateCache::find(uint64_t hash) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _pipelineStates.find(hash);
+        return (it != _pipelineStates.end()) ? it->second : nullptr;
+    }
+
+
+    void PipelineStateCache::insert(uint64_t hash, ID3D12PipelineStatePtr pipelineState) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _pipelineStates.emplace(hash, pipelineState);
+    }
+
+
+    size_t PipelineStateCache::size() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _pipelineStates.size();
+    }
+
+
+    ID3D12PipelineStatePtr PipelineStateCache::graphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc,
+        HRESULT* outResult) {
+        // The library compares every field of the stored desc, ignored ones included
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC canonicalDesc = fastdxu::canonicalGraphicsPipelineDesc(desc);
+        uint64_t pipelineHash = hash(canonicalDesc);
+        if (ID3D12PipelineStatePtr pipelineState = find(pipelineHash)) {
+            ++_hitCount;
+            _checkFailedAndAssign(S_OK, outResult);
+            return pipelineState;
+        }
+
+        wchar_t name[17];
+        _pipelineLibraryName(pipelineHash, name);
+        // Keeps the library and its data alive if load() replaces it meanwhile
+        ID3D12PipelineLibraryPtr library;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            library = _library;
+        }
+
+        // Missing names fail with E_INVALIDARG, so does a stored desc that differs: only a hash collision, which
+        // compiles every run since StorePipeline fails on the existing name
+        ID3D12PipelineState* pipelineState = nullptr;
+        if (library && SUCCEEDED(library->LoadGraphicsPipeline(name, &canonicalDesc, IID_PPV_ARGS(&pipelineState)))) {
+            ++_libraryHitCount;
+        } else {
+            HRESULT hr = _device->CreateGraphicsPipelineState(&canonicalDesc, IID_PPV_ARGS(&pipelineState));
+            CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
+            ++_compileCount;
+
+            if (library && SUCCEEDED(library->StorePipeline(name, pipelineState))) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _isLibraryDirty = true;
+            }
+        }
+
+        // Another thread may have created the same pipeline meanwhile, keep the first one
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _pipelineStates.emplace(pipelineHash, ID3D12PipelineStatePtr(pipelineState, PtrDeleter())).first;
+        _checkFailedAndAssign(S_OK, outResult);
+        return it->second;
+    }
+
+
+    HRESULT PipelineStateCache::load(const std::filesystem::path& filePath) {
+        // The library references the data until released, they share one owner
+        std::shared_ptr<std::vector<uint8_t>> libraryData = std::make_shared<std::vector<uint8_t>>();
+        std::ifstream file(filePath, std::ios::binary);
+        if (file) {
+            file.seekg(0, std::ios::end);
+            libraryData->resize(static_cast<size_t>(file.tellg()));
+            file.seekg(0, std::ios::beg);
+            file.read(reinterpret_cast<char*>(libraryData->data()), libraryData->size());
+            if (!file) {
+                libraryData->clear();
+            }
+        }
+
+        ID3D12PipelineLibrary* library = nullptr;
+        HRESULT hr = E_FAIL;
+        if (!libraryData->empty()) {
+            hr = _device->CreatePipelineLibrary(libraryData->data(), libraryData->size(), IID_PPV_ARGS(&library));
+        }
+        if (FAILED(hr)) {
+            // Stale driver, adapter or corrupt file, start over. Unsupported drivers fail here too
+            libraryData->clear();
+            hr = _device->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&library));
+            if (FAILED(hr)) {
+                return hr;
+            }
+        }
+
+        // Threads still loading from the previous library keep it and its data alive
+        ID3D12PipelineLibraryPtr libraryPtr(library, [libraryData](ID3D12PipelineLibrary* ptr) { SAFE_RELEASE(ptr); });
+        std::lock_guard<std::mutex> lock(_mutex);
+        _library = libraryPtr;
+        _isLibraryDirty = false;
+        return S_OK;
+    }
+
+
+    HRESULT PipelineStateCache::save(const std::filesystem::path& filePath) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_library || !_isLibraryDirty) {
+            return S_FALSE;
+        }
+
+        std::vector<uint8_t> libraryData(_library->GetSerializedSize());
+        HRESULT hr = _library->Serialize(libraryData.data(), libraryData.size());
+        if (FAILED(hr)) {
+            return hr;
+        }
+
+        std::ofstream file(filePath, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(libraryData.data()), libraryData.size());
+        if (!file) {
+            return E_FAIL;
+        }
+        _isLibraryDirty = false;
+        return S_OK;
+    }
 
-            DXGI_ADAPTER_DESC1 desc;
-            hardwareAdapter->GetDesc1(&desc);
-            if (desc.Flags & DXGI_ADAPTER_FLAG_SOFTWARE) {
+
+    ///
+    /// AsyncPipelineCompiler Implementation
+    ///
+    AsyncPipelineCompiler::AsyncPipelineCompiler(CompileFunction compileFunction, uint32_t threadCount) :
+        _compileFunction(compileFunction) {
+        for (uint32_t i = 0; i < std::max(threadCount, 1u); ++i) {
+            _workers.emplace_back(&AsyncPipelineCompiler::_workerMain, this);
+        }
+    }
+
+
+    AsyncPipelineCompiler::~AsyncPipelineCompiler() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _isStopping = true;
+            _pendingCount -= static_cast<uint32_t>(_requests.size());
+            _requests.clear();
+        }
+        _requestAvailable.notify_all();
+        for (std::thread& worker : _workers) {
+            worker.join();
+        }
+    }
+
+
+    AsyncPipelineStatePtr AsyncPipelineCompiler::compile(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc,
+        ID3D12PipelineStatePtr fallback) {
+        std::unique_ptr<Request> request(new Request());
+        request->desc = desc;
+        request->desc.CachedPSO = {};
+        request->target = std::make_shared<AsyncPipelineState>(fallback);
+        if (desc.pRootSignature != nullptr) {
+            // The caller may release its root signature before a worker gets to the request
+            desc.pRootSignature->AddRef();
+            request->rootSignature = ID3D12RootSignaturePtr(desc.pRootSignature, PtrDeleter());
+        }
+
+        D3D12_SHADER_BYTECODE* shaders[] = { &request->desc.VS, &request->desc.PS, &request->desc.DS,
+            &request->desc.HS, &request->desc.GS };
+        for (uint32_t i = 0; i < _countof(shaders); ++i) {
+            const uint8_t* bytecode = static_cast<const uint8_t*>(shaders[i]->pShaderBytecode);
+            if (bytecode != nullptr) {
+                request->shaderData[i].assign(bytecode, bytecode + shaders[i]->BytecodeLength);
+                shaders[i]->pShaderBytecode = request->shaderData[i].data();
+            }
+        }
+
+        D3D12_INPUT_LAYOUT_DESC& inputLayout = request->desc.InputLayout;
+        request->inputElements.assign(inputLayout.pInputElementDescs,
+            inputLayout.pInputElementDescs + inputLayout.NumElements);
+        for (D3D12_INPUT_ELEMENT_DESC& element : request->inputElements) {
+            element.SemanticName = request->semanticNames.emplace(request->semanticNames.end(),
+                element.SemanticName)->c_str();
+        }
+        inputLayout.pInputElementDescs = request->inputElements.data();
+
+        D3D12_STREAM_OUTPUT_DESC& streamOutput = request->desc.StreamOutput;
+        request->streamOutputEntries.assign(streamOutput.pSODeclaration,
+            streamOutput.pSODeclaration + streamOutput.NumEntries);
+        for (D3D12_SO_DECLARATION_ENTRY& entry : request->streamOutputEntries) {
+            if (entry.SemanticName != nullptr) {
+                entry.SemanticName = request->semanticNames.emplace(request->semanticNames.end(),
+                    entry.SemanticName)->c_str();
+            }
+        }
+        request->streamOutputStrides.assign(streamOutput.pBufferStrides,
+            streamOutput.pBufferStrides + streamOutput.NumStrides);
+        streamOutput.pSODeclaration = request->streamOutputEntries.data();
+        streamOutput.pBufferStrides = request->streamOutputStrides.data();
+
+        AsyncPipelineStatePtr target = request->target;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _requests.push_back(std::move(request));
+            ++_pendingCount;
+        }
+        _requestAvailable.notify_one();
+        return target;
+    }
+
+
+    void AsyncPipelineCompiler::waitIdle() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _idle.wait(lock, [this]() { return _pendingCount.load() == 0; });
+    }
+
+
+    void AsyncPipelineCompiler::_workerMain() {
+        for (;;) {
+            std::unique_ptr<Request> request;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _requestAvailable.wait(lock, [this]() { return _isStopping || !_requests.empty(); });
+                if (_isStopping) {
+                    return;
+                }
+                request = std::move(_requests.front());
+                _requests.pop_front();
+            }
+
+            FASTDX_PROFILE_SCOPE("AsyncPipelineCompiler::compile");
+            HRESULT hr = S_OK;
+            ID3D12PipelineStatePtr pipelineState = _compileFunction(request->desc, &hr);
+            AsyncPipelineState& target = *request->target;
+            target._result = (SUCCEEDED(hr) && pipelineState == nullptr) ? E_FAIL : hr;
+            target._pipelineState = pipelineState;
+            if (pipelineState != nullptr) {
+                target._published.store(pipelineState.get(), std::memory_order_release);
+                ++_compiledCount;
+            } else {
+                ++_failedCount;
+            }
+            target._isDone.store(true, std::memory_order_release);
+            // Root signature and shader copies are released before waitIdle() returns
+            request.reset();
+
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                --_pendingCount;
+            }
+            _idle.notify_all();
+        }
+    }
+
+
+    ///
+    /// ShaderLibrary Implementation
+    ///
+    ShaderLibrary::~ShaderLibrary() {
+        close();
+    }
+
+
+    HRESULT ShaderLibrary::open(const std::filesystem::path& filePath) {
+        close();
+        HANDLE file = CreateFileW(filePath.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return HRESULT_FROM_WIN32(GetLastError());
+        }
+
+        LARGE_INTEGER fileSize = {};
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < static_cast<int64_t>(sizeof(Header))) {
+            CloseHandle(file);
+            return E_FAIL;
+        }
+
+        // The view keeps the mapping alive, both handles can be closed right away
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (mapping == nullptr) {
+            return HRESULT_FROM_WIN32(GetLastError());
+        }
+        _view = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        CloseHandle(mapping);
+        if (_view == nullptr) {
+            return HRESULT_FROM_WIN32(GetLastError());
+        }
+        _sizeInBytes = static_cast<uint64_t>(fileSize.QuadPart);
+
+        if (!_validate()) {
+            close();
+            return E_INVALIDARG;
+        }
+        return S_OK;
+    }
+
+
+    void ShaderLibrary::close() {
+        if (_view != nullptr) {
+            UnmapViewOfFile(_view);
+        }
+        _view = nullptr;
+        _sizeInBytes = 0;
+        _header = nullptr;
+        _entries = nullptr;
+        _blobs = nullptr;
+    }
+
+
+    bool ShaderLibrary::_validate() const {
+        const Header* header = reinterpret_cast<const Header*>(_view);
+        if (header->magic != kMagic || header->version != kVersion) {
+            return false;
+        }
+
+        uint64_t tablesEnd = sizeof(Header) + uint64_t(header->entryCount) * sizeof(Entry) +
+            uint64_t(header->blobCount) * sizeof(Blob);
+        if (tablesEnd > _sizeInBytes) {
+            return false;
+        }
+
+        const Entry* entries = reinterpret_cast<const Entry*>(_view + sizeof(Header));
+        const Blob* blobs = reinterpret_cast<const Blob*>(entries + header->entryCount);
+        for (uint32_t i = 0; i < header->entryCount; ++i) {
+            const Entry& entry = entries[i];
+            if (entry.blobIndex >= header->blobCount || entry.nameOffset < tablesEnd ||
+                uint64_t(entry.nameOffset) + entry.nameLength > _sizeInBytes ||
+                (i > 0 && entries[i - 1].nameHash > entry.nameHash)) {
+                return false;
+            }
+        }
+        for (uint32_t i = 0; i < header->blobCount; ++i) {
+            const Blob& blob = blobs[i];
+            if (blob.dataOffset < tablesEnd || blob.sizeInBytes > _sizeInBytes - tablesEnd ||
+                blob.dataOffset > _sizeInBytes - blob.sizeInBytes ||
+                (i > 0 && blobs[i - 1].contentHash >= blob.contentHash)) {
+                return false;
+            }
+        }
+
+        ShaderLibrary* self = const_cast<ShaderLibrary*>(this);
+        self->_header = header;
+        self->_entries = entries;
+        self->_blobs = blobs;
+        return true;
+    }
+
+
+    D3D12_SHADER_BYTECODE ShaderLibrary::shader(const std::string& name) const {
+        if (_header == nullptr) {
+            return {};
+        }
+
+        // Names sharing a hash are adjacent, compare the strings to tell them apart
+        uint64_t nameHash = fastdxu::hashBytes(name.data(), name.size());
+        const Entry* entriesEnd = _entries + _header->entryCount;
+        const Entry* entry = std::lower_bound(_entries, entriesEnd, nameHash,
+            [](const Entry& entry, uint64_t hash) { return entry.nameHash < hash; });
+        for (; entry != entriesEnd && entry->nameHash == nameHash; ++entry) {
+            if (entry->nameLength == name.size() && memcmp(_view + entry->nameOffset, name.data(), name.size()) == 0) {
+                const Blob& blob = _blobs[entry->blobIndex];
+                return { _view + blob.dataOffset, static_cast<SIZE_T>(blob.sizeInBytes) };
+            }
+        }
+        return {};
+    }
+
+
+    D3D12_SHADER_BYTECODE ShaderLibrary::shaderByHash(uint64_t contentHash) const {
+        if (_header == nullptr) {
+            return {};
+        }
+
+        const Blob* blobsEnd = _blobs + _header->blobCount;
+        const Blob* blob = std::lower_bound(_blobs, blobsEnd, contentHash,
+            [](const Blob& blob, uint64_t hash) { return blob.contentHash < hash; });
+        if (blob == blobsEnd || blob->contentHash != contentHash) {
+            return {};
+        }
+        return { _view + blob->dataOffset, static_cast<SIZE_T>(blob->sizeInBytes) };
+    }
+
+
+    void ShaderLibraryWriter::add(const std::string& name, const void* data, size_t sizeInBytes) {
+        uint64_t contentHash = fastdxu::hashBytes(data, sizeInBytes);
+        _names[name] = contentHash;
+        if (_blobs.find(contentHash) == _blobs.end()) {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            _blobs.emplace(contentHash, std::vector<uint8_t>(bytes, bytes + sizeInBytes));
+        }
+    }
+
+
+    HRESULT ShaderLibraryWriter::addFile(const std::string& name, const std::filesystem::path& filePath) {
+        std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+        if (!file) {
+            return E_FAIL;
+        }
+
+        std::vector<uint8_t> data(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        if (!file.read(reinterpret_cast<char*>(data.data()), data.size())) {
+            return E_FAIL;
+        }
+        add(name, data.data(), data.size());
+        return S_OK;
+    }
+
+
+    HRESULT ShaderLibraryWriter::save(const std::filesystem::path& filePath) const {
+        typedef ShaderLibrary::Entry Entry;
+        typedef ShaderLibrary::Blob Blob;
+
+        // Blobs used by a name only, ones left behind by re-added names are dropped
+        std::vector<uint64_t> contentHashes;
+        for (const auto& name : _names) {
+            contentHashes.push_back(name.second);
+        }
+        std::sort(contentHashes.begin(), contentHashes.end());
+        contentHashes.erase(std::unique(contentHashes.begin(), contentHashes.end()), contentHashes.end());
+
+        uint64_t offset = sizeof(ShaderLibrary::Header) + _names.size() * sizeof(Entry) +
+            contentHashes.size() * sizeof(Blob);
+
+        std::vector<Entry> entries;
+        std::string names;
+        for (const auto& name : _names) {
+            uint32_t blobIndex = static_cast<uint32_t>(std::lower_bound(contentHashes.begin(), contentHashes.end(),
+                name.second) - contentHashes.begin());
+            entries.push_back({ fastdxu::hashBytes(name.first.data(), name.first.size()),
+                static_cast<uint32_t>(offset + names.size()), static_cast<uint32_t>(name.first.size()), blobIndex, 0 });
+            names += name.first;
+        }
+        std::stable_sort(entries.begin(), entries.end(),
+            [](const Entry& a, const Entry& b) { return a.nameHash < b.nameHash; });
+        offset += names.size();
+        if (offset > UINT32_MAX) {
+            return E_INVALIDARG;
+        }
+
+        uint64_t namesEnd = offset;
+        std::vector<Blob> blobs;
+        for (uint64_t contentHash : contentHashes) {
+            offset = (offset + ShaderLibrary::kBlobAlignment - 1) & ~uint64_t(ShaderLibrary::kBlobAlignment - 1);
+            uint64_t sizeInBytes = _blobs.at(contentHash).size();
+            blobs.push_back({ contentHash, offset, sizeInBytes });
+            offset += sizeInBytes;
+        }
+
+        std::ofstream file(filePath, std::ios::binary);
+        if (!file) {
+            return E_FAIL;
+        }
+
+        ShaderLibrary::Header header = { ShaderLibrary::kMagic, ShaderLibrary::kVersion,
+            static_cast<uint32_t>(entries.size()), static_cast<uint32_t>(blobs.size()) };
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(Entry));
+        file.write(reinterpret_cast<const char*>(blobs.data()), blobs.size() * sizeof(Blob));
+        file.write(names.data(), names.size());
+
+        const char padding[ShaderLibrary::kBlobAlignment] = {};
+        offset = namesEnd;
+        for (const Blob& blob : blobs) {
+            file.write(padding, static_cast<std::streamsize>(blob.dataOffset - offset));
+            const std::vector<uint8_t>& data = _blobs.at(blob.contentHash);
+            file.write(reinterpret_cast<const char*>(data.data()), data.size());
+            offset = blob.dataOffset + blob.sizeInBytes;
+        }
+        return file ? S_OK : E_FAIL;
+    }
+
+
+    D3D12_SHADER_BYTECODE ShaderLibraryWriter::shader(const std::string& name) const {
+        auto nameIt = _names.find(name);
+        if (nameIt == _names.end()) {
+            return {};
+        }
+        const std::vector<uint8_t>& data = _blobs.at(nameIt->second);
+        return { data.data(), data.size() };
+    }
+
+
+    ///
+    /// ShaderPermutationBuilder Implementation
+    ///
+    std::string ShaderBuildStatistics::toJson() const {
+        char json[256];
+        snprintf(json, sizeof(json), "{\"permutations\": %u, \"compiled\": %u, \"up_to_date\": %u, \"failed\": %u, "
+            "\"elapsed_ms\": %.3f}", permutationCount, compiledCount, upToDateCount, failedCount, elapsedMs);
+        return json;
+    }
+
+
+    ShaderPermutationBuilder::ShaderPermutationBuilder(const std::filesystem::path& compilerPath,
+        const std::filesystem::path& cacheDirectory, uint32_t threadCount) :
+        _compilerPath(compilerPath), _cacheDirectory(cacheDirectory), _threadCount(std::max(threadCount, 1u)) {
+    }
+
+
+    void ShaderPermutationBuilder::addIncludeDirectory(const std::filesystem::path& directory) {
+        _includeDirectories.push_back(directory);
+    }
+
+
+    void ShaderPermutationBuilder::addArgument(const std::string& argument) {
+        _arguments.push_back(argument);
+    }
+
+
+    void ShaderPermutationBuilder::addSource(const std::filesystem::path& sourcePath, const std::string& entryPoint,
+        const std::string& target, const std::vector<std::vector<std::string>>& axes) {
+        Source source = { sourcePath, entryPoint, target };
+        for (const std::vector<std::string>& axis : axes) {
+            if (!axis.empty()) {
+                source.axes.push_back(axis);
+            }
+        }
+        _sources.push_back(std::move(source));
+    }
+
+
+    uint64_t ShaderPermutationBuilder::_hashSourceTree(const std::filesystem::path& filePath, uint64_t hash,
+        std::vector<std::filesystem::path>& visited) {
+        std::filesystem::path normalPath = filePath.lexically_normal();
+        if (std::find(visited.begin(), visited.end(), normalPath) != visited.end()) {
+            return hash;
+        }
+        visited.push_back(normalPath);
+
+        std::ifstream file(normalPath, std::ios::binary);
+        std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        hash = fastdxu::hashBytes(text.data(), text.size(), hash);
+
+        // Includes resolve next to the including file first, then in the include directories
+        for (size_t position = text.find("#include"); position != std::string::npos;
+            position = text.find("#include", position + 1)) {
+            size_t nameBegin = text.find_first_of("\"<\n", position + 8);
+            if (nameBegin == std::string::npos || text[nameBegin] == '\n') {
                 continue;
             }
+            size_t nameEnd = text.find(text[nameBegin] == '<' ? '>' : '"', nameBegin + 1);
+            if (nameEnd == std::string::npos) {
+                break;
+            }
 
-            hr = D3D12CreateDevice(hardwareAdapter, featureLevel, IID_PPV_ARGS(&device));
-            if (SUCCEEDED(hr)) {
+            std::string includeName = text.substr(nameBegin + 1, nameEnd - nameBegin - 1);
+            hash = fastdxu::hashBytes(includeName.data(), includeName.size(), hash);
+            std::filesystem::path includePath = normalPath.parent_path() / includeName;
+            for (size_t i = 0; i < _includeDirectories.size() && !std::filesystem::exists(includePath); ++i) {
+                includePath = _includeDirectories[i] / includeName;
+            }
+            if (std::filesystem::exists(includePath)) {
+                hash = _hashSourceTree(includePath, hash, visited);
+            }
+        }
+        return hash;
+    }
+
+
+    HRESULT ShaderPermutationBuilder::_compile(const Permutation& permutation, std::string* outErrors) const {
+        // Output is renamed into the cache once complete, an interrupted compile never looks up to date
+        std::filesystem::path tempPath = permutation.outputPath;
+        tempPath += ".tmp";
+        std::filesystem::path errorsPath = permutation.outputPath;
+        errorsPath.replace_extension(".log");
+
+        // Names, defines and arguments are ASCII
+        auto quoted = [](const std::filesystem::path& path) { return L"\"" + path.wstring() + L"\""; };
+        auto widened = [](const std::string& value) { return std::wstring(value.begin(), value.end()); };
+        std::wstring commandLine = quoted(_compilerPath) + L" -T " + widened(permutation.source->target) +
+            L" -E " + widened(permutation.source->entryPoint);
+        for (const std::filesystem::path& directory : _includeDirectories) {
+            commandLine += L" -I " + quoted(directory);
+        }
+        for (const std::string& define : permutation.defines) {
+            commandLine += L" -D " + widened(define);
+        }
+        for (const std::string& argument : _arguments) {
+            commandLine += L" " + widened(argument);
+        }
+        commandLine += L" -Fo " + quoted(tempPath) + L" -Fe " + quoted(errorsPath) + L" " +
+            quoted(permutation.source->path);
+
+        STARTUPINFOW startupInfo = {};
+        startupInfo.cb = sizeof(startupInfo);
+        PROCESS_INFORMATION processInfo = {};
+        if (!CreateProcessW(nullptr, &commandLine[0], nullptr, nullptr, FALSE, CREATE_NO_WINDOW, nullptr, nullptr,
+            &startupInfo, &processInfo)) {
+            return HRESULT_FROM_WIN32(GetLastError());
+        }
+        WaitForSingleObject(processInfo.hProcess, INFINITE);
+        DWORD exitCode = 1;
+        GetExitCodeProcess(processInfo.hProcess, &exitCode);
+        CloseHandle(processInfo.hThread);
+        CloseHandle(processInfo.hProcess);
+
+        std::error_code errorCode;
+        if (exitCode != 0 || !std::filesystem::exists(tempPath)) {
+            std::ifstream errorsFile(errorsPath, std::ios::binary);
+            outErrors->assign(std::istreambuf_iterator<char>(errorsFile), std::istreambuf_iterator<char>());
+            errorsFile.close();
+            std::filesystem::remove(errorsPath, errorCode);
+            std::filesystem::remove(tempPath, errorCode);
+            return E_FAIL;
+        }
+        std::filesystem::remove(errorsPath, errorCode);
+        std::filesystem::rename(tempPath, permutation.outputPath, errorCode);
+        return errorCode ? E_FAIL : S_OK;
+    }
+
+
+    HRESULT ShaderPermutationBuilder::build(ShaderLibraryWriter& libraryWriter, ShaderBuildStatistics* outStatistics) {
+        FASTDX_PROFILE_FUNCTION();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        _dependencies.clear();
+        _errors.clear();
+        std::error_code errorCode;
+        std::filesystem::create_directories(_cacheDirectory, errorCode);
+
+        // Settings shared by every permutation, a compiler update changes its write time
+        auto hashString = [](const std::string& value, uint64_t hash) {
+            return fastdxu::hashBytes(value.c_str(), value.size() + 1, hash);
+        };
+        uint64_t settingsHash = hashString(_compilerPath.string(), fastdxu::hashBytes(nullptr, 0));
+        int64_t compilerTime = std::filesystem::last_write_time(_compilerPath, errorCode).time_since_epoch().count();
+        settingsHash = fastdxu::hashBytes(&compilerTime, sizeof(compilerTime), settingsHash);
+        for (const std::filesystem::path& directory : _includeDirectories) {
+            settingsHash = hashString(directory.string(), settingsHash);
+        }
+        for (const std::string& argument : _arguments) {
+            settingsHash = hashString(argument, settingsHash);
+        }
+
+        // Key each permutation by hash, the ones missing from the cache are out of date
+        std::vector<Permutation> permutations;
+        std::vector<size_t> outOfDateIndices;
+        for (const Source& source : _sources) {
+            std::vector<std::filesystem::path> visited;
+            uint64_t sourceHash = _hashSourceTree(source.path, settingsHash, visited);
+            sourceHash = hashString(source.target, hashString(source.entryPoint, sourceHash));
+            for (const std::filesystem::path& dependency : visited) {
+                if (std::find(_dependencies.begin(), _dependencies.end(), dependency) == _dependencies.end()) {
+                    _dependencies.push_back(dependency);
+                }
+            }
+
+            // Counts through option combinations, the first axis changes fastest
+            std::vector<size_t> optionIndices(source.axes.size(), 0);
+            for (;;) {
+                Permutation permutation = { source.path.stem().string(), &source };
+                uint64_t hash = sourceHash;
+                for (size_t axis = 0; axis < source.axes.size(); ++axis) {
+                    const std::string& define = source.axes[axis][optionIndices[axis]];
+                    hash = hashString(define, hash);
+                    if (!define.empty()) {
+                        permutation.name += "+" + define;
+                        permutation.defines.push_back(define);
+                    }
+                }
+
+                char fileName[32];
+                snprintf(fileName, sizeof(fileName), "%016llx.cso", static_cast<unsigned long long>(hash));
+                permutation.outputPath = _cacheDirectory / fileName;
+                if (!std::filesystem::exists(permutation.outputPath)) {
+                    outOfDateIndices.push_back(permutations.size());
+                }
+                permutations.push_back(std::move(permutation));
+
+                size_t axis = 0;
+                for (; axis < optionIndices.size(); ++axis) {
+                    if (++optionIndices[axis] < source.axes[axis].size()) {
+                        break;
+                    }
+                    optionIndices[axis] = 0;
+                }
+                if (axis == optionIndices.size()) {
+                    break;
+                }
+            }
+        }
+
+        // Each worker runs one compiler process at a time, the calling thread is one of them
+        std::vector<HRESULT> results(outOfDateIndices.size(), S_OK);
+        std::vector<std::string> compileErrors(outOfDateIndices.size());
+        std::atomic<size_t> nextIndex = 0;
+        auto compileNext = [&]() {
+            for (size_t i = nextIndex++; i < outOfDateIndices.size(); i = nextIndex++) {
+                results[i] = _compile(permutations[outOfDateIndices[i]], &compileErrors[i]);
+            }
+        };
+        std::vector<std::thread> workers;
+        size_t workerCount = std::min<size_t>(_threadCount, outOfDateIndices.size());
+        for (size_t i = 1; i < workerCount; ++i) {
+            workers.emplace_back(compileNext);
+        }
+        compileNext();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+
+        ShaderBuildStatistics statistics;
+        statistics.permutationCount = static_cast<uint32_t>(permutations.size());
+        statistics.upToDateCount = static_cast<uint32_t>(permutations.size() - outOfDateIndices.size());
+        for (size_t i = 0; i < outOfDateIndices.size(); ++i) {
+            if (SUCCEEDED(results[i])) {
+                ++statistics.compiledCount;
+            } else {
+                ++statistics.failedCount;
+                _errors.push_back(permutations[outOfDateIndices[i]].name + ": " + compileErrors[i]);
+            }
+        }
+
+        // Failed permutations have no output and are left out
+        for (const Permutation& permutation : permutations) {
+            if (std::filesystem::exists(permutation.outputPath)) {
+                libraryWriter.addFile(permutation.name, permutation.outputPath);
+            }
+        }
+
+        statistics.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (outStatistics != nullptr) {
+            *outStatistics = statistics;
+        }
+        return statistics.failedCount ? E_FAIL : S_OK;
+    }
+
+
+    ///
+    /// Shader Hot Reload Implementation
+    ///
+#if defined(_WIN32)
+    FileWatcher::FileWatcher(const std::filesystem::path& directory) : _directoryPath(directory.lexically_normal()) {
+        _directory = CreateFileW(_directoryPath.wstring().c_str(), FILE_LIST_DIRECTORY,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+            FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+        if (_directory == INVALID_HANDLE_VALUE) {
+            _result = HRESULT_FROM_WIN32(GetLastError());
+            return;
+        }
+        _stopEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+        _thread = std::thread(&FileWatcher::_watchMain, this);
+    }
+
+
+    FileWatcher::~FileWatcher() {
+        if (_thread.joinable()) {
+            SetEvent(_stopEvent);
+            _thread.join();
+        }
+        if (_stopEvent != nullptr) {
+            CloseHandle(_stopEvent);
+        }
+        if (_directory != INVALID_HANDLE_VALUE) {
+            CloseHandle(_directory);
+        }
+    }
+#else
+    FileWatcher::FileWatcher(const std::filesystem::path& directory) : _directoryPath(directory.lexically_normal()) {
+        _inotify = inotify_init1(IN_CLOEXEC);
+        if (_inotify < 0 || pipe(_stopPipe) != 0) {
+            _result = E_FAIL;
+            return;
+        }
+        _addWatches(std::filesystem::path(), nullptr);
+        if (_watches.empty()) {
+            _result = (errno == ENOENT || errno == ENOTDIR) ? HRESULT_FROM_WIN32(ERROR_PATH_NOT_FOUND) : E_FAIL;
+            return;
+        }
+        _thread = std::thread(&FileWatcher::_watchMain, this);
+    }
+
+
+    FileWatcher::~FileWatcher() {
+        if (_thread.joinable()) {
+            char stop = 0;
+            while (write(_stopPipe[1], &stop, 1) < 0 && errno == EINTR) {}
+            _thread.join();
+        }
+        for (int fd : { _stopPipe[0], _stopPipe[1], _inotify }) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+
+
+    void FileWatcher::_addWatches(const std::filesystem::path& relativePath,
+        std::vector<std::filesystem::path>* outFiles) {
+        const uint32_t kMask = IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_MOVED_TO | IN_ONLYDIR;
+        int watch = inotify_add_watch(_inotify, (_directoryPath / relativePath).c_str(), kMask);
+        if (watch < 0) {
+            return;
+        }
+        _watches[watch] = relativePath;
+
+        // Files written to a new directory before its watch was added are reported by the scan
+        std::error_code errorCode;
+        for (const std::filesystem::directory_entry& entry :
+            std::filesystem::directory_iterator(_directoryPath / relativePath, errorCode)) {
+            if (entry.is_directory(errorCode)) {
+                _addWatches(relativePath / entry.path().filename(), outFiles);
+            } else if (outFiles != nullptr) {
+                outFiles->push_back(entry.path().lexically_normal());
+            }
+        }
+    }
+#endif
+
+
+    std::vector<std::filesystem::path> FileWatcher::changes() {
+        std::vector<std::filesystem::path> changes;
+        std::lock_guard<std::mutex> lock(_mutex);
+        changes.swap(_changes);
+        return changes;
+    }
+
+
+    std::vector<std::filesystem::path> FileWatcher::waitForChanges(std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        std::vector<std::filesystem::path> changes;
+        _changed.wait_for(lock, timeout, [this]() { return !_changes.empty() || FAILED(result()); });
+        changes.swap(_changes);
+        return changes;
+    }
+
+
+#if defined(_WIN32)
+    void FileWatcher::_watchMain() {
+        alignas(DWORD) uint8_t buffer[16 * 1024];
+        OVERLAPPED overlapped = {};
+        overlapped.hEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+        HANDLE events[] = { overlapped.hEvent, _stopEvent };
+
+        // Errors end the watch, waiters return right away so the owner sees result()
+        auto stopOnError = [this]() {
+            HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+            std::lock_guard<std::mutex> lock(_mutex);
+            _result = hr;
+            _changed.notify_all();
+        };
+        for (;;) {
+            ResetEvent(overlapped.hEvent);
+            if (!ReadDirectoryChangesW(_directory, buffer, sizeof(buffer), TRUE,
+                FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME, nullptr, &overlapped, nullptr)) {
+                stopOnError();
+                break;
+            }
+
+            DWORD sizeInBytes = 0;
+            if (WaitForMultipleObjects(_countof(events), events, FALSE, INFINITE) != WAIT_OBJECT_0) {
+                CancelIoEx(_directory, &overlapped);
+                GetOverlappedResult(_directory, &overlapped, &sizeInBytes, TRUE);
+                break;
+            }
+            if (!GetOverlappedResult(_directory, &overlapped, &sizeInBytes, FALSE)) {
+                stopOnError();
+                break;
+            }
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto addChange = [this](const std::filesystem::path& path) {
+                if (std::find(_changes.begin(), _changes.end(), path) == _changes.end()) {
+                    _changes.push_back(path);
+                }
+            };
+            if (sizeInBytes == 0) {
+                addChange(_directoryPath);
+            }
+            for (DWORD offset = 0; sizeInBytes != 0;) {
+                const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(buffer + offset);
+                addChange((_directoryPath / std::wstring(info->FileName,
+                    info->FileNameLength / sizeof(WCHAR))).lexically_normal());
+                if (info->NextEntryOffset == 0) {
+                    break;
+                }
+                offset += info->NextEntryOffset;
+            }
+            _changed.notify_all();
+        }
+        CloseHandle(overlapped.hEvent);
+    }
+#else
+    void FileWatcher::_watchMain() {
+        alignas(inotify_event) char buffer[16 * 1024];
+        pollfd pollFds[] = { { _inotify, POLLIN, 0 }, { _stopPipe[0], POLLIN, 0 } };
+
+        // Errors end the watch, waiters return right away so the owner sees result()
+        auto stopOnError = [this]() {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _result = E_FAIL;
+            _changed.notify_all();
+        };
+        for (;;) {
+            if (poll(pollFds, 2, -1) < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                stopOnError();
+                break;
+            }
+            if (pollFds[1].revents != 0) {
+                break;
+            }
+            ssize_t sizeInBytes = read(_inotify, buffer, sizeof(buffer));
+            if (sizeInBytes <= 0) {
+                if (sizeInBytes < 0 && errno == EINTR) {
+                    continue;
+                }
+                stopOnError();
                 break;
             }
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto addChange = [this](const std::filesystem::path& path) {
+                if (std::find(_changes.begin(), _changes.end(), path) == _changes.end()) {
+                    _changes.push_back(path);
+                }
+            };
+            for (ssize_t offset = 0; offset < sizeInBytes;) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                offset += sizeof(inotify_event) + event->len;
+                if (event->mask & IN_Q_OVERFLOW) {
+                    addChange(_directoryPath);
+                    continue;
+                }
+                auto watch = _watches.find(event->wd);
+                if (watch == _watches.end()) {
+                    continue;
+                }
+                if (event->mask & IN_IGNORED) {
+                    _watches.erase(watch);
+                    continue;
+                }
+                if (event->len == 0) {
+                    continue;
+                }
+                std::filesystem::path relativePath = watch->second / event->name;
+                if ((event->mask & (IN_CREATE | IN_MOVED_TO)) && (event->mask & IN_ISDIR)) {
+                    std::vector<std::filesystem::path> files;
+                    _addWatches(relativePath, &files);
+                    for (const std::filesystem::path& file : files) {
+                        addChange(file);
+                    }
+                }
+                addChange((_directoryPath / relativePath).lexically_normal());
+            }
+            _changed.notify_all();
         }
-
-        for (IDXGIAdapter1* adapter : hardwareAdapters) {
-            SAFE_RELEASE(adapter);
-        }
-
-        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
-
-        auto devicePtr = std::shared_ptr<ID3D12Device2>(device, PtrDeleter());
-        return D3D12DeviceWrapperPtr(new D3D12DeviceWrapper(devicePtr));
     }
+#endif
 
 
-    ID3D12CommandAllocatorPtr D3D12DeviceWrapper::createCommandAllocator(D3D12_COMMAND_LIST_TYPE commandType, HRESULT* outResult) {
-
-        HRESULT hr;
-        ID3D12CommandAllocator* commandAllocator = nullptr;
-        hr = _device->CreateCommandAllocator(commandType, IID_PPV_ARGS(&commandAllocator));
-
-        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
-        return ID3D12CommandAllocatorPtr(commandAllocator, PtrDeleter());
+    ShaderHotReloader::ShaderHotReloader(ShaderPermutationBuilder builder, const std::filesystem::path& watchDirectory,
+        AsyncPipelineCompilerPtr pipelineCompiler) :
+        _builder(std::move(builder)), _watcher(watchDirectory), _pipelineCompiler(pipelineCompiler) {
+        if (FAILED(_watcher.result())) {
+            char error[64];
+            snprintf(error, sizeof(error), "Cannot watch the shader directory: 0x%08x",
+                static_cast<uint32_t>(_watcher.result()));
+            _lastBuildErrors.push_back(_watcher.directory().string() + ": " + error);
+            return;
+        }
+        _thread = std::thread(&ShaderHotReloader::_reloadMain, this);
     }
 
 
-    ID3D12GraphicsCommandListPtr D3D12DeviceWrapper::createCommandList(uint32_t nodeMask, D3D12_COMMAND_LIST_TYPE commandType,
-        ID3D12CommandAllocatorPtr allocator, HRESULT* outResult) {
-
-        HRESULT hr;
-        ID3D12GraphicsCommandList6* commandList = nullptr;
-        hr = _device->CreateCommandList(nodeMask, commandType, allocator.get(), nullptr, IID_PPV_ARGS(&commandList));
-
-        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
-        return ID3D12GraphicsCommandListPtr(commandList, PtrDeleter());
+    ShaderHotReloader::~ShaderHotReloader() {
+        _isStopping = true;
+        if (_thread.joinable()) {
+            _thread.join();
+        }
     }
 
 
-    ID3D12CommandQueuePtr D3D12DeviceWrapper::createCommandQueue(D3D12_COMMAND_LIST_TYPE type, HRESULT* outResult) {
-        D3D12_COMMAND_QUEUE_DESC queueDesc = {};
-        queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
-        queueDesc.Type = type;
-
-        ID3D12CommandQueue* commandQueue = nullptr;
-        HRESULT hr = _device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&commandQueue));
+    void ShaderHotReloader::addPipeline(ReloadablePipelineStatePtr pipelineState,
+        const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, const std::string& vertexShaderName,
+        const std::string& pixelShaderName) {
+        Registration registration = { pipelineState, desc, vertexShaderName, pixelShaderName,
+            fastdxu::hashBytes(desc.VS.pShaderBytecode, desc.VS.BytecodeLength),
+            fastdxu::hashBytes(desc.PS.pShaderBytecode, desc.PS.BytecodeLength) };
+        registration.desc.VS = {};
+        registration.desc.PS = {};
 
-        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
-        return ID3D12CommandQueuePtr(commandQueue, PtrDeleter());
+        std::lock_guard<std::mutex> lock(_mutex);
+        _registrations.push_back(std::move(registration));
     }
 
 
-    ID3D12ResourcePtr D3D12DeviceWrapper::createCommittedResource(const D3D12_HEAP_PROPERTIES& heapProperties,
-        D3D12_HEAP_FLAGS heapFlags, const D3D12_RESOURCE_DESC& desc, D3D12_RESOURCE_STATES initialState,
-        const D3D12_CLEAR_VALUE* optOptimalClearValue, HRESULT* outResult) {
+    uint32_t ShaderHotReloader::update(DeferredReleaseQueue& releaseQueue, uint64_t fenceValue) {
+        // The reload thread holds the lock while queueing compiles, try again next frame
+        std::unique_lock<std::mutex> lock(_mutex, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return 0;
+        }
 
-        HRESULT hr;
-        ID3D12Resource* resource;
-        hr = _device->CreateCommittedResource(&heapProperties, heapFlags, &desc, initialState, optOptimalClearValue,
-            IID_PPV_ARGS(&resource));
+        uint32_t swapCount = 0;
+        for (Registration& registration : _registrations) {
+            if (registration.pending == nullptr || !registration.pending->isDone()) {
+                continue;
+            }
 
-        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
-        return ID3D12ResourcePtr(resource, PtrDeleter());
+            // Failed compiles keep the running pipeline
+            if (registration.pending->isReady()) {
+                AsyncPipelineStatePtr& active = registration.pipelineState->_active;
+                if (active->pipelineState() != nullptr) {
+                    releaseQueue.release(active->pipelineState(), fenceValue);
+                }
+                if (active->fallback() != nullptr) {
+                    releaseQueue.release(active->fallback(), fenceValue);
+                }
+                active = registration.pending;
+                ++swapCount;
+            }
+            registration.pending = nullptr;
+        }
+        _swapCount += swapCount;
+        return swapCount;
     }
 
 
-    ID3D12FencePtr D3D12DeviceWrapper::createFence(uint64_t initialValue, D3D12_FENCE_FLAGS flags, HRESULT* outResult) {
+    ShaderBuildStatistics ShaderHotReloader::lastBuildStatistics() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _lastBuildStatistics;
+    }
 
-        ID3D12Fence1* fence = nullptr;
-        HRESULT hr = _device->CreateFence(initialValue, flags, IID_PPV_ARGS(&fence));
 
-        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
-        return ID3D12FencePtr(fence, PtrDeleter());
+    std::vector<std::string> ShaderHotReloader::lastBuildErrors() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _lastBuildErrors;
     }
 
 
-    ID3D12PipelineStatePtr D3D12DeviceWrapper::createGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc,
-        HRESULT* outResult) {
-        ID3D12PipelineState* pipelineState = nullptr;
-        HRESULT hr = _device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pipelineState));
-
-        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
-        return ID3D12PipelineStatePtr(pipelineState, PtrDeleter());
+    bool ShaderHotReloader::_isAffected(const std::vector<std::filesystem::path>& changes) const {
+        // The watched directory itself means changes were lost
+        const std::vector<std::filesystem::path>& dependencies = _builder.dependencies();
+        for (const std::filesystem::path& change : changes) {
+            if (change == _watcher.directory() ||
+                std::find(dependencies.begin(), dependencies.end(), change) != dependencies.end()) {
+                return true;
+            }
+        }
+        return false;
     }
 
 
-    ID3D12DescriptorHeapPtr D3D12DeviceWrapper::createDescriptorHeap(int32_t count, D3D12_DESCRIPTOR_HEAP_TYPE heapType,
-        HRESULT* outResult) {
+    void ShaderHotReloader::_rebuild() {
+        // Only permutations whose sources changed are recompiled
+        ShaderLibraryWriter libraryWriter;
+        ShaderBuildStatistics statistics;
+        _builder.build(libraryWriter, &statistics);
+        ++_buildCount;
+
+        // Recompile pipelines whose shaders changed, failed permutations are missing and keep the running shader
+        std::lock_guard<std::mutex> lock(_mutex);
+        _lastBuildStatistics = statistics;
+        _lastBuildErrors = _builder.errors();
+        for (Registration& registration : _registrations) {
+            D3D12_SHADER_BYTECODE vertexShader = libraryWriter.shader(registration.vertexShaderName);
+            D3D12_SHADER_BYTECODE pixelShader = libraryWriter.shader(registration.pixelShaderName);
+            if (vertexShader.pShaderBytecode == nullptr || pixelShader.pShaderBytecode == nullptr) {
+                continue;
+            }
 
-        D3D12_DESCRIPTOR_HEAP_FLAGS heapFlags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-        if (heapType == D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV || heapType == D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER) {
-            heapFlags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+            uint64_t vertexShaderHash = fastdxu::hashBytes(vertexShader.pShaderBytecode, vertexShader.BytecodeLength);
+            uint64_t pixelShaderHash = fastdxu::hashBytes(pixelShader.pShaderBytecode, pixelShader.BytecodeLength);
+            if (vertexShaderHash == registration.vertexShaderHash && pixelShaderHash == registration.pixelShaderHash) {
+                continue;
+            }
+            registration.vertexShaderHash = vertexShaderHash;
+            registration.pixelShaderHash = pixelShaderHash;
+
+            // compile() copies the bytecode, a newer compile replaces one not swapped in yet
+            D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = registration.desc;
+            desc.VS = vertexShader;
+            desc.PS = pixelShader;
+            registration.pending = _pipelineCompiler->compile(desc);
         }
+    }
 
-        D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc = {};
-        rtvHeapDesc.NumDescriptors = count;
-        rtvHeapDesc.Type = heapType;
-        rtvHeapDesc.Flags = heapFlags;
 
-        HRESULT hr;
-        ID3D12DescriptorHeap* heapDescriptor = nullptr;
-        hr = _device->CreateDescriptorHeap(&rtvHeapDesc, IID_PPV_ARGS(&heapDescriptor));
+    void ShaderHotReloader::_reloadMain() {
+        const std::chrono::milliseconds kPollTime(100);
+        const std::chrono::milliseconds kSettleTime(50);
 
-        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
-        return ID3D12DescriptorHeapPtr(heapDescriptor, PtrDeleter());
+        while (!_isStopping) {
+            std::vector<std::filesystem::path> changes = _watcher.waitForChanges(kPollTime);
+            if (FAILED(_watcher.result())) {
+                char error[64];
+                snprintf(error, sizeof(error), "Stopped watching the shader directory: 0x%08x",
+                    static_cast<uint32_t>(_watcher.result()));
+                std::lock_guard<std::mutex> lock(_mutex);
+                _lastBuildErrors.push_back(_watcher.directory().string() + ": " + error);
+                return;
+            }
+            if (changes.empty()) {
+                continue;
+            }
+
+            // Editors save in several writes, let them finish before reading the sources
+            std::this_thread::sleep_for(kSettleTime);
+            for (std::filesystem::path& change : _watcher.changes()) {
+                changes.push_back(std::move(change));
+            }
+            if (_isAffected(changes)) {
+                _rebuild();
+            }
+        }
     }
 
 
-    std::vector<ID3D12ResourcePtr> D3D12DeviceWrapper::createRenderTargetViews(
-        IDXGISwapChainPtr swapChain, ID3D12DescriptorHeapPtr heap, HRESULT* outResult) {
+    ///
+    /// CommandContextPool Implementation
+    ///
+    CommandContextPool::CommandContextPool(ID3D12DevicePtr device, D3D12_COMMAND_LIST_TYPE commandType) :
+        _device(device), _commandType(commandType) {
+    }
 
-        HRESULT hr;
-        DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
-        hr = swapChain->GetDesc1(&swapChainDesc);
-        CHECK_ASSIGN_RETURN_IF_FAILED_(hr, outResult, std::vector<ID3D12ResourcePtr>());
 
-        D3D12_CPU_DESCRIPTOR_HANDLE heapHandle = heap->GetCPUDescriptorHandleForHeapStart();
-        size_t heapDescriptorSize = _device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+    void CommandContextPool::beginFrame(uint64_t completedFenceValue) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        while (!_inFlightAllocators.empty() && _inFlightAllocators.front().fenceValue <= completedFenceValue) {
+            _freeAllocators.push_back(std::move(_inFlightAllocators.front().commandAllocator));
+            _inFlightAllocators.pop_front();
+        }
+    }
 
-        std::vector<ID3D12ResourcePtr> resources;
-        for (uint32_t i = 0; i < swapChainDesc.BufferCount; ++i) {
-            ID3D12Resource* renderTarget = nullptr;
-            hr = swapChain->GetBuffer(i, IID_PPV_ARGS(&renderTarget));
-            CHECK_ASSIGN_RETURN_IF_FAILED_(hr, outResult, std::vector<ID3D12ResourcePtr>());
-            resources.push_back(ID3D12ResourcePtr(renderTarget, PtrDeleter()));
 
-            _device->CreateRenderTargetView(renderTarget, nullptr, heapHandle);
-            heapHandle.ptr += heapDescriptorSize;
+    CommandContext CommandContextPool::acquire(uint32_t slot, HRESULT* outResult) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (slot >= _slots.size()) {
+            _slots.resize(slot + 1);
         }
 
-        return resources;
-    }
-
+        CommandContext& context = _slots[slot];
+        if (context.commandAllocator != nullptr) {
+            _checkFailedAndAssign(S_OK, outResult);
+            return context;
+        }
 
-    ID3D12RootSignaturePtr D3D12DeviceWrapper::createRootSignature(uint32_t nodeMask, const void* data, size_t dataSizeInBytes,
-        HRESULT* outResult) {
-        ID3D12RootSignature* rootSignature = nullptr;
-        HRESULT hr = _device->CreateRootSignature(nodeMask, data, dataSizeInBytes, IID_PPV_ARGS(&rootSignature));
+        HRESULT hr;
+        ID3D12CommandAllocatorPtr commandAllocator;
+        if (!_freeAllocators.empty()) {
+            commandAllocator = std::move(_freeAllocators.back());
+            _freeAllocators.pop_back();
+            hr = commandAllocator->Reset();
+            CHECK_ASSIGN_RETURN_IF_FAILED_(hr, outResult, CommandContext());
+        } else {
+            ID3D12CommandAllocator* newAllocator = nullptr;
+            hr = _device->CreateCommandAllocator(_commandType, IID_PPV_ARGS(&newAllocator));
+            CHECK_ASSIGN_RETURN_IF_FAILED_(hr, outResult, CommandContext());
+            commandAllocator = ID3D12CommandAllocatorPtr(newAllocator, PtrDeleter());
+            ++_allocatorCount;
+        }
 
-        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
-        return ID3D12RootSignaturePtr(rootSignature, PtrDeleter());
+        // Lists are created open, closed lists are reset onto the new allocator
+        if (context.commandList == nullptr) {
+            ID3D12GraphicsCommandList6* commandList = nullptr;
+            hr = _device->CreateCommandList(0, _commandType, commandAllocator.get(), nullptr,
+                IID_PPV_ARGS(&commandList));
+            CHECK_ASSIGN_RETURN_IF_FAILED_(hr, outResult, CommandContext());
+            context.commandList = ID3D12GraphicsCommandListPtr(commandList, PtrDeleter());
+        } else {
+            hr = context.commandList->Reset(commandAllocator.get(), nullptr);
+            CHECK_ASSIGN_RETURN_IF_FAILED_(hr, outResult, CommandContext());
+        }
 
+        context.commandAllocator = commandAllocator;
+        _checkFailedAndAssign(S_OK, outResult);
+        return context;
     }
 
 
-    IDXGISwapChainPtr D3D12DeviceWrapper::createSwapChainForHwnd(ID3D12CommandQueuePtr commandQueue,
-        const DXGI_SWAP_CHAIN_DESC1& swapChainDesc, HWND hwnd, HRESULT* outResult) {
+    void CommandContextPool::submit(ID3D12CommandQueuePtr commandQueue, uint64_t fenceValue) {
+        std::lock_guard<std::mutex> lock(_mutex);
 
-        HRESULT hr;
-        std::shared_ptr<IDXGIFactory4> dxgiFactory = _getOrCreateDXIG(&hr);
-        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
+        std::vector<ID3D12CommandList*> commandLists;
+        for (CommandContext& context : _slots) {
+            if (context.commandAllocator == nullptr) {
+                continue;
+            }
 
-        IDXGISwapChain1* swapChain1 = nullptr;
-        hr = dxgiFactory->CreateSwapChainForHwnd(
-            commandQueue.get(),     // Link to Command Queue
-            hwnd,                   // Link to Window
-            &swapChainDesc,
-            nullptr,
-            nullptr,
-            &swapChain1
-        );
-        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
+            context.commandList->Close();
+            commandLists.push_back(context.commandList.get());
+            _inFlightAllocators.push_back({ fenceValue, std::move(context.commandAllocator) });
+            context.commandAllocator = nullptr;
+        }
 
-        IDXGISwapChain3* swapChain3 = nullptr;
-        hr = swapChain1->QueryInterface(__uuidof(IDXGISwapChain3), reinterpret_cast<void**>(&swapChain3));
-        SAFE_RELEASE(swapChain1);
-        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
+        if (!commandLists.empty()) {
+            commandQueue->ExecuteCommandLists(static_cast<uint32_t>(commandLists.size()), commandLists.data());
+        }
+    }
 
-        hr = dxgiFactory->MakeWindowAssociation(hwnd, 0);
-        CHECK_ASSIGN_RETURN_IF_FAILED(hr, outResult);
 
-        return IDXGISwapChainPtr(swapChain3, PtrDeleter());
+    ///
+    /// WorkerPool Implementation
+    ///
+    WorkerPool::WorkerPool(uint32_t threadCount, const char* threadName) {
+        for (uint32_t i = 1; i < threadCount; ++i) {
+            _workers.emplace_back(&WorkerPool::_workerMain, this, threadName);
+        }
     }
 
 
-    void D3D12DeviceWrapper::createConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC& desc,
-        D3D12_CPU_DESCRIPTOR_HANDLE handle) {
-        _device->CreateConstantBufferView(&desc, handle);
+    WorkerPool::~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _isStopping = true;
+        }
+        _partsAvailable.notify_all();
+        for (std::thread& worker : _workers) {
+            worker.join();
+        }
     }
 
 
-    void D3D12DeviceWrapper::createDepthStencilView(ID3D12ResourcePtr resource, const D3D12_DEPTH_STENCIL_VIEW_DESC& desc,
-        D3D12_CPU_DESCRIPTOR_HANDLE handle) {
-        _device->CreateDepthStencilView(resource.get(), &desc, handle);
+    void WorkerPool::run(uint32_t partCount, const PartFunction& function) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        assert(_runningPartCount == 0 || !"WorkerPool::run() is not reentrant!");
+        _function = &function;
+        _partCount = partCount;
+        _nextPart = 0;
+        _runningPartCount = partCount;
+        if (partCount > 1) {
+            _partsAvailable.notify_all();
+        }
+
+        // Help with the parts, then wait for the ones picked up by workers
+        _runParts(lock);
+        _partsDone.wait(lock, [this]() { return _runningPartCount == 0; });
+        _function = nullptr;
     }
 
 
-    void D3D12DeviceWrapper::createRenderTargetView(ID3D12ResourcePtr resource, const D3D12_RENDER_TARGET_VIEW_DESC& desc,
-        D3D12_CPU_DESCRIPTOR_HANDLE handle) {
-        _device->CreateRenderTargetView(resource.get(), &desc, handle);
+    void WorkerPool::_runParts(std::unique_lock<std::mutex>& lock) {
+        while (_nextPart < _partCount) {
+            uint32_t partIndex = _nextPart++;
+            const PartFunction& function = *_function;
+            lock.unlock();
+            function(partIndex);
+            lock.lock();
+            if (--_runningPartCount == 0) {
+                _partsDone.notify_all();
+            }
+        }
     }
 
 
-    void D3D12DeviceWrapper::createShaderResourceView(ID3D12ResourcePtr resource, const D3D12_SHADER_RESOURCE_VIEW_DESC& desc,
-        D3D12_CPU_DESCRIPTOR_HANDLE handle) {
-        _device->CreateShaderResourceView(resource.get(), &desc, handle);
-    }
+    void WorkerPool::_workerMain(const char* threadName) {
+        if (threadName != nullptr) {
+            CpuProfiler::setThreadName(threadName);
+        }
 
-    inline uint32_t D3D12DeviceWrapper::getDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE descriptorHeapType) {
-        return _device->GetDescriptorHandleIncrementSize(descriptorHeapType);
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true) {
+            _partsAvailable.wait(lock, [this]() { return _isStopping || _nextPart < _partCount; });
+            if (_isStopping) {
+                return;
+            }
+            _runParts(lock);
+        }
     }
 
 };
@@ -745,4 +6969,289 @@ namespace fastdxu {
     inline DXGI_SWAP_CHAIN_DESC1 swapChainDesc(const HWND hwnd, uint32_t bufferCount, DXGI_FORMAT format) {
         return DEFAULT_DXGI_SWAP_CHAIN_DESC1(hwnd, bufferCount, format);
     }
+
+
+    inline std::pair<uint32_t, uint32_t> partitionRange(uint32_t count, uint32_t partCount, uint32_t partIndex) {
+        uint32_t begin = static_cast<uint32_t>(uint64_t(count) * partIndex / partCount);
+        uint32_t end = static_cast<uint32_t>(uint64_t(count) * (partIndex + 1) / partCount);
+        return { begin, end };
+    }
+
+
+    struct DEFAULT_D3D12_SAMPLER_DESC : public D3D12_SAMPLER_DESC {
+        DEFAULT_D3D12_SAMPLER_DESC(D3D12_FILTER filter, D3D12_TEXTURE_ADDRESS_MODE addressMode) {
+            Filter = filter;
+            AddressU = addressMode;
+            AddressV = addressMode;
+            AddressW = addressMode;
+            MipLODBias = 0.0f;
+            MaxAnisotropy = D3D12_DECODE_IS_ANISOTROPIC_FILTER(filter) ? 16 : 1;
+            ComparisonFunc = D3D12_COMPARISON_FUNC_NEVER;
+            BorderColor[0] = BorderColor[1] = BorderColor[2] = BorderColor[3] = 0.0f;
+            MinLOD = 0.0f;
+            MaxLOD = D3D12_FLOAT32_MAX;
+        }
+    };
+    inline D3D12_SAMPLER_DESC samplerDesc(D3D12_FILTER filter, D3D12_TEXTURE_ADDRESS_MODE addressMode) {
+        return DEFAULT_D3D12_SAMPLER_DESC(filter, addressMode);
+    }
+
+
+    inline D3D12_SAMPLER_DESC canonicalSamplerDesc(const D3D12_SAMPLER_DESC& desc) {
+        D3D12_SAMPLER_DESC canonicalDesc = desc;
+        if (!D3D12_DECODE_IS_ANISOTROPIC_FILTER(desc.Filter)) {
+            canonicalDesc.MaxAnisotropy = 1;
+        }
+        if (D3D12_DECODE_FILTER_REDUCTION(desc.Filter) != D3D12_FILTER_REDUCTION_TYPE_COMPARISON) {
+            canonicalDesc.ComparisonFunc = D3D12_COMPARISON_FUNC_NEVER;
+        }
+
+        bool usesBorder = desc.AddressU == D3D12_TEXTURE_ADDRESS_MODE_BORDER ||
+            desc.AddressV == D3D12_TEXTURE_ADDRESS_MODE_BORDER || desc.AddressW == D3D12_TEXTURE_ADDRESS_MODE_BORDER;
+        for (int32_t i = 0; i < _countof(canonicalDesc.BorderColor); ++i) {
+            // Also folds -0.0f into 0.0f
+            canonicalDesc.BorderColor[i] = usesBorder ? canonicalDesc.BorderColor[i] + 0.0f : 0.0f;
+        }
+        canonicalDesc.MipLODBias += 0.0f;
+        canonicalDesc.MinLOD += 0.0f;
+        return canonicalDesc;
+    }
+
+
+    // FNV-1a
+    inline uint64_t hashBytes(const void* data, size_t sizeInBytes, uint64_t seed) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        uint64_t hash = seed;
+        for (size_t i = 0; i < sizeInBytes; ++i) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+
+    inline uint64_t hashSamplerDesc(const D3D12_SAMPLER_DESC& desc) {
+        D3D12_SAMPLER_DESC canonicalDesc = canonicalSamplerDesc(desc);
+        return hashBytes(&canonicalDesc, sizeof(canonicalDesc));
+    }
+
+
+    inline bool findDxilContainerPart(const void* container, size_t containerSizeInBytes, uint32_t fourCC,
+        const void** outPartData, size_t* outPartSizeInBytes) {
+        // Header: "DXBC", 16B digest, version, container size, part count, then part offsets
+        const uint32_t kDxilContainerMagic = 0x43425844;
+        const size_t kHeaderSizeInBytes = 32;
+        const uint8_t* bytes = static_cast<const uint8_t*>(container);
+        if (bytes == nullptr || containerSizeInBytes < kHeaderSizeInBytes) {
+            return false;
+        }
+
+        uint32_t header[8];
+        memcpy(header, bytes, sizeof(header));
+        uint32_t containerSize = header[6];
+        uint32_t partCount = header[7];
+        if (header[0] != kDxilContainerMagic || containerSize < kHeaderSizeInBytes ||
+            containerSize > containerSizeInBytes ||
+            partCount > (containerSize - kHeaderSizeInBytes) / sizeof(uint32_t)) {
+            return false;
+        }
+
+        // Each part: four character code, size, then data
+        for (uint32_t i = 0; i < partCount; ++i) {
+            uint32_t partOffset;
+            memcpy(&partOffset, bytes + kHeaderSizeInBytes + i * sizeof(uint32_t), sizeof(partOffset));
+            if (partOffset > containerSize || containerSize - partOffset < 2 * sizeof(uint32_t)) {
+                return false;
+            }
+
+            uint32_t partHeader[2];
+            memcpy(partHeader, bytes + partOffset, sizeof(partHeader));
+            if (partHeader[1] > containerSize - partOffset - sizeof(partHeader)) {
+                return false;
+            }
+            if (partHeader[0] == fourCC) {
+                *outPartData = bytes + partOffset + sizeof(partHeader);
+                *outPartSizeInBytes = partHeader[1];
+                return true;
+            }
+        }
+        return false;
+    }
+
+
+    inline D3D12_GRAPHICS_PIPELINE_STATE_DESC canonicalGraphicsPipelineDesc(
+        const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) {
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC canonicalDesc = desc;
+        for (D3D12_SHADER_BYTECODE* shader : { &canonicalDesc.VS, &canonicalDesc.PS, &canonicalDesc.DS,
+            &canonicalDesc.HS, &canonicalDesc.GS }) {
+            if (shader->pShaderBytecode == nullptr || shader->BytecodeLength == 0) {
+                *shader = {};
+            }
+        }
+        if (canonicalDesc.StreamOutput.NumEntries == 0) {
+            canonicalDesc.StreamOutput = {};
+        }
+
+        // Same defaults as CD3DX12_BLEND_DESC and CD3DX12_DEPTH_STENCIL_DESC
+        D3D12_BLEND_DESC& blendState = canonicalDesc.BlendState;
+        uint32_t blendCount = blendState.IndependentBlendEnable ? desc.NumRenderTargets :
+            std::min(desc.NumRenderTargets, 1u);
+        for (uint32_t i = 0; i < _countof(blendState.RenderTarget); ++i) {
+            D3D12_RENDER_TARGET_BLEND_DESC& renderTarget = blendState.RenderTarget[i];
+            if (i >= blendCount) {
+                renderTarget = { FALSE, FALSE, D3D12_BLEND_ONE, D3D12_BLEND_ZERO, D3D12_BLEND_OP_ADD, D3D12_BLEND_ONE,
+                    D3D12_BLEND_ZERO, D3D12_BLEND_OP_ADD, D3D12_LOGIC_OP_NOOP, D3D12_COLOR_WRITE_ENABLE_ALL };
+                continue;
+            }
+            if (!renderTarget.BlendEnable) {
+                renderTarget.SrcBlend = renderTarget.SrcBlendAlpha = D3D12_BLEND_ONE;
+                renderTarget.DestBlend = renderTarget.DestBlendAlpha = D3D12_BLEND_ZERO;
+                renderTarget.BlendOp = renderTarget.BlendOpAlpha = D3D12_BLEND_OP_ADD;
+            }
+            if (!renderTarget.LogicOpEnable) {
+                renderTarget.LogicOp = D3D12_LOGIC_OP_NOOP;
+            }
+        }
+        canonicalDesc.RasterizerState.DepthBiasClamp += 0.0f;
+        canonicalDesc.RasterizerState.SlopeScaledDepthBias += 0.0f;
+
+        D3D12_DEPTH_STENCIL_DESC& depthStencilState = canonicalDesc.DepthStencilState;
+        if (!depthStencilState.DepthEnable) {
+            depthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
+            depthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
+        }
+        if (!depthStencilState.StencilEnable) {
+            const D3D12_DEPTH_STENCILOP_DESC kDefaultStencilOp = { D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP,
+                D3D12_STENCIL_OP_KEEP, D3D12_COMPARISON_FUNC_ALWAYS };
+            depthStencilState.StencilReadMask = D3D12_DEFAULT_STENCIL_READ_MASK;
+            depthStencilState.StencilWriteMask = D3D12_DEFAULT_STENCIL_WRITE_MASK;
+            depthStencilState.FrontFace = depthStencilState.BackFace = kDefaultStencilOp;
+        }
+
+        if (canonicalDesc.InputLayout.NumElements == 0) {
+            canonicalDesc.InputLayout.pInputElementDescs = nullptr;
+        }
+        for (uint32_t i = std::min(desc.NumRenderTargets, 8u); i < _countof(canonicalDesc.RTVFormats); ++i) {
+            canonicalDesc.RTVFormats[i] = DXGI_FORMAT_UNKNOWN;
+        }
+        canonicalDesc.CachedPSO = {};
+        return canonicalDesc;
+    }
+
+
+    inline uint64_t hashGraphicsPipelineDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSignatureHash) {
+        // Field by field, padding bytes are undefined
+        uint64_t hash = hashBytes(&rootSignatureHash, sizeof(rootSignatureHash));
+        auto hashValue = [&hash](const auto& value) {
+            hash = hashBytes(&value, sizeof(value), hash);
+        };
+        auto hashData = [&hash, &hashValue](const void* data, uint64_t sizeInBytes) {
+            hashValue(sizeInBytes);
+            hash = hashBytes(data, static_cast<size_t>(sizeInBytes), hash);
+        };
+        auto hashString = [&hashData](const char* string) {
+            hashData(string, string ? strlen(string) : 0);
+        };
+
+        for (const D3D12_SHADER_BYTECODE* shader : { &desc.VS, &desc.PS, &desc.DS, &desc.HS, &desc.GS }) {
+            hashData(shader->pShaderBytecode, shader->pShaderBytecode ? shader->BytecodeLength : 0);
+        }
+
+        const D3D12_STREAM_OUTPUT_DESC& streamOutput = desc.StreamOutput;
+        hashValue(streamOutput.NumEntries);
+        for (uint32_t i = 0; i < streamOutput.NumEntries; ++i) {
+            const D3D12_SO_DECLARATION_ENTRY& entry = streamOutput.pSODeclaration[i];
+            hashValue(entry.Stream);
+            hashString(entry.SemanticName);
+            hashValue(entry.SemanticIndex);
+            hashValue(entry.StartComponent);
+            hashValue(entry.ComponentCount);
+            hashValue(entry.OutputSlot);
+        }
+        if (streamOutput.NumEntries > 0) {
+            hashData(streamOutput.pBufferStrides, streamOutput.NumStrides * sizeof(uint32_t));
+            hashValue(streamOutput.RasterizedStream);
+        }
+
+        // Render targets past the first share its blend state unless independent blend is enabled
+        const D3D12_BLEND_DESC& blendState = desc.BlendState;
+        hashValue(blendState.AlphaToCoverageEnable);
+        hashValue(blendState.IndependentBlendEnable);
+        uint32_t blendCount = blendState.IndependentBlendEnable ? desc.NumRenderTargets :
+            std::min(desc.NumRenderTargets, 1u);
+        for (uint32_t i = 0; i < blendCount && i < _countof(blendState.RenderTarget); ++i) {
+            const D3D12_RENDER_TARGET_BLEND_DESC& renderTarget = blendState.RenderTarget[i];
+            hashValue(renderTarget.BlendEnable);
+            hashValue(renderTarget.LogicOpEnable);
+            if (renderTarget.BlendEnable) {
+                hashValue(renderTarget.SrcBlend);
+                hashValue(renderTarget.DestBlend);
+                hashValue(renderTarget.BlendOp);
+                hashValue(renderTarget.SrcBlendAlpha);
+                hashValue(renderTarget.DestBlendAlpha);
+                hashValue(renderTarget.BlendOpAlpha);
+            }
+            if (renderTarget.LogicOpEnable) {
+                hashValue(renderTarget.LogicOp);
+            }
+            hashValue(renderTarget.RenderTargetWriteMask);
+        }
+        hashValue(desc.SampleMask);
+        hashValue(desc.RasterizerState);
+
+        const D3D12_DEPTH_STENCIL_DESC& depthStencilState = desc.DepthStencilState;
+        hashValue(depthStencilState.DepthEnable);
+        if (depthStencilState.DepthEnable) {
+            hashValue(depthStencilState.DepthWriteMask);
+            hashValue(depthStencilState.DepthFunc);
+        }
+        hashValue(depthStencilState.StencilEnable);
+        if (depthStencilState.StencilEnable) {
+            hashValue(depthStencilState.StencilReadMask);
+            hashValue(depthStencilState.StencilWriteMask);
+            hashValue(depthStencilState.FrontFace);
+            hashValue(depthStencilState.BackFace);
+        }
+
+        hashValue(desc.InputLayout.NumElements);
+        for (uint32_t i = 0; i < desc.InputLayout.NumElements; ++i) {
+            const D3D12_INPUT_ELEMENT_DESC& element = desc.InputLayout.pInputElementDescs[i];
+            hashString(element.SemanticName);
+            hashValue(element.SemanticIndex);
+            hashValue(element.Format);
+            hashValue(element.InputSlot);
+            hashValue(element.AlignedByteOffset);
+            hashValue(element.InputSlotClass);
+            hashValue(element.InstanceDataStepRate);
+        }
+
+        hashValue(desc.IBStripCutValue);
+        hashValue(desc.PrimitiveTopologyType);
+        hashValue(desc.NumRenderTargets);
+        for (uint32_t i = 0; i < desc.NumRenderTargets && i < _countof(desc.RTVFormats); ++i) {
+            hashValue(desc.RTVFormats[i]);
+        }
+        hashValue(desc.DSVFormat);
+        hashValue(desc.SampleDesc);
+        hashValue(desc.NodeMask);
+        hashValue(desc.Flags);
+        return hash;
+    }
+
+
+    inline std::string jsonString(const std::string& text) {
+        std::string json = "\"";
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                json += '\\';
+                json += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                json += escaped;
+            } else {
+                json += c;
+            }
+        }
+        return json + "\"";
+    }
 };
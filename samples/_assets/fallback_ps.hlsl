@@ -0,0 +1,9 @@
+// Flat gray while the scene's pipeline compiles, reads no resources so any root signature fits
+struct v2f {
+    float4 position     : SV_POSITION;
+    float2 uv0          : TEXCOORD0;
+};
+
+float4 main(v2f IN) : SV_TARGET0 {
+    return float4(0.5f, 0.5f, 0.5f, 1.0f);
+}
@@ -0,0 +1,25 @@
+// https://microsoft.github.io/DirectX-Specs/d3d/HLSL_SM_6_6_DynamicResources.html
+#define ROOT_SIG                                                                \
+    "RootFlags(CBV_SRV_UAV_HEAP_DIRECTLY_INDEXED | SAMPLER_HEAP_DIRECTLY_INDEXED)" \
+    ", CBV(b0, visibility=SHADER_VISIBILITY_VERTEX, flags=DATA_STATIC)"         \
+    ", RootConstants(num32BitConstants=3, b1)"
+
+struct DrawConstants {
+    uint vertexBufferIndex;
+    uint materialIndex;     // Material textures are contiguous, base color first
+    uint samplerIndex;
+};
+
+ConstantBuffer<DrawConstants> Draw : register(b1);
+
+struct v2f {
+    float4 position     : SV_POSITION;
+    float2 uv0          : TEXCOORD0;
+};
+
+[RootSignature(ROOT_SIG)]
+float4 main(v2f IN) : SV_TARGET0 {
+    Texture2D<float4> albedoTex = ResourceDescriptorHeap[Draw.materialIndex];
+    SamplerState materialSampler = SamplerDescriptorHeap[Draw.samplerIndex];
+    return albedoTex.Sample(materialSampler, IN.uv0);
+}
@@ -0,0 +1,43 @@
+// https://microsoft.github.io/DirectX-Specs/d3d/HLSL_SM_6_6_DynamicResources.html
+#define ROOT_SIG                                                                \
+    "RootFlags(CBV_SRV_UAV_HEAP_DIRECTLY_INDEXED | SAMPLER_HEAP_DIRECTLY_INDEXED)" \
+    ", CBV(b0, visibility=SHADER_VISIBILITY_VERTEX, flags=DATA_STATIC)"         \
+    ", RootConstants(num32BitConstants=3, b1)"
+
+struct Constants {
+    float4x4 matW;
+    float4x4 matVP;
+};
+
+struct DrawConstants {
+    uint vertexBufferIndex;
+    uint materialIndex;
+    uint samplerIndex;
+};
+
+struct a2v {
+    float3 position;
+    float3 normal;
+    float2 uv0;
+};
+
+struct v2f {
+    float4 position     : SV_POSITION;
+    float2 uv0          : TEXCOORD0;
+};
+
+ConstantBuffer<Constants> Globals : register(b0);
+ConstantBuffer<DrawConstants> Draw : register(b1);
+
+[RootSignature(ROOT_SIG)]
+v2f main(uint vid : SV_VertexID) {
+    StructuredBuffer<a2v> vertexBuffer = ResourceDescriptorHeap[Draw.vertexBufferIndex];
+    a2v IN = vertexBuffer[vid];
+    v2f OUT;
+
+    float4 positionW = mul(float4(IN.position, 1.0f), Globals.matW);
+    OUT.position = mul(positionW, Globals.matVP);
+    OUT.uv0 = IN.uv0;
+
+    return OUT;
+}
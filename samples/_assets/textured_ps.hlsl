@@ -7,13 +7,13 @@
     "    SRV(t1)"                                                               \
     "    , visibility=SHADER_VISIBILITY_PIXEL"                                  \
     "  )"                                                                       \
-    ", StaticSampler(s0"                                                        \
-    "    , filter=FILTER_MIN_MAG_MIP_LINEAR"                                    \
+    ", DescriptorTable("                                                        \
+    "    Sampler(s0)"                                                           \
     "    , visibility=SHADER_VISIBILITY_PIXEL"                                  \
     "  )"
 
 Texture2D<float4> albedoTex : register(t1);
-SamplerState linearSampler : register(s0);
+SamplerState materialSampler : register(s0);
 
 struct v2f {
     float4 position     : SV_POSITION;
@@ -22,6 +22,6 @@ struct v2f {
 
 [RootSignature(ROOT_SIG)]
 float4 main(v2f IN) : SV_TARGET0 {
-    return albedoTex.Sample(linearSampler, IN.uv0);
+    return albedoTex.Sample(materialSampler, IN.uv0);
 }
 
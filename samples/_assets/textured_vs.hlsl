@@ -7,8 +7,8 @@
     "    SRV(t1)"                                                               \
     "    , visibility=SHADER_VISIBILITY_PIXEL"                                  \
     "  )"                                                                       \
-    ", StaticSampler(s0"                                                        \
-    "    , filter=FILTER_MIN_MAG_MIP_LINEAR"                                    \
+    ", DescriptorTable("                                                        \
+    "    Sampler(s0)"                                                           \
     "    , visibility=SHADER_VISIBILITY_PIXEL"                                  \
     "  )"
 
@@ -4,42 +4,88 @@
 #include <DirectXMath.h>
 #include <filesystem>
 #include <fstream>
+#include <thread>
 using namespace std;
 
 const int32_t kFrameCount = 3;
+const uint32_t kFrameLatency = 2;                       // 1 to 4, keys 1-4 change it at runtime
+const int32_t kFrameResourceCount = fastdx::FramePacer::kMaxLatency;
+const bool kUseBindless = true;
+const uint32_t kRecordThreadCount = 4;
+const uint32_t kFrameConstantsSizeInBytes = 64 * 1024;
+const uint32_t kDrawArgumentsSizeInBytes = 256 * 1024;
+const uint32_t kStaticDescriptorCount = 1024;
+const uint32_t kTransientDescriptorCountPerFrame = 1024;
 const DXGI_FORMAT kFrameFormat = DXGI_FORMAT_R10G10B10A2_UNORM;
 const D3D12_CLEAR_VALUE kClearDepth = { DXGI_FORMAT_D32_FLOAT, {1.0f, 0} };
 const D3D12_CLEAR_VALUE kClearRenderTarget = { kFrameFormat, { 0.0f, 0.2f, 0.4f, 1.0f } };
+const float kSceneRotationSpeed = 1.0f;                 // Radians per second
 fastdx::WindowProperties windowProp;
 
 fastdx::D3D12DeviceWrapperPtr device;
 fastdx::ID3D12CommandQueuePtr commandQueue;
-fastdx::ID3D12CommandAllocatorPtr commandAllocators[kFrameCount];
-fastdx::ID3D12GraphicsCommandListPtr commandList;
+fastdx::CommandContextPoolPtr commandContexts;
+fastdx::WorkerPoolPtr recordWorkers;                // Persistent, the main thread records one part
+fastdx::ID3D12GraphicsCommandListPtr commandList;   // Main thread context, slot 0
 fastdx::IDXGISwapChainPtr swapChain;
 fastdx::ID3D12DescriptorHeapPtr swapChainRtvHeap;
 fastdx::ID3D12DescriptorHeapPtr depthStencilViewHeap;
-fastdx::ID3D12PipelineStatePtr pipelineState;
+fastdx::ShaderVisibleDescriptorHeapPtr shaderDescriptorHeap;
+fastdx::BindlessResourceTablePtr bindlessTable;
+fastdx::ShaderVisibleDescriptorHeapPtr samplerDescriptorHeap;
+fastdx::SamplerCachePtr samplerCache;
+fastdx::AsyncPipelineCompilerPtr pipelineCompiler;
+fastdx::ReloadablePipelineStatePtr pipelineState;
+fastdx::ShaderHotReloaderPtr shaderHotReloader;
 fastdx::ID3D12RootSignaturePtr pipelineRootSignature;
+fastdx::IndirectArgumentLayout drawArgumentLayout;
+uint32_t drawIndexBufferArgument, drawConstantsArgument, drawIndexedArgument;
+fastdx::ID3D12CommandSignaturePtr drawCommandSignature;
 vector<fastdx::ID3D12ResourcePtr> renderTargets;
-fastdx::ID3D12ResourcePtr depthStencilTarget;
-vector<uint8_t> vertexShader, pixelShader;
-fastdx::ID3D12ResourcePtr sceneConstantBuffer[kFrameCount];
-std::vector<fastdx::ID3D12ResourcePtr> uploadBuffers;
-
-// Frame Sync
-int32_t frameIndex = 0;
-HANDLE fenceEvent;
-fastdx::ID3D12FencePtr swapFence;
-uint64_t swapFenceCounter = 0;
-uint64_t swapFenceWaitValue[kFrameCount] = {};
+D3D12_RESOURCE_DESC depthStencilResourceDesc;
+fastdx::RenderGraphPtr renderGraph;
+fastdx::ShaderLibrary shaderLibrary;
+D3D12_SHADER_BYTECODE vertexShader, pixelShader;
+fastdx::ConstantBufferAllocatorPtr frameConstants;
+fastdx::ConstantBufferAllocatorPtr drawArguments;
+fastdx::DeferredReleaseQueue releaseQueue;
+fastdx::ResourceStateTracker resourceStates;
+
+// Frame Sync, per-frame resources are indexed by frame slot and render targets by back buffer
+fastdx::FrameContextPtr frameContext;
+uint32_t frameSlot = 0;
+fastdx::FrameStatisticsPtr frameStatistics(new fastdx::FrameStatistics());
+fastdx::GpuProfilerPtr gpuProfiler;
 
 // GlTF Model
 vector<fastdx::ID3D12ResourcePtr> gltfVertexBuffers, gltfIndexBuffers;
 vector<D3D12_INDEX_BUFFER_VIEW> gltfIndexBuffersView;
 vector<vector<fastdx::ID3D12ResourcePtr>> gltfMaterialToTextures;
-vector<D3D12_GPU_DESCRIPTOR_HANDLE> gltfTextureDescriptorsHeapStart;
-fastdx::ID3D12DescriptorHeapPtr gltfTexturesViewHeap;
+vector<fastdx::DescriptorRange> gltfVertexBufferDescriptors, gltfMaterialDescriptors, gltfMaterialSamplers;
+vector<DirectX::XMFLOAT3> gltfMeshPartCenters;
+vector<uint32_t> gltfMeshPartMaterials;             // Index into the gltfMaterial* tables
+fastdx::DrawPacketQueue drawPackets;
+vector<ID3D12Pageable*> frameResources;             // Marked used by the frame being recorded
+fastdx::CommandStream sceneStream;
+fastdx::CommandStream recordStreams[kRecordThreadCount];
+bool useExecuteIndirect = true;                     // Requires kUseBindless, key I toggles it at runtime
+uint64_t droppedIndirectDrawCount = 0;              // Draws that did not fit the argument buffer
+
+// Shaders packed into one mapped archive, named by file stem. tools/shader_pack packs the .cso files after each
+// build of the project, or with kUseShaderBuilder the HLSL is compiled by DXC and only changed shaders are rebuilt.
+// The builder also hot reloads, saved edits to the HLSL are rebuilt in the background and swapped in
+const bool kUseShaderBuilder = false;
+const wchar_t* kShaderCompilerPath = L"dxc.exe";
+const wchar_t* kShaderSourceDirectory = L"../../../_assets";     // From samples/glTF/x64/<Configuration>
+const wchar_t* kShaderLibraryFileName = L"shaders.fdxs";
+struct ShaderFile { const wchar_t* name; const char* target; };
+const ShaderFile kShaderFiles[] = { { L"textured_vs", "vs_6_5" }, { L"textured_ps", "ps_6_5" },
+    { L"textured_bindless_vs", "vs_6_6" }, { L"textured_bindless_ps", "ps_6_6" }, { L"fallback_ps", "ps_6_5" } };
+
+// Frame Capture, F12 saves the next frame and F11 benchmarks replay of the saved one
+const wchar_t* kCaptureFileName = L"frame.fdxcap";
+const uint32_t kReplayIterationCount = 1000;
+bool isCaptureRequested = false;
 
 // Scene Constant Buffer
 struct SceneGlobals { // On x64 we can guarantee 16B alignment
@@ -48,6 +94,10 @@ struct SceneGlobals { // On x64 we can guarantee 16B alignment
 };
 SceneGlobals sceneGlobals = {};
 
+// Simulated at a fixed step, draws interpolate between the last two steps
+float sceneAngleY = 0.0f;
+float previousSceneAngleY = 0.0f;
+
 
 void memcpyToInterleaved(uint8_t* dest, size_t destStrideInBytes, const uint8_t* src, size_t srcStrideInBytes, size_t srcSizeInBytes) {
     assert(srcSizeInBytes % srcStrideInBytes == 0);
@@ -66,6 +116,7 @@ wstring getPathInModule(const wstring& filePath) {
 }
 
 bool readGltfModel(const wstring& filePath, tinygltf::Model* outModel) {
+    FASTDX_PROFILE_FUNCTION();
     tinygltf::TinyGLTF loader;
     wstring warn, err;
     bool isLoaded = loader.LoadASCIIFromFile(outModel, &err, &warn, getPathInModule(filePath));
@@ -76,25 +127,57 @@ bool readGltfModel(const wstring& filePath, tinygltf::Model* outModel) {
     return isLoaded;
 }
 
-HRESULT readShader(const wstring& filePath, vector<uint8_t>& outShaderData) {
-    auto fullFilePath = getPathInModule(filePath);
-    ifstream file(fullFilePath, ios::binary);
-    if (file) {
-        uintmax_t fileSize = filesystem::file_size(fullFilePath);
-        outShaderData.resize(fileSize);
-        file.read(reinterpret_cast<char*>(outShaderData.data()), fileSize);
+fastdx::ShaderPermutationBuilder buildShaderLibrary(const filesystem::path& libraryPath) {
+    FASTDX_PROFILE_FUNCTION();
+    fastdx::ShaderPermutationBuilder builder(kShaderCompilerPath, getPathInModule(L"shader_cache"));
+    builder.addArgument("-O3");
+    for (const ShaderFile& shaderFile : kShaderFiles) {
+        builder.addSource(getPathInModule(kShaderSourceDirectory) + L"/" + shaderFile.name + L".hlsl", "main",
+            shaderFile.target);
+    }
+
+    fastdx::ShaderLibraryWriter libraryWriter;
+    fastdx::ShaderBuildStatistics statistics;
+    if (FAILED(builder.build(libraryWriter, &statistics))) {
+        for (const string& error : builder.errors()) {
+            OutputDebugStringA(error.c_str());
+        }
     }
-    return file ? S_OK : E_FAIL;
+    OutputDebugStringA(("Shader build: " + statistics.toJson() + "\n").c_str());
+    libraryWriter.save(libraryPath);
+    return builder;
+}
+
+HRESULT openShaderLibrary() {
+    FASTDX_PROFILE_FUNCTION();
+    filesystem::path libraryPath = getPathInModule(kShaderLibraryFileName);
+    if (kUseShaderBuilder) {
+        shaderHotReloader = fastdx::ShaderHotReloaderPtr(new fastdx::ShaderHotReloader(
+            buildShaderLibrary(libraryPath), getPathInModule(kShaderSourceDirectory), pipelineCompiler));
+        if (FAILED(shaderHotReloader->watchResult())) {
+            for (const string& error : shaderHotReloader->lastBuildErrors()) {
+                OutputDebugStringA((error + "\n").c_str());
+            }
+        }
+    }
+    return shaderLibrary.open(libraryPath);
 }
 
 void initializeD3d(HWND hwnd) {
+    FASTDX_PROFILE_FUNCTION();
     // Create a device and queue to dispatch command lists
     device = fastdx::createDevice(D3D_FEATURE_LEVEL_12_2);
     commandQueue = device->createCommandQueue(D3D12_COMMAND_LIST_TYPE_DIRECT);
 
     // Create heaps for render target views, depth stencil and shader parameters
     swapChainRtvHeap = device->createDescriptorHeap(kFrameCount, D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-    depthStencilViewHeap = device->createDescriptorHeap(1, D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
+    depthStencilViewHeap = device->createDescriptorHeap(kFrameResourceCount, D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
+    shaderDescriptorHeap = device->createShaderVisibleDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV,
+        kStaticDescriptorCount, kTransientDescriptorCountPerFrame, kFrameResourceCount);
+    bindlessTable = device->createBindlessResourceTable(shaderDescriptorHeap);
+    samplerDescriptorHeap = device->createShaderVisibleDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER,
+        D3D12_MAX_SHADER_VISIBLE_SAMPLER_HEAP_SIZE, 0, kFrameResourceCount);
+    samplerCache = device->createSamplerCache(samplerDescriptorHeap);
 
     // Create a triple frame buffer swap chain for window
     DXGI_SWAP_CHAIN_DESC1 swapChainDesc = fastdxu::swapChainDesc(hwnd, kFrameCount, kFrameFormat);
@@ -103,73 +186,69 @@ void initializeD3d(HWND hwnd) {
     // Create swap chain render targets views in heap
     renderTargets = device->createRenderTargetViews(swapChain, swapChainRtvHeap);
 
-    // Create depth stencil resource
-    D3D12_HEAP_PROPERTIES defaultHeapProps = { D3D12_HEAP_TYPE_DEFAULT };
-    D3D12_RESOURCE_DESC depthStencilResourceDesc = fastdxu::resourceTexDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D,
+    // Depth stencil is a render graph transient, placed in the graph heap of each frame
+    depthStencilResourceDesc = fastdxu::resourceTexDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D,
         swapChainDesc.Width, swapChainDesc.Height, 1, DXGI_FORMAT_D32_FLOAT, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
-
-    depthStencilTarget = device->createCommittedResource(defaultHeapProps, D3D12_HEAP_FLAG_NONE,
-        depthStencilResourceDesc, D3D12_RESOURCE_STATE_DEPTH_WRITE, &kClearDepth);
-
-    // Create depth stencil render target view in heap
-    D3D12_DEPTH_STENCIL_VIEW_DESC depthStencilDesc = {};
-    depthStencilDesc.Format = DXGI_FORMAT_D32_FLOAT;
-    depthStencilDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
-    device->createDepthStencilView(depthStencilTarget, depthStencilDesc,
-        depthStencilViewHeap->GetCPUDescriptorHandleForHeapStart());
-
-    // Create one command allocator per frame buffer
-    for (int32_t i = 0; i < kFrameCount; ++i) {
-        commandAllocators[i] = device->createCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT);
+    renderGraph = device->createRenderGraph(kFrameResourceCount);
+
+    // Command lists per recording thread, allocators are recycled as frames complete
+    commandContexts = device->createCommandContextPool(D3D12_COMMAND_LIST_TYPE_DIRECT);
+    recordWorkers = std::make_shared<fastdx::WorkerPool>(kRecordThreadCount, "Record");
+
+    // Frame pacing, waits for a completed frame only when kFrameLatency frames ahead of the GPU
+    frameContext = device->createFrameContext(commandQueue, D3D12_COMMAND_LIST_TYPE_DIRECT, kFrameLatency);
+    gpuProfiler = device->createGpuProfiler(commandQueue);
+
+    // Pipeline states compile on a worker, loaded from the pipeline library of the previous run when unchanged
+    device->pipelineStateCache()->load(getPathInModule(L"pipelines.cache"));
+    pipelineCompiler = device->createAsyncPipelineCompiler();
+
+    // Map VS, PS from the shader library and Create root signature for shader
+    // Bindless shaders index ResourceDescriptorHeap, draws only set root constants
+    const char* vertexShaderName = kUseBindless ? "textured_bindless_vs" : "textured_vs";
+    const char* pixelShaderName = kUseBindless ? "textured_bindless_ps" : "textured_ps";
+    if (FAILED(openShaderLibrary())) {
+        OutputDebugString(L"Cannot open shaders.fdxs, packed by shader_pack when the project builds\n");
     }
+    vertexShader = shaderLibrary.shader(vertexShaderName);
+    pixelShader = shaderLibrary.shader(pixelShaderName);
+    pipelineRootSignature = device->createRootSignature(0, vertexShader.pShaderBytecode, vertexShader.BytecodeLength);
 
-    // Single command list will reuse all allocators
-    commandList = device->createCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocators[0]);
-    commandList->Close();
-
-    // Fence to wait for a completed frame to reuse
-    swapFence = device->createFence(swapFenceCounter++, D3D12_FENCE_FLAG_NONE);
-    fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-
-    // Read VS, PS and Create root signature for shader
-    readShader(L"textured_vs.cso", vertexShader);
-    readShader(L"textured_ps.cso", pixelShader);
-    pipelineRootSignature = device->createRootSignature(0, vertexShader.data(), vertexShader.size());
-
-    // Create a pipeline state
     D3D12_GRAPHICS_PIPELINE_STATE_DESC pipelineDesc = fastdxu::defaultGraphicsPipelineDesc(kFrameFormat);
     pipelineDesc.pRootSignature = pipelineRootSignature.get();
-    pipelineDesc.VS = { vertexShader.data(), vertexShader.size() };
-    pipelineDesc.PS = { pixelShader.data(), pixelShader.size() };
-    pipelineState = device->createGraphicsPipelineState(pipelineDesc);
+    pipelineDesc.VS = vertexShader;
+    pipelineDesc.PS = pixelShader;
+
+    // Drawn with a flat color until the scene's pipeline is compiled, the trivial pixel shader compiles quickly
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC fallbackPipelineDesc = pipelineDesc;
+    fallbackPipelineDesc.PS = shaderLibrary.shader("fallback_ps");
+    fastdx::ID3D12PipelineStatePtr fallbackPipelineState =
+        device->pipelineStateCache()->graphicsPipelineState(fallbackPipelineDesc);
+    pipelineState = fastdx::ReloadablePipelineStatePtr(new fastdx::ReloadablePipelineState(
+        pipelineCompiler->compile(pipelineDesc, fallbackPipelineState)));
+    if (shaderHotReloader) {
+        shaderHotReloader->addPipeline(pipelineState, pipelineDesc, vertexShaderName, pixelShaderName);
+    }
+
+    // Whole scene in one ExecuteIndirect, each command sets the index buffer and the draw root constants
+    if (kUseBindless) {
+        drawIndexBufferArgument = drawArgumentLayout.addIndexBufferView();
+        drawConstantsArgument = drawArgumentLayout.addConstants(1, 3);
+        drawIndexedArgument = drawArgumentLayout.addDrawIndexed();
+        drawCommandSignature = device->createCommandSignature(drawArgumentLayout, pipelineRootSignature);
+        drawArguments = device->createConstantBufferAllocator(kFrameResourceCount, kDrawArgumentsSizeInBytes);
+    }
 }
 
 void startCommandList() {
-    // Get and reset allocator for current frame, then point command list to it
-    auto commandAllocator = commandAllocators[frameIndex];
-    commandAllocator->Reset();
-    commandList->Reset(commandAllocator.get(), nullptr);
+    // Recycle allocators of completed frames, then open the main thread context
+    commandContexts->beginFrame(frameContext->completedFenceValue());
+    commandList = commandContexts->acquire(0).commandList;
 }
 
 void executeCommandList() {
-    // Close and dispatch command
-    commandList->Close();
-    ID3D12CommandList* commandLists[] = { commandList.get() };
-    commandQueue->ExecuteCommandLists(_countof(commandLists), commandLists);
-}
-
-void waitGpu(bool forceWait = false) {
-    // Queue always signal increasing counter values
-    commandQueue->Signal(swapFence.get(), swapFenceCounter);
-    swapFenceWaitValue[frameIndex] = swapFenceCounter++;
-
-    // Wait if next frame not ready
-    int32_t nextFrameIndex = swapChain->GetCurrentBackBufferIndex();
-    if (swapFence->GetCompletedValue() < swapFenceWaitValue[nextFrameIndex] || forceWait) {
-        swapFence->SetEventOnCompletion(swapFenceWaitValue[nextFrameIndex], fenceEvent);
-        WaitForSingleObjectEx(fenceEvent, INFINITE, FALSE);
-    }
-    frameIndex = nextFrameIndex;
+    // Close and dispatch every recorded context at once, the frame context signals frameFenceValue() next
+    commandContexts->submit(commandQueue, frameContext->frameFenceValue());
 }
 
 fastdx::ID3D12ResourcePtr createTextureBufferResource(const D3D12_RESOURCE_DESC& textureDesc, const void* dataPtr,
@@ -200,12 +279,12 @@ fastdx::ID3D12ResourcePtr createTextureBufferResource(const D3D12_RESOURCE_DESC&
     D3D12_TEXTURE_COPY_LOCATION dstRegion = { resource.get(), D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX, subresourceIndex };
     commandList->CopyTextureRegion(&dstRegion, 0, 0, 0, &srcRegion, nullptr);
 
-    // Transition Barrier
-    D3D12_RESOURCE_BARRIER transitionBarrier = fastdxu::resourceBarrierTransition(resource,
-        D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-    commandList->ResourceBarrier(1, &transitionBarrier);
+    // Transition is batched with the other uploads until the next flush
+    resourceStates.track(resource.get(), D3D12_RESOURCE_STATE_COPY_DEST);
+    resourceStates.transition(resource.get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 
-    uploadBuffers.push_back(cpuToGpuResource);
+    // Upload buffer is read by the copy above, release it once the next signaled fence value completes
+    releaseQueue.release(cpuToGpuResource, frameContext->frameFenceValue());
     return resource;
 }
 
@@ -237,11 +316,10 @@ fastdx::ID3D12ResourcePtr createBufferResource(const void* dataPtr, int32_t size
         // Issue GPU CopyResource command
         commandList->CopyResource(resource.get(), cpuToGpuResource.get());
 
-        D3D12_RESOURCE_BARRIER transitionBarrier = fastdxu::resourceBarrierTransition(resource,
-            D3D12_RESOURCE_STATE_COPY_DEST, bufferState);
-        commandList->ResourceBarrier(1, &transitionBarrier);
+        resourceStates.track(resource.get(), D3D12_RESOURCE_STATE_COPY_DEST);
+        resourceStates.transition(resource.get(), bufferState);
 
-        uploadBuffers.push_back(cpuToGpuResource);
+        releaseQueue.release(cpuToGpuResource, frameContext->frameFenceValue());
         return resource;
     }
     // Not supported
@@ -257,20 +335,19 @@ void createSceneConstantBuffer() {
     auto matView = DirectX::XMMatrixLookAtLH(XMLoadFloat3(&eye), XMLoadFloat3(&lookAt), XMLoadFloat3(&upVec));
     auto matProj = DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PI / 3.0f, windowProp.aspectRatio(), 0.1f, 1000.0f);
 
-    uint32_t cbSizeInBytes = sizeof(sceneGlobals);
     sceneGlobals.matW = DirectX::XMMatrixIdentity();
     sceneGlobals.matVP = DirectX::XMMatrixTranspose(matView * matProj); // HLSL expects column-major
 
-    // Create constant buffer resource and its view for shader
-    for (int i = 0; i < kFrameCount; ++i) {
-        sceneConstantBuffer[i] = createBufferResource(&sceneGlobals, cbSizeInBytes,
-            D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER, D3D12_HEAP_TYPE_UPLOAD);
-    }
+    // Persistently mapped per-frame constants, sub-allocated every frame in draw()
+    frameConstants = device->createConstantBufferAllocator(kFrameResourceCount, kFrameConstantsSizeInBytes);
 }
 
-/// Return one VB/IB pair for each mesh part of each mesh
+/// Return one VB/IB pair, one VB view and one bounds center for each mesh part of each mesh
 void loadGltfModelMeshes(const tinygltf::Model& gltfModel, vector<fastdx::ID3D12ResourcePtr>& outVertexBuffers,
-    vector<fastdx::ID3D12ResourcePtr>& outIndexBuffers, vector<D3D12_INDEX_BUFFER_VIEW>& outIndexBuffersView) {
+    vector<fastdx::ID3D12ResourcePtr>& outIndexBuffers, vector<D3D12_INDEX_BUFFER_VIEW>& outIndexBuffersView,
+    fastdx::BindlessResourceTablePtr resourceTable, vector<fastdx::DescriptorRange>& outVertexBufferDescriptors,
+    vector<DirectX::XMFLOAT3>& outMeshPartCenters, vector<uint32_t>& outMeshPartMaterials) {
+    FASTDX_PROFILE_FUNCTION();
 
     vector<const tinygltf::Mesh*> meshes;
     for (const auto &scene : gltfModel.scenes) {
@@ -294,6 +371,7 @@ void loadGltfModelMeshes(const tinygltf::Model& gltfModel, vector<fastdx::ID3D12
         for (auto meshPart : mesh->primitives) {
             uint8_t* vbDataPtr = nullptr;
             int32_t vbNumElements = 0;
+            DirectX::XMFLOAT3 center(0.0f, 0.0f, 0.0f);
 
             for (const auto& attrib : meshPart.attributes) {
                 auto attribName = attrib.first;
@@ -328,6 +406,15 @@ void loadGltfModelMeshes(const tinygltf::Model& gltfModel, vector<fastdx::ID3D12
 
                 int32_t attribStrideInBytes = attribAccessor.ByteStride(attribBufferView);
                 memcpyToInterleaved(vbCopyToPtr, vbStrideInBytes, attribDataPtr, attribStrideInBytes, attribBufferView.byteLength);
+
+                // glTF requires POSITION bounds, used for the draw depth sort
+                if (attribName == "POSITION" && attribAccessor.minValues.size() == 3 &&
+                    attribAccessor.maxValues.size() == 3) {
+                    center = DirectX::XMFLOAT3(
+                        static_cast<float>(attribAccessor.minValues[0] + attribAccessor.maxValues[0]) * 0.5f,
+                        static_cast<float>(attribAccessor.minValues[1] + attribAccessor.maxValues[1]) * 0.5f,
+                        static_cast<float>(attribAccessor.minValues[2] + attribAccessor.maxValues[2]) * 0.5f);
+                }
             }
 
             auto indexAccessor = gltfModel.accessors[meshPart.indices];
@@ -349,20 +436,66 @@ void loadGltfModelMeshes(const tinygltf::Model& gltfModel, vector<fastdx::ID3D12
             auto indexBufferView = fastdxu::indexBufferView(indexBuffer->GetGPUVirtualAddress(),
                 ibNumElements * ibStrideInBytes, DXGI_FORMAT_R16_UINT);
 
+            // Structured buffer view with a stable bindless index
+            D3D12_SHADER_RESOURCE_VIEW_DESC vertexBufferViewDesc = fastdxu::shaderResourceViewDesc(
+                D3D12_SRV_DIMENSION_BUFFER, DXGI_FORMAT_UNKNOWN);
+            vertexBufferViewDesc.Buffer.NumElements = vbNumElements;
+            vertexBufferViewDesc.Buffer.StructureByteStride = vbStrideInBytes;
+            auto vertexBufferDescriptor = resourceTable->addShaderResourceView(vertexBuffer, vertexBufferViewDesc);
+
             SAFE_FREE(vbDataPtr);
             SAFE_FREE(ibDataPtr);
 
             outVertexBuffers.push_back(vertexBuffer);
             outIndexBuffers.push_back(indexBuffer);
             outIndexBuffersView.push_back(indexBufferView);
+            outVertexBufferDescriptors.push_back(vertexBufferDescriptor);
+            outMeshPartCenters.push_back(center);
+
+            assert(meshPart.material >= 0 || !"Our shader require a material!");
+            outMeshPartMaterials.push_back(static_cast<uint32_t>(std::max(meshPart.material, 0)));
         }
     }
 }
 
+D3D12_TEXTURE_ADDRESS_MODE gltfAddressMode(int32_t wrapMode) {
+    switch (wrapMode) {
+    case TINYGLTF_TEXTURE_WRAP_CLAMP_TO_EDGE: return D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+    case TINYGLTF_TEXTURE_WRAP_MIRRORED_REPEAT: return D3D12_TEXTURE_ADDRESS_MODE_MIRROR;
+    default: return D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+    }
+}
+
+/// Undefined filters default to linear. Min filters without mipmapping clamp sampling to the top mip
+D3D12_SAMPLER_DESC gltfSamplerDesc(const tinygltf::Sampler& sampler) {
+    D3D12_FILTER_TYPE minFilter = D3D12_FILTER_TYPE_LINEAR;
+    D3D12_FILTER_TYPE mipFilter = D3D12_FILTER_TYPE_LINEAR;
+    bool usesMipmaps = true;
+    switch (sampler.minFilter) {
+    case TINYGLTF_TEXTURE_FILTER_NEAREST: minFilter = D3D12_FILTER_TYPE_POINT; usesMipmaps = false; break;
+    case TINYGLTF_TEXTURE_FILTER_LINEAR: usesMipmaps = false; break;
+    case TINYGLTF_TEXTURE_FILTER_NEAREST_MIPMAP_NEAREST: minFilter = mipFilter = D3D12_FILTER_TYPE_POINT; break;
+    case TINYGLTF_TEXTURE_FILTER_LINEAR_MIPMAP_NEAREST: mipFilter = D3D12_FILTER_TYPE_POINT; break;
+    case TINYGLTF_TEXTURE_FILTER_NEAREST_MIPMAP_LINEAR: minFilter = D3D12_FILTER_TYPE_POINT; break;
+    default: break;
+    }
+    D3D12_FILTER_TYPE magFilter = (sampler.magFilter == TINYGLTF_TEXTURE_FILTER_NEAREST) ?
+        D3D12_FILTER_TYPE_POINT : D3D12_FILTER_TYPE_LINEAR;
+
+    D3D12_SAMPLER_DESC desc = fastdxu::samplerDesc(
+        D3D12_ENCODE_BASIC_FILTER(minFilter, magFilter, mipFilter, D3D12_FILTER_REDUCTION_TYPE_STANDARD));
+    desc.AddressU = gltfAddressMode(sampler.wrapS);
+    desc.AddressV = gltfAddressMode(sampler.wrapT);
+    desc.MaxLOD = usesMipmaps ? D3D12_FLOAT32_MAX : 0.0f;
+    return desc;
+}
+
 void loadGltfModelMaterials(const tinygltf::Model& gltfModel,
     vector<vector<fastdx::ID3D12ResourcePtr>>& outMaterialToTextures,
-    vector<D3D12_GPU_DESCRIPTOR_HANDLE>& outTextureDescriptorsHeapStart,
-    fastdx::ID3D12DescriptorHeapPtr* outTexturesViewHeap) {
+    vector<fastdx::DescriptorRange>& outMaterialDescriptors,
+    vector<fastdx::DescriptorRange>& outMaterialSamplers,
+    fastdx::BindlessResourceTablePtr resourceTable, fastdx::SamplerCachePtr samplerCache) {
+    FASTDX_PROFILE_FUNCTION();
 
     map<int32_t, pair<D3D12_RESOURCE_DESC, fastdx::ID3D12ResourcePtr>> imageIdToTexture;
     vector<pair<D3D12_RESOURCE_DESC, fastdx::ID3D12ResourcePtr>> textureIdToTexture;
@@ -391,16 +524,13 @@ void loadGltfModelMaterials(const tinygltf::Model& gltfModel,
     }
     imageIdToTexture.clear();
 
-    // Samplers - Not Implemented
+    // Samplers, equal glTF samplers share one descriptor
+    vector<fastdx::DescriptorRange> samplerIdToSampler;
     for (const auto& sampler : gltfModel.samplers) {
+        samplerIdToSampler.push_back(samplerCache->acquire(gltfSamplerDesc(sampler)));
+        assert(samplerIdToSampler.back().isValid() || !"Out of sampler descriptors!");
     }
-
-    int32_t descriptorsCount = ((gltfModel.materials.size() * 5) + 31) & ~31;
-    size_t descriptorSizeInBytes = device->getDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-    fastdx::ID3D12DescriptorHeapPtr texturesViewHeap = device->createDescriptorHeap(
-        descriptorsCount, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-    D3D12_CPU_DESCRIPTOR_HANDLE texturesCpuHandle = texturesViewHeap->GetCPUDescriptorHandleForHeapStart();
-    D3D12_GPU_DESCRIPTOR_HANDLE texturesGpuHandle = texturesViewHeap->GetGPUDescriptorHandleForHeapStart();
+    fastdx::DescriptorRange defaultSampler = samplerCache->acquire(gltfSamplerDesc(tinygltf::Sampler()));
 
     for (auto material : gltfModel.materials) {
         int32_t textureIds[] = {
@@ -410,9 +540,9 @@ void loadGltfModelMaterials(const tinygltf::Model& gltfModel,
             //, material.emissiveTexture.index      // Not supported
             //, material.occlusionTexture.index     // Not supported
         };
-        outTextureDescriptorsHeapStart.push_back(texturesGpuHandle);
 
         vector<fastdx::ID3D12ResourcePtr> texturesPtr;
+        vector<D3D12_SHADER_RESOURCE_VIEW_DESC> texturesViewDesc;
         for (int32_t i=0; i <_countof(textureIds); ++i) {
             int32_t textureId = textureIds[i];
 
@@ -430,88 +560,341 @@ void loadGltfModelMaterials(const tinygltf::Model& gltfModel,
                 D3D12_SRV_DIMENSION_TEXTURE2D, textureDesc.Format);
             imageViewDesc.Texture2D.MipLevels = textureDesc.MipLevels + 1;
 
-            device->createShaderResourceView(texturePtr, imageViewDesc, texturesCpuHandle);
-            texturesCpuHandle.ptr += descriptorSizeInBytes;
-            texturesGpuHandle.ptr += descriptorSizeInBytes;
-
             texturesPtr.push_back(texturePtr);
+            texturesViewDesc.push_back(imageViewDesc);
         }
+
+        // Material textures are contiguous: a descriptor table, or a bindless base index
+        auto materialDescriptors = resourceTable->addShaderResourceViews(static_cast<uint32_t>(texturesPtr.size()),
+            texturesPtr.data(), texturesViewDesc.data());
+        assert(materialDescriptors.isValid() || !"Out of static descriptors!");
+
+        // Shaders sample all material textures with the base color sampler
+        int32_t samplerId = (textureIds[0] != -1) ? gltfModel.textures[textureIds[0]].sampler : -1;
+        fastdx::DescriptorRange materialSampler = (samplerId != -1) ? samplerIdToSampler[samplerId] : defaultSampler;
+
+        outMaterialDescriptors.push_back(materialDescriptors);
+        outMaterialSamplers.push_back(materialSampler);
         outMaterialToTextures.push_back(std::move(texturesPtr));
     }
-    *outTexturesViewHeap = texturesViewHeap;
 }
 
 void update(float elapsedTimeSec) {
-    static float angleY = 0.0f;
-    angleY -= elapsedTimeSec * 0.001f;
-    sceneGlobals.matW = DirectX::XMMatrixRotationY(angleY);
+    previousSceneAngleY = sceneAngleY;
+    sceneAngleY -= elapsedTimeSec * kSceneRotationSpeed;
+}
 
-    uint8_t* dataMapPtr = nullptr;
-    sceneConstantBuffer[frameIndex]->Map(0, nullptr, reinterpret_cast<void**>(&dataMapPtr));
-    memcpy(dataMapPtr, &sceneGlobals, sizeof(sceneGlobals));
-    sceneConstantBuffer[frameIndex]->Unmap(0, nullptr);
+/// Records sorted draw packets [begin, end) on its own list, which starts without any pipeline state
+template <typename CommandListType>
+void setSceneState(CommandListType& drawList, D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle,
+    D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle, D3D12_GPU_VIRTUAL_ADDRESS sceneConstantsAddress) {
+    D3D12_VIEWPORT viewport = { 0, 0, static_cast<float>(windowProp.width), static_cast<float>(windowProp.height),
+        D3D12_MIN_DEPTH, D3D12_MAX_DEPTH };
+    D3D12_RECT scissorRect = { 0, 0, windowProp.width, windowProp.height };
+
+    drawList.setViewports(1, &viewport);
+    drawList.setScissorRects(1, &scissorRect);
+    drawList.setRenderTargets(1, &rtvHandle, &dsvHandle);
+
+    drawList.setPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    drawList.setGraphicsRootSignature(pipelineRootSignature.get());
+    drawList.setGraphicsRootConstantBufferView(0, sceneConstantsAddress);
+
+    ID3D12DescriptorHeap* shaderHeaps[] = { shaderDescriptorHeap->heap().get(), samplerDescriptorHeap->heap().get() };
+    drawList.setDescriptorHeaps(_countof(shaderHeaps), shaderHeaps);
 }
 
-void draw() {
+template <typename CommandListType>
+void recordMeshParts(CommandListType& drawList, uint32_t begin, uint32_t end, D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle,
+    D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle, D3D12_GPU_VIRTUAL_ADDRESS sceneConstantsAddress) {
+    setSceneState(drawList, rtvHandle, dsvHandle, sceneConstantsAddress);
+
+    drawPackets.execute(begin, end, [&](const fastdx::DrawPacket& packet, uint32_t stateChanges) {
+        uint32_t i = packet.drawIndex;
+        uint32_t material = gltfMeshPartMaterials[i];
+
+        // Single pipeline for now
+        if (stateChanges & fastdx::DrawPacketQueue::kPipelineChanged) {
+            drawList.setPipelineState(pipelineState->current());
+        }
+
+        drawList.setIndexBuffer(gltfIndexBuffersView[i]);
+        if (kUseBindless) {
+            // Shaders fetch VB and textures by index, material constants only change with the material
+            if (stateChanges & fastdx::DrawPacketQueue::kMaterialChanged) {
+                uint32_t materialConstants[] = { gltfMaterialDescriptors[material].index,
+                    gltfMaterialSamplers[material].index };
+                drawList.setGraphicsRoot32BitConstants(1, _countof(materialConstants), materialConstants, 1);
+            }
+            drawList.setGraphicsRoot32BitConstant(1, gltfVertexBufferDescriptors[i].index, 0);
+        } else {
+            drawList.setGraphicsRootShaderResourceView(1, gltfVertexBuffers[i]->GetGPUVirtualAddress());
+
+            // Textures must use descriptor table
+            if (stateChanges & fastdx::DrawPacketQueue::kMaterialChanged) {
+                drawList.setGraphicsRootDescriptorTable(2, gltfMaterialDescriptors[material].gpuHandle);
+                drawList.setGraphicsRootDescriptorTable(3, gltfMaterialSamplers[material].gpuHandle);
+            }
+        }
+        drawList.drawIndexedInstanced(gltfIndexBuffersView[i].SizeInBytes / sizeof(uint16_t), 1, 0, 0, 0);
+    });
+}
+
+/// Return the argument buffer region read by the recorded ExecuteIndirect
+template <typename CommandListType>
+fastdx::ConstantBufferAllocation recordMeshPartsIndirect(CommandListType& drawList,
+    D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle, D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle,
+    D3D12_GPU_VIRTUAL_ADDRESS sceneConstantsAddress) {
+    // Pack one command per sorted draw packet into this frame region of the argument buffer, the draws that do
+    // not fit are dropped
+    drawArguments->beginFrame(frameSlot);
+    fastdx::ConstantBufferAllocation allocation = drawArguments->allocate(std::min(drawPackets.size() *
+        drawArgumentLayout.strideInBytes(), drawArguments->frameSizeInBytes()));
+    fastdx::IndirectArgumentWriter argumentWriter(drawArgumentLayout, allocation.cpuPtr, allocation.sizeInBytes);
+    for (const fastdx::DrawPacket& packet : drawPackets.packets()) {
+        uint32_t i = packet.drawIndex;
+        uint32_t material = gltfMeshPartMaterials[i];
+        if (!argumentWriter.beginCommand()) {
+            break;
+        }
+        uint32_t drawConstants[] = { gltfVertexBufferDescriptors[i].index, gltfMaterialDescriptors[material].index,
+            gltfMaterialSamplers[material].index };
+        argumentWriter.write(drawIndexBufferArgument, gltfIndexBuffersView[i]);
+        argumentWriter.write(drawConstantsArgument, drawConstants);
+        argumentWriter.write(drawIndexedArgument, D3D12_DRAW_INDEXED_ARGUMENTS{
+            gltfIndexBuffersView[i].SizeInBytes / static_cast<uint32_t>(sizeof(uint16_t)), 1, 0, 0, 0 });
+    }
+
+    uint32_t droppedDrawCount = drawPackets.size() - argumentWriter.commandCount();
+    if (droppedDrawCount > 0) {
+        // Logged once, the total is reported with the frame statistics
+        if (droppedIndirectDrawCount == 0) {
+            OutputDebugStringA(("Draw argument buffer full, " + to_string(droppedDrawCount) + " of " +
+                to_string(drawPackets.size()) + " draws dropped, raise kDrawArgumentsSizeInBytes\n").c_str());
+        }
+        droppedIndirectDrawCount += droppedDrawCount;
+    }
+
+    setSceneState(drawList, rtvHandle, dsvHandle, sceneConstantsAddress);
+    if (argumentWriter.commandCount() > 0) {
+        drawList.setPipelineState(pipelineState->current());
+        ID3D12Resource* argumentBuffer = drawArguments->buffer().get();
+        drawList.executeIndirect(drawCommandSignature.get(), argumentWriter.commandCount(), argumentBuffer,
+            allocation.gpuAddress - argumentBuffer->GetGPUVirtualAddress());
+    }
+    allocation.sizeInBytes = static_cast<uint32_t>(argumentWriter.sizeInBytes());
+    return allocation;
+}
+
+void captureFrame(const vector<fastdx::ConstantBufferAllocation>& referencedBuffers) {
+    // Copy the scene streams by replaying them, with the upload memory they point to
+    fastdx::FrameCapture frameCapture;
+    sceneStream.replay(frameCapture.addStream());
+    for (const fastdx::CommandStream& recordStream : recordStreams) {
+        recordStream.replay(frameCapture.addStream());
+    }
+    for (const auto& buffer : referencedBuffers) {
+        frameCapture.addBuffer(buffer.gpuAddress, buffer.cpuPtr, buffer.sizeInBytes);
+    }
+
+    HRESULT hr = frameCapture.save(getPathInModule(kCaptureFileName));
+    OutputDebugString(SUCCEEDED(hr) ? L"Frame captured\n" : L"Frame capture failed\n");
+}
+
+void benchmarkCapturedFrame() {
+    // Pure CPU replay cost of the saved frame, written as JSON next to the capture
+    fastdx::FrameCapture frameCapture;
+    if (FAILED(frameCapture.load(getPathInModule(kCaptureFileName)))) {
+        OutputDebugString(L"No frame capture to replay, press F12 first\n");
+        return;
+    }
+
+    string json = frameCapture.benchmark(kReplayIterationCount).toJson();
+    ofstream(filesystem::path(getPathInModule(L"frame_replay.json"))) << json << endl;
+    OutputDebugStringA((json + "\n").c_str());
+}
+
+void saveFrameStatistics() {
+    // Percentiles and histograms of the last frames, plus the raw times for plotting
+    ofstream(filesystem::path(getPathInModule(L"frame_statistics.csv"))) << frameStatistics->toCsv();
+    string json = frameStatistics->toJson();
+    ofstream(filesystem::path(getPathInModule(L"frame_statistics.json"))) << json << endl;
+    OutputDebugStringA((json + "\n").c_str());
+
+    // CPU timeline of the last frames on every thread, open in chrome://tracing or ui.perfetto.dev
+    fastdx::CpuProfiler::save(getPathInModule(L"cpu_trace.json"));
+
+    // GPU pass timings of the latest frame read back
+    const fastdx::GpuFrameTimings& gpuTimings = gpuProfiler->lastFrameTimings();
+    ofstream(filesystem::path(getPathInModule(L"gpu_timings.json"))) << gpuTimings.toJson() << endl;
+    OutputDebugStringA(gpuTimings.toString().c_str());
+
+    if (droppedIndirectDrawCount > 0) {
+        OutputDebugStringA(("Indirect draws dropped: " + to_string(droppedIndirectDrawCount) + "\n").c_str());
+    }
+}
+
+void draw(float alpha) {
     static D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = swapChainRtvHeap->GetCPUDescriptorHandleForHeapStart();
     static D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = depthStencilViewHeap->GetCPUDescriptorHandleForHeapStart();
     static size_t heapDescriptorSize = device->getDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-    D3D12_CPU_DESCRIPTOR_HANDLE frameRtvHandle = { rtvHandle.ptr + frameIndex * heapDescriptorSize };
+    static size_t dsvHeapDescriptorSize = device->getDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
 
-    static D3D12_RESOURCE_BARRIER transitionBarrier = fastdxu::resourceBarrierTransition(nullptr);
+    // Per-frame resources of this slot are free once this returns, drop resources the GPU no longer references
+    frameSlot = frameContext->beginFrame();
+    frameStatistics->addTime(fastdx::FrameTiming::GpuWait, frameContext->lastWaitTimeMs());
+    gpuProfiler->beginFrame(frameContext->completedFenceValue());
+    releaseQueue.retire(frameContext->completedFenceValue());
 
-    startCommandList();
-    {
-        // Present->RenderTarget barrier
-        transitionBarrier.Transition.pResource = renderTargets[frameIndex].get();
-        transitionBarrier.Transition.StateBefore = D3D12_RESOURCE_STATE_PRESENT;
-        transitionBarrier.Transition.StateAfter = D3D12_RESOURCE_STATE_RENDER_TARGET;
-        commandList->ResourceBarrier(1, &transitionBarrier);
-
-        D3D12_VIEWPORT viewport = { 0, 0, static_cast<float>(windowProp.width), static_cast<float>(windowProp.height),
-            D3D12_MIN_DEPTH, D3D12_MAX_DEPTH };
-        D3D12_RECT scissorRect = { 0, 0, windowProp.width, windowProp.height };
-
-        commandList->SetPipelineState(pipelineState.get());
-        commandList->RSSetViewports(1, &viewport);
-        commandList->RSSetScissorRects(1, &scissorRect);
-        commandList->OMSetRenderTargets(1, &frameRtvHandle, FALSE, &dsvHandle);
-
-        commandList->ClearRenderTargetView(frameRtvHandle, kClearRenderTarget.Color, 0, nullptr);
-        commandList->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH,
-            kClearDepth.DepthStencil.Depth, kClearDepth.DepthStencil.Stencil, 0, nullptr);
-
-        commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-        commandList->SetGraphicsRootSignature(pipelineRootSignature.get());
-        commandList->SetGraphicsRootConstantBufferView(0, sceneConstantBuffer[frameIndex]->GetGPUVirtualAddress());
-
-        // Draw all mesh parts
-        ID3D12DescriptorHeap* shaderTexturesHeaps[] = { gltfTexturesViewHeap.get() };
-        commandList->SetDescriptorHeaps(1, shaderTexturesHeaps);
-        for (int i = 0; i < gltfIndexBuffers.size(); ++i) {
-            commandList->IASetIndexBuffer(&gltfIndexBuffersView[i]);
-            commandList->SetGraphicsRootShaderResourceView(1, gltfVertexBuffers[i]->GetGPUVirtualAddress());
+    uint32_t backBufferIndex = swapChain->GetCurrentBackBufferIndex();
+    D3D12_CPU_DESCRIPTOR_HANDLE frameRtvHandle = { rtvHandle.ptr + backBufferIndex * heapDescriptorSize };
+    D3D12_CPU_DESCRIPTOR_HANDLE frameDsvHandle = { dsvHandle.ptr + frameSlot * dsvHeapDescriptorSize };
 
-            // Textures must use descriptor table
-            commandList->SetGraphicsRootDescriptorTable(2, gltfTextureDescriptorsHeapStart[i]);
-            commandList->DrawIndexedInstanced(gltfIndexBuffersView[i].SizeInBytes / sizeof(uint16_t), 1, 0, 0, 0);
+    // Keep video memory under budget, the model resources drawn are marked used below
+    device->residencyManager()->update(frameContext->completedFenceValue());
+
+    // Swap in pipelines rebuilt from edited shaders, replaced ones are released after this frame completes
+    if (shaderHotReloader) {
+        shaderHotReloader->update(releaseQueue, frameContext->frameFenceValue());
+    }
+
+    // Frame constants region is free, the GPU finished the frame that last used it
+    sceneGlobals.matW = DirectX::XMMatrixRotationY(previousSceneAngleY + (sceneAngleY - previousSceneAngleY) * alpha);
+    frameConstants->beginFrame(frameSlot);
+    fastdx::ConstantBufferAllocation sceneConstants = frameConstants->push(sceneGlobals);
+    shaderDescriptorHeap->beginFrame(frameSlot);
+
+    // Sort draws by pipeline, then material, then front to back. Mesh parts are drawn flat until the pipeline is
+    // compiled, or skipped if the fallback failed too
+    DirectX::XMMATRIX matViewProj = DirectX::XMMatrixTranspose(sceneGlobals.matVP);
+    uint32_t drawCount = (pipelineState->current() != nullptr) ? static_cast<uint32_t>(gltfIndexBuffers.size()) : 0;
+    drawPackets.clear();
+    for (uint32_t i = 0; i < drawCount; ++i) {
+        DirectX::XMVECTOR centerW = DirectX::XMVector3TransformCoord(DirectX::XMLoadFloat3(&gltfMeshPartCenters[i]),
+            sceneGlobals.matW);
+        float depth = DirectX::XMVectorGetZ(DirectX::XMVector3TransformCoord(centerW, matViewProj));
+        drawPackets.push(fastdx::DrawPacketQueue::sortKey(0, 0, static_cast<uint16_t>(gltfMeshPartMaterials[i]), depth),
+            i);
+    }
+    drawPackets.sort();
+
+    // Resources of every draw marked in one call, before the record threads start
+    frameResources.clear();
+    for (const fastdx::DrawPacket& packet : drawPackets.packets()) {
+        uint32_t i = packet.drawIndex;
+        frameResources.push_back(gltfIndexBuffers[i].get());
+        frameResources.push_back(gltfVertexBuffers[i].get());
+        for (const auto& texture : gltfMaterialToTextures[gltfMeshPartMaterials[i]]) {
+            frameResources.push_back(texture.get());
+        }
+    }
+    device->residencyManager()->markUsed(static_cast<uint32_t>(frameResources.size()), frameResources.data(),
+        frameContext->frameFenceValue());
+
+    // Single scene pass for now, the graph transitions the back buffer and places the depth buffer
+    renderGraph->reset();
+    uint32_t backBuffer = renderGraph->importResource("BackBuffer", renderTargets[backBufferIndex].get(),
+        D3D12_RESOURCE_STATE_PRESENT);
+    uint32_t depthBuffer = renderGraph->createTexture("DepthBuffer", depthStencilResourceDesc, &kClearDepth);
+
+    // Contexts are acquired in increasing slots, the graph takes one per pass plus one for final barriers
+    uint32_t nextSlot = 0;
+    uint32_t scenePass = renderGraph->addPass("Scene", [&](fastdx::ID3D12GraphicsCommandListPtr passList) {
+        D3D12_DEPTH_STENCIL_VIEW_DESC depthStencilDesc = {};
+        depthStencilDesc.Format = DXGI_FORMAT_D32_FLOAT;
+        depthStencilDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
+        device->d3dDevice()->CreateDepthStencilView(renderGraph->resource(depthBuffer), &depthStencilDesc,
+            frameDsvHandle);
+
+        // Depth may alias other transients, the clear initializes it
+        vector<fastdx::ConstantBufferAllocation> referencedBuffers = { sceneConstants };
+        sceneStream.reset();
+        sceneStream.clearRenderTargetView(frameRtvHandle, kClearRenderTarget.Color);
+        sceneStream.clearDepthStencilView(frameDsvHandle, D3D12_CLEAR_FLAG_DEPTH, kClearDepth.DepthStencil.Depth,
+            kClearDepth.DepthStencil.Stencil);
+
+        if (kUseBindless && useExecuteIndirect) {
+            for (fastdx::CommandStream& recordStream : recordStreams) {
+                recordStream.reset();
+            }
+            referencedBuffers.push_back(recordMeshPartsIndirect(sceneStream, frameRtvHandle, frameDsvHandle,
+                sceneConstants.gpuAddress));
+        } else {
+            // Draw all mesh parts, split across the workers recording command streams without touching D3D12
+            recordWorkers->run(kRecordThreadCount, [&](uint32_t t) {
+                FASTDX_PROFILE_SCOPE("recordMeshParts");
+                auto meshParts = fastdxu::partitionRange(drawPackets.size(), kRecordThreadCount, t);
+                recordStreams[t].reset();
+                recordMeshParts(recordStreams[t], meshParts.first, meshParts.second, frameRtvHandle,
+                    frameDsvHandle, sceneConstants.gpuAddress);
+            });
         }
 
-        // RenderTarget->Present barrier
-        transitionBarrier.Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
-        transitionBarrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PRESENT;
-        commandList->ResourceBarrier(1, &transitionBarrier);
+        if (isCaptureRequested) {
+            captureFrame(referencedBuffers);
+            isCaptureRequested = false;
+        }
+
+        // Replay in draw order, state repeated at the start of each stream is filtered
+        fastdx::CommandList drawList(passList);
+        fastdx::GpuProfilerScope sceneScope(gpuProfiler.get(), passList.get(), "Scene");
+        {
+            fastdx::GpuProfilerScope clearScope(gpuProfiler.get(), passList.get(), "Clear");
+            sceneStream.replay(drawList);
+        }
+        fastdx::GpuProfilerScope meshPartsScope(gpuProfiler.get(), passList.get(), "MeshParts");
+        for (const fastdx::CommandStream& recordStream : recordStreams) {
+            recordStream.replay(drawList);
+        }
+    });
+    renderGraph->write(scenePass, backBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    renderGraph->write(scenePass, depthBuffer, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+    renderGraph->compile();
+
+    startCommandList();
+    gpuProfiler->beginScope(commandList.get(), "Frame");
+    HRESULT hr = renderGraph->execute(frameSlot, [&nextSlot]() {
+        return commandContexts->acquire(nextSlot++).commandList;
+    });
+    if (FAILED(hr)) {
+        // Transient heaps could not be created, the frame is submitted without its passes
+        OutputDebugString(L"Render graph execute failed\n");
     }
+
+    // Last context of the frame closes the frame scope and resolves its timestamps
+    fastdx::ID3D12GraphicsCommandListPtr resolveList = commandContexts->acquire(nextSlot++).commandList;
+    gpuProfiler->endScope(resolveList.get());
+    gpuProfiler->endFrame(resolveList.get(), frameContext->frameFenceValue());
     executeCommandList();
 
-    swapChain->Present(1, 0);
-    waitGpu();
+    {
+        FASTDX_PROFILE_SCOPE("Present");
+        swapChain->Present(1, 0);
+    }
+    frameContext->endFrame();
 }
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
+    fastdx::CpuProfiler::setThreadName("Main");
     HWND hwnd = fastdx::createWindow(windowProp);
     fastdx::onWindowDestroy = []() {
-        waitGpu(true);
+        frameContext->waitIdle();
+        shaderHotReloader = nullptr;
+        pipelineCompiler->waitIdle();
+        device->pipelineStateCache()->save(getPathInModule(L"pipelines.cache"));
+    };
+    fastdx::onKeyDown = [](uint32_t virtualKey) {
+        if (virtualKey == VK_F12) {
+            isCaptureRequested = true;
+        } else if (virtualKey == VK_F11) {
+            benchmarkCapturedFrame();
+        } else if (virtualKey == VK_F9) {
+            saveFrameStatistics();
+        } else if (virtualKey == 'I') {
+            useExecuteIndirect = !useExecuteIndirect;
+        } else if (virtualKey >= '1' && virtualKey <= '4') {
+            frameContext->setLatency(virtualKey - '0');
+        }
     };
     initializeD3d(hwnd);
 
@@ -519,14 +902,18 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
     {
         tinygltf::Model gltfCubeModel;
         readGltfModel(L"Cube.gltf", &gltfCubeModel);
-        loadGltfModelMeshes(gltfCubeModel, gltfVertexBuffers, gltfIndexBuffers, gltfIndexBuffersView);
-        loadGltfModelMaterials(gltfCubeModel, gltfMaterialToTextures, gltfTextureDescriptorsHeapStart, &gltfTexturesViewHeap);
+        loadGltfModelMeshes(gltfCubeModel, gltfVertexBuffers, gltfIndexBuffers, gltfIndexBuffersView,
+            bindlessTable, gltfVertexBufferDescriptors, gltfMeshPartCenters, gltfMeshPartMaterials);
+        loadGltfModelMaterials(gltfCubeModel, gltfMaterialToTextures, gltfMaterialDescriptors, gltfMaterialSamplers,
+            bindlessTable, samplerCache);
 
         createSceneConstantBuffer();
+
+        // All upload transitions in one barrier call
+        resourceStates.flush(commandList);
     }
+    // No wait, the first frame's endFrame() signals the uploads' fence value and draw() retires their buffers
     executeCommandList();
-    waitGpu(true);
-    uploadBuffers.clear();
 
-    return fastdx::runMainLoop(update, draw);
+    return fastdx::runMainLoop(update, draw, fastdx::FrameScheduler(), frameStatistics);
 }
@@ -4,6 +4,7 @@
 #include <fstream>
 
 const int32_t kFrameCount = 3;
+const uint32_t kFrameLatency = 2;
 const DXGI_FORMAT kFrameFormat = DXGI_FORMAT_R10G10B10A2_UNORM;
 const D3D12_CLEAR_VALUE kClearDepth = { DXGI_FORMAT_D32_FLOAT, {1.0f, 0} };
 const D3D12_CLEAR_VALUE kClearRenderTarget = { kFrameFormat, { 0.0f, 0.2f, 0.4f, 1.0f } };
@@ -11,7 +12,7 @@ fastdx::WindowProperties windowProp;
 
 fastdx::D3D12DeviceWrapperPtr device;
 fastdx::ID3D12CommandQueuePtr commandQueue;
-fastdx::ID3D12CommandAllocatorPtr commandAllocators[kFrameCount];
+fastdx::FrameContextPtr frameContext;
 fastdx::ID3D12GraphicsCommandListPtr commandList;
 fastdx::IDXGISwapChainPtr swapChain;
 fastdx::ID3D12DescriptorHeapPtr swapChainRtvHeap;
@@ -23,12 +24,6 @@ fastdx::ID3D12ResourcePtr depthStencilTarget;
 std::vector<uint8_t> vertexShader, pixelShader;
 fastdx::ID3D12ResourcePtr vertexBuffer;
 
-int32_t frameIndex = 0;
-HANDLE fenceEvent;
-fastdx::ID3D12FencePtr swapFence;
-uint64_t swapFenceCounter = 0;
-uint64_t swapFenceWaitValue[kFrameCount] = {};
-
 HRESULT readShader(const std::wstring& filePath, std::vector<uint8_t>& outShaderData) {
     WCHAR modulePathBuffer[1024];
     GetModuleFileName(nullptr, modulePathBuffer, _countof(modulePathBuffer));
@@ -73,19 +68,13 @@ void initializeD3d(HWND hwnd) {
     device->createDepthStencilView(depthStencilTarget, depthStencilDesc,
         depthStencilViewHeap->GetCPUDescriptorHandleForHeapStart());
 
-    // Create one command allocator per frame buffer
-    for (int32_t i = 0; i < kFrameCount; ++i) {
-        commandAllocators[i] = device->createCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT);
-    }
+    // Frame pacing with one command allocator per frame in flight, at most kFrameLatency frames ahead of the GPU
+    frameContext = device->createFrameContext(commandQueue, D3D12_COMMAND_LIST_TYPE_DIRECT, kFrameLatency);
 
     // Single command list will reuse all allocators
-    commandList = device->createCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocators[0]);
+    commandList = device->createCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, frameContext->commandAllocator());
     commandList->Close();
 
-    // Fence to wait for a completed frame to reuse
-    swapFence = device->createFence(swapFenceCounter++, D3D12_FENCE_FLAG_NONE);
-    fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-
     // Read VS, PS and Create root signature for shader
     readShader(L"simple_vs.cso", vertexShader);
     readShader(L"simple_ps.cso", pixelShader);
@@ -120,36 +109,22 @@ void createTriangle() {
     vertexBuffer->Unmap(0, nullptr);
 }
 
-void waitGpu(bool forceWait = false) {
-    // Queue always signal increasing counter values
-    commandQueue->Signal(swapFence.get(), swapFenceCounter);
-    swapFenceWaitValue[frameIndex] = swapFenceCounter++;
-
-    // Wait if next frame not ready
-    int32_t nextFrameIndex = swapChain->GetCurrentBackBufferIndex();
-    if (swapFence->GetCompletedValue() < swapFenceWaitValue[nextFrameIndex] || forceWait) {
-        swapFence->SetEventOnCompletion(swapFenceWaitValue[nextFrameIndex], fenceEvent);
-        WaitForSingleObjectEx(fenceEvent, INFINITE, FALSE);
-    }
-    frameIndex = nextFrameIndex;
-}
-
-void draw() {
+void draw(float) {
     static D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = swapChainRtvHeap->GetCPUDescriptorHandleForHeapStart();
     static D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = depthStencilViewHeap->GetCPUDescriptorHandleForHeapStart();
     static size_t heapDescriptorSize = device->getDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-    D3D12_CPU_DESCRIPTOR_HANDLE frameRtvHandle = { rtvHandle.ptr + frameIndex * heapDescriptorSize };
+    uint32_t backBufferIndex = swapChain->GetCurrentBackBufferIndex();
+    D3D12_CPU_DESCRIPTOR_HANDLE frameRtvHandle = { rtvHandle.ptr + backBufferIndex * heapDescriptorSize };
 
     static D3D12_RESOURCE_BARRIER transitionBarrier = { D3D12_RESOURCE_BARRIER_TYPE_TRANSITION,
         D3D12_RESOURCE_BARRIER_FLAG_NONE, nullptr,  D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES };
 
-    // Get and reset allocator for current frame, then point command list to it
-    auto commandAllocator = commandAllocators[frameIndex];
-    commandAllocator->Reset();
-    commandList->Reset(commandAllocator.get(), nullptr);
+    // Wait until the frame allocator is free and reset it, then point command list to it
+    frameContext->beginFrame();
+    commandList->Reset(frameContext->commandAllocator().get(), nullptr);
     {
         // Present->RenderTarget barrier
-        transitionBarrier.Transition.pResource = renderTargets[frameIndex].get();
+        transitionBarrier.Transition.pResource = renderTargets[backBufferIndex].get();
         transitionBarrier.Transition.StateBefore = D3D12_RESOURCE_STATE_PRESENT;
         transitionBarrier.Transition.StateAfter = D3D12_RESOURCE_STATE_RENDER_TARGET;
         commandList->ResourceBarrier(1, &transitionBarrier);
@@ -184,14 +159,13 @@ void draw() {
     ID3D12CommandList* commandLists[] = { commandList.get() };
     commandQueue->ExecuteCommandLists(_countof(commandLists), commandLists);
     swapChain->Present(1, 0);
-
-    waitGpu();
+    frameContext->endFrame();
 }
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
     HWND hwnd = fastdx::createWindow(windowProp);
     fastdx::onWindowDestroy = []() {
-        waitGpu(true);
+        frameContext->waitIdle();
     };
     initializeD3d(hwnd);
     createTriangle();
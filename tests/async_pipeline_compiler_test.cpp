@@ -0,0 +1,67 @@
+#include "fakes.h"
+#include "test.h"
+
+#include <future>
+
+using namespace fastdx_test;
+
+namespace {
+    struct FakeRootSignature : ID3D12RootSignature {
+        FakeRootSignature(bool* isDestroyed) : isDestroyed(isDestroyed) {}
+        ~FakeRootSignature() { *isDestroyed = true; }
+
+        bool* isDestroyed;
+    };
+};
+
+
+TEST(requestsKeepTheirRootSignature) {
+    // The worker is held until the caller released its root signature
+    std::promise<void> released;
+    std::shared_future<void> isReleased = released.get_future().share();
+    bool isDestroyed = false;
+    bool wasAliveWhenCompiled = false;
+    fastdx::AsyncPipelineCompiler compiler([&](const D3D12_GRAPHICS_PIPELINE_STATE_DESC&, HRESULT* outResult) {
+        isReleased.wait();
+        wasAliveWhenCompiled = !isDestroyed;
+        *outResult = S_OK;
+        return makeFake<FakePipelineState>(D3D12_GRAPHICS_PIPELINE_STATE_DESC{});
+    }, 1);
+
+    fastdx::AsyncPipelineStatePtr pipelineState;
+    {
+        fastdx::ID3D12RootSignaturePtr rootSignature = makeFake<FakeRootSignature>(&isDestroyed);
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = {};
+        desc.pRootSignature = rootSignature.get();
+        pipelineState = compiler.compile(desc);
+    }
+    CHECK(!isDestroyed);
+    released.set_value();
+    compiler.waitIdle();
+    CHECK(wasAliveWhenCompiled);
+    CHECK(pipelineState->isReady());
+
+    // Released with the request once compiled
+    CHECK(isDestroyed);
+}
+
+
+TEST(fallbackIsCurrentUntilPublished) {
+    std::promise<void> released;
+    std::shared_future<void> isReleased = released.get_future().share();
+    fastdx::ID3D12PipelineStatePtr compiled = makeFake<FakePipelineState>(D3D12_GRAPHICS_PIPELINE_STATE_DESC{});
+    fastdx::AsyncPipelineCompiler compiler([&](const D3D12_GRAPHICS_PIPELINE_STATE_DESC&, HRESULT* outResult) {
+        isReleased.wait();
+        *outResult = S_OK;
+        return compiled;
+    }, 1);
+
+    fastdx::ID3D12PipelineStatePtr fallback = makeFake<FakePipelineState>(D3D12_GRAPHICS_PIPELINE_STATE_DESC{});
+    fastdx::AsyncPipelineStatePtr pipelineState = compiler.compile(D3D12_GRAPHICS_PIPELINE_STATE_DESC{}, fallback);
+    CHECK(pipelineState->current() == fallback.get());
+    CHECK(!pipelineState->isReady());
+    released.set_value();
+    compiler.waitIdle();
+    CHECK(pipelineState->current() == compiled.get());
+    CHECK_EQ(compiler.compiledCount(), 1u);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+///
+/// Minimal benchmark helper, times a function over several runs and keeps the median
+///
+#include <stdint.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace fastdx_test {
+    template <typename Function>
+    inline double medianMs(uint32_t runCount, Function function) {
+        std::vector<double> timesMs;
+        for (uint32_t run = 0; run < runCount; ++run) {
+            auto start = std::chrono::steady_clock::now();
+            function();
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            timesMs.push_back(elapsed.count());
+        }
+        std::sort(timesMs.begin(), timesMs.end());
+        return timesMs[timesMs.size() / 2];
+    }
+};
@@ -0,0 +1,99 @@
+#include "fakes.h"
+#include "test.h"
+
+using namespace fastdx_test;
+
+namespace {
+    struct BindlessFixture {
+        BindlessFixture(uint32_t staticCount) : device(makeFake<FakeDevice>()), wrapper(device) {
+            heap = wrapper.createShaderVisibleDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, staticCount, 4, 2);
+            table = wrapper.createBindlessResourceTable(heap);
+        }
+
+        fastdx::ID3D12ResourcePtr createTexture() {
+            D3D12_RESOURCE_DESC desc = {};
+            desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+            return makeFake<FakeResource>(desc, 0);
+        }
+
+        static D3D12_SHADER_RESOURCE_VIEW_DESC textureView(UINT mipLevels) {
+            D3D12_SHADER_RESOURCE_VIEW_DESC desc = {};
+            desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+            desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+            desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+            desc.Texture2D.MipLevels = mipLevels;
+            return desc;
+        }
+
+        std::shared_ptr<FakeDevice> device;
+        fastdx::D3D12DeviceWrapper wrapper;
+        fastdx::ShaderVisibleDescriptorHeapPtr heap;
+        fastdx::BindlessResourceTablePtr table;
+    };
+};
+
+
+TEST(viewsAddedTogetherAreContiguous) {
+    BindlessFixture fixture(16);
+    fastdx::ID3D12ResourcePtr resources[] = { fixture.createTexture(), fixture.createTexture(),
+        fixture.createTexture() };
+    D3D12_SHADER_RESOURCE_VIEW_DESC descs[] = { BindlessFixture::textureView(1), BindlessFixture::textureView(2),
+        BindlessFixture::textureView(3) };
+
+    fastdx::DescriptorRange first = fixture.table->addShaderResourceView(resources[0], descs[0]);
+    fastdx::DescriptorRange range = fixture.table->addShaderResourceViews(3, resources, descs);
+    CHECK_EQ(first.index, 0u);
+    CHECK_EQ(range.index, 1u);
+    CHECK_EQ(range.count, 3u);
+    CHECK_EQ(fixture.table->viewCount(), 4u);
+
+    CHECK_EQ(fixture.device->shaderResourceViews.size(), 4u);
+    for (uint32_t i = 0; i < 3; ++i) {
+        const FakeDevice::ShaderResourceViewCreation& view = fixture.device->shaderResourceViews[i + 1];
+        CHECK(view.resource == resources[i].get());
+        CHECK_EQ(view.desc.Texture2D.MipLevels, i + 1);
+        CHECK_EQ(view.destination.ptr, range.cpu(i).ptr);
+    }
+}
+
+
+TEST(tableKeepsResourcesAliveUntilRemoved) {
+    BindlessFixture fixture(16);
+    fastdx::ID3D12ResourcePtr resource = fixture.createTexture();
+    std::weak_ptr<ID3D12Resource> weakResource = resource;
+
+    fastdx::DescriptorRange range = fixture.table->addShaderResourceView(resource, BindlessFixture::textureView(1));
+    resource.reset();
+    CHECK(!weakResource.expired());
+
+    fixture.table->remove(range.index);
+    CHECK(weakResource.expired());
+    CHECK_EQ(fixture.table->viewCount(), 0u);
+
+    // Unknown indices are ignored
+    fixture.table->remove(range.index);
+    fixture.table->remove(12);
+    CHECK_EQ(fixture.table->viewCount(), 0u);
+}
+
+
+TEST(removedIndicesAreReused) {
+    BindlessFixture fixture(4);
+    fastdx::ID3D12ResourcePtr resources[] = { fixture.createTexture(), fixture.createTexture() };
+    D3D12_SHADER_RESOURCE_VIEW_DESC descs[] = { BindlessFixture::textureView(1), BindlessFixture::textureView(1) };
+
+    fastdx::DescriptorRange a = fixture.table->addShaderResourceViews(2, resources, descs);
+    fastdx::DescriptorRange b = fixture.table->addShaderResourceViews(2, resources, descs);
+    CHECK_EQ(b.index, 2u);
+
+    // Full, nothing is created or kept
+    size_t viewCount = fixture.device->shaderResourceViews.size();
+    long useCount = resources[0].use_count();
+    CHECK(!fixture.table->addShaderResourceView(resources[0], descs[0]).isValid());
+    CHECK_EQ(fixture.device->shaderResourceViews.size(), viewCount);
+    CHECK_EQ(resources[0].use_count(), useCount);
+
+    fixture.table->remove(a.index);
+    CHECK_EQ(fixture.table->addShaderResourceViews(2, resources, descs).index, a.index);
+    CHECK_EQ(fixture.table->viewCount(), 4u);
+}
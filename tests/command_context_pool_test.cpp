@@ -0,0 +1,155 @@
+#include "fakes.h"
+#include "test.h"
+
+#include <thread>
+
+using namespace fastdx_test;
+
+namespace {
+    struct PoolFixture {
+        PoolFixture() : device(makeFake<FakeDevice>()), wrapper(device), queue(makeFake<FakeCommandQueue>()) {
+            pool = wrapper.createCommandContextPool(D3D12_COMMAND_LIST_TYPE_DIRECT);
+        }
+
+        FakeCommandList* list(const fastdx::CommandContext& context) {
+            return static_cast<FakeCommandList*>(context.commandList.get());
+        }
+
+        std::shared_ptr<FakeDevice> device;
+        fastdx::D3D12DeviceWrapper wrapper;
+        std::shared_ptr<FakeCommandQueue> queue;
+        fastdx::CommandContextPoolPtr pool;
+    };
+};
+
+
+TEST(slotsAreSubmittedInOrderWhateverTheRecordingThread) {
+    PoolFixture fixture;
+    fixture.pool->beginFrame(0);
+
+    // Slots acquired out of order on several threads, slot 3 left unused
+    std::vector<fastdx::CommandContext> contexts(5);
+    std::vector<std::thread> threads;
+    for (uint32_t slot : { 4u, 1u, 2u, 0u }) {
+        threads.emplace_back([&, slot]() { contexts[slot] = fixture.pool->acquire(slot); });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    CHECK_EQ(fixture.device->commandListCount, 4);
+    CHECK_EQ(fixture.pool->allocatorCount(), 4u);
+
+    // An open slot is returned again
+    HRESULT hr = E_FAIL;
+    CHECK(fixture.pool->acquire(2, &hr).commandList == contexts[2].commandList);
+    CHECK(SUCCEEDED(hr));
+    CHECK_EQ(fixture.device->commandListCount, 4);
+
+    fixture.pool->submit(fixture.queue, 1);
+    CHECK_EQ(fixture.queue->executions.size(), 1u);
+    const std::vector<ID3D12CommandList*>& executed = fixture.queue->executions[0];
+    CHECK_EQ(executed.size(), 4u);
+    uint32_t executedSlots[] = { 0, 1, 2, 4 };
+    for (size_t i = 0; i < executed.size(); ++i) {
+        CHECK(executed[i] == contexts[executedSlots[i]].commandList.get());
+        CHECK(fixture.list(contexts[executedSlots[i]])->isClosed);
+    }
+
+    // Nothing open
+    fixture.pool->submit(fixture.queue, 2);
+    CHECK_EQ(fixture.queue->executions.size(), 1u);
+}
+
+
+TEST(allocatorsAreRecycledOnceTheirFenceCompletes) {
+    PoolFixture fixture;
+    const uint32_t kSlotCount = 3;
+    std::vector<ID3D12CommandList*> firstLists;
+
+    // Two frames in flight, each needs its own allocators
+    for (uint64_t fenceValue = 1; fenceValue <= 2; ++fenceValue) {
+        fixture.pool->beginFrame(0);
+        for (uint32_t slot = 0; slot < kSlotCount; ++slot) {
+            fastdx::CommandContext context = fixture.pool->acquire(slot);
+            if (fenceValue == 1) {
+                firstLists.push_back(context.commandList.get());
+            }
+        }
+        fixture.pool->submit(fixture.queue, fenceValue);
+    }
+    CHECK_EQ(fixture.pool->allocatorCount(), 2 * kSlotCount);
+    CHECK_EQ(fixture.pool->freeAllocatorCount(), 0u);
+
+    // Frame 1 completed, its allocators are reset and reused, lists too
+    fixture.pool->beginFrame(1);
+    CHECK_EQ(fixture.pool->freeAllocatorCount(), kSlotCount);
+    for (uint32_t slot = 0; slot < kSlotCount; ++slot) {
+        fastdx::CommandContext context = fixture.pool->acquire(slot);
+        CHECK(context.commandList.get() == firstLists[slot]);
+        CHECK(fixture.list(context)->allocator == context.commandAllocator.get());
+        CHECK_EQ(static_cast<FakeCommandAllocator*>(context.commandAllocator.get())->resetCount, 1);
+    }
+    fixture.pool->submit(fixture.queue, 3);
+    CHECK_EQ(fixture.pool->allocatorCount(), 2 * kSlotCount);
+    CHECK_EQ(fixture.device->commandListCount, static_cast<int>(kSlotCount));
+
+    // Fence values complete in order, frames 2 and 3 at once
+    fixture.pool->beginFrame(3);
+    CHECK_EQ(fixture.pool->freeAllocatorCount(), 2 * kSlotCount);
+}
+
+
+TEST(workerPoolRunsEveryPartOnce) {
+    for (uint32_t threadCount : { 1u, 2u, 4u }) {
+        fastdx::WorkerPool workers(threadCount);
+        CHECK_EQ(workers.threadCount(), threadCount);
+
+        for (uint32_t partCount : { 0u, 1u, 3u, 64u }) {
+            std::vector<std::atomic<int>> runCounts(partCount);
+            for (int run = 0; run < 10; ++run) {
+                workers.run(partCount, [&](uint32_t partIndex) { runCounts[partIndex].fetch_add(1); });
+            }
+            for (const std::atomic<int>& runCount : runCounts) {
+                CHECK_EQ(runCount.load(), 10);
+            }
+        }
+    }
+}
+
+
+TEST(workerPoolRunsPartsConcurrently) {
+    // Each part waits for all others, only returns if they run at the same time
+    const uint32_t kThreadCount = 4;
+    fastdx::WorkerPool workers(kThreadCount);
+    std::atomic<uint32_t> startedCount = 0;
+    std::atomic<std::thread::id> threadIds[kThreadCount];
+    workers.run(kThreadCount, [&](uint32_t partIndex) {
+        threadIds[partIndex] = std::this_thread::get_id();
+        startedCount.fetch_add(1);
+        while (startedCount.load() < kThreadCount) {
+            std::this_thread::yield();
+        }
+    });
+
+    for (uint32_t i = 0; i < kThreadCount; ++i) {
+        for (uint32_t j = i + 1; j < kThreadCount; ++j) {
+            CHECK(threadIds[i].load() != threadIds[j].load());
+        }
+    }
+}
+
+
+TEST(partitionRangeCoversTheRangeInBalancedParts) {
+    for (uint32_t count : { 0u, 1u, 7u, 100000u }) {
+        for (uint32_t partCount : { 1u, 3u, 8u }) {
+            uint32_t end = 0;
+            for (uint32_t partIndex = 0; partIndex < partCount; ++partIndex) {
+                std::pair<uint32_t, uint32_t> part = fastdxu::partitionRange(count, partCount, partIndex);
+                CHECK_EQ(part.first, end);
+                CHECK(part.second - part.first <= count / partCount + 1);
+                end = part.second;
+            }
+            CHECK_EQ(end, count);
+        }
+    }
+}
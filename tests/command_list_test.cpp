@@ -0,0 +1,102 @@
+#include "fakes.h"
+#include "test.h"
+
+using namespace fastdx_test;
+
+namespace {
+    struct CommandListFixture {
+        CommandListFixture() : commandList(makeFake<FakeCommandList>()), filteringList(commandList) {}
+
+        std::shared_ptr<FakeCommandList> commandList;
+        fastdx::CommandList filteringList;
+    };
+
+    ID3D12DescriptorHeap* heapPtr(uintptr_t value) {
+        return reinterpret_cast<ID3D12DescriptorHeap*>(value);
+    }
+};
+
+
+TEST(newDescriptorHeapsClearTheTables) {
+    CommandListFixture fixture;
+    fastdx::CommandList& list = fixture.filteringList;
+    D3D12_GPU_DESCRIPTOR_HANDLE table = { 0x2000000 };
+    ID3D12DescriptorHeap* heaps[] = { heapPtr(0x1000), heapPtr(0x2000) };
+    list.setDescriptorHeaps(2, heaps);
+    list.setGraphicsRootDescriptorTable(2, table);
+    list.setGraphicsRootConstantBufferView(0, 0x10000);
+    list.setGraphicsRootDescriptorTable(2, table);
+    CHECK_EQ(list.filteredCount(), 1u);
+
+    // Same heaps, the table stays bound
+    list.setDescriptorHeaps(2, heaps);
+    list.setGraphicsRootDescriptorTable(2, table);
+    CHECK_EQ(list.filteredCount(), 3u);
+
+    // Other heaps, the table is set again but the root CBV is kept
+    ID3D12DescriptorHeap* otherHeaps[] = { heapPtr(0x3000), heapPtr(0x2000) };
+    list.setDescriptorHeaps(2, otherHeaps);
+    list.setGraphicsRootDescriptorTable(2, table);
+    list.setGraphicsRootConstantBufferView(0, 0x10000);
+    CHECK_EQ(list.filteredCount(), 4u);
+    CHECK_EQ(list.issuedCount(), 5u);
+}
+
+
+TEST(rootConstantsAreFilteredPerParameter) {
+    CommandListFixture fixture;
+    fastdx::CommandList& list = fixture.filteringList;
+    uint32_t a[] = { 1, 2, 3, 4 };
+    uint32_t b[] = { 5, 6 };
+    list.setGraphicsRoot32BitConstants(0, 4, a, 0);
+    list.setGraphicsRoot32BitConstants(1, 2, b, 0);
+    list.setGraphicsRoot32BitConstants(0, 4, a, 0);
+    list.setGraphicsRoot32BitConstants(1, 2, b, 0);
+    CHECK_EQ(list.filteredCount(), 2u);
+
+    // Subranges already set are filtered, unknown or different values are not
+    list.setGraphicsRoot32BitConstant(0, 3, 2);
+    list.setGraphicsRoot32BitConstant(0, 9, 2);
+    list.setGraphicsRoot32BitConstant(1, 6, 2);
+    CHECK_EQ(list.filteredCount(), 3u);
+    CHECK_EQ(list.issuedCount(), 4u);
+
+    // Growing parameter 1 keeps its values
+    list.setGraphicsRoot32BitConstants(1, 2, b, 0);
+    CHECK_EQ(list.filteredCount(), 4u);
+}
+
+
+TEST(rootConstantsFitTheRootSignatureSize) {
+    // Parameters grown one value at a time up to the 64 DWORD limit, their ranges are moved and packed
+    CommandListFixture fixture;
+    fastdx::CommandList& list = fixture.filteringList;
+    const uint32_t kParameterCount = 4;
+    const uint32_t kValueCount = fastdx::CommandList::kMaxRootSignatureDwords / kParameterCount;
+    for (uint32_t value = 0; value < kValueCount; ++value) {
+        for (uint32_t parameter = 0; parameter < kParameterCount; ++parameter) {
+            list.setGraphicsRoot32BitConstant(parameter, parameter * 100 + value, value);
+        }
+    }
+    CHECK_EQ(list.issuedCount(), kParameterCount * kValueCount);
+
+    for (uint32_t parameter = 0; parameter < kParameterCount; ++parameter) {
+        for (uint32_t value = 0; value < kValueCount; ++value) {
+            list.setGraphicsRoot32BitConstant(parameter, parameter * 100 + value, value);
+        }
+    }
+    CHECK_EQ(list.filteredCount(), kParameterCount * kValueCount);
+
+    // A new root signature releases the constants
+    list.setGraphicsRootSignature(reinterpret_cast<ID3D12RootSignature*>(0x1000));
+    uint32_t values[fastdx::CommandList::kMaxRootSignatureDwords] = {};
+    list.setGraphicsRoot32BitConstants(7, _countof(values), values, 0);
+    list.setGraphicsRoot32BitConstants(7, _countof(values), values, 0);
+    CHECK_EQ(list.filteredCount(), kParameterCount * kValueCount + 1);
+}
+
+
+TEST(commandListShadowStaysSmall) {
+    // Constructed on the stack for every recorded pass
+    CHECK(sizeof(fastdx::CommandList) < 4096);
+}
@@ -0,0 +1,417 @@
+#include "fakes.h"
+#include "test.h"
+
+using namespace fastdx_test;
+
+namespace {
+    // Logs every call with its arguments, to compare direct recording with a replayed stream
+    class CallLog {
+    public:
+        void setPipelineState(ID3D12PipelineState* pipelineState) { _log("setPipelineState", { _ptr(pipelineState) }); }
+        void setGraphicsRootSignature(ID3D12RootSignature* rootSignature) {
+            _log("setGraphicsRootSignature", { _ptr(rootSignature) });
+        }
+        void setComputeRootSignature(ID3D12RootSignature* rootSignature) {
+            _log("setComputeRootSignature", { _ptr(rootSignature) });
+        }
+        void setPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY topology) { _log("setPrimitiveTopology", { topology }); }
+        void setViewports(uint32_t count, const D3D12_VIEWPORT* viewports) {
+            _log("setViewports", { count }, viewports, count * sizeof(*viewports));
+        }
+        void setScissorRects(uint32_t count, const D3D12_RECT* rects) {
+            _log("setScissorRects", { count }, rects, count * sizeof(*rects));
+        }
+        void setRenderTargets(uint32_t count, const D3D12_CPU_DESCRIPTOR_HANDLE* rtvHandles,
+            const D3D12_CPU_DESCRIPTOR_HANDLE* dsvHandle) {
+            _log("setRenderTargets", { count, dsvHandle ? dsvHandle->ptr : 0 }, rtvHandles,
+                count * sizeof(*rtvHandles));
+        }
+        void setDescriptorHeaps(uint32_t count, ID3D12DescriptorHeap* const* heaps) {
+            _log("setDescriptorHeaps", { count }, heaps, count * sizeof(*heaps));
+        }
+        void setIndexBuffer(const D3D12_INDEX_BUFFER_VIEW& view) { _log("setIndexBuffer", {}, &view, sizeof(view)); }
+        void setVertexBuffers(uint32_t startSlot, uint32_t count, const D3D12_VERTEX_BUFFER_VIEW* views) {
+            _log("setVertexBuffers", { startSlot, count }, views, count * sizeof(*views));
+        }
+        void setGraphicsRootConstantBufferView(uint32_t index, D3D12_GPU_VIRTUAL_ADDRESS address) {
+            _log("setGraphicsRootConstantBufferView", { index, address });
+        }
+        void setGraphicsRootShaderResourceView(uint32_t index, D3D12_GPU_VIRTUAL_ADDRESS address) {
+            _log("setGraphicsRootShaderResourceView", { index, address });
+        }
+        void setGraphicsRootDescriptorTable(uint32_t index, D3D12_GPU_DESCRIPTOR_HANDLE handle) {
+            _log("setGraphicsRootDescriptorTable", { index, handle.ptr });
+        }
+        void setGraphicsRoot32BitConstants(uint32_t index, uint32_t count, const void* data, uint32_t offset) {
+            _log("setGraphicsRoot32BitConstants", { index, count, offset }, data, count * sizeof(uint32_t));
+        }
+        void setGraphicsRoot32BitConstant(uint32_t index, uint32_t value, uint32_t offset) {
+            setGraphicsRoot32BitConstants(index, 1, &value, offset);
+        }
+        void setComputeRootDescriptorTable(uint32_t index, D3D12_GPU_DESCRIPTOR_HANDLE handle) {
+            _log("setComputeRootDescriptorTable", { index, handle.ptr });
+        }
+        void setComputeRoot32BitConstants(uint32_t index, uint32_t count, const void* data, uint32_t offset) {
+            _log("setComputeRoot32BitConstants", { index, count, offset }, data, count * sizeof(uint32_t));
+        }
+        void clearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE handle, const float color[4]) {
+            _log("clearRenderTargetView", { handle.ptr }, color, 4 * sizeof(float));
+        }
+        void clearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE handle, D3D12_CLEAR_FLAGS flags, float depth,
+            uint8_t stencil) {
+            _log("clearDepthStencilView", { handle.ptr, flags, stencil }, &depth, sizeof(depth));
+        }
+        void resourceBarrier(uint32_t count, const D3D12_RESOURCE_BARRIER* barriers) {
+            _log("resourceBarrier", { count }, barriers, count * sizeof(*barriers));
+        }
+        void drawInstanced(uint32_t vertexCount, uint32_t instanceCount, uint32_t startVertex,
+            uint32_t startInstance) {
+            _log("drawInstanced", { vertexCount, instanceCount, startVertex, startInstance });
+        }
+        void drawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex,
+            int32_t baseVertex, uint32_t startInstance) {
+            _log("drawIndexedInstanced", { indexCount, instanceCount, startIndex, static_cast<uint64_t>(baseVertex),
+                startInstance });
+        }
+        void dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) {
+            _log("dispatch", { groupCountX, groupCountY, groupCountZ });
+        }
+        void executeIndirect(ID3D12CommandSignature* commandSignature, uint32_t maxCommandCount,
+            ID3D12Resource* argumentBuffer, uint64_t argumentBufferOffset, ID3D12Resource* countBuffer = nullptr,
+            uint64_t countBufferOffset = 0) {
+            _log("executeIndirect", { _ptr(commandSignature), maxCommandCount, _ptr(argumentBuffer),
+                argumentBufferOffset, _ptr(countBuffer), countBufferOffset });
+        }
+
+        inline const std::vector<std::string>& calls() const { return _calls; }
+
+    private:
+        static uint64_t _ptr(const void* pointer) { return reinterpret_cast<uint64_t>(pointer); }
+
+        void _log(const char* name, std::initializer_list<uint64_t> values, const void* data = nullptr,
+            size_t sizeInBytes = 0) {
+            std::string call = name;
+            for (uint64_t value : values) {
+                call += " " + std::to_string(value);
+            }
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            for (size_t i = 0; i < sizeInBytes; ++i) {
+                call += (i == 0 ? " [" : ",") + std::to_string(bytes[i]);
+            }
+            _calls.push_back(sizeInBytes > 0 ? call + "]" : call);
+        }
+
+        std::vector<std::string> _calls;
+    };
+
+    template <typename T>
+    T* fakePtr(uintptr_t value) {
+        return reinterpret_cast<T*>(value);
+    }
+
+    // Every command with distinct arguments
+    template <typename CommandListType>
+    void recordEveryCommand(CommandListType& list, uint32_t seed) {
+        D3D12_VIEWPORT viewports[] = { { 0.0f, 0.0f, 1920.0f, 1080.0f, 0.0f, 1.0f },
+            { 16.0f, 32.0f, 640.0f, 480.0f, 0.25f, 0.75f } };
+        D3D12_RECT rects[] = { { 0, 0, 1920, 1080 } };
+        D3D12_CPU_DESCRIPTOR_HANDLE rtvHandles[] = { { 0x1000 + seed }, { 0x1020 } };
+        D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = { 0x2000 };
+        ID3D12DescriptorHeap* heaps[] = { fakePtr<ID3D12DescriptorHeap>(0x3000),
+            fakePtr<ID3D12DescriptorHeap>(0x3100) };
+        D3D12_VERTEX_BUFFER_VIEW vertexBuffers[] = { { 0x10000, 1024, 32 }, { 0x20000, 2048, 16 } };
+        uint32_t constants[] = { seed, 2, 3, 4, 5 };
+        float color[] = { 0.1f, 0.2f, 0.3f, 1.0f };
+        D3D12_RESOURCE_BARRIER barriers[2] = {};
+        barriers[0].Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+        barriers[0].Transition.pResource = fakePtr<ID3D12Resource>(0x4000);
+        barriers[0].Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
+        barriers[0].Transition.StateAfter = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+        barriers[1].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+        barriers[1].UAV.pResource = fakePtr<ID3D12Resource>(0x4100);
+
+        list.setPipelineState(fakePtr<ID3D12PipelineState>(0x5000 + seed));
+        list.setGraphicsRootSignature(fakePtr<ID3D12RootSignature>(0x5100));
+        list.setComputeRootSignature(fakePtr<ID3D12RootSignature>(0x5200));
+        list.setPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        list.setViewports(_countof(viewports), viewports);
+        list.setScissorRects(_countof(rects), rects);
+        list.setRenderTargets(_countof(rtvHandles), rtvHandles, &dsvHandle);
+        list.setRenderTargets(1, rtvHandles, nullptr);
+        list.setDescriptorHeaps(_countof(heaps), heaps);
+        list.setIndexBuffer(D3D12_INDEX_BUFFER_VIEW{ 0x30000, 512, DXGI_FORMAT_R16_UINT });
+        list.setVertexBuffers(1, _countof(vertexBuffers), vertexBuffers);
+        list.setGraphicsRootConstantBufferView(0, 0x40000 + seed);
+        list.setGraphicsRootShaderResourceView(1, 0x50000);
+        list.setGraphicsRootDescriptorTable(2, D3D12_GPU_DESCRIPTOR_HANDLE{ 0x60000 });
+        list.setGraphicsRoot32BitConstants(3, _countof(constants), constants, 1);
+        list.setGraphicsRoot32BitConstant(3, seed, 0);
+        list.setComputeRootDescriptorTable(4, D3D12_GPU_DESCRIPTOR_HANDLE{ 0x70000 });
+        list.setComputeRoot32BitConstants(5, 3, constants, 2);
+        list.clearRenderTargetView(rtvHandles[0], color);
+        list.clearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 7);
+        list.resourceBarrier(_countof(barriers), barriers);
+        list.drawInstanced(3, 1, seed, 0);
+        list.drawIndexedInstanced(36, 2, 6, -4, seed);
+        list.dispatch(8, 4, seed);
+        list.executeIndirect(fakePtr<ID3D12CommandSignature>(0x8000), 100, fakePtr<ID3D12Resource>(0x8100), 256);
+        list.executeIndirect(fakePtr<ID3D12CommandSignature>(0x8000), 50, fakePtr<ID3D12Resource>(0x8100), 512,
+            fakePtr<ID3D12Resource>(0x8200), 16);
+    }
+
+    const uint32_t kEveryCommandCount = 26;
+};
+
+
+TEST(replayMatchesDirectRecording) {
+    CallLog direct;
+    recordEveryCommand(direct, 1);
+    CHECK_EQ(direct.calls().size(), kEveryCommandCount);
+
+    fastdx::CommandStream stream;
+    recordEveryCommand(stream, 1);
+    CHECK_EQ(stream.commandCount(), kEveryCommandCount);
+    CallLog replayed;
+    stream.replay(replayed);
+    CHECK(replayed.calls() == direct.calls());
+
+    // Replaying twice gives the same calls again
+    stream.replay(replayed);
+    CHECK_EQ(replayed.calls().size(), 2 * direct.calls().size());
+    CHECK(std::equal(direct.calls().begin(), direct.calls().end(), replayed.calls().begin() + kEveryCommandCount));
+}
+
+
+TEST(replayIntoAnotherStreamCopiesIt) {
+    fastdx::CommandStream stream;
+    recordEveryCommand(stream, 2);
+    fastdx::CommandStream copy;
+    stream.replay(copy);
+    CHECK_EQ(copy.commandCount(), stream.commandCount());
+    CHECK_EQ(copy.sizeInBytes(), stream.sizeInBytes());
+
+    CallLog original, copied;
+    stream.replay(original);
+    copy.replay(copied);
+    CHECK(copied.calls() == original.calls());
+}
+
+
+TEST(commandsSpanPagesInOrder) {
+    // Enough commands for several pages, plus one larger than a page
+    fastdx::CommandStream stream;
+    CallLog direct;
+    const uint32_t kRecordCount = 200;
+    for (uint32_t i = 0; i < kRecordCount; ++i) {
+        recordEveryCommand(stream, i);
+        recordEveryCommand(direct, i);
+    }
+    std::vector<D3D12_RESOURCE_BARRIER> barriers(fastdx::CommandStream::kPageSizeInBytes /
+        sizeof(D3D12_RESOURCE_BARRIER) + 1);
+    for (size_t i = 0; i < barriers.size(); ++i) {
+        barriers[i].Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+        barriers[i].UAV.pResource = fakePtr<ID3D12Resource>(0x1000 + i);
+    }
+    stream.resourceBarrier(static_cast<uint32_t>(barriers.size()), barriers.data());
+    direct.resourceBarrier(static_cast<uint32_t>(barriers.size()), barriers.data());
+    stream.drawInstanced(1, 2, 3, 4);
+    direct.drawInstanced(1, 2, 3, 4);
+    CHECK(stream.capacityInBytes() > 2 * fastdx::CommandStream::kPageSizeInBytes);
+
+    CallLog replayed;
+    stream.replay(replayed);
+    CHECK_EQ(replayed.calls().size(), kRecordCount * kEveryCommandCount + 2);
+    CHECK(replayed.calls() == direct.calls());
+
+    fastdx::NullCommandList nullList;
+    stream.replay(nullList);
+    CHECK_EQ(nullList.drawCount(), 2u * kRecordCount + 1);
+    CHECK_EQ(nullList.dispatchCount(), kRecordCount);
+    CHECK_EQ(nullList.executeIndirectCount(), 2u * kRecordCount);
+    CHECK_EQ(nullList.barrierCount(), 2u * kRecordCount + barriers.size());
+}
+
+
+TEST(resetKeepsPagesAndForgetsCommands) {
+    fastdx::CommandStream stream;
+    for (uint32_t i = 0; i < 100; ++i) {
+        recordEveryCommand(stream, i);
+    }
+    size_t capacityInBytes = stream.capacityInBytes();
+
+    stream.reset();
+    CHECK_EQ(stream.commandCount(), 0u);
+    CHECK_EQ(stream.sizeInBytes(), 0u);
+    CallLog empty;
+    stream.replay(empty);
+    CHECK(empty.calls().empty());
+
+    // The next frame records into the same pages
+    CallLog direct, replayed;
+    recordEveryCommand(stream, 7);
+    recordEveryCommand(direct, 7);
+    stream.replay(replayed);
+    CHECK(replayed.calls() == direct.calls());
+    CHECK_EQ(stream.capacityInBytes(), capacityInBytes);
+}
+
+
+TEST(serializedStreamReplaysTheSame) {
+    fastdx::CommandStream stream;
+    for (uint32_t i = 0; i < 100; ++i) {
+        recordEveryCommand(stream, i);
+    }
+    std::vector<uint8_t> data;
+    stream.serialize(data);
+    CHECK_EQ(data.size(), stream.sizeInBytes());
+
+    fastdx::CommandStream loaded;
+    CHECK(loaded.deserialize(data.data(), data.size()));
+    CHECK_EQ(loaded.commandCount(), stream.commandCount());
+    CallLog original, replayed;
+    stream.replay(original);
+    loaded.replay(replayed);
+    CHECK(replayed.calls() == original.calls());
+
+    CHECK(loaded.deserialize(nullptr, 0));
+    CHECK_EQ(loaded.commandCount(), 0u);
+}
+
+
+namespace {
+    // Serialized command layout: opcode (2 bytes), reserved (2), size (4), then value (8), index (4), count (4)
+    const size_t kSizeOffset = 4;
+    const size_t kValueOffset = 8;
+    const size_t kCountOffset = 20;
+
+    template <typename T>
+    void patch(std::vector<uint8_t>& data, size_t offset, T value) {
+        memcpy(data.data() + offset, &value, sizeof(value));
+    }
+
+    // Truncates the command to sizeInBytes, as if recorded with less data
+    void resizeCommand(std::vector<uint8_t>& data, uint32_t sizeInBytes) {
+        patch(data, kSizeOffset, sizeInBytes);
+        data.resize(sizeInBytes);
+    }
+
+    template <typename RecordFunction>
+    std::vector<uint8_t> serializeCommand(RecordFunction record) {
+        fastdx::CommandStream stream;
+        record(stream);
+        std::vector<uint8_t> data;
+        stream.serialize(data);
+        return data;
+    }
+
+    bool deserializes(const std::vector<uint8_t>& data) {
+        fastdx::CommandStream stream;
+        return stream.deserialize(data.data(), data.size());
+    }
+};
+
+
+TEST(deserializeChecksEachPayloadSize) {
+    D3D12_VIEWPORT viewports[2] = {};
+    std::vector<uint8_t> setViewports = serializeCommand([&](fastdx::CommandStream& stream) {
+        stream.setViewports(2, viewports);
+    });
+    CHECK(deserializes(setViewports));
+    CHECK_EQ(setViewports.size(), 24 + 2 * sizeof(D3D12_VIEWPORT));
+
+    // A count larger than the data, or than replay supports
+    std::vector<uint8_t> data = setViewports;
+    patch(data, kCountOffset, 3u);
+    CHECK(!deserializes(data));
+    patch(data, kCountOffset, 1u);
+    CHECK(!deserializes(data));
+    data = setViewports;
+    resizeCommand(data, 24 + sizeof(D3D12_VIEWPORT));
+    CHECK(!deserializes(data));
+
+    D3D12_RESOURCE_BARRIER barriers[3] = {};
+    std::vector<uint8_t> resourceBarrier = serializeCommand([&](fastdx::CommandStream& stream) {
+        stream.resourceBarrier(3, barriers);
+    });
+    CHECK(deserializes(resourceBarrier));
+    patch(resourceBarrier, kCountOffset, 4u);
+    CHECK(!deserializes(resourceBarrier));
+    patch(resourceBarrier, kCountOffset, UINT32_MAX);
+    CHECK(!deserializes(resourceBarrier));
+
+    // Fixed payloads, a draw without its arguments and a clear without its color
+    std::vector<uint8_t> drawIndexed = serializeCommand([](fastdx::CommandStream& stream) {
+        stream.drawIndexedInstanced(36, 1, 0, 0, 0);
+    });
+    CHECK_EQ(drawIndexed.size(), 24u + 24u);
+    CHECK(deserializes(drawIndexed));
+    resizeCommand(drawIndexed, 24);
+    CHECK(!deserializes(drawIndexed));
+
+    float color[4] = {};
+    std::vector<uint8_t> clear = serializeCommand([&](fastdx::CommandStream& stream) {
+        stream.clearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE{ 0x1000 }, color);
+    });
+    CHECK(deserializes(clear));
+    resizeCommand(clear, 32);
+    CHECK(!deserializes(clear));
+
+    // Padding beyond what was recorded
+    std::vector<uint8_t> dispatch = serializeCommand([](fastdx::CommandStream& stream) { stream.dispatch(1, 1, 1); });
+    CHECK(deserializes(dispatch));
+    dispatch.resize(dispatch.size() + 8);
+    patch(dispatch, kSizeOffset, static_cast<uint32_t>(dispatch.size()));
+    CHECK(!deserializes(dispatch));
+}
+
+
+TEST(deserializeChecksRootArgumentRanges) {
+    uint32_t constants[4] = {};
+    std::vector<uint8_t> setConstants = serializeCommand([&](fastdx::CommandStream& stream) {
+        stream.setGraphicsRoot32BitConstants(1, 4, constants, 60);
+    });
+    CHECK(deserializes(setConstants));
+
+    // Past the 64 DWORD root signature, including an offset that would wrap
+    std::vector<uint8_t> data = setConstants;
+    patch(data, kValueOffset, uint64_t(61));
+    CHECK(!deserializes(data));
+    patch(data, kValueOffset, UINT64_MAX - 1);
+    CHECK(!deserializes(data));
+
+    std::vector<uint8_t> setTable = serializeCommand([](fastdx::CommandStream& stream) {
+        stream.setGraphicsRootDescriptorTable(fastdx::CommandList::kMaxRootParameters - 1,
+            D3D12_GPU_DESCRIPTOR_HANDLE{ 0x1000 });
+    });
+    CHECK(deserializes(setTable));
+    patch(setTable, 16, fastdx::CommandList::kMaxRootParameters);
+    CHECK(!deserializes(setTable));
+}
+
+
+TEST(deserializeRejectsMalformedStreams) {
+    fastdx::CommandStream stream;
+    recordEveryCommand(stream, 3);
+    std::vector<uint8_t> valid;
+    stream.serialize(valid);
+    CHECK(deserializes(valid));
+
+    std::vector<uint8_t> data = valid;
+    data.resize(data.size() - 8);
+    CHECK(!deserializes(data));
+
+    data = valid;
+    patch(data, 0, static_cast<uint16_t>(fastdx::CommandStream::Opcode::Count));
+    CHECK(!deserializes(data));
+
+    data = valid;
+    patch(data, kSizeOffset, 0u);
+    CHECK(!deserializes(data));
+
+    // A rejected stream is left empty
+    fastdx::CommandStream loaded;
+    CHECK(loaded.deserialize(valid.data(), valid.size()));
+    CHECK(!loaded.deserialize(data.data(), data.size()));
+    CHECK_EQ(loaded.commandCount(), 0u);
+    CHECK_EQ(loaded.sizeInBytes(), 0u);
+}
@@ -0,0 +1,104 @@
+#include "fakes.h"
+#include "test.h"
+
+using namespace fastdx_test;
+
+namespace {
+    struct Fixture {
+        std::shared_ptr<FakeDevice> device = makeFake<FakeDevice>();
+        fastdx::D3D12DeviceWrapper wrapper{ device };
+    };
+};
+
+
+TEST(frameSizeIsRoundedToConstantBufferAlignment) {
+    Fixture fixture;
+    HRESULT hr = E_FAIL;
+    fastdx::ConstantBufferAllocatorPtr allocator = fixture.wrapper.createConstantBufferAllocator(3, 1000, &hr);
+    CHECK_EQ(hr, S_OK);
+    CHECK_EQ(allocator->frameSizeInBytes(), 1024u);
+    CHECK_EQ(allocator->buffer()->GetDesc().Width, 3u * 1024u);
+}
+
+
+TEST(allocationsAreAlignedAndLinear) {
+    Fixture fixture;
+    fastdx::ConstantBufferAllocatorPtr allocator = fixture.wrapper.createConstantBufferAllocator(2, 1024);
+    FakeResource* buffer = static_cast<FakeResource*>(allocator->buffer().get());
+    allocator->beginFrame(0);
+
+    fastdx::ConstantBufferAllocation first = allocator->allocate(4);
+    fastdx::ConstantBufferAllocation second = allocator->allocate(257);
+    CHECK(first.cpuPtr == buffer->memory.data());
+    CHECK_EQ(first.gpuAddress, buffer->gpuAddress);
+    CHECK_EQ(first.sizeInBytes, 256u);
+    CHECK(second.cpuPtr == buffer->memory.data() + 256);
+    CHECK_EQ(second.gpuAddress, buffer->gpuAddress + 256);
+    CHECK_EQ(second.sizeInBytes, 512u);
+    CHECK_EQ(allocator->frameUsedSizeInBytes(), 768u);
+}
+
+
+TEST(frameOverflowReturnsEmptyAllocation) {
+    Fixture fixture;
+    fastdx::ConstantBufferAllocatorPtr allocator = fixture.wrapper.createConstantBufferAllocator(2, 512);
+    allocator->beginFrame(1);
+    CHECK(allocator->allocate(512).cpuPtr != nullptr);
+
+    fastdx::ConstantBufferAllocation overflow = allocator->allocate(1);
+    CHECK(overflow.cpuPtr == nullptr);
+    CHECK_EQ(overflow.gpuAddress, 0u);
+    CHECK_EQ(overflow.sizeInBytes, 0u);
+    CHECK_EQ(allocator->frameUsedSizeInBytes(), 512u);
+    CHECK_EQ(allocator->failedAllocationCount(), 1u);
+
+    // Counted since construction, not per frame
+    allocator->beginFrame(0);
+    CHECK(allocator->allocate(1024).cpuPtr == nullptr);
+    CHECK_EQ(allocator->failedAllocationCount(), 2u);
+}
+
+
+TEST(beginFrameRewindsIntoTheFrameRegion) {
+    Fixture fixture;
+    fastdx::ConstantBufferAllocatorPtr allocator = fixture.wrapper.createConstantBufferAllocator(3, 1024);
+    D3D12_GPU_VIRTUAL_ADDRESS base = allocator->buffer()->GetGPUVirtualAddress();
+    for (int32_t frame = 0; frame < 6; ++frame) {
+        allocator->beginFrame(frame % 3);
+        CHECK_EQ(allocator->frameUsedSizeInBytes(), 0u);
+        CHECK_EQ(allocator->allocate(16).gpuAddress, base + (frame % 3) * 1024u);
+        CHECK_EQ(allocator->allocate(16).gpuAddress, base + (frame % 3) * 1024u + 256u);
+    }
+}
+
+
+TEST(pushCopiesData) {
+    struct Constants {
+        float values[4];
+        uint32_t index;
+    };
+
+    Fixture fixture;
+    fastdx::ConstantBufferAllocatorPtr allocator = fixture.wrapper.createConstantBufferAllocator(1, 256);
+    allocator->beginFrame(0);
+    Constants constants = { { 1.0f, 2.0f, 3.0f, 4.0f }, 7 };
+    fastdx::ConstantBufferAllocation allocation = allocator->push(constants);
+    CHECK(allocation.cpuPtr != nullptr);
+    CHECK(memcmp(allocation.cpuPtr, &constants, sizeof(constants)) == 0);
+    CHECK(allocator->push(constants).cpuPtr == nullptr);
+}
+
+
+TEST(bufferStaysMappedUntilDestruction) {
+    Fixture fixture;
+    fastdx::ConstantBufferAllocatorPtr allocator = fixture.wrapper.createConstantBufferAllocator(2, 256);
+    fastdx::ID3D12ResourcePtr buffer = allocator->buffer();
+    FakeResource* fake = static_cast<FakeResource*>(buffer.get());
+    allocator->beginFrame(0);
+    allocator->allocate(64);
+    allocator->beginFrame(1);
+    CHECK_EQ(fake->mapCount, 1);
+    CHECK_EQ(fake->unmapCount, 0);
+    allocator.reset();
+    CHECK_EQ(fake->unmapCount, 1);
+}
@@ -0,0 +1,52 @@
+#include "benchmark.h"
+#include "fakes.h"
+
+using namespace fastdx_test;
+
+namespace {
+    const uint32_t kScopeCount = 1000000;
+    const double kMaxScopeNs = 50.0;
+
+    void profileScopes() {
+        for (uint32_t i = 0; i < kScopeCount; ++i) {
+            FASTDX_PROFILE_SCOPE("scope");
+        }
+    }
+
+    // The two timestamps of each scope alone, rdtsc is much slower under some hypervisors
+    void readTicks() {
+        volatile uint64_t sink = 0;
+        for (uint32_t i = 0; i < kScopeCount; ++i) {
+            sink = fastdx::CpuProfiler::ticks();
+            sink = fastdx::CpuProfiler::ticks();
+        }
+        (void)sink;
+    }
+};
+
+
+int main() {
+    // First scope of the thread registers its ring, not timed
+    profileScopes();
+
+    printf("%u empty profiled scopes on one thread, median of 20 runs\n", kScopeCount);
+    printf("%10s %16s %16s\n", "profiler", "total (ms)", "per scope (ns)");
+
+    double scopeNs = 0.0;
+    for (bool isEnabled : { true, false }) {
+        fastdx::CpuProfiler::setEnabled(isEnabled);
+        double totalMs = medianMs(20, profileScopes);
+        double perScopeNs = totalMs * 1e6 / kScopeCount;
+        printf("%10s %16.3f %16.2f\n", isEnabled ? "enabled" : "disabled", totalMs, perScopeNs);
+        scopeNs = isEnabled ? perScopeNs : scopeNs;
+    }
+    fastdx::CpuProfiler::setEnabled(true);
+    double ticksMs = medianMs(20, readTicks);
+    printf("%10s %16.3f %16.2f\n", "ticks x2", ticksMs, ticksMs * 1e6 / kScopeCount);
+
+    if (scopeNs > kMaxScopeNs) {
+        printf("Profiled scopes cost more than %.0f ns\n", kMaxScopeNs);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include "fakes.h"
+#include "test.h"
+
+#include <thread>
+
+using namespace fastdx_test;
+
+namespace {
+    const uint32_t kEventsPerThread = fastdx::CpuProfiler::kEventsPerThread;
+
+    size_t countOf(const std::string& text, const std::string& pattern) {
+        size_t count = 0;
+        for (size_t position = text.find(pattern); position != std::string::npos;
+            position = text.find(pattern, position + 1)) {
+            ++count;
+        }
+        return count;
+    }
+
+    // Scope events of the trace named k<N>, as N and the duration
+    std::vector<std::pair<uint32_t, double>> numberedEvents(const std::string& json) {
+        std::vector<std::pair<uint32_t, double>> events;
+        for (size_t position = json.find("\n{\"name\": \"k"); position != std::string::npos;
+            position = json.find("\n{\"name\": \"k", position + 1)) {
+            std::string line = json.substr(position, json.find('}', position) + 1 - position);
+            uint32_t number = 0;
+            uint32_t threadId = 0;
+            double beginUs = 0.0;
+            double durationUs = 0.0;
+            if (sscanf(line.c_str(), "\n{\"name\": \"k%u\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, "
+                "\"ts\": %lf, \"dur\": %lf}", &number, &threadId, &beginUs, &durationUs) == 4) {
+                events.push_back({ number, durationUs });
+            }
+        }
+        return events;
+    }
+};
+
+
+TEST(ringKeepsTheLastEvents) {
+    fastdx::CpuProfiler::clear();
+    std::vector<std::string> names;
+    for (uint32_t i = 0; i < kEventsPerThread + 10; ++i) {
+        names.push_back("event" + std::to_string(i));
+    }
+    std::thread thread([&]() {
+        uint64_t ticks = fastdx::CpuProfiler::ticks();
+        for (const std::string& name : names) {
+            fastdx::CpuProfiler::record(name.c_str(), ticks, ticks);
+        }
+    });
+    thread.join();
+
+    // Wrapped, the 10 oldest events are overwritten and the slot written next is dropped too
+    std::string json = fastdx::CpuProfiler::toChromeTraceJson();
+    CHECK_EQ(countOf(json, "{\"name\": \"event"), static_cast<size_t>(kEventsPerThread - 1));
+    CHECK_EQ(countOf(json, "\"event10\""), 0u);
+    CHECK_EQ(countOf(json, "\"event11\""), 1u);
+    CHECK_EQ(countOf(json, "\"event" + std::to_string(kEventsPerThread + 9) + "\""), 1u);
+
+    fastdx::CpuProfiler::clear();
+    CHECK_EQ(countOf(fastdx::CpuProfiler::toChromeTraceJson(), "\"ph\": \"X\""), 0u);
+}
+
+
+TEST(exitedThreadsHandTheirRingToNewThreads) {
+    // Threads started one after the other, like the glTF record threads of each frame
+    fastdx::CpuProfiler::clear();
+    std::thread([]() {
+        fastdx::CpuProfiler::setThreadName("first");
+        FASTDX_PROFILE_SCOPE("firstScope");
+    }).join();
+    std::string json = fastdx::CpuProfiler::toChromeTraceJson();
+    size_t threadCount = countOf(json, "\"thread_name\"");
+
+    for (int i = 0; i < 8; ++i) {
+        std::thread([]() {
+            FASTDX_PROFILE_SCOPE("nextScope");
+        }).join();
+    }
+    json = fastdx::CpuProfiler::toChromeTraceJson();
+    CHECK_EQ(countOf(json, "\"thread_name\""), threadCount);
+    CHECK_EQ(countOf(json, "\"first\""), 0u);
+
+    // Events of exited threads stay until overwritten
+    CHECK_EQ(countOf(json, "\"firstScope\""), 1u);
+    CHECK_EQ(countOf(json, "\"nextScope\""), 8u);
+}
+
+
+TEST(disabledScopesAreNotRecorded) {
+    fastdx::CpuProfiler::clear();
+    fastdx::CpuProfiler::setEnabled(false);
+    {
+        FASTDX_PROFILE_SCOPE("disabled");
+    }
+    fastdx::CpuProfiler::setEnabled(true);
+    {
+        FASTDX_PROFILE_SCOPE("enabled");
+    }
+    std::string json = fastdx::CpuProfiler::toChromeTraceJson();
+    CHECK_EQ(countOf(json, "\"disabled\""), 0u);
+    CHECK_EQ(countOf(json, "\"enabled\""), 1u);
+}
+
+
+TEST(eventsOverwrittenWhileSavedAreDropped) {
+    // Event i lasts k * 1000 ticks with k = i % 7 + 1. The ring size is not a multiple of 7, so an event
+    // overwritten during the copy would pair a name with another event's duration
+    const char* names[] = { "k1", "k2", "k3", "k4", "k5", "k6", "k7" };
+    fastdx::CpuProfiler::clear();
+    std::atomic<bool> isDone{ false };
+    std::atomic<uint64_t> recordedCount{ 0 };
+    std::thread writer([&]() {
+        uint64_t ticks = fastdx::CpuProfiler::ticks();
+        for (uint64_t i = 0; !isDone.load(std::memory_order_relaxed); ++i) {
+            uint32_t k = static_cast<uint32_t>(i % _countof(names)) + 1;
+            fastdx::CpuProfiler::record(names[k - 1], ticks, ticks + k * 1000);
+            recordedCount.store(i + 1, std::memory_order_relaxed);
+        }
+    });
+
+    uint32_t traceCount = 0;
+    uint32_t eventCount = 0;
+    bool isConsistent = true;
+    while (traceCount < 20 || recordedCount.load() < 4 * kEventsPerThread) {
+        std::vector<std::pair<uint32_t, double>> events = numberedEvents(fastdx::CpuProfiler::toChromeTraceJson());
+        if (events.empty()) {
+            continue;
+        }
+
+        // Same tick rate for the whole trace, within the 3 decimals of the durations
+        double usPerKTicks = events[0].second / events[0].first;
+        for (const std::pair<uint32_t, double>& event : events) {
+            isConsistent &= (std::abs(event.second / event.first - usPerKTicks) <= 0.002 + 0.01 * usPerKTicks);
+        }
+        isConsistent &= (events.size() <= kEventsPerThread);
+        eventCount += static_cast<uint32_t>(events.size());
+        ++traceCount;
+    }
+    isDone = true;
+    writer.join();
+    CHECK(isConsistent);
+    printf("%u traces saved %u events while %llu were recorded\n", traceCount, eventCount,
+        static_cast<unsigned long long>(recordedCount.load()));
+    fastdx::CpuProfiler::clear();
+}
@@ -0,0 +1,125 @@
+#include "fakes.h"
+#include "test.h"
+
+#include <thread>
+
+using namespace fastdx_test;
+
+namespace {
+    struct TrackedObject : IUnknown {
+        TrackedObject(std::atomic<int>* destroyedCount) : destroyedCount(destroyedCount) {}
+        ~TrackedObject() { destroyedCount->fetch_add(1); }
+
+        std::atomic<int>* destroyedCount;
+    };
+
+    // Counts destructions that happen before the fence value the object was released at completed
+    struct FencedObject : TrackedObject {
+        FencedObject(std::atomic<int>* destroyedCount, std::atomic<int>* earlyCount,
+            const std::atomic<uint64_t>* completedFenceValue, uint64_t fenceValue) :
+            TrackedObject(destroyedCount), earlyCount(earlyCount), completedFenceValue(completedFenceValue),
+            fenceValue(fenceValue) {}
+        ~FencedObject() {
+            if (fenceValue > completedFenceValue->load()) {
+                earlyCount->fetch_add(1);
+            }
+        }
+
+        std::atomic<int>* earlyCount;
+        const std::atomic<uint64_t>* completedFenceValue;
+        uint64_t fenceValue;
+    };
+};
+
+
+TEST(objectsRetireInFenceOrder) {
+    std::atomic<int> destroyedCount = 0;
+    fastdx::DeferredReleaseQueue queue;
+    for (uint64_t fenceValue : { 5, 1, 3, 2, 4 }) {
+        queue.release(makeFake<TrackedObject>(&destroyedCount), fenceValue);
+    }
+    CHECK_EQ(queue.pendingCount(), 5u);
+
+    CHECK_EQ(queue.retire(0), 0u);
+    CHECK_EQ(destroyedCount.load(), 0);
+    CHECK_EQ(queue.retire(2), 2u);
+    CHECK_EQ(destroyedCount.load(), 2);
+    CHECK_EQ(queue.retire(2), 0u);
+    CHECK_EQ(queue.retire(4), 2u);
+    CHECK_EQ(queue.pendingCount(), 1u);
+    CHECK_EQ(queue.flush(), 1u);
+    CHECK_EQ(destroyedCount.load(), 5);
+    CHECK_EQ(queue.pendingCount(), 0u);
+}
+
+
+TEST(queueHoldsTheLastReference) {
+    std::atomic<int> destroyedCount = 0;
+    fastdx::DeferredReleaseQueue queue;
+    std::shared_ptr<TrackedObject> object = makeFake<TrackedObject>(&destroyedCount);
+    queue.release(object, 1);
+    object.reset();
+    CHECK_EQ(destroyedCount.load(), 0);
+    queue.retire(1);
+    CHECK_EQ(destroyedCount.load(), 1);
+}
+
+
+TEST(nullObjectsAreIgnored) {
+    fastdx::DeferredReleaseQueue queue;
+    queue.release(nullptr, 1);
+    CHECK_EQ(queue.pendingCount(), 0u);
+}
+
+
+TEST(destructionFlushesPendingObjects) {
+    std::atomic<int> destroyedCount = 0;
+    {
+        fastdx::DeferredReleaseQueue queue;
+        queue.release(makeFake<TrackedObject>(&destroyedCount), 100);
+    }
+    CHECK_EQ(destroyedCount.load(), 1);
+}
+
+
+TEST(concurrentReleaseDuringRetire) {
+    const int kThreadCount = 4;
+    const int kObjectsPerThread = 20000;
+    std::atomic<int> destroyedCount = 0;
+    std::atomic<int> earlyCount = 0;
+    std::atomic<uint64_t> completedFenceValue = 0;
+    std::atomic<bool> isReleasing = true;
+    fastdx::DeferredReleaseQueue queue;
+
+    // Releasers tag objects with a fence value ahead of the completed one, like frames in flight
+    std::vector<std::thread> releasers;
+    for (int t = 0; t < kThreadCount; ++t) {
+        releasers.emplace_back([&]() {
+            for (int i = 0; i < kObjectsPerThread; ++i) {
+                uint64_t fenceValue = completedFenceValue.load() + 2;
+                queue.release(makeFake<FencedObject>(&destroyedCount, &earlyCount, &completedFenceValue, fenceValue),
+                    fenceValue);
+            }
+        });
+    }
+
+    std::thread retirer([&]() {
+        while (isReleasing.load()) {
+            uint64_t fenceValue = completedFenceValue.fetch_add(1) + 1;
+            queue.retire(fenceValue);
+        }
+    });
+
+    for (std::thread& releaser : releasers) {
+        releaser.join();
+    }
+    isReleasing = false;
+    retirer.join();
+
+    int releasedCount = kThreadCount * kObjectsPerThread;
+    CHECK_EQ(static_cast<int>(queue.pendingCount()) + destroyedCount.load(), releasedCount);
+    queue.retire(completedFenceValue.fetch_add(2) + 2);
+    CHECK_EQ(queue.pendingCount(), 0u);
+    CHECK_EQ(destroyedCount.load(), releasedCount);
+    CHECK_EQ(earlyCount.load(), 0);
+}
@@ -0,0 +1,167 @@
+#include "fakes.h"
+#include "test.h"
+
+using namespace fastdx_test;
+
+
+TEST(rangeAllocatorIsFirstFit) {
+    fastdx::RangeAllocator allocator(16);
+    CHECK_EQ(allocator.allocate(4), 0u);
+    CHECK_EQ(allocator.allocate(8), 4u);
+    CHECK_EQ(allocator.allocate(8), fastdx::RangeAllocator::kInvalidOffset);
+    CHECK_EQ(allocator.allocate(4), 12u);
+    CHECK_EQ(allocator.freeSize(), 0u);
+    CHECK_EQ(allocator.allocate(1), fastdx::RangeAllocator::kInvalidOffset);
+
+    // First hole large enough, not the smallest
+    allocator.free(0, 4);
+    allocator.free(12, 4);
+    CHECK_EQ(allocator.allocate(2), 0u);
+    CHECK_EQ(allocator.allocate(4), 12u);
+    CHECK_EQ(allocator.freeSize(), 2u);
+}
+
+
+TEST(rangeAllocatorMergesFreeRanges) {
+    fastdx::RangeAllocator allocator(12);
+    uint32_t a = allocator.allocate(4);
+    uint32_t b = allocator.allocate(4);
+    uint32_t c = allocator.allocate(4);
+
+    // Merged with the following range, then with the preceding one
+    allocator.free(c, 4);
+    allocator.free(b, 4);
+    CHECK_EQ(allocator.allocate(8), 4u);
+    allocator.free(4, 8);
+    allocator.free(a, 4);
+    CHECK_EQ(allocator.freeSize(), 12u);
+    CHECK_EQ(allocator.allocate(12), 0u);
+    allocator.free(0, 12);
+
+    // Middle range freed last merges both neighbours
+    a = allocator.allocate(4);
+    b = allocator.allocate(4);
+    c = allocator.allocate(4);
+    allocator.free(a, 4);
+    allocator.free(c, 4);
+    CHECK_EQ(allocator.allocate(8), fastdx::RangeAllocator::kInvalidOffset);
+    allocator.free(b, 4);
+    CHECK_EQ(allocator.allocate(12), 0u);
+}
+
+
+TEST(stagingHeapGrowsByPages) {
+    std::shared_ptr<FakeDevice> device = makeFake<FakeDevice>();
+    fastdx::D3D12DeviceWrapper wrapper{ device };
+    fastdx::StagingDescriptorHeapPtr heap = wrapper.createStagingDescriptorHeap(
+        D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 4);
+    CHECK(device->descriptorHeapDescs.empty());
+
+    std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> handles;
+    for (int i = 0; i < 5; ++i) {
+        HRESULT hr = E_FAIL;
+        handles.push_back(heap->allocate(&hr));
+        CHECK(SUCCEEDED(hr));
+    }
+    CHECK_EQ(device->descriptorHeapDescs.size(), 2u);
+    for (const D3D12_DESCRIPTOR_HEAP_DESC& desc : device->descriptorHeapDescs) {
+        CHECK_EQ(desc.NumDescriptors, 4u);
+        CHECK(desc.Flags == D3D12_DESCRIPTOR_HEAP_FLAG_NONE);
+    }
+    for (int i = 1; i < 4; ++i) {
+        CHECK_EQ(handles[i].ptr, handles[0].ptr + i * FakeDevice::kDescriptorSize);
+    }
+    CHECK(handles[4].ptr != handles[3].ptr + FakeDevice::kDescriptorSize);
+    CHECK_EQ(heap->allocatedCount(), 5u);
+}
+
+
+TEST(stagingHeapReusesFreedDescriptors) {
+    std::shared_ptr<FakeDevice> device = makeFake<FakeDevice>();
+    fastdx::D3D12DeviceWrapper wrapper{ device };
+    fastdx::StagingDescriptorHeapPtr heap = wrapper.createStagingDescriptorHeap(
+        D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 2);
+
+    D3D12_CPU_DESCRIPTOR_HANDLE a = heap->allocate();
+    D3D12_CPU_DESCRIPTOR_HANDLE b = heap->allocate();
+    heap->free(a);
+    heap->free(D3D12_CPU_DESCRIPTOR_HANDLE{});
+    CHECK_EQ(heap->allocatedCount(), 1u);
+
+    CHECK_EQ(heap->allocate().ptr, a.ptr);
+    heap->free(b);
+    CHECK_EQ(heap->allocate().ptr, b.ptr);
+    CHECK_EQ(device->descriptorHeapDescs.size(), 1u);
+}
+
+
+TEST(shaderVisibleHeapStaticRanges) {
+    std::shared_ptr<FakeDevice> device = makeFake<FakeDevice>();
+    fastdx::D3D12DeviceWrapper wrapper{ device };
+    fastdx::ShaderVisibleDescriptorHeapPtr heap = wrapper.createShaderVisibleDescriptorHeap(
+        D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 8, 4, 2);
+    CHECK_EQ(device->descriptorHeapDescs.size(), 1u);
+    CHECK_EQ(device->descriptorHeapDescs[0].NumDescriptors, 16u);
+    CHECK(device->descriptorHeapDescs[0].Flags == D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE);
+
+    D3D12_CPU_DESCRIPTOR_HANDLE cpuStart = heap->heap()->GetCPUDescriptorHandleForHeapStart();
+    D3D12_GPU_DESCRIPTOR_HANDLE gpuStart = heap->heap()->GetGPUDescriptorHandleForHeapStart();
+    fastdx::DescriptorRange a = heap->allocateStatic(3);
+    fastdx::DescriptorRange b = heap->allocateStatic(5);
+    CHECK(a.isValid() && b.isValid());
+    CHECK_EQ(b.index, 3u);
+    CHECK_EQ(b.cpuHandle.ptr, cpuStart.ptr + 3 * FakeDevice::kDescriptorSize);
+    CHECK_EQ(b.gpu(2).ptr, gpuStart.ptr + 5 * FakeDevice::kDescriptorSize);
+
+    // Static ranges never spill into the transient ring
+    CHECK(!heap->allocateStatic(1).isValid());
+    heap->freeStatic(a);
+    CHECK_EQ(heap->allocateStatic(3).index, 0u);
+}
+
+
+TEST(shaderVisibleHeapTransientRingWraps) {
+    std::shared_ptr<FakeDevice> device = makeFake<FakeDevice>();
+    fastdx::D3D12DeviceWrapper wrapper{ device };
+    fastdx::ShaderVisibleDescriptorHeapPtr heap = wrapper.createShaderVisibleDescriptorHeap(
+        D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 8, 4, 2);
+
+    heap->beginFrame(0);
+    CHECK_EQ(heap->allocateTransient(3).index, 8u);
+    CHECK(!heap->allocateTransient(2).isValid());
+    CHECK_EQ(heap->allocateTransient(1).index, 11u);
+
+    heap->beginFrame(1);
+    CHECK_EQ(heap->allocateTransient(4).index, 12u);
+    CHECK(!heap->allocateTransient(1).isValid());
+
+    // Back to frame 0's partition, rewound
+    heap->beginFrame(0);
+    CHECK_EQ(heap->allocateTransient(4).index, 8u);
+}
+
+
+TEST(copyToTransientGathersStagingDescriptors) {
+    std::shared_ptr<FakeDevice> device = makeFake<FakeDevice>();
+    fastdx::D3D12DeviceWrapper wrapper{ device };
+    fastdx::ShaderVisibleDescriptorHeapPtr heap = wrapper.createShaderVisibleDescriptorHeap(
+        D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 0, 100, 1);
+    heap->beginFrame(0);
+
+    // More sources than one copy call takes
+    std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> sources;
+    for (SIZE_T i = 0; i < 70; ++i) {
+        sources.push_back({ 0x9000000 + i * 7 * FakeDevice::kDescriptorSize });
+    }
+    fastdx::DescriptorRange range = heap->copyToTransient(static_cast<uint32_t>(sources.size()), sources.data());
+    CHECK_EQ(range.count, 70u);
+    CHECK_EQ(device->descriptorCopies.size(), 70u);
+    for (size_t i = 0; i < device->descriptorCopies.size(); ++i) {
+        CHECK_EQ(device->descriptorCopies[i].count, 1u);
+        CHECK_EQ(device->descriptorCopies[i].source.ptr, sources[i].ptr);
+        CHECK_EQ(device->descriptorCopies[i].destination.ptr, range.cpu(static_cast<uint32_t>(i)).ptr);
+    }
+
+    CHECK(!heap->copyToTransient(31, sources.data()).isValid());
+    CHECK_EQ(device->descriptorCopies.size(), 70u);
+}
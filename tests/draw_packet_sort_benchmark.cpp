@@ -0,0 +1,65 @@
+#include "benchmark.h"
+#include "fakes.h"
+
+#include <random>
+
+using namespace fastdx_test;
+
+namespace {
+    const uint32_t kPacketCount = 1000000;
+
+    bool isSorted(const std::vector<fastdx::DrawPacket>& packets) {
+        return std::is_sorted(packets.begin(), packets.end(),
+            [](const fastdx::DrawPacket& a, const fastdx::DrawPacket& b) { return a.sortKey < b.sortKey; });
+    }
+};
+
+
+int main() {
+    // A scene's keys, few pipelines and materials, then fully random keys where no digit is skipped
+    std::mt19937_64 random(1234);
+    std::vector<uint64_t> sceneKeys(kPacketCount), randomKeys(kPacketCount);
+    for (uint32_t i = 0; i < kPacketCount; ++i) {
+        sceneKeys[i] = fastdx::DrawPacketQueue::sortKey(0, static_cast<uint16_t>(random() % 16),
+            static_cast<uint16_t>(random() % 512), static_cast<float>(random() % 1000000) / 1000000.0f);
+        randomKeys[i] = random();
+    }
+
+    printf("Sorting %u draw packets, median of 20 runs\n", kPacketCount);
+    printf("%8s %16s %16s %16s\n", "keys", "push (ms)", "radix (ms)", "std::sort (ms)");
+
+    fastdx::DrawPacketQueue queue;
+    std::vector<fastdx::DrawPacket> packets;
+    for (const char* name : { "scene", "random" }) {
+        const std::vector<uint64_t>& keys = (strcmp(name, "scene") == 0) ? sceneKeys : randomKeys;
+        auto push = [&]() {
+            queue.clear();
+            for (uint32_t i = 0; i < kPacketCount; ++i) {
+                queue.push(keys[i], i);
+            }
+        };
+
+        double pushMs = medianMs(20, push);
+        double radixMs = medianMs(20, [&]() {
+            push();
+            queue.sort();
+        }) - pushMs;
+        if (!isSorted(queue.packets())) {
+            printf("Radix sort output is not sorted\n");
+            return 1;
+        }
+
+        double stdSortMs = medianMs(20, [&]() {
+            push();
+            packets = queue.packets();
+            std::stable_sort(packets.begin(), packets.end(),
+                [](const fastdx::DrawPacket& a, const fastdx::DrawPacket& b) { return a.sortKey < b.sortKey; });
+        }) - pushMs;
+        if (!isSorted(packets)) {
+            printf("std::stable_sort output is not sorted\n");
+            return 1;
+        }
+        printf("%8s %16.3f %16.3f %16.3f\n", name, pushMs, radixMs, stdSortMs);
+    }
+    return 0;
+}
@@ -0,0 +1,402 @@
+#pragma once
+
+///
+/// Fake D3D12 objects backed by CPU memory, the device records what fastdx asks it to create
+///
+#include "fastdx.h"
+
+#include <atomic>
+#include <cstring>
+#include <cwchar>
+#include <mutex>
+#include <vector>
+
+namespace fastdx_test {
+    struct FakeResource : ID3D12Resource {
+        FakeResource(const D3D12_RESOURCE_DESC& desc, D3D12_GPU_VIRTUAL_ADDRESS gpuAddress) :
+            desc(desc), gpuAddress(gpuAddress) {
+            if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER) {
+                memory.resize(static_cast<size_t>(desc.Width));
+            }
+        }
+
+        HRESULT Map(UINT, const D3D12_RANGE*, void** data) override {
+            ++mapCount;
+            *data = memory.data();
+            return memory.empty() ? E_FAIL : S_OK;
+        }
+        void Unmap(UINT, const D3D12_RANGE*) override { ++unmapCount; }
+        D3D12_RESOURCE_DESC GetDesc() override { return desc; }
+        D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress() override { return gpuAddress; }
+
+        D3D12_RESOURCE_DESC desc;
+        D3D12_GPU_VIRTUAL_ADDRESS gpuAddress;
+        std::vector<uint8_t> memory;
+        int mapCount = 0;
+        int unmapCount = 0;
+    };
+
+    struct FakeHeap : ID3D12Heap {
+        FakeHeap(const D3D12_HEAP_DESC& desc) : desc(desc) {}
+        D3D12_HEAP_DESC GetDesc() override { return desc; }
+
+        D3D12_HEAP_DESC desc;
+    };
+
+    struct FakeDescriptorHeap : ID3D12DescriptorHeap {
+        FakeDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC& desc, SIZE_T cpuStart, UINT64 gpuStart) :
+            desc(desc), cpuStart(cpuStart), gpuStart(gpuStart) {}
+
+        D3D12_DESCRIPTOR_HEAP_DESC GetDesc() override { return desc; }
+        D3D12_CPU_DESCRIPTOR_HANDLE GetCPUDescriptorHandleForHeapStart() override { return { cpuStart }; }
+        D3D12_GPU_DESCRIPTOR_HANDLE GetGPUDescriptorHandleForHeapStart() override { return { gpuStart }; }
+
+        D3D12_DESCRIPTOR_HEAP_DESC desc;
+        SIZE_T cpuStart;
+        UINT64 gpuStart;
+    };
+
+    struct FakeCommandAllocator : ID3D12CommandAllocator {
+        HRESULT Reset() override {
+            ++resetCount;
+            return S_OK;
+        }
+
+        int resetCount = 0;
+    };
+
+    struct FakeCommandList : ID3D12GraphicsCommandList6 {
+        FakeCommandList(ID3D12CommandAllocator* allocator = nullptr) : allocator(allocator) {}
+
+        HRESULT Close() override {
+            if (isClosed) {
+                return E_FAIL;
+            }
+            isClosed = true;
+            return S_OK;
+        }
+
+        HRESULT Reset(ID3D12CommandAllocator* newAllocator, ID3D12PipelineState*) override {
+            if (!isClosed) {
+                return E_FAIL;
+            }
+            allocator = newAllocator;
+            isClosed = false;
+            ++resetCount;
+            return S_OK;
+        }
+
+        void ResourceBarrier(UINT count, const D3D12_RESOURCE_BARRIER* barriers) override {
+            barrierCalls.emplace_back(barriers, barriers + count);
+        }
+
+        ID3D12CommandAllocator* allocator;
+        bool isClosed = false;
+        int resetCount = 0;
+        std::vector<std::vector<D3D12_RESOURCE_BARRIER>> barrierCalls;
+    };
+
+    /// Signal() completes the GPU work up to value, from the test or FakeCommandQueue
+    struct FakeFence : ID3D12Fence {
+        UINT64 GetCompletedValue() override { return completedValue.load(); }
+
+        HRESULT SetEventOnCompletion(UINT64 value, HANDLE event) override {
+            std::lock_guard<std::mutex> lock(mutex);
+            waitValues.push_back(value);
+            if (completedValue.load() >= value) {
+                SetEvent(event);
+            } else {
+                pendingEvents.push_back({ value, event });
+            }
+            return S_OK;
+        }
+
+        HRESULT Signal(UINT64 value) override {
+            std::lock_guard<std::mutex> lock(mutex);
+            completedValue.store(value);
+            for (size_t i = 0; i < pendingEvents.size();) {
+                if (pendingEvents[i].first <= value) {
+                    SetEvent(pendingEvents[i].second);
+                    pendingEvents.erase(pendingEvents.begin() + i);
+                } else {
+                    ++i;
+                }
+            }
+            return S_OK;
+        }
+
+        std::atomic<UINT64> completedValue{ 0 };
+        std::mutex mutex;
+        std::vector<UINT64> waitValues;
+        std::vector<std::pair<UINT64, HANDLE>> pendingEvents;
+    };
+
+    struct FakeCommandQueue : ID3D12CommandQueue {
+        void ExecuteCommandLists(UINT count, ID3D12CommandList* const* commandLists) override {
+            executions.emplace_back(commandLists, commandLists + count);
+        }
+
+        // The GPU finishes at once when completesSignals is set, otherwise when the test signals the fence
+        HRESULT Signal(ID3D12Fence* fence, UINT64 value) override {
+            signalValues.push_back(value);
+            return completesSignals ? fence->Signal(value) : S_OK;
+        }
+
+        std::vector<std::vector<ID3D12CommandList*>> executions;
+        std::vector<UINT64> signalValues;
+        bool completesSignals = false;
+    };
+
+    struct FakePipelineState : ID3D12PipelineState {
+        FakePipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) : desc(desc) {}
+
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC desc;
+    };
+
+    /// Serialized as fixed size records, read from the memory it was created with like the runtime does. Loads
+    /// compare every byte of the desc
+    struct FakePipelineLibrary : ID3D12PipelineLibrary {
+        struct Record {
+            wchar_t name[17];
+            D3D12_GRAPHICS_PIPELINE_STATE_DESC desc;
+        };
+
+        FakePipelineLibrary(const void* data, size_t sizeInBytes) :
+            data(static_cast<const Record*>(data)), recordCount(sizeInBytes / sizeof(Record)) {}
+
+        HRESULT StorePipeline(LPCWSTR name, ID3D12PipelineState* pipelineState) override {
+            if (find(name) != nullptr) {
+                return E_INVALIDARG;
+            }
+            Record record = {};
+            wcsncpy(record.name, name, 16);
+            record.desc = static_cast<FakePipelineState*>(pipelineState)->desc;
+            storedRecords.push_back(record);
+            return S_OK;
+        }
+
+        HRESULT LoadGraphicsPipeline(LPCWSTR name, const D3D12_GRAPHICS_PIPELINE_STATE_DESC* desc, REFIID,
+            void** pipelineState) override {
+            const Record* record = find(name);
+            if (record == nullptr || !isSameDesc(record->desc, *desc)) {
+                return E_INVALIDARG;
+            }
+            *pipelineState = static_cast<ID3D12PipelineState*>(new FakePipelineState(*desc));
+            return S_OK;
+        }
+
+        SIZE_T GetSerializedSize() override { return (recordCount + storedRecords.size()) * sizeof(Record); }
+
+        HRESULT Serialize(void* outData, SIZE_T sizeInBytes) override {
+            if (sizeInBytes < GetSerializedSize()) {
+                return E_INVALIDARG;
+            }
+            Record* records = static_cast<Record*>(outData);
+            std::copy(data, data + recordCount, records);
+            std::copy(storedRecords.begin(), storedRecords.end(), records + recordCount);
+            return S_OK;
+        }
+
+        // Every byte but the render target blend padding, which struct assignments leave undefined
+        static bool isSameDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& a,
+            const D3D12_GRAPHICS_PIPELINE_STATE_DESC& b) {
+            D3D12_GRAPHICS_PIPELINE_STATE_DESC descs[2];
+            memcpy(&descs[0], &a, sizeof(a));
+            memcpy(&descs[1], &b, sizeof(b));
+            const size_t kBlendSizeInBytes = offsetof(D3D12_RENDER_TARGET_BLEND_DESC, RenderTargetWriteMask) + 1;
+            for (D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc : descs) {
+                for (D3D12_RENDER_TARGET_BLEND_DESC& renderTarget : desc.BlendState.RenderTarget) {
+                    memset(reinterpret_cast<uint8_t*>(&renderTarget) + kBlendSizeInBytes, 0,
+                        sizeof(renderTarget) - kBlendSizeInBytes);
+                }
+            }
+            return memcmp(&descs[0], &descs[1], sizeof(descs[0])) == 0;
+        }
+
+        const Record* find(LPCWSTR name) const {
+            for (size_t i = 0; i < recordCount + storedRecords.size(); ++i) {
+                const Record* record = (i < recordCount) ? &data[i] : &storedRecords[i - recordCount];
+                if (wcscmp(record->name, name) == 0) {
+                    return record;
+                }
+            }
+            return nullptr;
+        }
+
+        const Record* data;
+        size_t recordCount;
+        std::vector<Record> storedRecords;
+    };
+
+    struct FakeDevice : ID3D12Device2 {
+        static const UINT kDescriptorSize = 32;
+
+        HRESULT CheckFeatureSupport(D3D12_FEATURE feature, void* data, UINT sizeInBytes) override {
+            if (feature != D3D12_FEATURE_D3D12_OPTIONS || sizeInBytes != sizeof(D3D12_FEATURE_DATA_D3D12_OPTIONS)) {
+                return E_INVALIDARG;
+            }
+            D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+            options.ResourceHeapTier = resourceHeapTier;
+            memcpy(data, &options, sizeof(options));
+            return S_OK;
+        }
+
+        HRESULT CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE, REFIID, void** allocator) override {
+            *allocator = static_cast<ID3D12CommandAllocator*>(new FakeCommandAllocator());
+            ++commandAllocatorCount;
+            return S_OK;
+        }
+
+        HRESULT CreateCommandList(UINT, D3D12_COMMAND_LIST_TYPE, ID3D12CommandAllocator* allocator,
+            ID3D12PipelineState*, REFIID, void** commandList) override {
+            *commandList = static_cast<ID3D12GraphicsCommandList6*>(new FakeCommandList(allocator));
+            ++commandListCount;
+            return S_OK;
+        }
+
+        HRESULT CreateCommittedResource(const D3D12_HEAP_PROPERTIES*, D3D12_HEAP_FLAGS, const D3D12_RESOURCE_DESC* desc,
+            D3D12_RESOURCE_STATES, const D3D12_CLEAR_VALUE*, REFIID, void** resource) override {
+            *resource = static_cast<ID3D12Resource*>(new FakeResource(*desc, nextGpuAddress));
+            nextGpuAddress += (desc->Width + 0xFFFF) & ~0xFFFFull;
+            ++committedResourceCount;
+            return S_OK;
+        }
+
+        HRESULT CreateHeap(const D3D12_HEAP_DESC* desc, REFIID, void** heap) override {
+            if (resourceHeapTier == D3D12_RESOURCE_HEAP_TIER_1 &&
+                desc->Flags == D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES) {
+                return E_INVALIDARG;
+            }
+            heapDescs.push_back(*desc);
+            *heap = static_cast<ID3D12Heap*>(new FakeHeap(*desc));
+            return S_OK;
+        }
+
+        HRESULT CreatePlacedResource(ID3D12Heap* heap, UINT64 offset, const D3D12_RESOURCE_DESC* desc,
+            D3D12_RESOURCE_STATES, const D3D12_CLEAR_VALUE*, REFIID, void** resource) override {
+            placedResources.push_back({ heap, offset, *desc });
+            *resource = static_cast<ID3D12Resource*>(new FakeResource(*desc, nextGpuAddress));
+            nextGpuAddress += 0x10000;
+            return S_OK;
+        }
+
+        D3D12_RESOURCE_ALLOCATION_INFO GetResourceAllocationInfo(UINT, UINT, const D3D12_RESOURCE_DESC* desc) override {
+            UINT64 sizeInBytes = desc->Width * (desc->Height != 0 ? desc->Height : 1) * 4;
+            return { (sizeInBytes + 0xFFFF) & ~0xFFFFull, 0x10000 };
+        }
+
+        HRESULT CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC* desc, REFIID, void** heap) override {
+            descriptorHeapDescs.push_back(*desc);
+            *heap = static_cast<ID3D12DescriptorHeap*>(new FakeDescriptorHeap(*desc, nextCpuDescriptor,
+                (desc->Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE) ? nextGpuDescriptor : 0));
+            nextCpuDescriptor += 0x100000;
+            nextGpuDescriptor += 0x100000;
+            return S_OK;
+        }
+
+        UINT GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE) override { return kDescriptorSize; }
+
+        void CreateShaderResourceView(ID3D12Resource* resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* desc,
+            D3D12_CPU_DESCRIPTOR_HANDLE destination) override {
+            shaderResourceViews.push_back({ resource, *desc, destination });
+        }
+
+        void CreateSampler(const D3D12_SAMPLER_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE destination) override {
+            samplers.push_back({ *desc, destination });
+        }
+
+        void CopyDescriptorsSimple(UINT count, D3D12_CPU_DESCRIPTOR_HANDLE destination,
+            D3D12_CPU_DESCRIPTOR_HANDLE source, D3D12_DESCRIPTOR_HEAP_TYPE) override {
+            descriptorCopies.push_back({ count, destination, source });
+        }
+
+        // Recorded as one copy per source range, destinations are assumed to be a single range
+        void CopyDescriptors(UINT, const D3D12_CPU_DESCRIPTOR_HANDLE* destinations, const UINT*, UINT sourceCount,
+            const D3D12_CPU_DESCRIPTOR_HANDLE* sources, const UINT* sourceSizes, D3D12_DESCRIPTOR_HEAP_TYPE) override {
+            D3D12_CPU_DESCRIPTOR_HANDLE destination = destinations[0];
+            for (UINT i = 0; i < sourceCount; ++i) {
+                UINT count = sourceSizes ? sourceSizes[i] : 1;
+                descriptorCopies.push_back({ count, destination, sources[i] });
+                destination.ptr += count * kDescriptorSize;
+            }
+        }
+
+        HRESULT CreateRootSignature(UINT, const void*, SIZE_T, REFIID, void** rootSignature) override {
+            *rootSignature = new ID3D12RootSignature();
+            ++rootSignatureCount;
+            return S_OK;
+        }
+
+        HRESULT CreateGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC* desc, REFIID,
+            void** pipelineState) override {
+            *pipelineState = static_cast<ID3D12PipelineState*>(new FakePipelineState(*desc));
+            ++pipelineStateCount;
+            return S_OK;
+        }
+
+        HRESULT CreatePipelineLibrary(const void* data, SIZE_T sizeInBytes, REFIID, void** library) override {
+            if (sizeInBytes % sizeof(FakePipelineLibrary::Record) != 0) {
+                return E_INVALIDARG;
+            }
+            *library = static_cast<ID3D12PipelineLibrary*>(new FakePipelineLibrary(data, sizeInBytes));
+            return S_OK;
+        }
+
+        HRESULT MakeResident(UINT count, ID3D12Pageable* const* objects) override {
+            residentCalls.emplace_back(objects, objects + count);
+            return S_OK;
+        }
+
+        HRESULT Evict(UINT count, ID3D12Pageable* const* objects) override {
+            evictCalls.emplace_back(objects, objects + count);
+            return S_OK;
+        }
+
+        struct PlacedResource {
+            ID3D12Heap* heap;
+            UINT64 offset;
+            D3D12_RESOURCE_DESC desc;
+        };
+
+        struct ShaderResourceViewCreation {
+            ID3D12Resource* resource;
+            D3D12_SHADER_RESOURCE_VIEW_DESC desc;
+            D3D12_CPU_DESCRIPTOR_HANDLE destination;
+        };
+
+        struct SamplerCreation {
+            D3D12_SAMPLER_DESC desc;
+            D3D12_CPU_DESCRIPTOR_HANDLE destination;
+        };
+
+        struct DescriptorCopy {
+            UINT count;
+            D3D12_CPU_DESCRIPTOR_HANDLE destination;
+            D3D12_CPU_DESCRIPTOR_HANDLE source;
+        };
+
+        D3D12_RESOURCE_HEAP_TIER resourceHeapTier = D3D12_RESOURCE_HEAP_TIER_2;
+        D3D12_GPU_VIRTUAL_ADDRESS nextGpuAddress = 0x100000000ull;
+        SIZE_T nextCpuDescriptor = 0x1000000;
+        UINT64 nextGpuDescriptor = 0x2000000;
+        int committedResourceCount = 0;
+        int commandAllocatorCount = 0;
+        int commandListCount = 0;
+        int pipelineStateCount = 0;
+        int rootSignatureCount = 0;
+        std::vector<D3D12_HEAP_DESC> heapDescs;
+        std::vector<PlacedResource> placedResources;
+        std::vector<D3D12_DESCRIPTOR_HEAP_DESC> descriptorHeapDescs;
+        std::vector<ShaderResourceViewCreation> shaderResourceViews;
+        std::vector<SamplerCreation> samplers;
+        std::vector<DescriptorCopy> descriptorCopies;
+        std::vector<std::vector<ID3D12Pageable*>> residentCalls;
+        std::vector<std::vector<ID3D12Pageable*>> evictCalls;
+    };
+
+    // Shared owner of a fake, released through IUnknown like the objects fastdx creates
+    template <typename T, typename... Args>
+    inline std::shared_ptr<T> makeFake(Args&&... args) {
+        return std::shared_ptr<T>(new T(std::forward<Args>(args)...), [](T* object) { object->Release(); });
+    }
+};
@@ -0,0 +1,2 @@
+#define FASTDX_IMPLEMENTATION
+#include "fastdx.h"
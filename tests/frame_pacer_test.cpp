@@ -0,0 +1,166 @@
+#include "fakes.h"
+#include "test.h"
+
+#include <thread>
+
+using namespace fastdx_test;
+
+namespace {
+    struct FrameContextFixture {
+        FrameContextFixture(uint32_t latency) : device(makeFake<FakeDevice>()),
+            queue(makeFake<FakeCommandQueue>()), fence(makeFake<FakeFence>()),
+            frameContext(device, queue, D3D12_COMMAND_LIST_TYPE_DIRECT, fence, latency) {}
+
+        // Records a frame on the allocator of its slot, returns the slot
+        uint32_t frame() {
+            uint32_t frameSlot = frameContext.beginFrame();
+            allocators[frameSlot] = frameContext.commandAllocator();
+            frameContext.endFrame();
+            return frameSlot;
+        }
+
+        FakeCommandAllocator* allocator(uint32_t frameSlot) {
+            return static_cast<FakeCommandAllocator*>(allocators[frameSlot].get());
+        }
+
+        std::shared_ptr<FakeDevice> device;
+        std::shared_ptr<FakeCommandQueue> queue;
+        std::shared_ptr<FakeFence> fence;
+        fastdx::FrameContext frameContext;
+        fastdx::ID3D12CommandAllocatorPtr allocators[fastdx::FramePacer::kMaxLatency];
+    };
+};
+
+
+TEST(pacerWaitsForTheFrameLatencyFramesBack) {
+    fastdx::FramePacer pacer(2);
+    CHECK_EQ(pacer.beginFrame(), 0u);
+    CHECK_EQ(pacer.endFrame(), 1u);
+    CHECK_EQ(pacer.beginFrame(), 0u);
+    CHECK_EQ(pacer.endFrame(), 2u);
+    CHECK_EQ(pacer.beginFrame(), 1u);
+    CHECK_EQ(pacer.frameSlot(), 2u);
+
+    // Signals outside of a frame, e.g. uploads, do not shift the frames waited for
+    CHECK_EQ(pacer.signal(), 3u);
+    CHECK_EQ(pacer.endFrame(), 4u);
+    CHECK_EQ(pacer.beginFrame(), 2u);
+    CHECK_EQ(pacer.endFrame(), 5u);
+    CHECK_EQ(pacer.beginFrame(), 4u);
+    CHECK_EQ(pacer.frameNumber(), 4u);
+    CHECK_EQ(pacer.nextSignalValue(), 6u);
+}
+
+
+TEST(pacerLatencyIsClamped) {
+    fastdx::FramePacer pacer(0);
+    CHECK_EQ(pacer.latency(), 1u);
+    pacer.setLatency(fastdx::FramePacer::kMaxLatency + 5);
+    CHECK_EQ(pacer.latency(), fastdx::FramePacer::kMaxLatency);
+}
+
+
+TEST(pacerLatencyChangesApplyToTheNextFrame) {
+    fastdx::FramePacer pacer(3);
+    for (int i = 0; i < 3; ++i) {
+        CHECK_EQ(pacer.beginFrame(), 0u);
+        pacer.endFrame();
+    }
+
+    // Lowered, the next frame waits for the last one
+    pacer.setLatency(1);
+    CHECK_EQ(pacer.beginFrame(), 3u);
+    pacer.endFrame();
+
+    // Raised, the CPU runs ahead again without waiting for frames it already waited for
+    pacer.setLatency(4);
+    CHECK_EQ(pacer.beginFrame(), 1u);
+    pacer.endFrame();
+    CHECK_EQ(pacer.beginFrame(), 2u);
+}
+
+
+TEST(pacerSlotsAreFreeForAnyLatency) {
+    // Whatever the latency, the frame last recorded in the slot completed before the wait value
+    fastdx::FramePacer pacer(1);
+    uint64_t slotValues[fastdx::FramePacer::kMaxLatency] = {};
+    const uint32_t latencies[] = { 1, 4, 2, 3, 1, 1, 4, 4, 2 };
+    for (uint32_t frame = 0; frame < 64; ++frame) {
+        pacer.setLatency(latencies[frame % _countof(latencies)]);
+        uint64_t waitValue = pacer.beginFrame();
+        uint32_t frameSlot = pacer.frameSlot();
+        CHECK_EQ(frameSlot, frame % fastdx::FramePacer::kMaxLatency);
+        CHECK(slotValues[frameSlot] <= waitValue);
+        if (frame % 3 == 0) {
+            pacer.signal();
+        }
+        slotValues[frameSlot] = pacer.endFrame();
+    }
+}
+
+
+TEST(frameContextStallsOnlyWhenTheGpuIsBehind) {
+    FrameContextFixture fixture(2);
+    CHECK_EQ(fixture.frame(), 0u);
+    CHECK_EQ(fixture.frame(), 1u);
+    CHECK(fixture.queue->signalValues == std::vector<UINT64>({ 1, 2 }));
+
+    // Frame 0 completed, frame 2 is recorded at once
+    fixture.fence->Signal(1);
+    CHECK_EQ(fixture.frame(), 2u);
+    CHECK_EQ(fixture.frameContext.stallCount(), 0u);
+    CHECK(fixture.fence->waitValues.empty());
+
+    // Frame 1 still running, frame 3 waits for its fence value
+    std::thread gpu([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        fixture.fence->Signal(2);
+    });
+    CHECK_EQ(fixture.frameContext.beginFrame(), 3u);
+    gpu.join();
+    CHECK_EQ(fixture.frameContext.stallCount(), 1u);
+    CHECK(fixture.fence->waitValues == std::vector<UINT64>({ 2 }));
+    CHECK(fixture.frameContext.lastWaitTimeMs() > 0.0);
+    CHECK_EQ(fixture.frameContext.frameFenceValue(), 4u);
+    CHECK_EQ(fixture.frameContext.endFrame(), 4u);
+}
+
+
+TEST(frameContextReusesAllocatorsAcrossLatencyChanges) {
+    FrameContextFixture fixture(1);
+    fixture.queue->completesSignals = true;
+    CHECK_EQ(fixture.frame(), 0u);
+    CHECK_EQ(fixture.frame(), 1u);
+
+    // Slots cycle over kMaxLatency whatever the latency, one allocator each
+    fixture.frameContext.setLatency(3);
+    CHECK_EQ(fixture.frame(), 2u);
+    CHECK_EQ(fixture.frame(), 3u);
+    CHECK_EQ(fixture.device->commandAllocatorCount, 4);
+    fixture.frameContext.setLatency(2);
+    CHECK_EQ(fixture.frame(), 0u);
+    CHECK_EQ(fixture.frame(), 1u);
+    CHECK_EQ(fixture.device->commandAllocatorCount, 4);
+
+    // Reset by beginFrame() before each reuse, never while the frame using it is in flight
+    CHECK_EQ(fixture.allocator(0)->resetCount, 1);
+    CHECK_EQ(fixture.allocator(1)->resetCount, 1);
+    CHECK_EQ(fixture.allocator(2)->resetCount, 0);
+    CHECK_EQ(fixture.frameContext.stallCount(), 0u);
+}
+
+
+TEST(frameContextWaitIdleSignalsOutsideOfFrames) {
+    FrameContextFixture fixture(2);
+    fixture.queue->completesSignals = true;
+    fixture.frame();
+    fixture.frameContext.waitIdle();
+    CHECK(fixture.queue->signalValues == std::vector<UINT64>({ 1, 2 }));
+    CHECK_EQ(fixture.frameContext.completedFenceValue(), 2u);
+
+    // The frame after it signals the next value, the frames waited for are unchanged
+    CHECK_EQ(fixture.frameContext.frameFenceValue(), 3u);
+    fixture.frame();
+    CHECK_EQ(fixture.frameContext.frameNumber(), 2u);
+    CHECK(fixture.queue->signalValues == std::vector<UINT64>({ 1, 2, 3 }));
+}
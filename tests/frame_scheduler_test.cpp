@@ -0,0 +1,100 @@
+#include "fakes.h"
+#include "test.h"
+
+#include <cmath>
+
+using namespace fastdx_test;
+
+namespace {
+    // Steps of 0.25 s, exact in binary so the expected step counts and alphas are too
+    const double kStep = 0.25;
+
+    bool isNear(double a, double b) {
+        return std::abs(a - b) < 1e-6;
+    }
+};
+
+
+TEST(irregularDeltasAccumulate) {
+    fastdx::FrameScheduler scheduler(kStep);
+    double deltas[] = { 0.125, 0.0625, 0.0625, 0.625, 0.0, 0.3125 };
+    uint32_t expectedSteps[] = { 0, 0, 1, 2, 0, 1 };
+    double expectedAlphas[] = { 0.5, 0.75, 0.0, 0.5, 0.5, 0.75 };
+    for (size_t i = 0; i < _countof(deltas); ++i) {
+        CHECK_EQ(scheduler.advance(deltas[i]), expectedSteps[i]);
+        CHECK(isNear(scheduler.alpha(), expectedAlphas[i]));
+    }
+    CHECK_EQ(scheduler.stepCount(), 4u);
+    CHECK_EQ(scheduler.frameCount(), 6u);
+    CHECK_EQ(scheduler.droppedTime(), 0.0);
+
+    // Negative deltas, e.g. a clock going back, add nothing
+    CHECK_EQ(scheduler.advance(-1.0), 0u);
+    CHECK(isNear(scheduler.alpha(), 0.75));
+}
+
+
+TEST(jitteredFramesSimulateRealTime) {
+    // 60 Hz steps, frames alternating between a half and one and a half steps of a clock
+    double time = 100.0;
+    fastdx::FrameScheduler scheduler(1.0 / 60.0, 8, [&]() { return time; });
+    CHECK_EQ(scheduler.advance(), 0u);
+
+    uint32_t maxSteps = 0;
+    for (int frame = 0; frame < 600; ++frame) {
+        time += ((frame % 2) ? 1.5 : 0.5) / 60.0;
+        maxSteps = std::max(maxSteps, scheduler.advance());
+    }
+    CHECK_EQ(scheduler.stepCount(), 600u);
+    CHECK_EQ(maxSteps, 2u);
+    CHECK_EQ(scheduler.droppedTime(), 0.0);
+}
+
+
+TEST(deltasJustUnderAStepStillStep) {
+    // Vsync'd frames measured a hair short, one step every frame rather than alternating 0 and 2
+    fastdx::FrameScheduler scheduler(1.0 / 60.0);
+    for (int frame = 0; frame < 100; ++frame) {
+        CHECK_EQ(scheduler.advance((1.0 - 2e-5) / 60.0), 1u);
+    }
+}
+
+
+TEST(stepsPastTheCapAreDropped) {
+    fastdx::FrameScheduler scheduler(kStep, 4);
+    CHECK_EQ(scheduler.maxSteps(), 4u);
+
+    // 10.4 steps after a stall, 4 simulated, 6 dropped, the fraction kept for alpha
+    CHECK_EQ(scheduler.advance(2.6), 4u);
+    CHECK(isNear(scheduler.droppedTime(), 1.5));
+    CHECK(isNear(scheduler.alpha(), 0.4));
+
+    // No backlog of dropped steps on the next frame
+    CHECK_EQ(scheduler.advance(0.0), 0u);
+    CHECK_EQ(scheduler.advance(kStep), 1u);
+    CHECK_EQ(scheduler.stepCount(), 5u);
+
+    // At least one step
+    scheduler.setMaxSteps(0);
+    CHECK_EQ(scheduler.maxSteps(), 1u);
+}
+
+
+TEST(resetRestartsTiming) {
+    double time = 0.0;
+    fastdx::FrameScheduler scheduler(kStep, 8, [&]() { return time; });
+    CHECK_EQ(scheduler.advance(), 0u);
+    time = 0.625;
+    CHECK_EQ(scheduler.advance(), 2u);
+    CHECK(isNear(scheduler.alpha(), 0.5));
+
+    // A long stall, e.g. loading, is neither simulated nor counted as dropped
+    scheduler.reset();
+    time = 60.0;
+    CHECK_EQ(scheduler.advance(), 0u);
+    CHECK_EQ(scheduler.alpha(), 0.0f);
+    time = 60.25;
+    CHECK_EQ(scheduler.advance(), 1u);
+    CHECK_EQ(scheduler.droppedTime(), 0.0);
+    CHECK_EQ(scheduler.stepCount(), 3u);
+}
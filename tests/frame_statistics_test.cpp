@@ -0,0 +1,134 @@
+#include "fakes.h"
+#include "test.h"
+
+#include <thread>
+
+using namespace fastdx_test;
+
+namespace {
+    // Every timing of the frame set to value
+    fastdx::FrameTimes frameTimes(float value) {
+        fastdx::FrameTimes times;
+        for (float& timeMs : times.timesMs) {
+            timeMs = value;
+        }
+        return times;
+    }
+
+    std::vector<fastdx::FrameTimes> framesOf(const std::vector<float>& timesMs) {
+        std::vector<fastdx::FrameTimes> frames;
+        for (float timeMs : timesMs) {
+            frames.push_back(frameTimes(timeMs));
+        }
+        return frames;
+    }
+};
+
+
+TEST(percentilesUseTheNearestRank) {
+    // Shuffled 1 to 100 ms
+    std::vector<float> timesMs;
+    for (int i = 0; i < 100; ++i) {
+        timesMs.push_back(static_cast<float>((i * 37) % 100 + 1));
+    }
+    fastdx::FrameTimingSummary summary = fastdx::FrameStatistics::summarize(framesOf(timesMs),
+        fastdx::FrameTiming::Frame);
+    CHECK_EQ(summary.frameCount, 100u);
+    CHECK_EQ(summary.minMs, 1.0);
+    CHECK_EQ(summary.meanMs, 50.5);
+    CHECK_EQ(summary.p50Ms, 50.0);
+    CHECK_EQ(summary.p95Ms, 95.0);
+    CHECK_EQ(summary.p99Ms, 99.0);
+    CHECK_EQ(summary.maxMs, 100.0);
+
+    // Ranks round up, never interpolate
+    summary = fastdx::FrameStatistics::summarize(framesOf({ 4, 1, 3, 2, 10, 9, 8, 7, 6, 5 }),
+        fastdx::FrameTiming::Draw);
+    CHECK_EQ(summary.p50Ms, 5.0);
+    CHECK_EQ(summary.p95Ms, 10.0);
+    CHECK_EQ(summary.p99Ms, 10.0);
+
+    summary = fastdx::FrameStatistics::summarize(framesOf({ 7 }), fastdx::FrameTiming::Draw);
+    CHECK_EQ(summary.p50Ms, 7.0);
+    CHECK_EQ(summary.p99Ms, 7.0);
+    CHECK_EQ(fastdx::FrameStatistics::summarize({}, fastdx::FrameTiming::Draw).frameCount, 0u);
+}
+
+
+TEST(histogramBucketsClampBothEnds) {
+    fastdx::FrameStatistics statistics(16);
+    for (float timeMs : { -1.0f, 0.0f, 1.9f, 2.0f, 5.9f, 6.0f, 7.9f, 8.0f, 100.0f }) {
+        statistics.record(frameTimes(timeMs));
+    }
+
+    // [0, 2), [2, 4), [4, 6), [6, inf), negative times in the first
+    std::vector<uint32_t> buckets = statistics.histogram(fastdx::FrameTiming::Update, 2.0, 4);
+    CHECK(buckets == std::vector<uint32_t>({ 3, 1, 1, 4 }));
+
+    // Only the last frames
+    buckets = statistics.histogram(fastdx::FrameTiming::Update, 2.0, 4, 3);
+    CHECK(buckets == std::vector<uint32_t>({ 0, 0, 0, 3 }));
+
+    CHECK(statistics.histogram(fastdx::FrameTiming::Update, 2.0, 0).empty());
+    CHECK(statistics.histogram(fastdx::FrameTiming::Update, 0.0, 2) == std::vector<uint32_t>({ 0, 0 }));
+}
+
+
+TEST(snapshotsKeepTheLastFramesInOrder) {
+    // Rounded up to 8 slots
+    fastdx::FrameStatistics statistics(5);
+    CHECK_EQ(statistics.capacity(), 8u);
+    CHECK(statistics.snapshot().empty());
+
+    for (int frame = 0; frame < 12; ++frame) {
+        statistics.addTime(fastdx::FrameTiming::GpuWait, 0.5);
+        statistics.addTime(fastdx::FrameTiming::GpuWait, frame);
+        statistics.endFrame();
+    }
+    CHECK_EQ(statistics.frameCount(), 12u);
+
+    std::vector<fastdx::FrameTimes> frames = statistics.snapshot();
+    CHECK_EQ(frames.size(), 8u);
+    for (size_t i = 0; i < frames.size(); ++i) {
+        CHECK_EQ(frames[i].frameNumber, i + 4);
+        CHECK_EQ(frames[i][fastdx::FrameTiming::GpuWait], frames[i].frameNumber + 0.5f);
+        CHECK_EQ(frames[i][fastdx::FrameTiming::Frame], 0.0f);
+    }
+
+    frames = statistics.snapshot(3);
+    CHECK_EQ(frames.size(), 3u);
+    CHECK_EQ(frames[0].frameNumber, 9u);
+    CHECK_EQ(statistics.summary(fastdx::FrameTiming::GpuWait, 2).minMs, 10.5);
+}
+
+
+TEST(snapshotsNeverReturnTornFrames) {
+    // A small ring so the writer laps readers, each frame's timings all equal its number
+    const uint64_t kFrameCount = 200000;
+    fastdx::FrameStatistics statistics(4);
+    std::thread writer([&]() {
+        for (uint64_t frame = 0; frame < kFrameCount; ++frame) {
+            statistics.record(frameTimes(static_cast<float>(frame)));
+        }
+    });
+
+    uint64_t snapshotCount = 0;
+    uint64_t frameCount = 0;
+    bool isConsistent = true;
+    while (statistics.frameCount() < kFrameCount) {
+        std::vector<fastdx::FrameTimes> frames = statistics.snapshot();
+        for (size_t i = 0; i < frames.size(); ++i) {
+            for (float timeMs : frames[i].timesMs) {
+                isConsistent &= (timeMs == static_cast<float>(frames[i].frameNumber));
+            }
+            isConsistent &= (i == 0 || frames[i].frameNumber > frames[i - 1].frameNumber);
+        }
+        ++snapshotCount;
+        frameCount += frames.size();
+    }
+    writer.join();
+    CHECK(isConsistent);
+    CHECK_EQ(statistics.snapshot().back().frameNumber, kFrameCount - 1);
+    printf("%llu snapshots read %llu frames while recording\n", static_cast<unsigned long long>(snapshotCount),
+        static_cast<unsigned long long>(frameCount));
+}
@@ -0,0 +1,180 @@
+#include "fakes.h"
+#include "test.h"
+
+using namespace fastdx_test;
+
+namespace {
+    // First query and query count of each call
+    typedef std::vector<std::pair<uint32_t, uint32_t>> QueryRanges;
+
+    /// Timestamp queries on a GPU clock ticking once per query, one tick per millisecond. Callbacks are logged in
+    /// call order
+    struct GpuProfilerFixture {
+        GpuProfilerFixture(uint32_t maxScopesPerFrame) : commandList(makeFake<FakeCommandList>()),
+            profiler(1000, maxScopesPerFrame,
+                [this](ID3D12GraphicsCommandList*, uint32_t query) {
+                    queries.resize(std::max<size_t>(queries.size(), query + 1));
+                    queries[query] = gpuClock++;
+                    ++timestampCount;
+                },
+                [this](ID3D12GraphicsCommandList*, uint32_t firstQuery, uint32_t queryCount) {
+                    resolves.push_back({ firstQuery, queryCount });
+                    readbackBuffer.resize(std::max<size_t>(readbackBuffer.size(), firstQuery + queryCount));
+                    std::copy(queries.begin() + firstQuery, queries.begin() + firstQuery + queryCount,
+                        readbackBuffer.begin() + firstQuery);
+                },
+                [this](uint32_t firstQuery, uint32_t queryCount, uint64_t* outTimestamps) {
+                    readbacks.push_back({ firstQuery, queryCount });
+                    std::copy(readbackBuffer.begin() + firstQuery, readbackBuffer.begin() + firstQuery + queryCount,
+                        outTimestamps);
+                }) {}
+
+        // A frame with a single scope, signaled with fenceValue
+        void frame(uint64_t completedFenceValue, uint64_t fenceValue) {
+            profiler.beginFrame(completedFenceValue);
+            profiler.beginScope(commandList.get(), "frame");
+            profiler.endFrame(commandList.get(), fenceValue);
+        }
+
+        std::shared_ptr<FakeCommandList> commandList;
+        fastdx::GpuProfiler profiler;
+        uint64_t gpuClock = 100;
+        uint32_t timestampCount = 0;
+        std::vector<uint64_t> queries;
+        std::vector<uint64_t> readbackBuffer;
+        QueryRanges resolves;
+        QueryRanges readbacks;
+    };
+};
+
+
+TEST(scopesNestDepthFirst) {
+    GpuProfilerFixture fixture(8);
+    fastdx::GpuProfiler& profiler = fixture.profiler;
+    ID3D12GraphicsCommandList* commandList = fixture.commandList.get();
+
+    profiler.beginFrame(0);
+    profiler.beginScope(commandList, "a");
+    {
+        fastdx::GpuProfilerScope b(&profiler, commandList, "b");
+    }
+    profiler.beginScope(commandList, "c");
+    profiler.beginScope(commandList, "d");
+    profiler.endScope(commandList);
+    profiler.endScope(commandList);
+    profiler.endScope(commandList);
+    // Left open, endFrame() closes it
+    profiler.beginScope(commandList, "e");
+    profiler.endFrame(commandList, 1);
+    CHECK_EQ(fixture.timestampCount, 10u);
+    CHECK(fixture.resolves == QueryRanges({ { 0, 10 } }));
+
+    // Read back once the fence value completed
+    profiler.beginFrame(0);
+    CHECK(fixture.readbacks.empty());
+    profiler.beginFrame(1);
+    CHECK_EQ(profiler.resolvedFrameCount(), 1u);
+
+    const std::vector<fastdx::GpuTimingNode>& nodes = profiler.lastFrameTimings().nodes;
+    CHECK_EQ(nodes.size(), 5u);
+    const char* names[] = { "a", "b", "c", "d", "e" };
+    uint32_t parents[] = { fastdx::GpuTimingNode::kInvalidParent, 0, 0, 2, fastdx::GpuTimingNode::kInvalidParent };
+    uint32_t depths[] = { 0, 1, 1, 2, 0 };
+    double beginsMs[] = { 0.0, 1.0, 3.0, 4.0, 8.0 };
+    double durationsMs[] = { 7.0, 1.0, 3.0, 1.0, 1.0 };
+    for (size_t i = 0; i < nodes.size() && i < _countof(names); ++i) {
+        CHECK(nodes[i].name == names[i]);
+        CHECK_EQ(nodes[i].parent, parents[i]);
+        CHECK_EQ(nodes[i].depth, depths[i]);
+        CHECK_EQ(nodes[i].beginMs, beginsMs[i]);
+        CHECK_EQ(nodes[i].durationMs, durationsMs[i]);
+    }
+    CHECK(profiler.lastFrameTimings().toString() == "a 7.000 ms\n  b 1.000 ms\n  c 3.000 ms\n    d 1.000 ms\n"
+        "e 1.000 ms\n");
+}
+
+
+TEST(scopesPastTheLimitDropWithTheirChildren) {
+    GpuProfilerFixture fixture(2);
+    fastdx::GpuProfiler& profiler = fixture.profiler;
+    ID3D12GraphicsCommandList* commandList = fixture.commandList.get();
+
+    profiler.beginFrame(0);
+    profiler.beginScope(commandList, "a");
+    profiler.beginScope(commandList, "b");
+    profiler.endScope(commandList);
+    profiler.beginScope(commandList, "dropped");
+    profiler.beginScope(commandList, "child");
+    profiler.endScope(commandList);
+    profiler.endScope(commandList);
+    // Still closes a, not a dropped scope
+    profiler.endScope(commandList);
+    profiler.endFrame(commandList, 1);
+
+    CHECK_EQ(profiler.droppedScopeCount(), 2u);
+    CHECK_EQ(fixture.timestampCount, 4u);
+    CHECK(fixture.resolves == QueryRanges({ { 0, 4 } }));
+
+    profiler.beginFrame(1);
+    const std::vector<fastdx::GpuTimingNode>& nodes = profiler.lastFrameTimings().nodes;
+    CHECK_EQ(nodes.size(), 2u);
+    CHECK_EQ(nodes[0].durationMs, 3.0);
+    CHECK_EQ(nodes[1].parent, 0u);
+
+    // The next frame starts with an empty budget
+    profiler.beginScope(commandList, "a");
+    profiler.beginScope(commandList, "b");
+    profiler.endFrame(commandList, 2);
+    CHECK_EQ(profiler.droppedScopeCount(), 2u);
+    CHECK_EQ(fixture.resolves.back().first, profiler.maxScopesPerFrame() * 2);
+}
+
+
+TEST(framesAreReadBackInSubmissionOrder) {
+    GpuProfilerFixture fixture(4);
+    fastdx::GpuProfiler& profiler = fixture.profiler;
+    const uint32_t kQueriesPerFrame = 2 * profiler.maxScopesPerFrame();
+    fixture.frame(0, 1);
+    fixture.frame(0, 2);
+    // Without scopes, nothing to resolve or read back
+    profiler.beginFrame(0);
+    profiler.endFrame(fixture.commandList.get(), 3);
+    fixture.frame(0, 4);
+    CHECK_EQ(fixture.resolves.size(), 3u);
+
+    // Every completed frame, oldest first, never one still in flight
+    fixture.frame(2, 5);
+    CHECK(fixture.readbacks == QueryRanges({ { 0, 2 }, { kQueriesPerFrame, 2 } }));
+    CHECK_EQ(profiler.lastFrameTimings().frameNumber, 1u);
+    fixture.frame(5, 6);
+    CHECK_EQ(fixture.readbacks.size(), 4u);
+    CHECK_EQ(fixture.readbacks[2].first, 3 * kQueriesPerFrame);
+    CHECK_EQ(fixture.readbacks[3].first, 4 * kQueriesPerFrame);
+    CHECK_EQ(profiler.lastFrameTimings().frameNumber, 4u);
+    CHECK_EQ(profiler.resolvedFrameCount(), 4u);
+    CHECK_EQ(profiler.droppedFrameCount(), 0u);
+}
+
+
+TEST(framesStillInFlightAreNotProfiled) {
+    GpuProfilerFixture fixture(4);
+    fastdx::GpuProfiler& profiler = fixture.profiler;
+    for (uint64_t fenceValue = 1; fenceValue <= fastdx::GpuProfiler::kFrameCount; ++fenceValue) {
+        fixture.frame(0, fenceValue);
+    }
+
+    // The GPU is kFrameCount frames behind, the next frame's queries are still in use
+    uint32_t timestampCount = fixture.timestampCount;
+    fixture.frame(0, fastdx::GpuProfiler::kFrameCount + 1);
+    CHECK_EQ(profiler.droppedFrameCount(), 1u);
+    CHECK_EQ(fixture.timestampCount, timestampCount);
+    CHECK_EQ(fixture.resolves.size(), static_cast<size_t>(fastdx::GpuProfiler::kFrameCount));
+
+    // Once its range was read back it is reused, the dropped frame keeps its number
+    fixture.frame(2, fastdx::GpuProfiler::kFrameCount + 2);
+    CHECK_EQ(fixture.readbacks.size(), 2u);
+    CHECK_EQ(profiler.droppedFrameCount(), 1u);
+    CHECK_EQ(fixture.resolves.back().first, 2 * profiler.maxScopesPerFrame());
+    fixture.frame(fastdx::GpuProfiler::kFrameCount + 2, fastdx::GpuProfiler::kFrameCount + 3);
+    CHECK_EQ(profiler.lastFrameTimings().frameNumber, fastdx::GpuProfiler::kFrameCount + 1);
+}
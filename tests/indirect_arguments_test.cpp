@@ -0,0 +1,113 @@
+#include "fakes.h"
+#include "test.h"
+
+using namespace fastdx_test;
+
+namespace {
+    // The glTF sample layout
+    struct DrawLayout {
+        DrawLayout() {
+            indexBuffer = layout.addIndexBufferView();
+            constants = layout.addConstants(1, 3);
+            drawIndexed = layout.addDrawIndexed();
+        }
+
+        fastdx::IndirectArgumentLayout layout;
+        uint32_t indexBuffer;
+        uint32_t constants;
+        uint32_t drawIndexed;
+    };
+};
+
+
+TEST(argumentsArePackedInOrder) {
+    DrawLayout draw;
+    CHECK_EQ(draw.layout.argumentCount(), 3u);
+    CHECK_EQ(draw.layout.offset(draw.indexBuffer), 0u);
+    CHECK_EQ(draw.layout.sizeInBytes(draw.indexBuffer), sizeof(D3D12_INDEX_BUFFER_VIEW));
+    CHECK_EQ(draw.layout.offset(draw.constants), sizeof(D3D12_INDEX_BUFFER_VIEW));
+    CHECK_EQ(draw.layout.sizeInBytes(draw.constants), 3 * sizeof(uint32_t));
+    CHECK_EQ(draw.layout.offset(draw.drawIndexed), sizeof(D3D12_INDEX_BUFFER_VIEW) + 3 * sizeof(uint32_t));
+    CHECK_EQ(draw.layout.strideInBytes(), sizeof(D3D12_INDEX_BUFFER_VIEW) + 3 * sizeof(uint32_t) +
+        sizeof(D3D12_DRAW_INDEXED_ARGUMENTS));
+
+    const D3D12_INDIRECT_ARGUMENT_DESC& constantsDesc = draw.layout.argumentDescs()[draw.constants];
+    CHECK(constantsDesc.Type == D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT);
+    CHECK_EQ(constantsDesc.Constant.RootParameterIndex, 1u);
+    CHECK_EQ(constantsDesc.Constant.Num32BitValuesToSet, 3u);
+    CHECK_EQ(constantsDesc.Constant.DestOffsetIn32BitValues, 0u);
+
+    D3D12_COMMAND_SIGNATURE_DESC signatureDesc = draw.layout.commandSignatureDesc();
+    CHECK_EQ(signatureDesc.ByteStride, draw.layout.strideInBytes());
+    CHECK_EQ(signatureDesc.NumArgumentDescs, 3u);
+    CHECK(signatureDesc.pArgumentDescs == draw.layout.argumentDescs().data());
+}
+
+
+TEST(onlyRootArgumentsNeedARootSignature) {
+    DrawLayout draw;
+    CHECK(draw.layout.changesRootArguments());
+
+    fastdx::IndirectArgumentLayout buffers;
+    buffers.addVertexBufferView(0);
+    buffers.addIndexBufferView();
+    buffers.addDraw();
+    CHECK(!buffers.changesRootArguments());
+
+    fastdx::IndirectArgumentLayout dispatch;
+    dispatch.addConstantBufferView(0);
+    dispatch.addDispatch();
+    CHECK(dispatch.changesRootArguments());
+    CHECK_EQ(dispatch.strideInBytes(), sizeof(D3D12_GPU_VIRTUAL_ADDRESS) + sizeof(D3D12_DISPATCH_ARGUMENTS));
+}
+
+
+TEST(writerPacksCommandsAtTheStride) {
+    DrawLayout draw;
+    const uint32_t kCommandCount = 3;
+    std::vector<uint8_t> data(kCommandCount * draw.layout.strideInBytes(), 0xCD);
+    fastdx::IndirectArgumentWriter writer(draw.layout, data.data(), data.size());
+
+    for (uint32_t i = 0; i < kCommandCount; ++i) {
+        CHECK(writer.beginCommand());
+        uint32_t constants[] = { i, i + 10, i + 20 };
+        writer.write(draw.indexBuffer, D3D12_INDEX_BUFFER_VIEW{ 0x10000ull * i, 36 * 2, DXGI_FORMAT_R16_UINT });
+        writer.write(draw.constants, constants);
+        writer.write(draw.drawIndexed, D3D12_DRAW_INDEXED_ARGUMENTS{ 36, 1, 0, 0, i });
+    }
+    CHECK_EQ(writer.commandCount(), kCommandCount);
+    CHECK_EQ(writer.sizeInBytes(), data.size());
+
+    for (uint32_t i = 0; i < kCommandCount; ++i) {
+        const uint8_t* command = data.data() + i * draw.layout.strideInBytes();
+        D3D12_INDEX_BUFFER_VIEW indexBufferView;
+        memcpy(&indexBufferView, command + draw.layout.offset(draw.indexBuffer), sizeof(indexBufferView));
+        CHECK_EQ(indexBufferView.BufferLocation, 0x10000ull * i);
+        uint32_t constants[3];
+        memcpy(constants, command + draw.layout.offset(draw.constants), sizeof(constants));
+        CHECK_EQ(constants[2], i + 20);
+        D3D12_DRAW_INDEXED_ARGUMENTS arguments;
+        memcpy(&arguments, command + draw.layout.offset(draw.drawIndexed), sizeof(arguments));
+        CHECK_EQ(arguments.IndexCountPerInstance, 36u);
+        CHECK_EQ(arguments.StartInstanceLocation, i);
+    }
+}
+
+
+TEST(writerStopsWhenFull) {
+    DrawLayout draw;
+    // Room for two commands and a partial third
+    std::vector<uint8_t> data(2 * draw.layout.strideInBytes() + draw.layout.strideInBytes() / 2);
+    fastdx::IndirectArgumentWriter writer(draw.layout, data.data(), data.size());
+    CHECK(writer.beginCommand());
+    CHECK(writer.beginCommand());
+    CHECK(!writer.beginCommand());
+    CHECK(!writer.beginCommand());
+    CHECK_EQ(writer.commandCount(), 2u);
+    CHECK_EQ(writer.sizeInBytes(), 2u * draw.layout.strideInBytes());
+
+    // A failed allocation gives an empty region, nothing is written
+    fastdx::IndirectArgumentWriter emptyWriter(draw.layout, nullptr, 0);
+    CHECK(!emptyWriter.beginCommand());
+    CHECK_EQ(emptyWriter.commandCount(), 0u);
+}
@@ -0,0 +1,134 @@
+#include "fakes.h"
+#include "test.h"
+
+using namespace fastdx_test;
+
+namespace {
+    const uint8_t kVertexShader[] = { 'D', 'X', 'B', 'C', 1, 2, 3, 4 };
+    const uint8_t kPixelShader[] = { 'D', 'X', 'B', 'C', 5, 6, 7, 8 };
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC pipelineDesc() {
+        // The fake library compares padding bytes too
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC desc;
+        memset(&desc, 0, sizeof(desc));
+        desc.pRootSignature = reinterpret_cast<ID3D12RootSignature*>(0x1000);
+        desc.VS = { kVertexShader, sizeof(kVertexShader) };
+        desc.PS = { kPixelShader, sizeof(kPixelShader) };
+        desc.SampleMask = 0xffffffff;
+        desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+        desc.NumRenderTargets = 1;
+        desc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+        desc.SampleDesc.Count = 1;
+        return desc;
+    }
+
+    // Same pipeline, fields the runtime ignores set to other values
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC pipelineDescWithIgnoredFields() {
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = pipelineDesc();
+        desc.BlendState.RenderTarget[0].SrcBlend = D3D12_BLEND_SRC_ALPHA;
+        desc.BlendState.RenderTarget[3].BlendEnable = TRUE;
+        desc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_GREATER;
+        desc.DepthStencilState.StencilReadMask = 0x0f;
+        desc.RasterizerState.SlopeScaledDepthBias = -0.0f;
+        desc.RTVFormats[5] = DXGI_FORMAT_R16G16B16A16_FLOAT;
+        desc.HS = { nullptr, 64 };
+        desc.CachedPSO = { kPixelShader, sizeof(kPixelShader) };
+        return desc;
+    }
+
+    std::filesystem::path libraryPath(const char* name) {
+        std::filesystem::path path = std::filesystem::temp_directory_path() / name;
+        std::filesystem::remove(path);
+        return path;
+    }
+};
+
+
+TEST(ignoredFieldsShareOnePipeline) {
+    std::shared_ptr<FakeDevice> device = makeFake<FakeDevice>();
+    fastdx::PipelineStateCache cache(device);
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = pipelineDesc();
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC other = pipelineDescWithIgnoredFields();
+    CHECK_EQ(cache.hash(desc), cache.hash(other));
+
+    fastdx::ID3D12PipelineStatePtr pipelineState = cache.graphicsPipelineState(desc);
+    CHECK(pipelineState != nullptr);
+    CHECK(cache.graphicsPipelineState(other) == pipelineState);
+    CHECK_EQ(device->pipelineStateCount, 1);
+    CHECK_EQ(cache.hitCount(), 1u);
+
+    // A field the runtime reads is a different pipeline
+    other.RTVFormats[0] = DXGI_FORMAT_B8G8R8A8_UNORM;
+    CHECK(cache.hash(desc) != cache.hash(other));
+    CHECK(cache.graphicsPipelineState(other) != pipelineState);
+    CHECK_EQ(device->pipelineStateCount, 2);
+}
+
+
+TEST(savedLibraryLoadsCanonicalDescs) {
+    std::filesystem::path path = libraryPath("fastdx_pipeline_state_cache_test.bin");
+    std::shared_ptr<FakeDevice> device = makeFake<FakeDevice>();
+    {
+        fastdx::PipelineStateCache cache(device);
+        CHECK(SUCCEEDED(cache.load(path)));
+        CHECK(cache.graphicsPipelineState(pipelineDesc()) != nullptr);
+        CHECK_EQ(cache.compileCount(), 1u);
+        CHECK(cache.save(path) == S_OK);
+        CHECK(cache.save(path) == S_FALSE);
+    }
+
+    // The stored desc is the canonical one, the runtime compares it byte for byte with the requested desc
+    fastdx::PipelineStateCache cache(device);
+    CHECK(SUCCEEDED(cache.load(path)));
+    CHECK(cache.graphicsPipelineState(pipelineDescWithIgnoredFields()) != nullptr);
+    CHECK_EQ(cache.libraryHitCount(), 1u);
+    CHECK_EQ(cache.compileCount(), 0u);
+    CHECK_EQ(device->pipelineStateCount, 1);
+    CHECK(cache.save(path) == S_FALSE);
+    std::filesystem::remove(path);
+}
+
+
+TEST(corruptLibraryStartsOver) {
+    std::filesystem::path path = libraryPath("fastdx_pipeline_state_cache_corrupt.bin");
+    {
+        std::ofstream file(path, std::ios::binary);
+        file.write("corrupt", 7);
+    }
+    std::shared_ptr<FakeDevice> device = makeFake<FakeDevice>();
+    fastdx::PipelineStateCache cache(device);
+    CHECK(SUCCEEDED(cache.load(path)));
+    CHECK(cache.graphicsPipelineState(pipelineDesc()) != nullptr);
+    CHECK_EQ(cache.compileCount(), 1u);
+    CHECK(cache.save(path) == S_OK);
+    std::filesystem::remove(path);
+}
+
+
+TEST(reloadKeepsLibraryInUseAlive) {
+    std::filesystem::path path = libraryPath("fastdx_pipeline_state_cache_reload.bin");
+    std::shared_ptr<FakeDevice> device = makeFake<FakeDevice>();
+    {
+        fastdx::PipelineStateCache cache(device);
+        cache.load(path);
+        cache.graphicsPipelineState(pipelineDesc());
+        cache.save(path);
+    }
+
+    // Loads read the library data while another thread replaces the library
+    fastdx::PipelineStateCache cache(device);
+    CHECK(SUCCEEDED(cache.load(path)));
+    std::thread loader([&cache]() {
+        for (int i = 0; i < 200; ++i) {
+            D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = pipelineDesc();
+            desc.SampleDesc.Quality = i;
+            cache.graphicsPipelineState(desc);
+        }
+    });
+    for (int i = 0; i < 200; ++i) {
+        CHECK(SUCCEEDED(cache.load(path)));
+    }
+    loader.join();
+    CHECK_EQ(cache.size(), 200u);
+    std::filesystem::remove(path);
+}
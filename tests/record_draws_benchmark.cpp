@@ -0,0 +1,80 @@
+#include "benchmark.h"
+#include "fakes.h"
+
+using namespace fastdx_test;
+
+namespace {
+    const uint32_t kDrawCount = 100000;
+    const uint32_t kDrawsPerPipeline = 100;
+
+    // What the glTF sample records per mesh part
+    template <typename CommandListType>
+    void recordDraws(CommandListType& commandList, uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+            if (i == begin || i % kDrawsPerPipeline == 0) {
+                commandList.setPipelineState(reinterpret_cast<ID3D12PipelineState*>(
+                    uintptr_t(0x1000 + i / kDrawsPerPipeline * 0x10)));
+            }
+            D3D12_INDEX_BUFFER_VIEW indexBufferView = { 0x100000000ull + i * 0x10000ull, 0x10000,
+                DXGI_FORMAT_R32_UINT };
+            D3D12_VERTEX_BUFFER_VIEW vertexBufferView = { 0x200000000ull + i * 0x10000ull, 0x10000, 32 };
+            uint32_t constants[] = { i, i * 2, i * 3, i * 4 };
+            commandList.setIndexBuffer(indexBufferView);
+            commandList.setVertexBuffers(0, 1, &vertexBufferView);
+            commandList.setGraphicsRoot32BitConstants(1, _countof(constants), constants, 0);
+            commandList.drawIndexedInstanced(36, 1, 0, 0, 0);
+        }
+    }
+};
+
+
+int main() {
+    std::shared_ptr<FakeDevice> device = makeFake<FakeDevice>();
+    fastdx::D3D12DeviceWrapper wrapper{ device };
+    fastdx::CommandContextPoolPtr pool = wrapper.createCommandContextPool(D3D12_COMMAND_LIST_TYPE_DIRECT);
+    std::shared_ptr<FakeCommandQueue> queue = makeFake<FakeCommandQueue>();
+
+    printf("Recording %u draws, median of 20 runs\n", kDrawCount);
+    printf("%8s %16s %16s %16s\n", "threads", "streams (ms)", "replay (ms)", "lists (ms)");
+
+    uint32_t maxThreadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    for (uint32_t threadCount = 1; threadCount <= std::min(maxThreadCount, 16u); threadCount *= 2) {
+        fastdx::WorkerPool workers(threadCount);
+
+        // One command stream per part, replayed in order on one thread like the glTF sample
+        std::vector<fastdx::CommandStream> streams(threadCount);
+        double streamsMs = medianMs(20, [&]() {
+            workers.run(threadCount, [&](uint32_t part) {
+                std::pair<uint32_t, uint32_t> range = fastdxu::partitionRange(kDrawCount, threadCount, part);
+                streams[part].reset();
+                recordDraws(streams[part], range.first, range.second);
+            });
+        });
+        fastdx::NullCommandList nullList;
+        double replayMs = medianMs(20, [&]() {
+            for (const fastdx::CommandStream& stream : streams) {
+                stream.replay(nullList);
+            }
+        });
+
+        // One pooled command list per part, submitted with a single call
+        uint64_t fenceValue = 0;
+        double listsMs = medianMs(20, [&]() {
+            pool->beginFrame(fenceValue);
+            workers.run(threadCount, [&](uint32_t part) {
+                std::pair<uint32_t, uint32_t> range = fastdxu::partitionRange(kDrawCount, threadCount, part);
+                fastdx::CommandList commandList(pool->acquire(part).commandList);
+                recordDraws(commandList, range.first, range.second);
+            });
+            pool->submit(queue, ++fenceValue);
+        });
+
+        if (nullList.drawCount() != 20ull * kDrawCount) {
+            printf("Replayed %llu draws instead of %llu\n", static_cast<unsigned long long>(nullList.drawCount()),
+                20ull * kDrawCount);
+            return 1;
+        }
+        printf("%8u %16.3f %16.3f %16.3f\n", threadCount, streamsMs, replayMs, listsMs);
+    }
+    return 0;
+}
@@ -0,0 +1,175 @@
+#include "fakes.h"
+#include "test.h"
+
+using namespace fastdx_test;
+
+namespace {
+    D3D12_RESOURCE_DESC textureDesc(uint64_t width, D3D12_RESOURCE_FLAGS flags, uint32_t sampleCount = 1) {
+        D3D12_RESOURCE_DESC desc = {};
+        desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+        desc.Width = width;
+        desc.Height = 256;
+        desc.DepthOrArraySize = 1;
+        desc.MipLevels = 1;
+        desc.SampleDesc.Count = sampleCount;
+        desc.Flags = flags;
+        return desc;
+    }
+
+    D3D12_RESOURCE_DESC bufferDesc(uint64_t sizeInBytes) {
+        D3D12_RESOURCE_DESC desc = {};
+        desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+        desc.Width = sizeInBytes;
+        desc.Height = 1;
+        desc.DepthOrArraySize = 1;
+        desc.MipLevels = 1;
+        desc.SampleDesc.Count = 1;
+        return desc;
+    }
+
+    struct RenderGraphFixture {
+        RenderGraphFixture(D3D12_RESOURCE_HEAP_TIER resourceHeapTier) : device(makeFake<FakeDevice>()),
+            commandList(makeFake<ID3D12GraphicsCommandList6>()) {
+            device->resourceHeapTier = resourceHeapTier;
+            renderGraph = std::make_shared<fastdx::RenderGraph>(device, 2, [this](const D3D12_RESOURCE_DESC& desc) {
+                // MSAA textures need the 4 MB placement alignment
+                D3D12_RESOURCE_ALLOCATION_INFO info = device->GetResourceAllocationInfo(0, 1, &desc);
+                if (desc.SampleDesc.Count > 1) {
+                    info.Alignment = D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT;
+                }
+                return info;
+            });
+        }
+
+        // One pass writing each resource, all alive together
+        void declareFrame(const std::vector<D3D12_RESOURCE_DESC>& descs) {
+            renderGraph->reset();
+            uint32_t pass = renderGraph->addPass("pass", [](fastdx::ID3D12GraphicsCommandListPtr) {}, true);
+            for (const D3D12_RESOURCE_DESC& desc : descs) {
+                bool isBuffer = (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER);
+                renderGraph->write(pass, renderGraph->createTexture("resource", desc),
+                    isBuffer ? D3D12_RESOURCE_STATE_UNORDERED_ACCESS : D3D12_RESOURCE_STATE_RENDER_TARGET);
+            }
+            renderGraph->compile();
+        }
+
+        HRESULT execute(int32_t frameIndex) {
+            return renderGraph->execute(frameIndex, [this]() { return commandList; });
+        }
+
+        ID3D12Heap* placedHeap(uint64_t width) {
+            for (const FakeDevice::PlacedResource& placed : device->placedResources) {
+                if (placed.desc.Width == width) {
+                    return placed.heap;
+                }
+            }
+            return nullptr;
+        }
+
+        std::shared_ptr<FakeDevice> device;
+        fastdx::ID3D12GraphicsCommandListPtr commandList;
+        fastdx::RenderGraphPtr renderGraph;
+    };
+};
+
+
+TEST(tier2PlacesEverythingInOneHeap) {
+    RenderGraphFixture fixture(D3D12_RESOURCE_HEAP_TIER_2);
+    fixture.declareFrame({ textureDesc(256, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET),
+        textureDesc(512, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS), bufferDesc(65536) });
+    CHECK(SUCCEEDED(fixture.execute(0)));
+
+    CHECK_EQ(fixture.device->heapDescs.size(), 1u);
+    CHECK(fixture.device->heapDescs[0].Flags == D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES);
+    CHECK_EQ(fixture.device->heapDescs[0].SizeInBytes, fixture.renderGraph->heapSizeInBytes());
+    CHECK_EQ(fixture.device->placedResources.size(), 3u);
+    CHECK(fixture.placedHeap(256) == fixture.placedHeap(512));
+    CHECK(fixture.placedHeap(256) == fixture.placedHeap(65536));
+}
+
+
+TEST(tier1PlacesEachCategoryInItsOwnHeap) {
+    RenderGraphFixture fixture(D3D12_RESOURCE_HEAP_TIER_1);
+    fixture.declareFrame({ textureDesc(256, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET),
+        textureDesc(512, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL),
+        textureDesc(1024, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS), bufferDesc(65536) });
+    CHECK(SUCCEEDED(fixture.execute(0)));
+
+    // The fake rejects heaps allowing every category on tier 1
+    CHECK_EQ(fixture.device->heapDescs.size(), 3u);
+    auto heapFlags = [](ID3D12Heap* heap) { return static_cast<FakeHeap*>(heap)->desc.Flags; };
+    CHECK(heapFlags(fixture.placedHeap(256)) == D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES);
+    CHECK(fixture.placedHeap(512) == fixture.placedHeap(256));
+    CHECK(heapFlags(fixture.placedHeap(1024)) == D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES);
+    CHECK(heapFlags(fixture.placedHeap(65536)) == D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS);
+
+    // Offsets are per heap, the first resource of each starts at 0
+    CHECK_EQ(fixture.renderGraph->heapOffset(2), 0u);
+    CHECK_EQ(fixture.renderGraph->heapOffset(3), 0u);
+    uint64_t totalSizeInBytes = 0;
+    for (const D3D12_HEAP_DESC& heapDesc : fixture.device->heapDescs) {
+        totalSizeInBytes += heapDesc.SizeInBytes;
+    }
+    CHECK_EQ(totalSizeInBytes, fixture.renderGraph->heapSizeInBytes());
+}
+
+
+TEST(tier1HeapsGrowIndependently) {
+    RenderGraphFixture fixture(D3D12_RESOURCE_HEAP_TIER_1);
+    fixture.declareFrame({ textureDesc(256, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET), bufferDesc(65536) });
+    CHECK(SUCCEEDED(fixture.execute(0)));
+    CHECK_EQ(fixture.device->heapDescs.size(), 2u);
+
+    // Only the buffer heap grows, the render target keeps its placed resource
+    fixture.declareFrame({ textureDesc(256, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET), bufferDesc(4 * 65536) });
+    CHECK(SUCCEEDED(fixture.execute(0)));
+    CHECK_EQ(fixture.device->heapDescs.size(), 3u);
+    CHECK(fixture.device->heapDescs[2].Flags == D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS);
+    CHECK_EQ(fixture.device->placedResources.size(), 3u);
+}
+
+
+TEST(disjointLifetimesAlias) {
+    RenderGraphFixture fixture(D3D12_RESOURCE_HEAP_TIER_2);
+    fastdx::RenderGraphPtr renderGraph = fixture.renderGraph;
+    D3D12_RESOURCE_DESC desc = textureDesc(256, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
+    auto noop = [](fastdx::ID3D12GraphicsCommandListPtr) {};
+
+    uint32_t a = renderGraph->createTexture("a", desc);
+    uint32_t b = renderGraph->createTexture("b", desc);
+    uint32_t c = renderGraph->createTexture("c", desc);
+    uint32_t unused = renderGraph->createTexture("unused", desc);
+    uint32_t first = renderGraph->addPass("first", noop);
+    renderGraph->write(first, a, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    uint32_t second = renderGraph->addPass("second", noop);
+    renderGraph->read(second, a, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    renderGraph->write(second, b, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    uint32_t third = renderGraph->addPass("third", noop, true);
+    renderGraph->read(third, b, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    renderGraph->write(third, c, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    uint32_t culled = renderGraph->addPass("culled", noop);
+    renderGraph->write(culled, unused, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    renderGraph->compile();
+
+    CHECK(renderGraph->isPassCulled(culled));
+    CHECK_EQ(renderGraph->culledPassCount(), 1u);
+    CHECK(renderGraph->heapOffset(a) == renderGraph->heapOffset(c));
+    CHECK(renderGraph->heapOffset(a) != renderGraph->heapOffset(b));
+    CHECK_EQ(renderGraph->heapSizeInBytes(), 2 * renderGraph->transientSizeInBytes() / 3);
+    CHECK(SUCCEEDED(fixture.execute(0)));
+    CHECK_EQ(fixture.device->placedResources.size(), 3u);
+}
+
+
+TEST(heapAlignmentIsResetEachFrame) {
+    RenderGraphFixture fixture(D3D12_RESOURCE_HEAP_TIER_2);
+    fixture.declareFrame({ textureDesc(256, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET, 4) });
+    CHECK(SUCCEEDED(fixture.execute(0)));
+    CHECK_EQ(fixture.device->heapDescs[0].Alignment, D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT);
+
+    // MSAA turned off, the next frame's heap no longer needs 4 MB alignment
+    fixture.declareFrame({ textureDesc(256, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET) });
+    CHECK(SUCCEEDED(fixture.execute(1)));
+    CHECK_EQ(fixture.device->heapDescs.size(), 2u);
+    CHECK_EQ(fixture.device->heapDescs[1].Alignment, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+}
@@ -0,0 +1,203 @@
+#include "fakes.h"
+#include "test.h"
+
+using namespace fastdx_test;
+
+namespace {
+    const uint64_t kMegabyte = 1024 * 1024;
+
+    // Manager over a fixed budget, recording the objects it evicts and makes resident
+    struct ResidencyFixture {
+        ResidencyFixture(uint64_t budgetInBytes) :
+            manager([this]() { return budget; },
+                [this](uint32_t count, ID3D12Pageable* const* objects) {
+                    evicted.insert(evicted.end(), objects, objects + count);
+                    budget.usageInBytes -= count * kMegabyte;
+                    return S_OK;
+                },
+                [this](uint32_t count, ID3D12Pageable* const* objects) {
+                    madeResident.insert(madeResident.end(), objects, objects + count);
+                    ++makeResidentCallCount;
+                    budget.usageInBytes += count * kMegabyte;
+                    return S_OK;
+                }) {
+            budget.budgetInBytes = budgetInBytes;
+        }
+
+        // One megabyte evictable buffer
+        ID3D12Pageable* add() {
+            objects.push_back(makeFake<FakeHeap>(D3D12_HEAP_DESC{}));
+            manager.track(objects.back().get(), kMegabyte, fastdx::ResourceCategory::Buffer, true);
+            budget.usageInBytes += kMegabyte;
+            return objects.back().get();
+        }
+
+        fastdx::VideoMemoryBudget budget;
+        std::vector<ID3D12Pageable*> evicted;
+        std::vector<ID3D12Pageable*> madeResident;
+        uint32_t makeResidentCallCount = 0;
+        std::vector<std::shared_ptr<FakeHeap>> objects;
+        fastdx::ResidencyManager manager;
+    };
+};
+
+
+TEST(objectsInFlightAreNeverEvicted) {
+    ResidencyFixture fixture(2 * kMegabyte);
+    ID3D12Pageable* a = fixture.add();
+    ID3D12Pageable* b = fixture.add();
+    ID3D12Pageable* c = fixture.add();
+
+    // Four frames in flight: used by frame 10, the GPU only completed frame 6
+    for (ID3D12Pageable* object : { a, b, c }) {
+        CHECK(SUCCEEDED(fixture.manager.markUsed(object, 10)));
+    }
+    for (uint64_t completedFenceValue = 6; completedFenceValue < 10; ++completedFenceValue) {
+        CHECK(SUCCEEDED(fixture.manager.update(completedFenceValue)));
+        CHECK(fixture.evicted.empty());
+    }
+
+    CHECK(SUCCEEDED(fixture.manager.update(10)));
+    CHECK_EQ(fixture.evicted.size(), 1u);
+    CHECK(fixture.evicted[0] == a);
+    CHECK_EQ(fixture.manager.evictedSizeInBytes(), kMegabyte);
+}
+
+
+TEST(evictionSkipsObjectsStillInUse) {
+    ResidencyFixture fixture(1 * kMegabyte);
+    ID3D12Pageable* a = fixture.add();
+    ID3D12Pageable* b = fixture.add();
+    ID3D12Pageable* c = fixture.add();
+
+    // a is least recently used but marked with a later fence value from another submission
+    CHECK(SUCCEEDED(fixture.manager.markUsed(a, 8)));
+    CHECK(SUCCEEDED(fixture.manager.markUsed(b, 5)));
+    CHECK(SUCCEEDED(fixture.manager.markUsed(c, 5)));
+    CHECK(SUCCEEDED(fixture.manager.markUsed(a, 2)));
+
+    CHECK(SUCCEEDED(fixture.manager.update(5)));
+    CHECK_EQ(fixture.evicted.size(), 2u);
+    CHECK(std::find(fixture.evicted.begin(), fixture.evicted.end(), a) == fixture.evicted.end());
+}
+
+
+TEST(lruOrderAndMakeResident) {
+    ResidencyFixture fixture(2 * kMegabyte);
+    ID3D12Pageable* a = fixture.add();
+    ID3D12Pageable* b = fixture.add();
+    ID3D12Pageable* c = fixture.add();
+    CHECK(SUCCEEDED(fixture.manager.markUsed(b, 1)));
+    CHECK(SUCCEEDED(fixture.manager.markUsed(a, 1)));
+    CHECK(SUCCEEDED(fixture.manager.markUsed(c, 1)));
+
+    CHECK(SUCCEEDED(fixture.manager.update(1)));
+    CHECK_EQ(fixture.evicted.size(), 1u);
+    CHECK(fixture.evicted[0] == b);
+    CHECK_EQ(fixture.manager.residentSizeInBytes(), 2 * kMegabyte);
+
+    // Marking an evicted object makes it resident before the GPU uses it again
+    CHECK(SUCCEEDED(fixture.manager.markUsed(b, 2)));
+    CHECK_EQ(fixture.madeResident.size(), 1u);
+    CHECK(fixture.madeResident[0] == b);
+    CHECK_EQ(fixture.manager.evictedSizeInBytes(), 0u);
+
+    CHECK(SUCCEEDED(fixture.manager.update(2)));
+    CHECK_EQ(fixture.evicted.size(), 2u);
+    CHECK(fixture.evicted[1] == a);
+}
+
+
+TEST(untrackUpdatesAccounting) {
+    ResidencyFixture fixture(1 * kMegabyte);
+    ID3D12Pageable* a = fixture.add();
+    ID3D12Pageable* b = fixture.add();
+    CHECK_EQ(fixture.manager.allocatedSizeInBytes(fastdx::ResourceCategory::Buffer), 2 * kMegabyte);
+
+    ID3D12Pageable* used[] = { a, b };
+    CHECK(SUCCEEDED(fixture.manager.markUsed(_countof(used), used, 0)));
+    CHECK(SUCCEEDED(fixture.manager.update(0)));
+    CHECK(fixture.evicted.size() == 1u && fixture.evicted[0] == a);
+
+    fixture.manager.untrack(a);
+    fixture.manager.untrack(b);
+    CHECK_EQ(fixture.manager.allocatedSizeInBytes(fastdx::ResourceCategory::Buffer), 0u);
+    CHECK_EQ(fixture.manager.evictedSizeInBytes(), 0u);
+    CHECK_EQ(fixture.manager.residentSizeInBytes(), 0u);
+    CHECK(fixture.manager.markUsed(a, 1) == E_INVALIDARG);
+}
+
+
+TEST(objectsNeverMarkedAreNotEvicted) {
+    // e.g. a fallback texture read every frame without being marked
+    ResidencyFixture fixture(1 * kMegabyte);
+    ID3D12Pageable* unmarked = fixture.add();
+    ID3D12Pageable* a = fixture.add();
+    ID3D12Pageable* b = fixture.add();
+    CHECK(SUCCEEDED(fixture.manager.update(100)));
+    CHECK(fixture.evicted.empty());
+
+    CHECK(SUCCEEDED(fixture.manager.markUsed(a, 1)));
+    CHECK(SUCCEEDED(fixture.manager.markUsed(b, 1)));
+    CHECK(SUCCEEDED(fixture.manager.update(1)));
+    CHECK_EQ(fixture.evicted.size(), 2u);
+    CHECK(std::find(fixture.evicted.begin(), fixture.evicted.end(), unmarked) == fixture.evicted.end());
+}
+
+
+TEST(batchedMarksMakeEvictedObjectsResidentAtOnce) {
+    ResidencyFixture fixture(1 * kMegabyte);
+    ID3D12Pageable* a = fixture.add();
+    ID3D12Pageable* b = fixture.add();
+    ID3D12Pageable* c = fixture.add();
+    ID3D12Pageable* frameObjects[] = { a, b, c, a };
+    CHECK(SUCCEEDED(fixture.manager.markUsed(_countof(frameObjects), frameObjects, 1)));
+    CHECK(SUCCEEDED(fixture.manager.update(1)));
+    CHECK_EQ(fixture.evicted.size(), 2u);
+    CHECK(fixture.evicted[0] == b && fixture.evicted[1] == c);
+
+    // Duplicates are made resident once, an unknown object fails without skipping the others
+    std::shared_ptr<FakeHeap> untracked = makeFake<FakeHeap>(D3D12_HEAP_DESC{});
+    ID3D12Pageable* nextFrameObjects[] = { c, untracked.get(), b, c };
+    CHECK(fixture.manager.markUsed(_countof(nextFrameObjects), nextFrameObjects, 2) == E_INVALIDARG);
+    CHECK_EQ(fixture.makeResidentCallCount, 1u);
+    CHECK(fixture.madeResident == std::vector<ID3D12Pageable*>({ c, b }));
+    CHECK_EQ(fixture.manager.evictedSizeInBytes(), 0u);
+
+    // b and c are still used by frame 2 in flight, only a can be evicted
+    CHECK(SUCCEEDED(fixture.manager.update(1)));
+    CHECK_EQ(fixture.evicted.size(), 3u);
+    CHECK(fixture.evicted.back() == a);
+}
+
+
+TEST(renderGraphHeapsAreTracked) {
+    std::shared_ptr<FakeDevice> device = makeFake<FakeDevice>();
+    fastdx::D3D12DeviceWrapper wrapper{ device };
+    fastdx::ResidencyManagerPtr residencyManager = wrapper.residencyManager();
+    {
+        fastdx::RenderGraphPtr renderGraph = wrapper.createRenderGraph(2);
+
+        D3D12_RESOURCE_DESC desc = {};
+        desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+        desc.Width = 256;
+        desc.Height = 256;
+        desc.DepthOrArraySize = 1;
+        desc.MipLevels = 1;
+        desc.SampleDesc.Count = 1;
+        desc.Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+        fastdx::ID3D12GraphicsCommandListPtr commandList = makeFake<ID3D12GraphicsCommandList6>();
+        for (int32_t frameIndex = 0; frameIndex < 2; ++frameIndex) {
+            renderGraph->reset();
+            uint32_t texture = renderGraph->createTexture("color", desc);
+            uint32_t pass = renderGraph->addPass("draw", [](fastdx::ID3D12GraphicsCommandListPtr) {}, true);
+            renderGraph->write(pass, texture, D3D12_RESOURCE_STATE_RENDER_TARGET);
+            renderGraph->compile();
+            CHECK(SUCCEEDED(renderGraph->execute(frameIndex, [&]() { return commandList; })));
+        }
+        CHECK_EQ(device->heapDescs.size(), 2u);
+        CHECK_EQ(residencyManager->allocatedSizeInBytes(fastdx::ResourceCategory::RenderTarget),
+            2 * renderGraph->heapSizeInBytes());
+    }
+    CHECK_EQ(residencyManager->allocatedSizeInBytes(fastdx::ResourceCategory::RenderTarget), 0u);
+}
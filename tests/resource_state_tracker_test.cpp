@@ -0,0 +1,181 @@
+#include "fakes.h"
+#include "test.h"
+
+using namespace fastdx_test;
+
+namespace {
+    struct TrackerFixture {
+        TrackerFixture() : commandList(makeFake<FakeCommandList>()) {}
+
+        ID3D12Resource* add(D3D12_RESOURCE_STATES state, uint32_t subresourceCount = 1) {
+            resources.push_back(makeFake<FakeResource>(D3D12_RESOURCE_DESC{}, 0));
+            tracker.track(resources.back().get(), state, subresourceCount);
+            return resources.back().get();
+        }
+
+        bool isTransition(const D3D12_RESOURCE_BARRIER& barrier, ID3D12Resource* resource, uint32_t subresource,
+            D3D12_RESOURCE_STATES stateBefore, D3D12_RESOURCE_STATES stateAfter) {
+            return barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION && barrier.Transition.pResource == resource &&
+                barrier.Transition.Subresource == subresource && barrier.Transition.StateBefore == stateBefore &&
+                barrier.Transition.StateAfter == stateAfter;
+        }
+
+        fastdx::ResourceStateTracker tracker;
+        std::shared_ptr<FakeCommandList> commandList;
+        std::vector<std::shared_ptr<FakeResource>> resources;
+    };
+};
+
+
+TEST(redundantTransitionsAreSkipped) {
+    TrackerFixture fixture;
+    ID3D12Resource* texture = fixture.add(D3D12_RESOURCE_STATE_COPY_DEST);
+    ID3D12Resource* buffer = fixture.add(D3D12_RESOURCE_STATE_GENERIC_READ);
+
+    fixture.tracker.transition(texture, D3D12_RESOURCE_STATE_COPY_DEST);
+    // Read bits already included in a read-only state
+    fixture.tracker.transition(buffer, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    CHECK(fixture.tracker.pendingBarriers().empty());
+    CHECK_EQ(fixture.tracker.requestedCount(), 2u);
+    CHECK(fixture.tracker.state(buffer) == D3D12_RESOURCE_STATE_GENERIC_READ);
+
+    // Added read bits still need a barrier
+    fixture.tracker.transition(texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    fixture.tracker.transition(texture, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE);
+    CHECK_EQ(fixture.tracker.pendingBarriers().size(), 1u);
+    CHECK(fixture.isTransition(fixture.tracker.pendingBarriers()[0], texture, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
+        D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE));
+}
+
+
+TEST(queuedTransitionsMergeAndCancel) {
+    TrackerFixture fixture;
+    ID3D12Resource* a = fixture.add(D3D12_RESOURCE_STATE_RENDER_TARGET);
+    ID3D12Resource* b = fixture.add(D3D12_RESOURCE_STATE_COPY_DEST);
+
+    // Back and forth before a flush
+    fixture.tracker.transition(a, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    fixture.tracker.transition(a, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    CHECK(fixture.tracker.pendingBarriers().empty());
+
+    // A->B->C becomes A->C
+    fixture.tracker.transition(b, D3D12_RESOURCE_STATE_COPY_SOURCE);
+    fixture.tracker.transition(b, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    CHECK_EQ(fixture.tracker.pendingBarriers().size(), 1u);
+    CHECK(fixture.isTransition(fixture.tracker.pendingBarriers()[0], b, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
+        D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+
+    // Not merged across a flush
+    CHECK_EQ(fixture.tracker.flush(fixture.commandList), 1u);
+    fixture.tracker.transition(b, D3D12_RESOURCE_STATE_COPY_DEST);
+    CHECK(fixture.isTransition(fixture.tracker.pendingBarriers()[0], b, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
+        D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST));
+}
+
+
+TEST(subresourcesAreTrackedIndividually) {
+    TrackerFixture fixture;
+    ID3D12Resource* texture = fixture.add(D3D12_RESOURCE_STATE_COPY_DEST, 4);
+
+    fixture.tracker.transition(texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, 2);
+    CHECK_EQ(fixture.tracker.pendingBarriers().size(), 1u);
+    CHECK(fixture.isTransition(fixture.tracker.pendingBarriers()[0], texture, 2,
+        D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+    CHECK(fixture.tracker.state(texture, 2) == D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    CHECK(fixture.tracker.state(texture, 3) == D3D12_RESOURCE_STATE_COPY_DEST);
+    fixture.tracker.flush(fixture.commandList);
+
+    // Only the subresources not in state yet
+    fixture.tracker.transition(texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    const std::vector<D3D12_RESOURCE_BARRIER>& barriers = fixture.tracker.pendingBarriers();
+    CHECK_EQ(barriers.size(), 3u);
+    uint32_t subresources[] = { 0, 1, 3 };
+    for (size_t i = 0; i < barriers.size(); ++i) {
+        CHECK(fixture.isTransition(barriers[i], texture, subresources[i], D3D12_RESOURCE_STATE_COPY_DEST,
+            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+    }
+    fixture.tracker.flush(fixture.commandList);
+
+    // Uniform again, a single barrier covers all subresources
+    fixture.tracker.transition(texture, D3D12_RESOURCE_STATE_COPY_DEST);
+    CHECK_EQ(fixture.tracker.pendingBarriers().size(), 1u);
+    CHECK_EQ(fixture.tracker.pendingBarriers()[0].Transition.Subresource, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES);
+}
+
+
+TEST(splitBarriersEndOnRequest) {
+    TrackerFixture fixture;
+    ID3D12Resource* a = fixture.add(D3D12_RESOURCE_STATE_RENDER_TARGET);
+    ID3D12Resource* b = fixture.add(D3D12_RESOURCE_STATE_RENDER_TARGET);
+
+    fixture.tracker.beginTransition(a, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    fixture.tracker.beginTransition(b, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    CHECK_EQ(fixture.tracker.pendingBarriers().size(), 2u);
+    CHECK(fixture.tracker.pendingBarriers()[0].Flags == D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY);
+    CHECK(fixture.tracker.state(a) == D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    fixture.tracker.flush(fixture.commandList);
+
+    fixture.tracker.endTransition(b);
+    CHECK_EQ(fixture.tracker.pendingBarriers().size(), 1u);
+    const D3D12_RESOURCE_BARRIER& end = fixture.tracker.pendingBarriers()[0];
+    CHECK(end.Flags == D3D12_RESOURCE_BARRIER_FLAG_END_ONLY);
+    CHECK(fixture.isTransition(end, b, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, D3D12_RESOURCE_STATE_RENDER_TARGET,
+        D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+
+    fixture.tracker.endTransition(b);
+    fixture.tracker.endTransition(a);
+    CHECK_EQ(fixture.tracker.pendingBarriers().size(), 2u);
+    CHECK(fixture.tracker.pendingBarriers()[1].Transition.pResource == a);
+}
+
+
+TEST(flushIssuesOneCall) {
+    TrackerFixture fixture;
+    ID3D12Resource* a = fixture.add(D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    ID3D12Resource* b = fixture.add(D3D12_RESOURCE_STATE_COPY_DEST);
+
+    CHECK_EQ(fixture.tracker.flush(fixture.commandList), 0u);
+    CHECK(fixture.commandList->barrierCalls.empty());
+
+    fixture.tracker.uavBarrier(a);
+    fixture.tracker.transition(b, D3D12_RESOURCE_STATE_COPY_SOURCE);
+    CHECK_EQ(fixture.tracker.flush(fixture.commandList), 2u);
+    CHECK_EQ(fixture.commandList->barrierCalls.size(), 1u);
+    CHECK(fixture.commandList->barrierCalls[0][0].Type == D3D12_RESOURCE_BARRIER_TYPE_UAV);
+    CHECK(fixture.commandList->barrierCalls[0][0].UAV.pResource == a);
+    CHECK(fixture.tracker.pendingBarriers().empty());
+    CHECK_EQ(fixture.tracker.flushCount(), 1u);
+    CHECK_EQ(fixture.tracker.barrierCount(), 2u);
+}
+
+
+TEST(sceneLoadBarrierCallsAreBatched) {
+    // 500 textures uploaded then made shader resources, formerly one ResourceBarrier call per texture
+    const uint32_t kTextureCount = 500;
+    TrackerFixture fixture;
+    std::vector<ID3D12Resource*> textures;
+    for (uint32_t i = 0; i < kTextureCount; ++i) {
+        textures.push_back(fixture.add(D3D12_RESOURCE_STATE_COPY_DEST));
+    }
+    for (ID3D12Resource* texture : textures) {
+        fixture.tracker.transition(texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    }
+    fixture.tracker.flush(fixture.commandList);
+    CHECK_EQ(fixture.commandList->barrierCalls.size(), 1u);
+    CHECK_EQ(fixture.commandList->barrierCalls[0].size(), kTextureCount);
+
+    // Materials sharing textures request them again while drawing, already in state
+    for (uint32_t draw = 0; draw < 2 * kTextureCount; ++draw) {
+        fixture.tracker.transition(textures[draw % kTextureCount], D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    }
+    CHECK_EQ(fixture.tracker.flush(fixture.commandList), 0u);
+
+    // 1 call instead of 500, and 500 barriers out of 1500 requests
+    CHECK_EQ(fixture.commandList->barrierCalls.size(), 1u);
+    CHECK_EQ(fixture.tracker.requestedCount(), 3u * kTextureCount);
+    CHECK_EQ(fixture.tracker.barrierCount(), kTextureCount);
+    printf("500-texture scene: %llu transitions requested, %llu barriers in %llu ResourceBarrier call\n",
+        static_cast<unsigned long long>(fixture.tracker.requestedCount()),
+        static_cast<unsigned long long>(fixture.tracker.barrierCount()),
+        static_cast<unsigned long long>(fixture.tracker.flushCount()));
+}
@@ -0,0 +1,106 @@
+#include "fakes.h"
+#include "test.h"
+
+using namespace fastdx_test;
+
+namespace {
+    // DXIL container holding the given parts, each { fourCC, data }
+    std::vector<uint8_t> dxilContainer(const std::vector<std::pair<uint32_t, std::vector<uint8_t>>>& parts) {
+        const uint32_t kHeaderSizeInBytes = 32;
+        uint32_t sizeInBytes = kHeaderSizeInBytes + static_cast<uint32_t>(parts.size() * sizeof(uint32_t));
+        std::vector<uint32_t> offsets;
+        for (const auto& part : parts) {
+            offsets.push_back(sizeInBytes);
+            sizeInBytes += 2 * sizeof(uint32_t) + static_cast<uint32_t>(part.second.size());
+        }
+
+        std::vector<uint8_t> container(sizeInBytes);
+        uint32_t header[8] = { 0x43425844, 0, 0, 0, 0, 1, sizeInBytes, static_cast<uint32_t>(parts.size()) };
+        memcpy(container.data(), header, sizeof(header));
+        memcpy(container.data() + kHeaderSizeInBytes, offsets.data(), offsets.size() * sizeof(uint32_t));
+        for (size_t i = 0; i < parts.size(); ++i) {
+            uint32_t partHeader[2] = { parts[i].first, static_cast<uint32_t>(parts[i].second.size()) };
+            memcpy(container.data() + offsets[i], partHeader, sizeof(partHeader));
+            memcpy(container.data() + offsets[i] + sizeof(partHeader), parts[i].second.data(), parts[i].second.size());
+        }
+        return container;
+    }
+
+    void setHeaderField(std::vector<uint8_t>& container, uint32_t index, uint32_t value) {
+        memcpy(container.data() + index * sizeof(uint32_t), &value, sizeof(value));
+    }
+
+    bool hasRootSignaturePart(const std::vector<uint8_t>& container) {
+        const void* data = nullptr;
+        size_t sizeInBytes = 0;
+        return fastdxu::findDxilContainerPart(container.data(), container.size(), fastdxu::kDxilPartRootSignature,
+            &data, &sizeInBytes);
+    }
+};
+
+
+TEST(findsContainerParts) {
+    std::vector<uint8_t> container = dxilContainer({ { fastdxu::kDxilPartShader, { 1, 2, 3, 4 } },
+        { fastdxu::kDxilPartRootSignature, { 5, 6, 7 } } });
+    const void* data = nullptr;
+    size_t sizeInBytes = 0;
+    CHECK(fastdxu::findDxilContainerPart(container.data(), container.size(), fastdxu::kDxilPartRootSignature,
+        &data, &sizeInBytes));
+    CHECK_EQ(sizeInBytes, 3u);
+    CHECK_EQ(static_cast<const uint8_t*>(data)[0], 5);
+    CHECK(!fastdxu::findDxilContainerPart(container.data(), container.size(), 0x4E475349, &data, &sizeInBytes));
+}
+
+
+TEST(rejectsMalformedContainers) {
+    std::vector<uint8_t> container = dxilContainer({ { fastdxu::kDxilPartRootSignature, { 5, 6, 7 } } });
+    CHECK(hasRootSignaturePart(container));
+    CHECK(!fastdxu::findDxilContainerPart(container.data(), 31, fastdxu::kDxilPartRootSignature, nullptr, nullptr));
+
+    // A container size smaller than the header, the part count bound must not wrap
+    std::vector<uint8_t> malformed = container;
+    setHeaderField(malformed, 6, 16);
+    setHeaderField(malformed, 7, 0x10000000);
+    CHECK(!hasRootSignaturePart(malformed));
+
+    // Larger than the bytes given
+    malformed = container;
+    setHeaderField(malformed, 6, static_cast<uint32_t>(container.size() + 1));
+    CHECK(!hasRootSignaturePart(malformed));
+
+    // Part offset and part size past the end
+    malformed = container;
+    setHeaderField(malformed, 8, static_cast<uint32_t>(container.size() - 4));
+    CHECK(!hasRootSignaturePart(malformed));
+    malformed = container;
+    setHeaderField(malformed, 10, 4);
+    CHECK(!hasRootSignaturePart(malformed));
+
+    malformed = container;
+    setHeaderField(malformed, 0, 0);
+    CHECK(!hasRootSignaturePart(malformed));
+}
+
+
+TEST(rootSignaturesAreSharedByContent) {
+    std::shared_ptr<FakeDevice> fakeDevice = makeFake<FakeDevice>();
+    fastdx::D3D12DeviceWrapper device(fakeDevice);
+
+    // Vertex and pixel shaders embedding the same root signature
+    std::vector<uint8_t> vertexShader = dxilContainer({ { fastdxu::kDxilPartShader, { 1, 2, 3, 4 } },
+        { fastdxu::kDxilPartRootSignature, { 5, 6, 7 } } });
+    std::vector<uint8_t> pixelShader = dxilContainer({ { fastdxu::kDxilPartShader, { 8, 9 } },
+        { fastdxu::kDxilPartRootSignature, { 5, 6, 7 } } });
+    fastdx::ID3D12RootSignaturePtr rootSignature = device.createRootSignature(0, vertexShader.data(),
+        vertexShader.size());
+    CHECK(rootSignature != nullptr);
+    CHECK(device.createRootSignature(0, pixelShader.data(), pixelShader.size()) == rootSignature);
+    CHECK_EQ(fakeDevice->rootSignatureCount, 1);
+
+    // Other bytes or node mask are other root signatures
+    std::vector<uint8_t> otherShader = dxilContainer({ { fastdxu::kDxilPartShader, { 1, 2, 3, 4 } },
+        { fastdxu::kDxilPartRootSignature, { 5, 6, 8 } } });
+    CHECK(device.createRootSignature(0, otherShader.data(), otherShader.size()) != rootSignature);
+    CHECK(device.createRootSignature(1, vertexShader.data(), vertexShader.size()) != rootSignature);
+    CHECK_EQ(fakeDevice->rootSignatureCount, 3);
+}
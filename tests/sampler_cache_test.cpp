@@ -0,0 +1,126 @@
+#include "fakes.h"
+#include "test.h"
+
+using namespace fastdx_test;
+
+namespace {
+    struct SamplerFixture {
+        SamplerFixture(uint32_t staticCount) : device(makeFake<FakeDevice>()), wrapper(device) {
+            heap = wrapper.createShaderVisibleDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, staticCount, 0, 1);
+            cache = wrapper.createSamplerCache(heap);
+        }
+
+        std::shared_ptr<FakeDevice> device;
+        fastdx::D3D12DeviceWrapper wrapper;
+        fastdx::ShaderVisibleDescriptorHeapPtr heap;
+        fastdx::SamplerCachePtr cache;
+    };
+
+    D3D12_SAMPLER_DESC samplerDesc(D3D12_FILTER filter, D3D12_TEXTURE_ADDRESS_MODE addressMode) {
+        D3D12_SAMPLER_DESC desc = {};
+        desc.Filter = filter;
+        desc.AddressU = desc.AddressV = desc.AddressW = addressMode;
+        desc.MaxAnisotropy = 1;
+        desc.ComparisonFunc = D3D12_COMPARISON_FUNC_NEVER;
+        desc.MaxLOD = 1000.0f;
+        return desc;
+    }
+};
+
+
+TEST(equivalentDescsShareOneSampler) {
+    SamplerFixture fixture(8);
+    D3D12_SAMPLER_DESC desc = samplerDesc(D3D12_FILTER_MIN_MAG_MIP_LINEAR, D3D12_TEXTURE_ADDRESS_MODE_WRAP);
+
+    // Fields the filter and address modes ignore
+    D3D12_SAMPLER_DESC equivalentDesc = desc;
+    equivalentDesc.MaxAnisotropy = 16;
+    equivalentDesc.ComparisonFunc = D3D12_COMPARISON_FUNC_LESS;
+    equivalentDesc.BorderColor[3] = 1.0f;
+    equivalentDesc.MipLODBias = -0.0f;
+
+    fastdx::DescriptorRange a = fixture.cache->acquire(desc);
+    fastdx::DescriptorRange b = fixture.cache->acquire(equivalentDesc);
+    CHECK(a.isValid());
+    CHECK_EQ(b.index, a.index);
+    CHECK_EQ(fixture.cache->samplerCount(), 1u);
+    CHECK_EQ(fixture.cache->hitCount(), 1u);
+    CHECK_EQ(fixture.cache->missCount(), 1u);
+
+    CHECK_EQ(fixture.device->samplers.size(), 1u);
+    CHECK_EQ(fixture.device->samplers[0].destination.ptr, a.cpuHandle.ptr);
+    CHECK_EQ(fixture.device->samplers[0].desc.MaxAnisotropy, 1u);
+}
+
+
+TEST(fieldsInUseAreNotFolded) {
+    SamplerFixture fixture(8);
+    D3D12_SAMPLER_DESC compare = samplerDesc(D3D12_FILTER_COMPARISON_MIN_MAG_MIP_LINEAR,
+        D3D12_TEXTURE_ADDRESS_MODE_CLAMP);
+    D3D12_SAMPLER_DESC compareLess = compare;
+    compareLess.ComparisonFunc = D3D12_COMPARISON_FUNC_LESS;
+
+    D3D12_SAMPLER_DESC border = samplerDesc(D3D12_FILTER_MIN_MAG_MIP_POINT, D3D12_TEXTURE_ADDRESS_MODE_WRAP);
+    border.AddressV = D3D12_TEXTURE_ADDRESS_MODE_BORDER;
+    D3D12_SAMPLER_DESC whiteBorder = border;
+    whiteBorder.BorderColor[0] = whiteBorder.BorderColor[1] = whiteBorder.BorderColor[2] = 1.0f;
+
+    D3D12_SAMPLER_DESC anisotropic = samplerDesc(D3D12_FILTER_ANISOTROPIC, D3D12_TEXTURE_ADDRESS_MODE_WRAP);
+    D3D12_SAMPLER_DESC anisotropic16 = anisotropic;
+    anisotropic16.MaxAnisotropy = 16;
+
+    for (const D3D12_SAMPLER_DESC& desc : { compare, compareLess, border, whiteBorder, anisotropic, anisotropic16 }) {
+        CHECK(fixture.cache->acquire(desc).isValid());
+    }
+    CHECK_EQ(fixture.cache->samplerCount(), 6u);
+    CHECK_EQ(fixture.cache->hitCount(), 0u);
+}
+
+
+TEST(leastRecentlyReleasedIsRecycledWhenFull) {
+    SamplerFixture fixture(3);
+    D3D12_SAMPLER_DESC descs[] = {
+        samplerDesc(D3D12_FILTER_MIN_MAG_MIP_POINT, D3D12_TEXTURE_ADDRESS_MODE_WRAP),
+        samplerDesc(D3D12_FILTER_MIN_MAG_MIP_LINEAR, D3D12_TEXTURE_ADDRESS_MODE_WRAP),
+        samplerDesc(D3D12_FILTER_MIN_MAG_MIP_POINT, D3D12_TEXTURE_ADDRESS_MODE_CLAMP),
+        samplerDesc(D3D12_FILTER_MIN_MAG_MIP_LINEAR, D3D12_TEXTURE_ADDRESS_MODE_CLAMP),
+    };
+    fastdx::DescriptorRange a = fixture.cache->acquire(descs[0]);
+    fastdx::DescriptorRange b = fixture.cache->acquire(descs[1]);
+    fastdx::DescriptorRange c = fixture.cache->acquire(descs[2]);
+
+    // Every sampler referenced
+    CHECK(!fixture.cache->acquire(descs[3]).isValid());
+
+    // Released samplers stay cached until the heap is full, then go least recently released first
+    fixture.cache->release(b);
+    fixture.cache->release(a);
+    CHECK_EQ(fixture.cache->acquire(descs[3]).index, b.index);
+    CHECK_EQ(fixture.device->samplers.back().destination.ptr, b.cpuHandle.ptr);
+    CHECK_EQ(fixture.cache->acquire(descs[0]).index, a.index);
+    CHECK_EQ(fixture.cache->hitCount(), 1u);
+
+    CHECK(!fixture.cache->acquire(descs[1]).isValid());
+    fixture.cache->release(c);
+    CHECK_EQ(fixture.cache->acquire(descs[1]).index, c.index);
+    CHECK_EQ(fixture.cache->samplerCount(), 3u);
+    CHECK_EQ(fixture.cache->missCount(), 5u);
+}
+
+
+TEST(releaseIsReferenceCounted) {
+    SamplerFixture fixture(1);
+    D3D12_SAMPLER_DESC desc = samplerDesc(D3D12_FILTER_MIN_MAG_MIP_POINT, D3D12_TEXTURE_ADDRESS_MODE_WRAP);
+    D3D12_SAMPLER_DESC otherDesc = samplerDesc(D3D12_FILTER_MIN_MAG_MIP_LINEAR, D3D12_TEXTURE_ADDRESS_MODE_WRAP);
+
+    fastdx::DescriptorRange range = fixture.cache->acquire(desc);
+    fixture.cache->acquire(desc);
+    fixture.cache->release(range);
+    CHECK(!fixture.cache->acquire(otherDesc).isValid());
+
+    // Extra releases are ignored
+    fixture.cache->release(range);
+    fixture.cache->release(range);
+    CHECK(fixture.cache->acquire(otherDesc).isValid());
+    CHECK(!fixture.cache->acquire(desc).isValid());
+}
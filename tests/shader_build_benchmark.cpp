@@ -0,0 +1,96 @@
+#include "benchmark.h"
+#include "fakes.h"
+
+#include <fstream>
+
+using namespace fastdx_test;
+
+namespace {
+    const uint32_t kSourceCount = 6;
+
+    // Stands in for DXC off Windows: sleeps like a compile, then writes the output named by -Fo
+    const char* kFakeCompiler =
+        "#!/bin/sh\n"
+        "output=\"\"\n"
+        "while [ $# -gt 0 ]; do\n"
+        "    if [ \"$1\" = \"-Fo\" ]; then output=\"$2\"; shift; fi\n"
+        "    shift\n"
+        "done\n"
+        "sleep 0.03\n"
+        "printf DXBC > \"$output\"\n";
+
+    void writeFile(const std::filesystem::path& path, const std::string& text) {
+        std::ofstream file(path, std::ios::binary);
+        file << text;
+    }
+
+    std::string sourceText(uint32_t index, const char* scale) {
+        return "#include \"common.hlsli\"\nfloat4 main() : SV_TARGET0 { return tint() * " + std::to_string(index) +
+            scale + "; }\n";
+    }
+
+    void printBuild(const char* name, const fastdx::ShaderBuildStatistics& statistics, double fullMs) {
+        printf("%24s %10.1f ms %6.1f%% %5u compiled %5u up to date\n", name, statistics.elapsedMs,
+            100.0 * statistics.elapsedMs / fullMs, statistics.compiledCount, statistics.upToDateCount);
+    }
+};
+
+
+int main(int argc, char** argv) {
+    // A real compiler can be given, on Windows it must be
+#if defined(_WIN32)
+    if (argc <= 1) {
+        printf("Usage: shader_build_benchmark <dxc.exe>\n");
+        return 2;
+    }
+#endif
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "fastdx_shader_build_benchmark";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory / "include");
+    std::filesystem::path compilerPath = (argc > 1) ? std::filesystem::path(argv[1]) : directory / "fake_dxc.sh";
+    if (argc <= 1) {
+        writeFile(compilerPath, kFakeCompiler);
+        std::filesystem::permissions(compilerPath, std::filesystem::perms::owner_all);
+    }
+
+    // Sources sharing one include, each with 2 x 2 x 3 permutations
+    writeFile(directory / "include" / "common.hlsli", "float4 tint() { return float4(1, 1, 1, 1); }\n");
+    fastdx::ShaderPermutationBuilder builder(compilerPath, directory / "cache");
+    builder.addIncludeDirectory(directory / "include");
+    for (uint32_t i = 0; i < kSourceCount; ++i) {
+        std::filesystem::path sourcePath = directory / ("shader_" + std::to_string(i) + "_ps.hlsl");
+        writeFile(sourcePath, sourceText(i, ""));
+        builder.addSource(sourcePath, "main", "ps_6_5", { { "", "SKINNED" }, { "", "ALPHA_TEST" },
+            { "QUALITY=0", "QUALITY=1", "QUALITY=2" } });
+    }
+
+    auto build = [&builder]() {
+        fastdx::ShaderLibraryWriter writer;
+        fastdx::ShaderBuildStatistics statistics;
+        if (FAILED(builder.build(writer, &statistics))) {
+            for (const std::string& error : builder.errors()) {
+                printf("%s\n", error.c_str());
+            }
+        }
+        return statistics;
+    };
+
+    printf("Building %u sources, %u permutations, %u compiler threads\n", kSourceCount, kSourceCount * 12,
+        std::thread::hardware_concurrency());
+    fastdx::ShaderBuildStatistics full = build();
+    printBuild("full", full, full.elapsedMs);
+    printBuild("nothing changed", build(), full.elapsedMs);
+
+    writeFile(directory / "shader_0_ps.hlsl", sourceText(0, " * 0.5f"));
+    printBuild("one source edited", build(), full.elapsedMs);
+
+    // Back to a source seen before, its outputs are still cached
+    writeFile(directory / "shader_0_ps.hlsl", sourceText(0, ""));
+    printBuild("edit reverted", build(), full.elapsedMs);
+
+    writeFile(directory / "include" / "common.hlsli", "float4 tint() { return float4(1, 0, 0, 1); }\n");
+    printBuild("shared include edited", build(), full.elapsedMs);
+
+    std::filesystem::remove_all(directory);
+    return (full.failedCount == 0 && full.compiledCount == kSourceCount * 12) ? 0 : 1;
+}
@@ -0,0 +1,214 @@
+#include "fakes.h"
+#include "test.h"
+
+#include <fstream>
+
+using namespace fastdx_test;
+
+namespace {
+    const std::chrono::milliseconds kTimeout(5000);
+
+    // Off Windows the compiler runs through /bin/sh. This one writes its source and the include directory files as
+    // the output named by -Fo, so include edits change the bytecode
+    const char* kFakeCompiler =
+        "#!/bin/sh\n"
+        "output=\"\"\n"
+        "include=\"\"\n"
+        "for argument in \"$@\"; do source=\"$argument\"; done\n"
+        "while [ $# -gt 0 ]; do\n"
+        "    if [ \"$1\" = \"-Fo\" ]; then output=\"$2\"; shift; fi\n"
+        "    if [ \"$1\" = \"-I\" ]; then include=\"$2\"; shift; fi\n"
+        "    shift\n"
+        "done\n"
+        "cat \"$source\" \"$include\"/* > \"$output\"\n";
+
+    void writeFile(const std::filesystem::path& path, const std::string& text) {
+        std::ofstream file(path, std::ios::binary);
+        file << text;
+    }
+
+    struct ShaderDirectory {
+        ShaderDirectory(const char* name) : path(std::filesystem::temp_directory_path() / name) {
+            std::filesystem::remove_all(path);
+            std::filesystem::create_directories(path / "include");
+            compilerPath = path / "fake_dxc.sh";
+            writeFile(compilerPath, kFakeCompiler);
+            std::filesystem::permissions(compilerPath, std::filesystem::perms::owner_all);
+        }
+        ~ShaderDirectory() { std::filesystem::remove_all(path); }
+
+        std::filesystem::path path;
+        std::filesystem::path compilerPath;
+    };
+
+    bool waitForChange(fastdx::FileWatcher& watcher, const std::filesystem::path& path) {
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + kTimeout;
+        while (std::chrono::steady_clock::now() < end) {
+            std::vector<std::filesystem::path> changes = watcher.waitForChanges(std::chrono::milliseconds(100));
+            if (std::find(changes.begin(), changes.end(), path.lexically_normal()) != changes.end()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template <typename Predicate>
+    bool waitUntil(Predicate predicate) {
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + kTimeout;
+        while (!predicate()) {
+            if (std::chrono::steady_clock::now() > end) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return true;
+    }
+};
+
+
+TEST(watcherReportsChangedFiles) {
+    ShaderDirectory directory("fastdx_file_watcher_test");
+    fastdx::FileWatcher watcher(directory.path);
+    CHECK(watcher.isWatching());
+    CHECK(watcher.result() == S_OK);
+
+    // Created and written files, nested ones included
+    writeFile(directory.path / "a.hlsl", "a");
+    CHECK(waitForChange(watcher, directory.path / "a.hlsl"));
+    writeFile(directory.path / "include" / "b.hlsli", "b");
+    CHECK(waitForChange(watcher, directory.path / "include" / "b.hlsli"));
+
+    // Several writes to one file are reported once
+    for (int i = 0; i < 5; ++i) {
+        writeFile(directory.path / "a.hlsl", std::string(i + 1, 'a'));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    std::vector<std::filesystem::path> changes = watcher.waitForChanges(kTimeout);
+    CHECK_EQ(std::count(changes.begin(), changes.end(), (directory.path / "a.hlsl").lexically_normal()), 1);
+    CHECK(watcher.changes().empty());
+}
+
+
+TEST(watcherReportsMissingDirectories) {
+    fastdx::FileWatcher watcher(std::filesystem::temp_directory_path() / "fastdx_file_watcher_missing");
+    CHECK(!watcher.isWatching());
+    CHECK(FAILED(watcher.result()));
+
+    // Waiting on a failed watcher returns right away
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    CHECK(watcher.waitForChanges(kTimeout).empty());
+    CHECK(std::chrono::steady_clock::now() - start < kTimeout);
+}
+
+
+TEST(watcherFollowsDirectoriesMovedIn) {
+    ShaderDirectory directory("fastdx_file_watcher_move_test");
+    std::filesystem::path outside = std::filesystem::temp_directory_path() / "fastdx_file_watcher_moved";
+    std::filesystem::remove_all(outside);
+    std::filesystem::create_directories(outside / "nested");
+    fastdx::FileWatcher watcher(directory.path);
+    CHECK(watcher.isWatching());
+
+    // Built outside the tree, then renamed in, its nested directories are watched too
+    std::filesystem::rename(outside, directory.path / "moved");
+    CHECK(waitForChange(watcher, directory.path / "moved"));
+    writeFile(directory.path / "moved" / "nested" / "c.hlsli", "c");
+    CHECK(waitForChange(watcher, directory.path / "moved" / "nested" / "c.hlsli"));
+}
+
+
+TEST(dependenciesFollowIncludes) {
+    ShaderDirectory directory("fastdx_shader_dependencies_test");
+    writeFile(directory.path / "include" / "common.hlsli", "#include \"nested.hlsli\"\n");
+    writeFile(directory.path / "include" / "nested.hlsli", "// nested\n");
+    writeFile(directory.path / "local.hlsli", "// next to the source\n");
+    writeFile(directory.path / "shader_ps.hlsl", "#include \"common.hlsli\"\n#include \"local.hlsli\"\n"
+        "#include \"missing.hlsli\"\n#include \"common.hlsli\"\n");
+
+    fastdx::ShaderPermutationBuilder builder(directory.compilerPath, directory.path / "cache", 1);
+    builder.addIncludeDirectory(directory.path / "include");
+    builder.addSource(directory.path / "shader_ps.hlsl", "main", "ps_6_5", { { "", "ALPHA_TEST" } });
+    fastdx::ShaderLibraryWriter writer;
+    fastdx::ShaderBuildStatistics statistics;
+    CHECK(SUCCEEDED(builder.build(writer, &statistics)));
+    CHECK_EQ(statistics.compiledCount, 2u);
+    CHECK(writer.shader("shader_ps+ALPHA_TEST").pShaderBytecode != nullptr);
+
+    // Each file once, missing includes are left out
+    std::vector<std::filesystem::path> expected = { directory.path / "shader_ps.hlsl",
+        directory.path / "include" / "common.hlsli", directory.path / "include" / "nested.hlsli",
+        directory.path / "local.hlsli" };
+    const std::vector<std::filesystem::path>& dependencies = builder.dependencies();
+    CHECK_EQ(dependencies.size(), expected.size());
+    for (const std::filesystem::path& path : expected) {
+        CHECK(std::find(dependencies.begin(), dependencies.end(), path.lexically_normal()) != dependencies.end());
+    }
+
+    // A nested include edit makes every permutation out of date
+    writeFile(directory.path / "include" / "nested.hlsli", "// edited\n");
+    CHECK(SUCCEEDED(builder.build(writer, &statistics)));
+    CHECK_EQ(statistics.compiledCount, 2u);
+    CHECK(SUCCEEDED(builder.build(writer, &statistics)));
+    CHECK_EQ(statistics.upToDateCount, 2u);
+}
+
+
+TEST(reloaderRecompilesOnIncludeEdits) {
+    ShaderDirectory directory("fastdx_shader_hot_reload_test");
+    writeFile(directory.path / "include" / "common.hlsli", "// common\n");
+    writeFile(directory.path / "shader_vs.hlsl", "#include \"common.hlsli\"\n");
+    writeFile(directory.path / "shader_ps.hlsl", "// pixel\n");
+    writeFile(directory.path / "unrelated.txt", "");
+
+    fastdx::ShaderPermutationBuilder builder(directory.compilerPath, directory.path / "cache", 1);
+    builder.addIncludeDirectory(directory.path / "include");
+    builder.addSource(directory.path / "shader_vs.hlsl", "main", "vs_6_5");
+    builder.addSource(directory.path / "shader_ps.hlsl", "main", "ps_6_5");
+    fastdx::ShaderLibraryWriter writer;
+    CHECK(SUCCEEDED(builder.build(writer)));
+
+    std::atomic<int> compileCount = 0;
+    fastdx::AsyncPipelineCompilerPtr compiler = std::make_shared<fastdx::AsyncPipelineCompiler>(
+        [&compileCount](const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, HRESULT* outResult) {
+            ++compileCount;
+            *outResult = S_OK;
+            return makeFake<FakePipelineState>(desc);
+        }, 1);
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = {};
+    desc.VS = writer.shader("shader_vs");
+    desc.PS = writer.shader("shader_ps");
+    fastdx::ReloadablePipelineStatePtr pipelineState = std::make_shared<fastdx::ReloadablePipelineState>(
+        compiler->compile(desc));
+    compiler->waitIdle();
+    ID3D12PipelineState* original = pipelineState->current();
+
+    fastdx::ShaderHotReloader reloader(std::move(builder), directory.path, compiler);
+    CHECK(reloader.watchResult() == S_OK);
+    reloader.addPipeline(pipelineState, desc, "shader_vs", "shader_ps");
+
+    // Files no shader depends on do not rebuild
+    writeFile(directory.path / "unrelated.txt", "edited");
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    CHECK_EQ(reloader.buildCount(), 0u);
+
+    writeFile(directory.path / "include" / "common.hlsli", "// edited\n");
+    CHECK(waitUntil([&]() { return reloader.buildCount() > 0 && compiler->pendingCount() == 0 &&
+        compileCount == 2; }));
+    fastdx::DeferredReleaseQueue releaseQueue;
+    CHECK(waitUntil([&]() { return reloader.update(releaseQueue, 1) == 1; }));
+    CHECK(pipelineState->current() != original);
+    CHECK(reloader.lastBuildErrors().empty());
+    CHECK_EQ(reloader.swapCount(), 1u);
+}
+
+
+TEST(reloaderReportsUnwatchableDirectories) {
+    ShaderDirectory directory("fastdx_shader_hot_reload_missing");
+    fastdx::ShaderPermutationBuilder builder(directory.compilerPath, directory.path / "cache", 1);
+    fastdx::AsyncPipelineCompilerPtr compiler = std::make_shared<fastdx::AsyncPipelineCompiler>(
+        [](const D3D12_GRAPHICS_PIPELINE_STATE_DESC&, HRESULT*) { return nullptr; }, 1);
+    fastdx::ShaderHotReloader reloader(std::move(builder), directory.path / "missing", compiler);
+    CHECK(FAILED(reloader.watchResult()));
+    CHECK_EQ(reloader.lastBuildErrors().size(), 1u);
+    CHECK(reloader.lastBuildErrors()[0].find("Cannot watch") != std::string::npos);
+}
@@ -0,0 +1,81 @@
+#include "benchmark.h"
+#include "fakes.h"
+
+#include <fstream>
+#include <random>
+
+using namespace fastdx_test;
+
+namespace {
+    const uint32_t kShaderCount = 5000;
+    const uint32_t kUniqueShaderCount = 3000;       // Permutations often compile to the same bytecode
+
+    std::string shaderName(uint32_t index) {
+        return "shader_" + std::to_string(index);
+    }
+};
+
+
+int main() {
+    // Blob sizes of a typical DXIL permutation set, 2 KB to 32 KB
+    std::mt19937 random(1234);
+    std::vector<std::vector<uint8_t>> blobs(kUniqueShaderCount);
+    uint64_t totalSizeInBytes = 0;
+    for (std::vector<uint8_t>& blob : blobs) {
+        blob.resize(2048 + random() % (30 * 1024));
+        for (uint8_t& value : blob) {
+            value = static_cast<uint8_t>(random());
+        }
+    }
+
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "fastdx_shader_library_benchmark";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    fastdx::ShaderLibraryWriter writer;
+    for (uint32_t i = 0; i < kShaderCount; ++i) {
+        const std::vector<uint8_t>& blob = blobs[i % kUniqueShaderCount];
+        std::ofstream file(directory / (shaderName(i) + ".cso"), std::ios::binary);
+        file.write(reinterpret_cast<const char*>(blob.data()), blob.size());
+        writer.add(shaderName(i), blob.data(), blob.size());
+        totalSizeInBytes += blob.size();
+    }
+    std::filesystem::path libraryPath = directory / "shaders.fdxs";
+    if (FAILED(writer.save(libraryPath))) {
+        printf("Cannot write %s\n", libraryPath.string().c_str());
+        return 1;
+    }
+
+    printf("Loading %u shaders (%u unique, %.1f MB loose, %.1f MB packed), median of 10 runs\n", kShaderCount,
+        kUniqueShaderCount, totalSizeInBytes / (1024.0 * 1024.0),
+        std::filesystem::file_size(libraryPath) / (1024.0 * 1024.0));
+
+    // Every shader read into memory from its own .cso file
+    uint64_t checksum = 0;
+    double looseMs = medianMs(10, [&]() {
+        std::vector<std::vector<uint8_t>> shaders(kShaderCount);
+        for (uint32_t i = 0; i < kShaderCount; ++i) {
+            std::ifstream file(directory / (shaderName(i) + ".cso"), std::ios::binary | std::ios::ate);
+            shaders[i].resize(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(reinterpret_cast<char*>(shaders[i].data()), shaders[i].size());
+            checksum += shaders[i][0];
+        }
+    });
+
+    // One mapping, each lookup is a binary search returning a pointer into it. The first byte is read so the
+    // pages are touched like a pipeline creation would
+    fastdx::ShaderLibrary library;
+    double packedMs = medianMs(10, [&]() {
+        library.open(libraryPath);
+        for (uint32_t i = 0; i < kShaderCount; ++i) {
+            D3D12_SHADER_BYTECODE shader = library.shader(shaderName(i));
+            checksum += static_cast<const uint8_t*>(shader.pShaderBytecode)[0];
+        }
+        library.close();
+    });
+
+    printf("%16s %12.3f ms\n%16s %12.3f ms (%.1fx)\n", "loose files", looseMs, "packed library", packedMs,
+        looseMs / packedMs);
+    std::filesystem::remove_all(directory);
+    return (checksum != 0) ? 0 : 1;
+}
@@ -0,0 +1,576 @@
+#pragma once
+
+///
+/// Minimal Win32/D3D12 declarations for building the fastdx tests on platforms without the Windows SDK.
+/// Interfaces are plain C++ classes whose methods do nothing by default; tests derive fakes from them and
+/// override what they exercise. Free functions are defined in win32_stub.cpp.
+///
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <wchar.h>
+
+#define _countof(a) (sizeof(a) / sizeof((a)[0]))
+#define __stdcall
+#define CALLBACK
+#define WINAPI
+#define FALSE 0
+#define TRUE 1
+#define INFINITE 0xFFFFFFFF
+
+#define S_OK ((HRESULT)0L)
+#define S_FALSE ((HRESULT)1L)
+#define E_NOTIMPL ((HRESULT)0x80004001L)
+#define E_NOINTERFACE ((HRESULT)0x80004002L)
+#define E_FAIL ((HRESULT)0x80004005L)
+#define E_OUTOFMEMORY ((HRESULT)0x8007000EL)
+#define E_INVALIDARG ((HRESULT)0x80070057L)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define HRESULT_FROM_WIN32(x) ((HRESULT)(x) <= 0 ? ((HRESULT)(x)) : ((HRESULT)(((x) & 0x0000FFFF) | 0x80070000)))
+#define IID_PPV_ARGS(pp) IID(), reinterpret_cast<void**>(pp)
+#define __uuidof(x) IID()
+
+#define SW_HIDE 0
+#define SW_SHOW 5
+#define WM_DESTROY 0x2
+#define WM_SIZE 0x5
+#define WM_PAINT 0xF
+#define WM_CLOSE 0x10
+#define WM_QUIT 0x12
+#define WM_KEYDOWN 0x100
+#define VK_ESCAPE 0x1B
+#define VK_F9 0x78
+#define VK_F11 0x7A
+#define VK_F12 0x7B
+#define PM_REMOVE 1
+#define CS_VREDRAW 1
+#define CS_HREDRAW 2
+#define WS_POPUP 0x80000000L
+#define WS_OVERLAPPEDWINDOW 0xCF0000L
+#define CW_USEDEFAULT ((int)0x80000000)
+#define IDI_APPLICATION 0
+#define IDC_ARROW 0
+
+#define INVALID_HANDLE_VALUE ((HANDLE)(intptr_t)-1)
+#define GENERIC_READ 0x80000000L
+#define FILE_SHARE_READ 0x1
+#define OPEN_EXISTING 3
+#define FILE_ATTRIBUTE_NORMAL 0x80
+#define FILE_FLAG_BACKUP_SEMANTICS 0x02000000
+#define PAGE_READONLY 0x2
+#define FILE_MAP_READ 0x4
+#define WAIT_OBJECT_0 0L
+#define WAIT_TIMEOUT 258L
+#define WAIT_FAILED 0xFFFFFFFF
+#define ERROR_FILE_NOT_FOUND 2L
+#define ERROR_PATH_NOT_FOUND 3L
+#define CREATE_NO_WINDOW 0x08000000
+#define STARTF_USESTDHANDLES 0x100
+
+#define D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING 0x1688
+#define D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES 0xffffffff
+#define D3D12_MIN_DEPTH 0.0f
+#define D3D12_MAX_DEPTH 1.0f
+#define D3D12_DEFAULT_STENCIL_READ_MASK 0xff
+#define D3D12_DEFAULT_STENCIL_WRITE_MASK 0xff
+#define D3D12_DEFAULT_DEPTH_BIAS 0
+#define D3D12_DEFAULT_DEPTH_BIAS_CLAMP 0.0f
+#define D3D12_DEFAULT_SLOPE_SCALED_DEPTH_BIAS 0.0f
+#define D3D12_DEFAULT_SAMPLE_MASK 0xffffffff
+#define D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT 256
+#define D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT 65536
+#define D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT 4194304
+#define D3D12_MAX_SHADER_VISIBLE_SAMPLER_HEAP_SIZE 2048
+#define D3D12_FLOAT32_MAX 3.402823466e+38f
+#define D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE 16
+#define D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT 8
+#define D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT 32
+#define D3D12_ERROR_ADAPTER_NOT_FOUND ((HRESULT)0x887E0001L)
+#define D3D12_ERROR_DRIVER_VERSION_MISMATCH ((HRESULT)0x887E0002L)
+#define D3D12_ENCODE_BASIC_FILTER(min, mag, mip, reduction) \
+    ((D3D12_FILTER)((((min) & 3) << 4) | (((mag) & 3) << 2) | ((mip) & 3) | (((reduction) & 3) << 7)))
+#define D3D12_DECODE_FILTER_REDUCTION(F) ((D3D12_FILTER_REDUCTION_TYPE)(((F) >> 7) & 3))
+#define D3D12_DECODE_IS_ANISOTROPIC_FILTER(F) \
+    (((F) & 0x40) && ((((F) >> 4) & 3) == 1) && ((((F) >> 2) & 3) == 1) && (((F) & 3) == 1))
+
+///
+/// Win32
+///
+typedef int32_t HRESULT;
+typedef int BOOL;
+typedef int32_t INT;
+typedef int32_t LONG;
+typedef uint8_t UINT8;
+typedef uint16_t UINT16;
+typedef uint32_t UINT;
+typedef uint32_t DWORD;
+typedef uint32_t ULONG;
+typedef uint64_t UINT64;
+typedef uint64_t SIZE_T;
+typedef float FLOAT;
+typedef int64_t LONG_PTR;
+typedef LONG_PTR LRESULT;
+typedef uint64_t WPARAM;
+typedef int64_t LPARAM;
+typedef wchar_t WCHAR;
+typedef wchar_t* LPWSTR;
+typedef const wchar_t* LPCWSTR;
+typedef char* LPSTR;
+typedef void* LPVOID;
+typedef const void* LPCVOID;
+typedef void* HANDLE;
+typedef void* HWND;
+typedef void* HINSTANCE;
+typedef void* HMODULE;
+typedef void* HICON;
+typedef void* HCURSOR;
+
+typedef struct { LONG left, top, right, bottom; } RECT;
+typedef struct { HWND hwnd; UINT message; WPARAM wParam; LPARAM lParam; DWORD time; } MSG;
+typedef LRESULT (*WNDPROC)(HWND, UINT, WPARAM, LPARAM);
+typedef struct {
+    UINT cbSize; UINT style; WNDPROC lpfnWndProc; int cbClsExtra, cbWndExtra; HINSTANCE hInstance; HICON hIcon;
+    HCURSOR hCursor; void* hbrBackground; LPCWSTR lpszMenuName; LPCWSTR lpszClassName; HICON hIconSm;
+} WNDCLASSEX;
+typedef struct { int64_t QuadPart; } LARGE_INTEGER;
+typedef struct {
+    DWORD cb; LPWSTR lpReserved, lpDesktop, lpTitle; DWORD dwX, dwY, dwXSize, dwYSize, dwXCountChars, dwYCountChars;
+    DWORD dwFillAttribute, dwFlags; UINT16 wShowWindow, cbReserved2; void* lpReserved2;
+    HANDLE hStdInput, hStdOutput, hStdError;
+} STARTUPINFOW;
+typedef struct { HANDLE hProcess, hThread; DWORD dwProcessId, dwThreadId; } PROCESS_INFORMATION;
+
+HMODULE GetModuleHandle(LPCWSTR moduleName);
+DWORD GetModuleFileName(HMODULE module, WCHAR* fileName, DWORD size);
+HICON LoadIcon(HINSTANCE instance, int name);
+HCURSOR LoadCursor(HINSTANCE instance, int name);
+UINT RegisterClassEx(const WNDCLASSEX* windowClass);
+BOOL UnregisterClass(LPCWSTR className, HINSTANCE instance);
+HWND CreateWindow(LPCWSTR className, LPCWSTR windowName, DWORD style, int x, int y, int width, int height,
+    HWND parent, void* menu, HINSTANCE instance, void* param);
+BOOL ShowWindow(HWND window, int command);
+BOOL GetWindowRect(HWND window, RECT* rect);
+LRESULT SendMessage(HWND window, UINT message, WPARAM wParam, LPARAM lParam);
+LRESULT DefWindowProc(HWND window, UINT message, WPARAM wParam, LPARAM lParam);
+void PostQuitMessage(int exitCode);
+BOOL PeekMessage(MSG* message, HWND window, UINT filterMin, UINT filterMax, UINT removeMessage);
+BOOL TranslateMessage(const MSG* message);
+LRESULT DispatchMessage(const MSG* message);
+void OutputDebugString(LPCWSTR text);
+void OutputDebugStringA(const char* text);
+DWORD GetLastError();
+BOOL QueryPerformanceCounter(LARGE_INTEGER* count);
+BOOL QueryPerformanceFrequency(LARGE_INTEGER* frequency);
+
+HANDLE CreateEvent(void* attributes, BOOL manualReset, BOOL initialState, LPCWSTR name);
+BOOL SetEvent(HANDLE event);
+BOOL ResetEvent(HANDLE event);
+DWORD WaitForSingleObject(HANDLE handle, DWORD milliseconds);
+DWORD WaitForSingleObjectEx(HANDLE handle, DWORD milliseconds, BOOL alertable);
+DWORD WaitForMultipleObjects(DWORD count, const HANDLE* handles, BOOL waitAll, DWORD milliseconds);
+BOOL CloseHandle(HANDLE handle);
+
+HANDLE CreateFileW(LPCWSTR fileName, DWORD access, DWORD shareMode, void* attributes, DWORD disposition,
+    DWORD flags, HANDLE templateFile);
+HANDLE CreateFile(LPCWSTR fileName, DWORD access, DWORD shareMode, void* attributes, DWORD disposition,
+    DWORD flags, HANDLE templateFile);
+BOOL GetFileSizeEx(HANDLE file, LARGE_INTEGER* size);
+HANDLE CreateFileMappingW(HANDLE file, void* attributes, DWORD protect, DWORD sizeHigh, DWORD sizeLow, LPCWSTR name);
+HANDLE CreateFileMapping(HANDLE file, void* attributes, DWORD protect, DWORD sizeHigh, DWORD sizeLow, LPCWSTR name);
+LPVOID MapViewOfFile(HANDLE mapping, DWORD access, DWORD offsetHigh, DWORD offsetLow, SIZE_T size);
+BOOL UnmapViewOfFile(LPCVOID view);
+
+BOOL CreateProcessW(LPCWSTR applicationName, LPWSTR commandLine, void* processAttributes, void* threadAttributes,
+    BOOL inheritHandles, DWORD creationFlags, void* environment, LPCWSTR currentDirectory,
+    STARTUPINFOW* startupInfo, PROCESS_INFORMATION* processInformation);
+BOOL GetExitCodeProcess(HANDLE process, DWORD* exitCode);
+
+///
+/// COM
+///
+struct GUID { uint32_t Data1; };
+typedef GUID IID;
+typedef const IID& REFIID;
+
+struct IUnknown {
+    virtual ~IUnknown() {}
+    virtual HRESULT QueryInterface(REFIID, void**) { return E_NOINTERFACE; }
+    virtual ULONG AddRef() { return ++_refCount; }
+    virtual ULONG Release() {
+        ULONG refCount = --_refCount;
+        if (refCount == 0) {
+            delete this;
+        }
+        return refCount;
+    }
+private:
+    ULONG _refCount = 1;
+};
+
+struct ID3DBlob : IUnknown {
+    virtual void* GetBufferPointer() { return nullptr; }
+    virtual SIZE_T GetBufferSize() { return 0; }
+};
+
+///
+/// D3D12 types
+///
+typedef RECT D3D12_RECT;
+typedef uint64_t D3D12_GPU_VIRTUAL_ADDRESS;
+struct D3D12_CPU_DESCRIPTOR_HANDLE { SIZE_T ptr; };
+struct D3D12_GPU_DESCRIPTOR_HANDLE { UINT64 ptr; };
+struct D3D12_RANGE { SIZE_T Begin, End; };
+struct D3D12_BOX { UINT left, top, front, right, bottom, back; };
+
+enum DXGI_FORMAT {
+    DXGI_FORMAT_UNKNOWN = 0, DXGI_FORMAT_R32G32B32A32_FLOAT = 2, DXGI_FORMAT_R32G32B32_FLOAT = 6,
+    DXGI_FORMAT_R16G16B16A16_FLOAT = 10, DXGI_FORMAT_R10G10B10A2_UNORM = 24, DXGI_FORMAT_R8G8B8A8_UNORM = 28,
+    DXGI_FORMAT_R32_TYPELESS = 39, DXGI_FORMAT_D32_FLOAT = 40, DXGI_FORMAT_R32_FLOAT = 41,
+    DXGI_FORMAT_R32_UINT = 42, DXGI_FORMAT_R16_UINT = 57, DXGI_FORMAT_B8G8R8A8_UNORM = 87
+};
+struct DXGI_SAMPLE_DESC { UINT Count; UINT Quality; };
+
+enum D3D_FEATURE_LEVEL { D3D_FEATURE_LEVEL_12_0 = 0xc000, D3D_FEATURE_LEVEL_12_1 = 0xc100, D3D_FEATURE_LEVEL_12_2 = 0xc200 };
+enum D3D_PRIMITIVE_TOPOLOGY { D3D_PRIMITIVE_TOPOLOGY_UNDEFINED = 0, D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST = 4 };
+typedef D3D_PRIMITIVE_TOPOLOGY D3D12_PRIMITIVE_TOPOLOGY;
+enum D3D12_PRIMITIVE_TOPOLOGY_TYPE { D3D12_PRIMITIVE_TOPOLOGY_TYPE_UNDEFINED = 0, D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE = 3 };
+
+enum D3D12_COMMAND_LIST_TYPE { D3D12_COMMAND_LIST_TYPE_DIRECT = 0, D3D12_COMMAND_LIST_TYPE_COMPUTE = 2, D3D12_COMMAND_LIST_TYPE_COPY = 3 };
+enum D3D12_COMMAND_QUEUE_FLAGS { D3D12_COMMAND_QUEUE_FLAG_NONE = 0 };
+struct D3D12_COMMAND_QUEUE_DESC { D3D12_COMMAND_LIST_TYPE Type; INT Priority; D3D12_COMMAND_QUEUE_FLAGS Flags; UINT NodeMask; };
+enum D3D12_FENCE_FLAGS { D3D12_FENCE_FLAG_NONE = 0 };
+
+enum D3D12_DESCRIPTOR_HEAP_TYPE {
+    D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV = 0, D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, D3D12_DESCRIPTOR_HEAP_TYPE_RTV,
+    D3D12_DESCRIPTOR_HEAP_TYPE_DSV, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES
+};
+enum D3D12_DESCRIPTOR_HEAP_FLAGS { D3D12_DESCRIPTOR_HEAP_FLAG_NONE = 0, D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE = 1 };
+struct D3D12_DESCRIPTOR_HEAP_DESC { D3D12_DESCRIPTOR_HEAP_TYPE Type; UINT NumDescriptors; D3D12_DESCRIPTOR_HEAP_FLAGS Flags; UINT NodeMask; };
+
+enum D3D12_HEAP_TYPE { D3D12_HEAP_TYPE_DEFAULT = 1, D3D12_HEAP_TYPE_UPLOAD = 2, D3D12_HEAP_TYPE_READBACK = 3 };
+enum D3D12_CPU_PAGE_PROPERTY { D3D12_CPU_PAGE_PROPERTY_UNKNOWN = 0 };
+enum D3D12_MEMORY_POOL { D3D12_MEMORY_POOL_UNKNOWN = 0 };
+struct D3D12_HEAP_PROPERTIES {
+    D3D12_HEAP_TYPE Type; D3D12_CPU_PAGE_PROPERTY CPUPageProperty; D3D12_MEMORY_POOL MemoryPoolPreference;
+    UINT CreationNodeMask; UINT VisibleNodeMask;
+};
+enum D3D12_HEAP_FLAGS {
+    D3D12_HEAP_FLAG_NONE = 0, D3D12_HEAP_FLAG_DENY_BUFFERS = 0x4, D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES = 0x40,
+    D3D12_HEAP_FLAG_DENY_NON_RT_DS_TEXTURES = 0x80, D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES = 0,
+    D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS = 0xc0, D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES = 0x44,
+    D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES = 0x84
+};
+struct D3D12_HEAP_DESC { UINT64 SizeInBytes; D3D12_HEAP_PROPERTIES Properties; UINT64 Alignment; D3D12_HEAP_FLAGS Flags; };
+enum D3D12_RESOURCE_HEAP_TIER { D3D12_RESOURCE_HEAP_TIER_1 = 1, D3D12_RESOURCE_HEAP_TIER_2 = 2 };
+enum D3D12_FEATURE { D3D12_FEATURE_D3D12_OPTIONS = 0 };
+struct D3D12_FEATURE_DATA_D3D12_OPTIONS {
+    BOOL DoublePrecisionFloatShaderOps; BOOL OutputMergerLogicOp; UINT MinPrecisionSupport; UINT TiledResourcesTier;
+    UINT ResourceBindingTier; BOOL PSSpecifiedStencilRefSupported; BOOL TypedUAVLoadAdditionalFormats; BOOL ROVsSupported;
+    UINT ConservativeRasterizationTier; UINT MaxGPUVirtualAddressBitsPerResource;
+    BOOL StandardSwizzle64KBSupported; UINT CrossNodeSharingTier; BOOL CrossAdapterRowMajorTextureSupported;
+    BOOL VPAndRTArrayIndexFromAnyShaderFeedingRasterizerSupportedWithoutGSEmulation;
+    D3D12_RESOURCE_HEAP_TIER ResourceHeapTier;
+};
+
+enum D3D12_RESOURCE_DIMENSION {
+    D3D12_RESOURCE_DIMENSION_UNKNOWN = 0, D3D12_RESOURCE_DIMENSION_BUFFER = 1, D3D12_RESOURCE_DIMENSION_TEXTURE1D,
+    D3D12_RESOURCE_DIMENSION_TEXTURE2D, D3D12_RESOURCE_DIMENSION_TEXTURE3D
+};
+enum D3D12_TEXTURE_LAYOUT { D3D12_TEXTURE_LAYOUT_UNKNOWN = 0, D3D12_TEXTURE_LAYOUT_ROW_MAJOR = 1 };
+enum D3D12_RESOURCE_FLAGS {
+    D3D12_RESOURCE_FLAG_NONE = 0, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET = 0x1, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL = 0x2,
+    D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS = 0x4
+};
+inline D3D12_RESOURCE_FLAGS operator|(D3D12_RESOURCE_FLAGS a, D3D12_RESOURCE_FLAGS b) { return D3D12_RESOURCE_FLAGS(int(a) | int(b)); }
+inline D3D12_RESOURCE_FLAGS operator&(D3D12_RESOURCE_FLAGS a, D3D12_RESOURCE_FLAGS b) { return D3D12_RESOURCE_FLAGS(int(a) & int(b)); }
+struct D3D12_RESOURCE_DESC {
+    D3D12_RESOURCE_DIMENSION Dimension; UINT64 Alignment; UINT64 Width; UINT Height; UINT16 DepthOrArraySize;
+    UINT16 MipLevels; DXGI_FORMAT Format; DXGI_SAMPLE_DESC SampleDesc; D3D12_TEXTURE_LAYOUT Layout; D3D12_RESOURCE_FLAGS Flags;
+};
+struct D3D12_RESOURCE_ALLOCATION_INFO { UINT64 SizeInBytes, Alignment; };
+enum D3D12_RESOURCE_STATES {
+    D3D12_RESOURCE_STATE_COMMON = 0, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER = 0x1,
+    D3D12_RESOURCE_STATE_INDEX_BUFFER = 0x2, D3D12_RESOURCE_STATE_RENDER_TARGET = 0x4,
+    D3D12_RESOURCE_STATE_UNORDERED_ACCESS = 0x8, D3D12_RESOURCE_STATE_DEPTH_WRITE = 0x10,
+    D3D12_RESOURCE_STATE_DEPTH_READ = 0x20, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE = 0x40,
+    D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE = 0x80, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT = 0x200,
+    D3D12_RESOURCE_STATE_COPY_DEST = 0x400, D3D12_RESOURCE_STATE_COPY_SOURCE = 0x800,
+    D3D12_RESOURCE_STATE_GENERIC_READ = 0xac3, D3D12_RESOURCE_STATE_PRESENT = 0,
+    D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE = 0xc0
+};
+inline D3D12_RESOURCE_STATES operator|(D3D12_RESOURCE_STATES a, D3D12_RESOURCE_STATES b) { return D3D12_RESOURCE_STATES(int(a) | int(b)); }
+inline D3D12_RESOURCE_STATES operator&(D3D12_RESOURCE_STATES a, D3D12_RESOURCE_STATES b) { return D3D12_RESOURCE_STATES(int(a) & int(b)); }
+inline D3D12_RESOURCE_STATES& operator|=(D3D12_RESOURCE_STATES& a, D3D12_RESOURCE_STATES b) { return a = a | b; }
+struct D3D12_DEPTH_STENCIL_VALUE { FLOAT Depth; UINT8 Stencil; };
+struct D3D12_CLEAR_VALUE { DXGI_FORMAT Format; union { FLOAT Color[4]; D3D12_DEPTH_STENCIL_VALUE DepthStencil; }; };
+
+enum D3D12_RESOURCE_BARRIER_TYPE { D3D12_RESOURCE_BARRIER_TYPE_TRANSITION = 0, D3D12_RESOURCE_BARRIER_TYPE_ALIASING, D3D12_RESOURCE_BARRIER_TYPE_UAV };
+enum D3D12_RESOURCE_BARRIER_FLAGS { D3D12_RESOURCE_BARRIER_FLAG_NONE = 0, D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY = 1, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY = 2 };
+struct ID3D12Resource;
+struct D3D12_RESOURCE_TRANSITION_BARRIER { ID3D12Resource* pResource; UINT Subresource; D3D12_RESOURCE_STATES StateBefore; D3D12_RESOURCE_STATES StateAfter; };
+struct D3D12_RESOURCE_ALIASING_BARRIER { ID3D12Resource* pResourceBefore; ID3D12Resource* pResourceAfter; };
+struct D3D12_RESOURCE_UAV_BARRIER { ID3D12Resource* pResource; };
+struct D3D12_RESOURCE_BARRIER {
+    D3D12_RESOURCE_BARRIER_TYPE Type; D3D12_RESOURCE_BARRIER_FLAGS Flags;
+    union { D3D12_RESOURCE_TRANSITION_BARRIER Transition; D3D12_RESOURCE_ALIASING_BARRIER Aliasing; D3D12_RESOURCE_UAV_BARRIER UAV; };
+};
+
+struct D3D12_VIEWPORT { FLOAT TopLeftX, TopLeftY, Width, Height, MinDepth, MaxDepth; };
+struct D3D12_INDEX_BUFFER_VIEW { D3D12_GPU_VIRTUAL_ADDRESS BufferLocation; UINT SizeInBytes; DXGI_FORMAT Format; };
+struct D3D12_VERTEX_BUFFER_VIEW { D3D12_GPU_VIRTUAL_ADDRESS BufferLocation; UINT SizeInBytes; UINT StrideInBytes; };
+enum D3D12_TEXTURE_COPY_TYPE { D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX = 0, D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT = 1 };
+struct D3D12_SUBRESOURCE_FOOTPRINT { DXGI_FORMAT Format; UINT Width, Height, Depth, RowPitch; };
+struct D3D12_PLACED_SUBRESOURCE_FOOTPRINT { UINT64 Offset; D3D12_SUBRESOURCE_FOOTPRINT Footprint; };
+struct D3D12_TEXTURE_COPY_LOCATION {
+    ID3D12Resource* pResource; D3D12_TEXTURE_COPY_TYPE Type;
+    union { D3D12_PLACED_SUBRESOURCE_FOOTPRINT PlacedFootprint; UINT SubresourceIndex; };
+};
+enum D3D12_CLEAR_FLAGS { D3D12_CLEAR_FLAG_DEPTH = 1, D3D12_CLEAR_FLAG_STENCIL = 2 };
+enum D3D12_QUERY_HEAP_TYPE { D3D12_QUERY_HEAP_TYPE_OCCLUSION = 0, D3D12_QUERY_HEAP_TYPE_TIMESTAMP = 1 };
+enum D3D12_QUERY_TYPE { D3D12_QUERY_TYPE_OCCLUSION = 0, D3D12_QUERY_TYPE_TIMESTAMP = 2 };
+struct D3D12_QUERY_HEAP_DESC { D3D12_QUERY_HEAP_TYPE Type; UINT Count; UINT NodeMask; };
+
+struct D3D12_SHADER_BYTECODE { const void* pShaderBytecode; SIZE_T BytecodeLength; };
+struct D3D12_SO_DECLARATION_ENTRY { UINT Stream; const char* SemanticName; UINT SemanticIndex; UINT8 StartComponent, ComponentCount, OutputSlot; };
+struct D3D12_STREAM_OUTPUT_DESC { const D3D12_SO_DECLARATION_ENTRY* pSODeclaration; UINT NumEntries; const UINT* pBufferStrides; UINT NumStrides; UINT RasterizedStream; };
+enum D3D12_BLEND { D3D12_BLEND_ZERO = 1, D3D12_BLEND_ONE = 2, D3D12_BLEND_SRC_ALPHA = 5 };
+enum D3D12_BLEND_OP { D3D12_BLEND_OP_ADD = 1 };
+enum D3D12_LOGIC_OP { D3D12_LOGIC_OP_NOOP = 4 };
+enum D3D12_COLOR_WRITE_ENABLE { D3D12_COLOR_WRITE_ENABLE_ALL = 15 };
+struct D3D12_RENDER_TARGET_BLEND_DESC {
+    BOOL BlendEnable, LogicOpEnable; D3D12_BLEND SrcBlend, DestBlend; D3D12_BLEND_OP BlendOp; D3D12_BLEND SrcBlendAlpha, DestBlendAlpha;
+    D3D12_BLEND_OP BlendOpAlpha; D3D12_LOGIC_OP LogicOp; UINT8 RenderTargetWriteMask;
+};
+struct D3D12_BLEND_DESC { BOOL AlphaToCoverageEnable, IndependentBlendEnable; D3D12_RENDER_TARGET_BLEND_DESC RenderTarget[8]; };
+enum D3D12_FILL_MODE { D3D12_FILL_MODE_WIREFRAME = 2, D3D12_FILL_MODE_SOLID = 3 };
+enum D3D12_CULL_MODE { D3D12_CULL_MODE_NONE = 1, D3D12_CULL_MODE_FRONT, D3D12_CULL_MODE_BACK };
+enum D3D12_CONSERVATIVE_RASTERIZATION_MODE { D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF = 0 };
+struct D3D12_RASTERIZER_DESC {
+    D3D12_FILL_MODE FillMode; D3D12_CULL_MODE CullMode; BOOL FrontCounterClockwise; INT DepthBias; FLOAT DepthBiasClamp, SlopeScaledDepthBias;
+    BOOL DepthClipEnable, MultisampleEnable, AntialiasedLineEnable; UINT ForcedSampleCount; D3D12_CONSERVATIVE_RASTERIZATION_MODE ConservativeRaster;
+};
+enum D3D12_DEPTH_WRITE_MASK { D3D12_DEPTH_WRITE_MASK_ZERO = 0, D3D12_DEPTH_WRITE_MASK_ALL = 1 };
+enum D3D12_COMPARISON_FUNC { D3D12_COMPARISON_FUNC_NEVER = 1, D3D12_COMPARISON_FUNC_LESS = 2, D3D12_COMPARISON_FUNC_GREATER = 5,
+    D3D12_COMPARISON_FUNC_ALWAYS = 8 };
+enum D3D12_STENCIL_OP { D3D12_STENCIL_OP_KEEP = 1 };
+struct D3D12_DEPTH_STENCILOP_DESC { D3D12_STENCIL_OP StencilFailOp, StencilDepthFailOp, StencilPassOp; D3D12_COMPARISON_FUNC StencilFunc; };
+struct D3D12_DEPTH_STENCIL_DESC {
+    BOOL DepthEnable; D3D12_DEPTH_WRITE_MASK DepthWriteMask; D3D12_COMPARISON_FUNC DepthFunc; BOOL StencilEnable;
+    UINT8 StencilReadMask, StencilWriteMask; D3D12_DEPTH_STENCILOP_DESC FrontFace, BackFace;
+};
+enum D3D12_INPUT_CLASSIFICATION { D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA = 0 };
+struct D3D12_INPUT_ELEMENT_DESC {
+    const char* SemanticName; UINT SemanticIndex; DXGI_FORMAT Format; UINT InputSlot, AlignedByteOffset;
+    D3D12_INPUT_CLASSIFICATION InputSlotClass; UINT InstanceDataStepRate;
+};
+struct D3D12_INPUT_LAYOUT_DESC { const D3D12_INPUT_ELEMENT_DESC* pInputElementDescs; UINT NumElements; };
+enum D3D12_INDEX_BUFFER_STRIP_CUT_VALUE { D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_DISABLED = 0 };
+struct D3D12_CACHED_PIPELINE_STATE { const void* pCachedBlob; SIZE_T CachedBlobSizeInBytes; };
+enum D3D12_PIPELINE_STATE_FLAGS { D3D12_PIPELINE_STATE_FLAG_NONE = 0 };
+struct ID3D12RootSignature;
+struct D3D12_GRAPHICS_PIPELINE_STATE_DESC {
+    ID3D12RootSignature* pRootSignature; D3D12_SHADER_BYTECODE VS, PS, DS, HS, GS; D3D12_STREAM_OUTPUT_DESC StreamOutput;
+    D3D12_BLEND_DESC BlendState; UINT SampleMask; D3D12_RASTERIZER_DESC RasterizerState; D3D12_DEPTH_STENCIL_DESC DepthStencilState;
+    D3D12_INPUT_LAYOUT_DESC InputLayout; D3D12_INDEX_BUFFER_STRIP_CUT_VALUE IBStripCutValue;
+    D3D12_PRIMITIVE_TOPOLOGY_TYPE PrimitiveTopologyType; UINT NumRenderTargets; DXGI_FORMAT RTVFormats[8]; DXGI_FORMAT DSVFormat;
+    DXGI_SAMPLE_DESC SampleDesc; UINT NodeMask; D3D12_CACHED_PIPELINE_STATE CachedPSO; D3D12_PIPELINE_STATE_FLAGS Flags;
+};
+
+enum D3D12_SRV_DIMENSION { D3D12_SRV_DIMENSION_UNKNOWN = 0, D3D12_SRV_DIMENSION_BUFFER = 1, D3D12_SRV_DIMENSION_TEXTURE2D = 4 };
+enum D3D12_BUFFER_SRV_FLAGS { D3D12_BUFFER_SRV_FLAG_NONE = 0, D3D12_BUFFER_SRV_FLAG_RAW = 1 };
+struct D3D12_BUFFER_SRV { UINT64 FirstElement; UINT NumElements; UINT StructureByteStride; D3D12_BUFFER_SRV_FLAGS Flags; };
+struct D3D12_TEX2D_SRV { UINT MostDetailedMip, MipLevels, PlaneSlice; FLOAT ResourceMinLODClamp; };
+struct D3D12_SHADER_RESOURCE_VIEW_DESC {
+    DXGI_FORMAT Format; D3D12_SRV_DIMENSION ViewDimension; UINT Shader4ComponentMapping;
+    union { D3D12_BUFFER_SRV Buffer; D3D12_TEX2D_SRV Texture2D; };
+};
+struct D3D12_CONSTANT_BUFFER_VIEW_DESC { D3D12_GPU_VIRTUAL_ADDRESS BufferLocation; UINT SizeInBytes; };
+enum D3D12_DSV_DIMENSION { D3D12_DSV_DIMENSION_TEXTURE2D = 3 };
+struct D3D12_DEPTH_STENCIL_VIEW_DESC { DXGI_FORMAT Format; D3D12_DSV_DIMENSION ViewDimension; UINT Flags; UINT MipSlice; };
+enum D3D12_RTV_DIMENSION { D3D12_RTV_DIMENSION_TEXTURE2D = 4 };
+struct D3D12_RENDER_TARGET_VIEW_DESC { DXGI_FORMAT Format; D3D12_RTV_DIMENSION ViewDimension; UINT MipSlice; };
+
+enum D3D12_FILTER {
+    D3D12_FILTER_MIN_MAG_MIP_POINT = 0, D3D12_FILTER_MIN_MAG_POINT_MIP_LINEAR = 0x1,
+    D3D12_FILTER_MIN_POINT_MAG_LINEAR_MIP_POINT = 0x4, D3D12_FILTER_MIN_POINT_MAG_MIP_LINEAR = 0x5,
+    D3D12_FILTER_MIN_LINEAR_MAG_MIP_POINT = 0x10, D3D12_FILTER_MIN_LINEAR_MAG_POINT_MIP_LINEAR = 0x11,
+    D3D12_FILTER_MIN_MAG_LINEAR_MIP_POINT = 0x14, D3D12_FILTER_MIN_MAG_MIP_LINEAR = 0x15, D3D12_FILTER_ANISOTROPIC = 0x55,
+    D3D12_FILTER_COMPARISON_MIN_MAG_MIP_LINEAR = 0x95
+};
+enum D3D12_FILTER_TYPE { D3D12_FILTER_TYPE_POINT = 0, D3D12_FILTER_TYPE_LINEAR = 1 };
+enum D3D12_FILTER_REDUCTION_TYPE { D3D12_FILTER_REDUCTION_TYPE_STANDARD = 0, D3D12_FILTER_REDUCTION_TYPE_COMPARISON = 1 };
+enum D3D12_TEXTURE_ADDRESS_MODE {
+    D3D12_TEXTURE_ADDRESS_MODE_WRAP = 1, D3D12_TEXTURE_ADDRESS_MODE_MIRROR, D3D12_TEXTURE_ADDRESS_MODE_CLAMP, D3D12_TEXTURE_ADDRESS_MODE_BORDER
+};
+struct D3D12_SAMPLER_DESC {
+    D3D12_FILTER Filter; D3D12_TEXTURE_ADDRESS_MODE AddressU, AddressV, AddressW; FLOAT MipLODBias; UINT MaxAnisotropy;
+    D3D12_COMPARISON_FUNC ComparisonFunc; FLOAT BorderColor[4]; FLOAT MinLOD, MaxLOD;
+};
+
+enum D3D12_INDIRECT_ARGUMENT_TYPE {
+    D3D12_INDIRECT_ARGUMENT_TYPE_DRAW = 0, D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED, D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH,
+    D3D12_INDIRECT_ARGUMENT_TYPE_VERTEX_BUFFER_VIEW, D3D12_INDIRECT_ARGUMENT_TYPE_INDEX_BUFFER_VIEW,
+    D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT, D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT_BUFFER_VIEW,
+    D3D12_INDIRECT_ARGUMENT_TYPE_SHADER_RESOURCE_VIEW, D3D12_INDIRECT_ARGUMENT_TYPE_UNORDERED_ACCESS_VIEW
+};
+struct D3D12_INDIRECT_ARGUMENT_DESC {
+    D3D12_INDIRECT_ARGUMENT_TYPE Type;
+    union {
+        struct { UINT Slot; } VertexBuffer;
+        struct { UINT RootParameterIndex, DestOffsetIn32BitValues, Num32BitValuesToSet; } Constant;
+        struct { UINT RootParameterIndex; } ConstantBufferView;
+        struct { UINT RootParameterIndex; } ShaderResourceView;
+        struct { UINT RootParameterIndex; } UnorderedAccessView;
+    };
+};
+struct D3D12_COMMAND_SIGNATURE_DESC { UINT ByteStride; UINT NumArgumentDescs; const D3D12_INDIRECT_ARGUMENT_DESC* pArgumentDescs; UINT NodeMask; };
+struct D3D12_DRAW_ARGUMENTS { UINT VertexCountPerInstance, InstanceCount, StartVertexLocation, StartInstanceLocation; };
+struct D3D12_DRAW_INDEXED_ARGUMENTS { UINT IndexCountPerInstance, InstanceCount, StartIndexLocation; INT BaseVertexLocation; UINT StartInstanceLocation; };
+struct D3D12_DISPATCH_ARGUMENTS { UINT ThreadGroupCountX, ThreadGroupCountY, ThreadGroupCountZ; };
+
+///
+/// D3D12 interfaces
+///
+struct ID3D12Object : IUnknown {
+    virtual HRESULT SetName(LPCWSTR) { return S_OK; }
+};
+struct ID3D12DeviceChild : ID3D12Object {};
+struct ID3D12Pageable : ID3D12DeviceChild {};
+struct ID3D12RootSignature : ID3D12DeviceChild {};
+struct ID3D12CommandSignature : ID3D12Pageable {};
+struct ID3D12QueryHeap : ID3D12Pageable {};
+
+struct ID3D12Resource : ID3D12Pageable {
+    virtual HRESULT Map(UINT, const D3D12_RANGE*, void**) { return E_NOTIMPL; }
+    virtual void Unmap(UINT, const D3D12_RANGE*) {}
+    virtual D3D12_RESOURCE_DESC GetDesc() { return D3D12_RESOURCE_DESC(); }
+    virtual D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress() { return 0; }
+};
+
+struct ID3D12Heap : ID3D12Pageable {
+    virtual D3D12_HEAP_DESC GetDesc() { return D3D12_HEAP_DESC(); }
+};
+
+struct ID3D12CommandAllocator : ID3D12Pageable {
+    virtual HRESULT Reset() { return S_OK; }
+};
+
+struct ID3D12Fence : ID3D12Pageable {
+    virtual UINT64 GetCompletedValue() { return 0; }
+    virtual HRESULT SetEventOnCompletion(UINT64, HANDLE) { return E_NOTIMPL; }
+    virtual HRESULT Signal(UINT64) { return E_NOTIMPL; }
+};
+struct ID3D12Fence1 : ID3D12Fence {};
+
+struct ID3D12PipelineState : ID3D12Pageable {
+    virtual HRESULT GetCachedBlob(ID3DBlob**) { return E_NOTIMPL; }
+};
+
+struct ID3D12DescriptorHeap : ID3D12Pageable {
+    virtual D3D12_DESCRIPTOR_HEAP_DESC GetDesc() { return D3D12_DESCRIPTOR_HEAP_DESC(); }
+    virtual D3D12_CPU_DESCRIPTOR_HANDLE GetCPUDescriptorHandleForHeapStart() { return D3D12_CPU_DESCRIPTOR_HANDLE(); }
+    virtual D3D12_GPU_DESCRIPTOR_HANDLE GetGPUDescriptorHandleForHeapStart() { return D3D12_GPU_DESCRIPTOR_HANDLE(); }
+};
+
+struct ID3D12CommandList : ID3D12DeviceChild {};
+
+struct ID3D12GraphicsCommandList : ID3D12CommandList {
+    virtual HRESULT Close() { return S_OK; }
+    virtual HRESULT Reset(ID3D12CommandAllocator*, ID3D12PipelineState*) { return S_OK; }
+    virtual void DrawInstanced(UINT, UINT, UINT, UINT) {}
+    virtual void DrawIndexedInstanced(UINT, UINT, UINT, INT, UINT) {}
+    virtual void Dispatch(UINT, UINT, UINT) {}
+    virtual void CopyBufferRegion(ID3D12Resource*, UINT64, ID3D12Resource*, UINT64, UINT64) {}
+    virtual void CopyTextureRegion(const D3D12_TEXTURE_COPY_LOCATION*, UINT, UINT, UINT, const D3D12_TEXTURE_COPY_LOCATION*,
+        const D3D12_BOX*) {}
+    virtual void CopyResource(ID3D12Resource*, ID3D12Resource*) {}
+    virtual void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY) {}
+    virtual void RSSetViewports(UINT, const D3D12_VIEWPORT*) {}
+    virtual void RSSetScissorRects(UINT, const D3D12_RECT*) {}
+    virtual void SetPipelineState(ID3D12PipelineState*) {}
+    virtual void ResourceBarrier(UINT, const D3D12_RESOURCE_BARRIER*) {}
+    virtual void SetDescriptorHeaps(UINT, ID3D12DescriptorHeap* const*) {}
+    virtual void SetGraphicsRootSignature(ID3D12RootSignature*) {}
+    virtual void SetComputeRootSignature(ID3D12RootSignature*) {}
+    virtual void SetGraphicsRootDescriptorTable(UINT, D3D12_GPU_DESCRIPTOR_HANDLE) {}
+    virtual void SetComputeRootDescriptorTable(UINT, D3D12_GPU_DESCRIPTOR_HANDLE) {}
+    virtual void SetGraphicsRoot32BitConstant(UINT, UINT, UINT) {}
+    virtual void SetGraphicsRoot32BitConstants(UINT, UINT, const void*, UINT) {}
+    virtual void SetComputeRoot32BitConstants(UINT, UINT, const void*, UINT) {}
+    virtual void SetGraphicsRootConstantBufferView(UINT, D3D12_GPU_VIRTUAL_ADDRESS) {}
+    virtual void SetGraphicsRootShaderResourceView(UINT, D3D12_GPU_VIRTUAL_ADDRESS) {}
+    virtual void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW*) {}
+    virtual void IASetVertexBuffers(UINT, UINT, const D3D12_VERTEX_BUFFER_VIEW*) {}
+    virtual void OMSetRenderTargets(UINT, const D3D12_CPU_DESCRIPTOR_HANDLE*, BOOL, const D3D12_CPU_DESCRIPTOR_HANDLE*) {}
+    virtual void ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_CLEAR_FLAGS, FLOAT, UINT8, UINT, const D3D12_RECT*) {}
+    virtual void ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE, const FLOAT[4], UINT, const D3D12_RECT*) {}
+    virtual void EndQuery(ID3D12QueryHeap*, D3D12_QUERY_TYPE, UINT) {}
+    virtual void ResolveQueryData(ID3D12QueryHeap*, D3D12_QUERY_TYPE, UINT, UINT, ID3D12Resource*, UINT64) {}
+    virtual void ExecuteIndirect(ID3D12CommandSignature*, UINT, ID3D12Resource*, UINT64, ID3D12Resource*, UINT64) {}
+};
+struct ID3D12GraphicsCommandList6 : ID3D12GraphicsCommandList {};
+
+struct ID3D12CommandQueue : ID3D12Pageable {
+    virtual void ExecuteCommandLists(UINT, ID3D12CommandList* const*) {}
+    virtual HRESULT Signal(ID3D12Fence*, UINT64) { return E_NOTIMPL; }
+    virtual HRESULT Wait(ID3D12Fence*, UINT64) { return E_NOTIMPL; }
+    virtual HRESULT GetTimestampFrequency(UINT64*) { return E_NOTIMPL; }
+};
+
+struct ID3D12PipelineLibrary : ID3D12DeviceChild {
+    virtual HRESULT StorePipeline(LPCWSTR, ID3D12PipelineState*) { return E_NOTIMPL; }
+    virtual HRESULT LoadGraphicsPipeline(LPCWSTR, const D3D12_GRAPHICS_PIPELINE_STATE_DESC*, REFIID, void**) { return E_NOTIMPL; }
+    virtual SIZE_T GetSerializedSize() { return 0; }
+    virtual HRESULT Serialize(void*, SIZE_T) { return E_NOTIMPL; }
+};
+
+struct ID3D12Device : ID3D12Object {
+    virtual HRESULT CheckFeatureSupport(D3D12_FEATURE, void*, UINT) { return E_NOTIMPL; }
+    virtual HRESULT CreateCommandQueue(const D3D12_COMMAND_QUEUE_DESC*, REFIID, void**) { return E_NOTIMPL; }
+    virtual HRESULT CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE, REFIID, void**) { return E_NOTIMPL; }
+    virtual HRESULT CreateGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC*, REFIID, void**) { return E_NOTIMPL; }
+    virtual HRESULT CreateCommandList(UINT, D3D12_COMMAND_LIST_TYPE, ID3D12CommandAllocator*, ID3D12PipelineState*, REFIID,
+        void**) { return E_NOTIMPL; }
+    virtual HRESULT CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC*, REFIID, void**) { return E_NOTIMPL; }
+    virtual UINT GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE) { return 0; }
+    virtual HRESULT CreateRootSignature(UINT, const void*, SIZE_T, REFIID, void**) { return E_NOTIMPL; }
+    virtual void CreateConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE) {}
+    virtual void CreateShaderResourceView(ID3D12Resource*, const D3D12_SHADER_RESOURCE_VIEW_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE) {}
+    virtual void CreateRenderTargetView(ID3D12Resource*, const D3D12_RENDER_TARGET_VIEW_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE) {}
+    virtual void CreateDepthStencilView(ID3D12Resource*, const D3D12_DEPTH_STENCIL_VIEW_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE) {}
+    virtual void CreateSampler(const D3D12_SAMPLER_DESC*, D3D12_CPU_DESCRIPTOR_HANDLE) {}
+    virtual void CopyDescriptors(UINT, const D3D12_CPU_DESCRIPTOR_HANDLE*, const UINT*, UINT, const D3D12_CPU_DESCRIPTOR_HANDLE*,
+        const UINT*, D3D12_DESCRIPTOR_HEAP_TYPE) {}
+    virtual void CopyDescriptorsSimple(UINT, D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_DESCRIPTOR_HEAP_TYPE) {}
+    virtual D3D12_RESOURCE_ALLOCATION_INFO GetResourceAllocationInfo(UINT, UINT, const D3D12_RESOURCE_DESC*) {
+        return D3D12_RESOURCE_ALLOCATION_INFO();
+    }
+    virtual HRESULT CreateCommittedResource(const D3D12_HEAP_PROPERTIES*, D3D12_HEAP_FLAGS, const D3D12_RESOURCE_DESC*,
+        D3D12_RESOURCE_STATES, const D3D12_CLEAR_VALUE*, REFIID, void**) { return E_NOTIMPL; }
+    virtual HRESULT CreateHeap(const D3D12_HEAP_DESC*, REFIID, void**) { return E_NOTIMPL; }
+    virtual HRESULT CreatePlacedResource(ID3D12Heap*, UINT64, const D3D12_RESOURCE_DESC*, D3D12_RESOURCE_STATES,
+        const D3D12_CLEAR_VALUE*, REFIID, void**) { return E_NOTIMPL; }
+    virtual HRESULT CreateFence(UINT64, D3D12_FENCE_FLAGS, REFIID, void**) { return E_NOTIMPL; }
+    virtual HRESULT CreateQueryHeap(const D3D12_QUERY_HEAP_DESC*, REFIID, void**) { return E_NOTIMPL; }
+    virtual HRESULT CreateCommandSignature(const D3D12_COMMAND_SIGNATURE_DESC*, ID3D12RootSignature*, REFIID, void**) {
+        return E_NOTIMPL;
+    }
+    virtual void GetCopyableFootprints(const D3D12_RESOURCE_DESC*, UINT, UINT, UINT64, D3D12_PLACED_SUBRESOURCE_FOOTPRINT*, UINT*,
+        UINT64*, UINT64*) {}
+    virtual HRESULT MakeResident(UINT, ID3D12Pageable* const*) { return S_OK; }
+    virtual HRESULT Evict(UINT, ID3D12Pageable* const*) { return S_OK; }
+};
+struct ID3D12Device1 : ID3D12Device {
+    virtual HRESULT CreatePipelineLibrary(const void*, SIZE_T, REFIID, void**) { return E_NOTIMPL; }
+};
+struct ID3D12Device2 : ID3D12Device1 {};
+
+struct ID3D12Debug1 : IUnknown {
+    virtual void EnableDebugLayer() {}
+    virtual void SetEnableGPUBasedValidation(BOOL) {}
+    virtual void SetEnableSynchronizedCommandQueueValidation(BOOL) {}
+};
+
+HRESULT D3D12GetDebugInterface(REFIID riid, void** debug);
+HRESULT D3D12CreateDevice(IUnknown* adapter, D3D_FEATURE_LEVEL minimumFeatureLevel, REFIID riid, void** device);
@@ -0,0 +1,48 @@
+#pragma once
+
+///
+/// Minimal DXGI declarations for building the fastdx tests without the Windows SDK.
+///
+#include "d3d12.h"
+
+#define DXGI_ERROR_NOT_FOUND ((HRESULT)0x887A0002L)
+#define DXGI_ADAPTER_FLAG_SOFTWARE 2
+#define DXGI_CREATE_FACTORY_DEBUG 0x1
+#define DXGI_USAGE_RENDER_TARGET_OUTPUT 0x20
+
+struct DXGI_ADAPTER_DESC1 { WCHAR Description[128]; UINT Flags; };
+enum DXGI_MEMORY_SEGMENT_GROUP { DXGI_MEMORY_SEGMENT_GROUP_LOCAL = 0, DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL = 1 };
+struct DXGI_QUERY_VIDEO_MEMORY_INFO { UINT64 Budget, CurrentUsage, AvailableForReservation, CurrentReservation; };
+enum DXGI_SCALING { DXGI_SCALING_STRETCH = 0 };
+enum DXGI_SWAP_EFFECT { DXGI_SWAP_EFFECT_FLIP_DISCARD = 4 };
+enum DXGI_ALPHA_MODE { DXGI_ALPHA_MODE_UNSPECIFIED = 0 };
+struct DXGI_SWAP_CHAIN_DESC1 {
+    UINT Width, Height; DXGI_FORMAT Format; BOOL Stereo; DXGI_SAMPLE_DESC SampleDesc; UINT BufferUsage, BufferCount;
+    DXGI_SCALING Scaling; DXGI_SWAP_EFFECT SwapEffect; DXGI_ALPHA_MODE AlphaMode; UINT Flags;
+};
+
+struct IDXGIAdapter1 : IUnknown {
+    virtual HRESULT GetDesc1(DXGI_ADAPTER_DESC1*) { return E_NOTIMPL; }
+};
+struct IDXGIAdapter3 : IDXGIAdapter1 {
+    virtual HRESULT QueryVideoMemoryInfo(UINT, DXGI_MEMORY_SEGMENT_GROUP, DXGI_QUERY_VIDEO_MEMORY_INFO*) { return E_NOTIMPL; }
+};
+
+struct IDXGISwapChain1 : IUnknown {
+    virtual HRESULT GetBuffer(UINT, REFIID, void**) { return E_NOTIMPL; }
+    virtual HRESULT GetDesc1(DXGI_SWAP_CHAIN_DESC1*) { return E_NOTIMPL; }
+    virtual HRESULT Present(UINT, UINT) { return E_NOTIMPL; }
+};
+struct IDXGISwapChain3 : IDXGISwapChain1 {
+    virtual UINT GetCurrentBackBufferIndex() { return 0; }
+};
+
+struct IDXGIFactory4 : IUnknown {
+    virtual HRESULT EnumAdapters1(UINT, IDXGIAdapter1**) { return DXGI_ERROR_NOT_FOUND; }
+    virtual HRESULT CreateSwapChainForHwnd(IUnknown*, HWND, const DXGI_SWAP_CHAIN_DESC1*, void*, void*, IDXGISwapChain1**) {
+        return E_NOTIMPL;
+    }
+    virtual HRESULT MakeWindowAssociation(HWND, UINT) { return E_NOTIMPL; }
+};
+
+HRESULT CreateDXGIFactory2(UINT flags, REFIID riid, void** factory);
@@ -0,0 +1,16 @@
+#pragma once
+
+///
+/// Minimal DXGI debug declarations for building the fastdx tests without the Windows SDK.
+///
+#include "dxgi1_6.h"
+
+#define DXGI_DEBUG_ALL GUID{0}
+#define DXGI_INFO_QUEUE_MESSAGE_SEVERITY_CORRUPTION 0
+#define DXGI_INFO_QUEUE_MESSAGE_SEVERITY_ERROR 1
+
+struct IDXGIInfoQueue : IUnknown {
+    virtual HRESULT SetBreakOnSeverity(GUID, int, BOOL) { return E_NOTIMPL; }
+};
+
+HRESULT DXGIGetDebugInterface1(UINT flags, REFIID riid, void** debug);
@@ -0,0 +1,294 @@
+///
+/// POSIX implementations of the Win32 calls fastdx makes, enough to run its CPU-side logic in tests: events,
+/// processes and read-only file mappings. Windowing, DXGI and device creation always fail. FileWatcher has its own
+/// inotify backend off Windows.
+///
+#include "d3d12.h"
+#include "dxgi1_6.h"
+#include "dxgidebug.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace {
+    thread_local DWORD lastError = 0;
+
+    struct Handle {
+        virtual ~Handle() {}
+    };
+
+    // All events share one lock and condition, WaitForMultipleObjects sleeps on it
+    std::mutex eventMutex;
+    std::condition_variable eventChanged;
+
+    struct Event : Handle {
+        bool isManualReset = false;
+        bool isSignaled = false;
+    };
+
+    struct Process : Handle {
+        pid_t pid = -1;
+        bool hasExited = false;
+        DWORD exitCode = 0;
+    };
+
+    struct File : Handle {
+        int fd = -1;
+        ~File() { close(fd); }
+    };
+
+    struct Mapping : Handle {
+        int fd = -1;
+        size_t sizeInBytes = 0;
+        ~Mapping() { close(fd); }
+    };
+
+    std::mutex viewMutex;
+    std::map<const void*, size_t> viewSizes;
+
+    void setEvent(HANDLE handle, bool isSignaled) {
+        std::lock_guard<std::mutex> lock(eventMutex);
+        static_cast<Event*>(static_cast<Handle*>(handle))->isSignaled = isSignaled;
+        eventChanged.notify_all();
+    }
+
+    DWORD waitEvents(DWORD count, const HANDLE* handles, DWORD milliseconds) {
+        std::unique_lock<std::mutex> lock(eventMutex);
+        std::chrono::steady_clock::time_point deadline =
+            std::chrono::steady_clock::now() + std::chrono::milliseconds(milliseconds);
+        for (;;) {
+            for (DWORD i = 0; i < count; ++i) {
+                Event* event = static_cast<Event*>(static_cast<Handle*>(handles[i]));
+                if (event->isSignaled) {
+                    event->isSignaled = event->isManualReset;
+                    return WAIT_OBJECT_0 + i;
+                }
+            }
+            if (milliseconds == INFINITE) {
+                eventChanged.wait(lock);
+            } else if (eventChanged.wait_until(lock, deadline) == std::cv_status::timeout) {
+                return WAIT_TIMEOUT;
+            }
+        }
+    }
+
+    std::string narrow(LPCWSTR text) {
+        return std::filesystem::path(text).string();
+    }
+};
+
+
+HMODULE GetModuleHandle(LPCWSTR) { return nullptr; }
+DWORD GetModuleFileName(HMODULE, WCHAR*, DWORD) { return 0; }
+HICON LoadIcon(HINSTANCE, int) { return nullptr; }
+HCURSOR LoadCursor(HINSTANCE, int) { return nullptr; }
+UINT RegisterClassEx(const WNDCLASSEX*) { return 0; }
+BOOL UnregisterClass(LPCWSTR, HINSTANCE) { return FALSE; }
+HWND CreateWindow(LPCWSTR, LPCWSTR, DWORD, int, int, int, int, HWND, void*, HINSTANCE, void*) { return nullptr; }
+BOOL ShowWindow(HWND, int) { return FALSE; }
+BOOL GetWindowRect(HWND, RECT*) { return FALSE; }
+LRESULT SendMessage(HWND, UINT, WPARAM, LPARAM) { return 0; }
+LRESULT DefWindowProc(HWND, UINT, WPARAM, LPARAM) { return 0; }
+void PostQuitMessage(int) {}
+BOOL PeekMessage(MSG*, HWND, UINT, UINT, UINT) { return FALSE; }
+BOOL TranslateMessage(const MSG*) { return FALSE; }
+LRESULT DispatchMessage(const MSG*) { return 0; }
+void OutputDebugString(LPCWSTR text) { fputws(text, stderr); }
+void OutputDebugStringA(const char* text) { fputs(text, stderr); }
+DWORD GetLastError() { return lastError; }
+
+
+BOOL QueryPerformanceCounter(LARGE_INTEGER* count) {
+    count->QuadPart = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    return TRUE;
+}
+
+
+BOOL QueryPerformanceFrequency(LARGE_INTEGER* frequency) {
+    frequency->QuadPart = 1000000000;
+    return TRUE;
+}
+
+
+HANDLE CreateEvent(void*, BOOL manualReset, BOOL initialState, LPCWSTR) {
+    Event* event = new Event();
+    event->isManualReset = manualReset != FALSE;
+    event->isSignaled = initialState != FALSE;
+    return static_cast<Handle*>(event);
+}
+
+
+BOOL SetEvent(HANDLE event) {
+    setEvent(event, true);
+    return TRUE;
+}
+
+
+BOOL ResetEvent(HANDLE event) {
+    setEvent(event, false);
+    return TRUE;
+}
+
+
+DWORD WaitForSingleObject(HANDLE handle, DWORD milliseconds) {
+    if (Process* process = dynamic_cast<Process*>(static_cast<Handle*>(handle))) {
+        int status = 0;
+        if (!process->hasExited && waitpid(process->pid, &status, 0) == process->pid) {
+            process->hasExited = true;
+            process->exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+        }
+        return WAIT_OBJECT_0;
+    }
+    return waitEvents(1, &handle, milliseconds);
+}
+
+
+DWORD WaitForSingleObjectEx(HANDLE handle, DWORD milliseconds, BOOL) {
+    return WaitForSingleObject(handle, milliseconds);
+}
+
+
+DWORD WaitForMultipleObjects(DWORD count, const HANDLE* handles, BOOL, DWORD milliseconds) {
+    return waitEvents(count, handles, milliseconds);
+}
+
+
+BOOL CloseHandle(HANDLE handle) {
+    if (handle == nullptr || handle == INVALID_HANDLE_VALUE) {
+        lastError = 6;  // ERROR_INVALID_HANDLE
+        return FALSE;
+    }
+    delete static_cast<Handle*>(handle);
+    return TRUE;
+}
+
+
+HANDLE CreateFileW(LPCWSTR fileName, DWORD, DWORD, void*, DWORD, DWORD flags, HANDLE) {
+    std::string path = narrow(fileName);
+    struct stat status = {};
+    if (stat(path.c_str(), &status) != 0) {
+        lastError = ERROR_FILE_NOT_FOUND;
+        return INVALID_HANDLE_VALUE;
+    }
+
+    if (S_ISDIR(status.st_mode)) {
+        lastError = 5;  // ERROR_ACCESS_DENIED
+        return INVALID_HANDLE_VALUE;
+    }
+
+    File* file = new File();
+    file->fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file->fd < 0) {
+        delete file;
+        lastError = ERROR_FILE_NOT_FOUND;
+        return INVALID_HANDLE_VALUE;
+    }
+    return static_cast<Handle*>(file);
+}
+
+
+HANDLE CreateFile(LPCWSTR fileName, DWORD access, DWORD shareMode, void* attributes, DWORD disposition, DWORD flags,
+    HANDLE templateFile) {
+    return CreateFileW(fileName, access, shareMode, attributes, disposition, flags, templateFile);
+}
+
+
+BOOL GetFileSizeEx(HANDLE handle, LARGE_INTEGER* size) {
+    struct stat status = {};
+    if (fstat(static_cast<File*>(static_cast<Handle*>(handle))->fd, &status) != 0) {
+        return FALSE;
+    }
+    size->QuadPart = status.st_size;
+    return TRUE;
+}
+
+
+HANDLE CreateFileMappingW(HANDLE handle, void*, DWORD, DWORD, DWORD, LPCWSTR) {
+    LARGE_INTEGER size = {};
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0) {
+        lastError = 1006;  // ERROR_FILE_INVALID, empty files cannot be mapped
+        return nullptr;
+    }
+    Mapping* mapping = new Mapping();
+    mapping->fd = dup(static_cast<File*>(static_cast<Handle*>(handle))->fd);
+    mapping->sizeInBytes = static_cast<size_t>(size.QuadPart);
+    return static_cast<Handle*>(mapping);
+}
+
+
+HANDLE CreateFileMapping(HANDLE file, void* attributes, DWORD protect, DWORD sizeHigh, DWORD sizeLow, LPCWSTR name) {
+    return CreateFileMappingW(file, attributes, protect, sizeHigh, sizeLow, name);
+}
+
+
+LPVOID MapViewOfFile(HANDLE handle, DWORD, DWORD, DWORD, SIZE_T) {
+    Mapping* mapping = static_cast<Mapping*>(static_cast<Handle*>(handle));
+    void* view = mmap(nullptr, mapping->sizeInBytes, PROT_READ, MAP_PRIVATE, mapping->fd, 0);
+    if (view == MAP_FAILED) {
+        lastError = 8;  // ERROR_NOT_ENOUGH_MEMORY
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(viewMutex);
+    viewSizes[view] = mapping->sizeInBytes;
+    return view;
+}
+
+
+BOOL UnmapViewOfFile(LPCVOID view) {
+    std::lock_guard<std::mutex> lock(viewMutex);
+    auto it = viewSizes.find(view);
+    if (it == viewSizes.end()) {
+        return FALSE;
+    }
+    munmap(const_cast<void*>(view), it->second);
+    viewSizes.erase(it);
+    return TRUE;
+}
+
+
+BOOL CreateProcessW(LPCWSTR, LPWSTR commandLine, void*, void*, BOOL, DWORD, void*, LPCWSTR, STARTUPINFOW*,
+    PROCESS_INFORMATION* processInformation) {
+    // Quoted Windows command lines are valid shell command lines for the paths used in tests
+    std::string command = narrow(commandLine);
+    const char* arguments[] = { "/bin/sh", "-c", command.c_str(), nullptr };
+    pid_t pid = -1;
+    if (posix_spawn(&pid, "/bin/sh", nullptr, nullptr, const_cast<char**>(arguments), environ) != 0) {
+        lastError = ERROR_FILE_NOT_FOUND;
+        return FALSE;
+    }
+    Process* process = new Process();
+    process->pid = pid;
+    processInformation->hProcess = static_cast<Handle*>(process);
+    processInformation->hThread = static_cast<Handle*>(new Handle());
+    processInformation->dwProcessId = static_cast<DWORD>(pid);
+    processInformation->dwThreadId = 0;
+    return TRUE;
+}
+
+
+BOOL GetExitCodeProcess(HANDLE handle, DWORD* exitCode) {
+    Process* process = static_cast<Process*>(static_cast<Handle*>(handle));
+    *exitCode = process->hasExited ? process->exitCode : 259;  // STILL_ACTIVE
+    return TRUE;
+}
+
+
+HRESULT D3D12GetDebugInterface(REFIID, void**) { return E_NOTIMPL; }
+HRESULT D3D12CreateDevice(IUnknown*, D3D_FEATURE_LEVEL, REFIID, void**) { return E_NOTIMPL; }
+HRESULT CreateDXGIFactory2(UINT, REFIID, void**) { return E_NOTIMPL; }
+HRESULT DXGIGetDebugInterface1(UINT, REFIID, void**) { return E_NOTIMPL; }
@@ -0,0 +1,62 @@
+#pragma once
+
+///
+/// Minimal test harness, TEST() registers a case and CHECK() records failures without stopping it
+///
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+namespace fastdx_test {
+    struct TestCase {
+        const char* name;
+        void (*function)();
+    };
+
+    inline std::vector<TestCase>& testCases() {
+        static std::vector<TestCase> cases;
+        return cases;
+    }
+
+    inline int& failureCount() {
+        static int count = 0;
+        return count;
+    }
+
+    struct TestRegistrar {
+        TestRegistrar(const char* name, void (*function)()) {
+            testCases().push_back({ name, function });
+        }
+    };
+
+    inline void fail(const char* file, int line, const char* expression) {
+        fprintf(stderr, "%s(%d): CHECK(%s) failed\n", file, line, expression);
+        ++failureCount();
+    }
+
+    // Runs every case, or those whose name contains filter
+    inline int runTests(const char* filter) {
+        int caseCount = 0;
+        for (const TestCase& testCase : testCases()) {
+            if (filter != nullptr && strstr(testCase.name, filter) == nullptr) {
+                continue;
+            }
+            int failuresBefore = failureCount();
+            testCase.function();
+            printf("[%s] %s\n", failureCount() == failuresBefore ? "  OK  " : " FAIL ", testCase.name);
+            ++caseCount;
+        }
+        printf("%d cases, %d failed checks\n", caseCount, failureCount());
+        return failureCount() == 0 ? 0 : 1;
+    }
+};
+
+#define TEST(NAME) \
+    static void NAME(); \
+    static fastdx_test::TestRegistrar NAME##Registrar(#NAME, NAME); \
+    static void NAME()
+
+#define CHECK(CONDITION) \
+    do { if (!(CONDITION)) { fastdx_test::fail(__FILE__, __LINE__, #CONDITION); } } while (false)
+
+#define CHECK_EQ(A, B) CHECK((A) == (B))
@@ -0,0 +1,5 @@
+#include "test.h"
+
+int main(int argc, char** argv) {
+    return fastdx_test::runTests(argc > 1 ? argv[1] : nullptr);
+}
@@ -0,0 +1,92 @@
+///
+/// Packs compiled shaders into a ShaderLibrary archive at build time, each named by its file stem.
+///
+///     shader_pack [--force] <output.fdxs> <shader.cso | directory>...
+///
+/// Directories add every .cso file directly inside them. The archive is only rewritten when an input is newer or
+/// was added, so it can run as a post-build step of every build.
+///
+#define FASTDX_IMPLEMENTATION
+#include "../../fastdx/fastdx.h"
+
+#include <stdio.h>
+
+namespace {
+    bool collectInputs(const std::filesystem::path& path, std::map<std::string, std::filesystem::path>& outInputs) {
+        std::error_code errorCode;
+        if (std::filesystem::is_directory(path, errorCode)) {
+            for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(path, errorCode)) {
+                if (entry.is_regular_file() && entry.path().extension() == ".cso") {
+                    outInputs[entry.path().stem().string()] = entry.path();
+                }
+            }
+            return !errorCode;
+        }
+        if (!std::filesystem::is_regular_file(path, errorCode)) {
+            return false;
+        }
+        outInputs[path.stem().string()] = path;
+        return true;
+    }
+
+    // Names and newest input compared with the archive, a removed input also needs a repack
+    bool isUpToDate(const std::filesystem::path& outputPath,
+        const std::map<std::string, std::filesystem::path>& inputs) {
+        std::error_code errorCode;
+        std::filesystem::file_time_type outputTime = std::filesystem::last_write_time(outputPath, errorCode);
+        if (errorCode) {
+            return false;
+        }
+        fastdx::ShaderLibrary library;
+        if (FAILED(library.open(outputPath)) || library.shaderCount() != inputs.size()) {
+            return false;
+        }
+        for (const auto& input : inputs) {
+            std::filesystem::file_time_type inputTime = std::filesystem::last_write_time(input.second, errorCode);
+            if (errorCode || inputTime > outputTime || library.shader(input.first).pShaderBytecode == nullptr) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+
+int main(int argc, char** argv) {
+    int argumentIndex = 1;
+    bool isForced = (argc > 1 && strcmp(argv[1], "--force") == 0);
+    argumentIndex += isForced ? 1 : 0;
+    if (argc - argumentIndex < 2) {
+        fprintf(stderr, "Usage: shader_pack [--force] <output.fdxs> <shader.cso | directory>...\n");
+        return 2;
+    }
+
+    std::filesystem::path outputPath = argv[argumentIndex++];
+    std::map<std::string, std::filesystem::path> inputs;
+    for (; argumentIndex < argc; ++argumentIndex) {
+        if (!collectInputs(argv[argumentIndex], inputs)) {
+            fprintf(stderr, "shader_pack: cannot read %s\n", argv[argumentIndex]);
+            return 1;
+        }
+    }
+
+    if (!isForced && isUpToDate(outputPath, inputs)) {
+        printf("shader_pack: %s is up to date\n", outputPath.string().c_str());
+        return 0;
+    }
+
+    fastdx::ShaderLibraryWriter writer;
+    for (const auto& input : inputs) {
+        if (FAILED(writer.addFile(input.first, input.second))) {
+            fprintf(stderr, "shader_pack: cannot read %s\n", input.second.string().c_str());
+            return 1;
+        }
+    }
+    if (FAILED(writer.save(outputPath))) {
+        fprintf(stderr, "shader_pack: cannot write %s\n", outputPath.string().c_str());
+        return 1;
+    }
+    printf("shader_pack: %zu shaders, %zu unique blobs packed into %s\n", writer.shaderCount(), writer.blobCount(),
+        outputPath.string().c_str());
+    return 0;
+}